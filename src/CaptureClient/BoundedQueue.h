@@ -0,0 +1,85 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_CLIENT_BOUNDED_QUEUE_H_
+#define CAPTURE_CLIENT_BOUNDED_QUEUE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <stddef.h>
+
+#include <deque>
+#include <optional>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_capture_client {
+
+// A first-in-first-out queue between one or more producer threads and one or more consumer threads
+// that holds at most `capacity` elements. Push blocks while the queue is full and Pop blocks while
+// the queue is empty, so that a fast producer is slowed down to the pace of the consumer instead of
+// making the queue grow without bounds.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_{capacity} { CHECK(capacity_ > 0); }
+
+  // Blocks until there is space in the queue. Returns false, dropping `element`, if the queue has
+  // been closed or cancelled.
+  bool Push(T&& element) {
+    absl::MutexLock lock{&mutex_};
+    mutex_.Await(absl::Condition(
+        +[](BoundedQueue* self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(self->mutex_) {
+          return self->elements_.size() < self->capacity_ || self->closed_;
+        },
+        this));
+    if (closed_) return false;
+    elements_.push_back(std::move(element));
+    return true;
+  }
+
+  // Blocks until there is an element in the queue. Returns nullopt once the queue has been closed
+  // and all elements pushed before have been popped, or right away once it has been cancelled.
+  std::optional<T> Pop() {
+    absl::MutexLock lock{&mutex_};
+    mutex_.Await(absl::Condition(
+        +[](BoundedQueue* self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(self->mutex_) {
+          return !self->elements_.empty() || self->closed_;
+        },
+        this));
+    if (elements_.empty()) return std::nullopt;
+    std::optional<T> element{std::move(elements_.front())};
+    elements_.pop_front();
+    return element;
+  }
+
+  // No more elements can be pushed. The elements already in the queue can still be popped.
+  void Close() {
+    absl::MutexLock lock{&mutex_};
+    closed_ = true;
+  }
+
+  // Same as Close, but also drops the elements in the queue.
+  void Cancel() {
+    absl::MutexLock lock{&mutex_};
+    closed_ = true;
+    elements_.clear();
+  }
+
+  [[nodiscard]] size_t size() const {
+    absl::MutexLock lock{&mutex_};
+    return elements_.size();
+  }
+
+ private:
+  const size_t capacity_;
+  mutable absl::Mutex mutex_;
+  std::deque<T> elements_ ABSL_GUARDED_BY(mutex_);
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace orbit_capture_client
+
+#endif  // CAPTURE_CLIENT_BOUNDED_QUEUE_H_
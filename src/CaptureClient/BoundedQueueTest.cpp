@@ -0,0 +1,117 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/synchronization/notification.h>
+#include <absl/time/time.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+
+namespace orbit_capture_client {
+
+TEST(BoundedQueue, PopReturnsElementsInOrderOfPush) {
+  BoundedQueue<int> queue{3};
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  EXPECT_TRUE(queue.Push(3));
+  EXPECT_EQ(queue.size(), 3);
+
+  EXPECT_EQ(queue.Pop(), 1);
+  EXPECT_EQ(queue.Pop(), 2);
+  EXPECT_TRUE(queue.Push(4));
+  EXPECT_EQ(queue.Pop(), 3);
+  EXPECT_EQ(queue.Pop(), 4);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(BoundedQueue, MoveOnlyElements) {
+  BoundedQueue<std::unique_ptr<int>> queue{1};
+  EXPECT_TRUE(queue.Push(std::make_unique<int>(42)));
+  std::optional<std::unique_ptr<int>> element = queue.Pop();
+  ASSERT_TRUE(element.has_value());
+  EXPECT_EQ(**element, 42);
+}
+
+TEST(BoundedQueue, CloseLetsRemainingElementsBePopped) {
+  BoundedQueue<int> queue{2};
+  EXPECT_TRUE(queue.Push(1));
+  queue.Close();
+  EXPECT_FALSE(queue.Push(2));
+
+  EXPECT_EQ(queue.Pop(), 1);
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+TEST(BoundedQueue, CancelDropsRemainingElements) {
+  BoundedQueue<int> queue{2};
+  EXPECT_TRUE(queue.Push(1));
+  queue.Cancel();
+  EXPECT_FALSE(queue.Push(2));
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+TEST(BoundedQueue, PushBlocksWhileFull) {
+  BoundedQueue<int> queue{1};
+  EXPECT_TRUE(queue.Push(1));
+
+  absl::Notification pushed;
+  std::thread producer{[&queue, &pushed] {
+    EXPECT_TRUE(queue.Push(2));
+    pushed.Notify();
+  }};
+
+  EXPECT_FALSE(pushed.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  EXPECT_EQ(queue.Pop(), 1);
+  pushed.WaitForNotification();
+  EXPECT_EQ(queue.Pop(), 2);
+  producer.join();
+}
+
+TEST(BoundedQueue, CancelUnblocksPush) {
+  BoundedQueue<int> queue{1};
+  EXPECT_TRUE(queue.Push(1));
+
+  std::thread producer{[&queue] { EXPECT_FALSE(queue.Push(2)); }};
+  queue.Cancel();
+  producer.join();
+}
+
+TEST(BoundedQueue, CloseUnblocksPop) {
+  BoundedQueue<int> queue{1};
+
+  std::thread consumer{[&queue] { EXPECT_EQ(queue.Pop(), std::nullopt); }};
+  queue.Close();
+  consumer.join();
+}
+
+TEST(BoundedQueue, ProducerAndConsumerThreads) {
+  constexpr int kElementCount = 10'000;
+  BoundedQueue<int> queue{16};
+
+  std::thread producer{[&queue] {
+    for (int i = 0; i < kElementCount; ++i) {
+      EXPECT_TRUE(queue.Push(int{i}));
+    }
+    queue.Close();
+  }};
+
+  std::vector<int> popped;
+  while (std::optional<int> element = queue.Pop()) {
+    popped.push_back(element.value());
+  }
+  producer.join();
+
+  ASSERT_EQ(popped.size(), kElementCount);
+  for (int i = 0; i < kElementCount; ++i) {
+    EXPECT_EQ(popped[i], i);
+  }
+}
+
+}  // namespace orbit_capture_client
@@ -11,10 +11,13 @@
 #include <absl/time/time.h>
 
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 
+#include "BoundedQueue.h"
 #include "CaptureClient/CaptureEventProcessor.h"
 #include "CaptureClient/CaptureListener.h"
 #include "ClientData/FunctionUtils.h"
@@ -23,6 +26,7 @@
 #include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/ThreadUtils.h"
 #include "capture.pb.h"
 #include "tracepoint.pb.h"
 
@@ -44,6 +48,40 @@ using orbit_grpc_protos::UnwindingMethod;
 
 using orbit_base::Future;
 
+namespace {
+
+// Each CaptureResponse holds up to 10'000 events (see GrpcCaptureEventSender in the service).
+constexpr size_t kMaxQueuedCaptureResponses = 64;
+
+// Reports the rate of events passing through one stage of the capture to introspection about once
+// per second.
+class EventRateReporter {
+ public:
+  explicit EventRateReporter(const char* name) : name_{name} {}
+
+  void Add(uint64_t event_count) {
+    event_count_ += event_count;
+    const absl::Time now = absl::Now();
+    const absl::Duration elapsed = now - interval_start_;
+    if (elapsed < kReportInterval) return;
+
+    [[maybe_unused]] const double events_per_second =
+        static_cast<double>(event_count_) / absl::ToDoubleSeconds(elapsed);
+    ORBIT_DOUBLE(name_, events_per_second);
+    event_count_ = 0;
+    interval_start_ = now;
+  }
+
+ private:
+  static constexpr absl::Duration kReportInterval = absl::Seconds(1);
+
+  const char* name_;
+  uint64_t event_count_ = 0;
+  absl::Time interval_start_ = absl::Now();
+};
+
+}  // namespace
+
 // TODO(b/187170164): This method contains a lot of arguments. Consider making it more structured.
 Future<ErrorMessageOr<CaptureListener::CaptureOutcome>> CaptureClient::Capture(
     orbit_base::ThreadPool* thread_pool, int32_t process_id,
@@ -203,6 +241,25 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
   }
   LOG("Sent CaptureRequest on Capture's gRPC stream: asking to start capturing");
 
+  // Responses are received on this thread and processed, in order, on a separate thread, so that
+  // a slowdown in processing doesn't immediately stall reading from the gRPC stream.
+  BoundedQueue<CaptureResponse> response_queue{kMaxQueuedCaptureResponses};
+  std::thread processing_thread{[this, &response_queue, capture_event_processor] {
+    orbit_base::SetCurrentThreadName("CaptureProcess");
+    EventRateReporter processed_event_rate_reporter{"CaptureClient processed events per second"};
+    while (std::optional<CaptureResponse> response = response_queue.Pop()) {
+      if (try_abort_) {
+        // Also unblocks the receiving thread if it is waiting for space in the queue.
+        response_queue.Cancel();
+        break;
+      }
+      ORBIT_SCOPE("Process CaptureResponse");
+      ProcessEvents(capture_event_processor, response->capture_events());
+      processed_event_rate_reporter.Add(response->capture_events_size());
+    }
+  }};
+
+  EventRateReporter received_event_rate_reporter{"CaptureClient received events per second"};
   while (!writes_done_failed_ && !try_abort_) {
     CaptureResponse response;
     bool read_succeeded;
@@ -210,12 +267,19 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
       absl::ReaderMutexLock lock{&context_and_stream_mutex_};
       read_succeeded = reader_writer_->Read(&response);
     }
-    if (read_succeeded) {
-      ProcessEvents(capture_event_processor, response.capture_events());
-    } else {
-      break;
-    }
+    if (!read_succeeded) break;
+
+    received_event_rate_reporter.Add(response.capture_events_size());
+    if (!response_queue.Push(std::move(response))) break;
+    ORBIT_UINT64("CaptureClient queued CaptureResponses", response_queue.size());
+  }
+
+  if (try_abort_) {
+    response_queue.Cancel();
+  } else {
+    response_queue.Close();
   }
+  processing_thread.join();
 
   ErrorMessageOr<void> finish_result = FinishCapture();
   if (try_abort_) {
@@ -6,13 +6,17 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <google/protobuf/arena.h>
 #include <llvm/Demangle/Demangle.h>
 
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "CaptureClient/ApiEventProcessor.h"
 #include "CaptureClient/GpuQueueSubmissionProcessor.h"
+#include "CaptureClient/StringInternPool.h"
 #include "GrpcProtos/Constants.h"
 #include "OrbitBase/Logging.h"
 #include "capture_data.pb.h"
@@ -105,14 +109,26 @@ class CaptureEventProcessorForListener : public CaptureEventProcessor {
   std::optional<std::filesystem::path> file_path_;
   absl::flat_hash_set<uint64_t> frame_track_function_ids_;
 
-  absl::flat_hash_map<uint64_t, orbit_grpc_protos::Callstack> callstack_intern_pool;
-  absl::flat_hash_map<uint64_t, std::string> string_intern_pool_;
+  // The interned callstacks are allocated on `callstack_arena_`, so that they are never moved or
+  // copied once interned.
+  google::protobuf::Arena callstack_arena_;
+  absl::flat_hash_map<uint64_t, const orbit_grpc_protos::Callstack*> callstack_intern_pool_;
+  StringInternPool string_intern_pool_;
   CaptureListener* capture_listener_ = nullptr;
 
   absl::flat_hash_set<uint64_t> callstack_hashes_seen_;
   void SendCallstackToListenerIfNecessary(uint64_t callstack_id,
                                           const orbit_grpc_protos::Callstack& callstack);
-  uint64_t GetStringHashAndSendToListenerIfNecessary(const std::string& str);
+  uint64_t GetStringKeyAndSendToListenerIfNecessary(std::string_view str);
+
+  // The labels of the timers of a GpuJob are the same for every GpuJob, so their keys are only
+  // looked up for the first one.
+  struct GpuJobLabelKeys {
+    uint64_t sw_queue_key;
+    uint64_t hw_queue_key;
+    uint64_t hw_execution_key;
+  };
+  std::optional<GpuJobLabelKeys> gpu_job_label_keys_;
 
   GpuQueueSubmissionProcessor gpu_queue_submission_processor_;
   ApiEventProcessor api_event_processor_;
@@ -272,17 +288,22 @@ void CaptureEventProcessorForListener::ProcessSchedulingSlice(
 
 void CaptureEventProcessorForListener::ProcessInternedCallstack(
     InternedCallstack interned_callstack) {
-  if (callstack_intern_pool.contains(interned_callstack.key())) {
+  if (callstack_intern_pool_.contains(interned_callstack.key())) {
     ERROR("Overwriting InternedCallstack with key %llu", interned_callstack.key());
+    return;
   }
-  callstack_intern_pool.emplace(interned_callstack.key(),
-                                std::move(*interned_callstack.mutable_intern()));
+  Callstack* callstack = google::protobuf::Arena::CreateMessage<Callstack>(&callstack_arena_);
+  callstack->Swap(interned_callstack.mutable_intern());
+  callstack_intern_pool_.emplace(interned_callstack.key(), callstack);
 }
 
 void CaptureEventProcessorForListener::ProcessCallstackSample(
     const CallstackSample& callstack_sample) {
   uint64_t callstack_id = callstack_sample.callstack_id();
-  Callstack callstack = callstack_intern_pool[callstack_id];
+  auto callstack_it = callstack_intern_pool_.find(callstack_id);
+  const Callstack& callstack = callstack_it != callstack_intern_pool_.end()
+                                   ? *callstack_it->second
+                                   : Callstack::default_instance();
 
   SendCallstackToListenerIfNecessary(callstack_id, callstack);
 
@@ -340,11 +361,11 @@ void CaptureEventProcessorForListener::ProcessIntrospectionScope(
 }
 
 void CaptureEventProcessorForListener::ProcessInternedString(InternedString interned_string) {
-  if (string_intern_pool_.contains(interned_string.key())) {
+  if (!string_intern_pool_.Add(interned_string.key(), interned_string.intern())) {
     ERROR("Overwriting InternedString with key %llu", interned_string.key());
   }
-  capture_listener_->OnKeyAndString(interned_string.key(), interned_string.intern());
-  string_intern_pool_.emplace(interned_string.key(), std::move(*interned_string.mutable_intern()));
+  capture_listener_->OnKeyAndString(interned_string.key(),
+                                    std::move(*interned_string.mutable_intern()));
 }
 
 void CaptureEventProcessorForListener::ProcessModuleUpdate(
@@ -367,8 +388,11 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
   int32_t thread_id = gpu_job.tid();
   uint64_t amdgpu_cs_ioctl_time_ns = gpu_job.amdgpu_cs_ioctl_time_ns();
 
-  constexpr const char* kSwQueue = "sw queue";
-  uint64_t sw_queue_key = GetStringHashAndSendToListenerIfNecessary(kSwQueue);
+  if (!gpu_job_label_keys_.has_value()) {
+    gpu_job_label_keys_ = GpuJobLabelKeys{GetStringKeyAndSendToListenerIfNecessary("sw queue"),
+                                          GetStringKeyAndSendToListenerIfNecessary("hw queue"),
+                                          GetStringKeyAndSendToListenerIfNecessary("hw execution")};
+  }
 
   TimerInfo timer_user_to_sched;
   timer_user_to_sched.set_process_id(process_id);
@@ -376,7 +400,7 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
   timer_user_to_sched.set_start(amdgpu_cs_ioctl_time_ns);
   timer_user_to_sched.set_end(gpu_job.amdgpu_sched_run_job_time_ns());
   timer_user_to_sched.set_depth(gpu_job.depth());
-  timer_user_to_sched.set_user_data_key(sw_queue_key);
+  timer_user_to_sched.set_user_data_key(gpu_job_label_keys_->sw_queue_key);
   timer_user_to_sched.set_timeline_hash(timeline_key);
   timer_user_to_sched.set_processor(-1);
   timer_user_to_sched.set_type(TimerInfo::kGpuActivity);
@@ -385,31 +409,25 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
 
   capture_listener_->OnTimer(timer_user_to_sched);
 
-  constexpr const char* kHwQueue = "hw queue";
-  uint64_t hw_queue_key = GetStringHashAndSendToListenerIfNecessary(kHwQueue);
-
   TimerInfo timer_sched_to_start;
   timer_sched_to_start.set_process_id(process_id);
   timer_sched_to_start.set_thread_id(thread_id);
   timer_sched_to_start.set_start(gpu_job.amdgpu_sched_run_job_time_ns());
   timer_sched_to_start.set_end(gpu_job.gpu_hardware_start_time_ns());
   timer_sched_to_start.set_depth(gpu_job.depth());
-  timer_sched_to_start.set_user_data_key(hw_queue_key);
+  timer_sched_to_start.set_user_data_key(gpu_job_label_keys_->hw_queue_key);
   timer_sched_to_start.set_timeline_hash(timeline_key);
   timer_sched_to_start.set_processor(-1);
   timer_sched_to_start.set_type(TimerInfo::kGpuActivity);
   capture_listener_->OnTimer(timer_sched_to_start);
 
-  constexpr const char* kHwExecution = "hw execution";
-  uint64_t hw_execution_key = GetStringHashAndSendToListenerIfNecessary(kHwExecution);
-
   TimerInfo timer_start_to_finish;
   timer_start_to_finish.set_process_id(process_id);
   timer_start_to_finish.set_thread_id(thread_id);
   timer_start_to_finish.set_start(gpu_job.gpu_hardware_start_time_ns());
   timer_start_to_finish.set_end(gpu_job.dma_fence_signaled_time_ns());
   timer_start_to_finish.set_depth(gpu_job.depth());
-  timer_start_to_finish.set_user_data_key(hw_execution_key);
+  timer_start_to_finish.set_user_data_key(gpu_job_label_keys_->hw_execution_key);
   timer_start_to_finish.set_timeline_hash(timeline_key);
   timer_start_to_finish.set_processor(-1);
   timer_start_to_finish.set_type(TimerInfo::kGpuActivity);
@@ -417,7 +435,7 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
 
   std::vector<TimerInfo> vulkan_related_timers = gpu_queue_submission_processor_.ProcessGpuJob(
       gpu_job, string_intern_pool_,
-      [this](const std::string& str) { return GetStringHashAndSendToListenerIfNecessary(str); });
+      [this](std::string_view str) { return GetStringKeyAndSendToListenerIfNecessary(str); });
   for (const TimerInfo& timer : vulkan_related_timers) {
     capture_listener_->OnTimer(timer);
   }
@@ -427,8 +445,8 @@ void CaptureEventProcessorForListener::ProcessGpuQueueSubmission(
     const GpuQueueSubmission& gpu_queue_submission) {
   std::vector<TimerInfo> vulkan_related_timers =
       gpu_queue_submission_processor_.ProcessGpuQueueSubmission(
-          gpu_queue_submission, string_intern_pool_, [this](const std::string& str) {
-            return GetStringHashAndSendToListenerIfNecessary(str);
+          gpu_queue_submission, string_intern_pool_, [this](std::string_view str) {
+            return GetStringKeyAndSendToListenerIfNecessary(str);
           });
   for (const TimerInfo& timer : vulkan_related_timers) {
     capture_listener_->OnTimer(timer);
@@ -503,7 +521,7 @@ void CaptureEventProcessorForListener::ExtractAndProcessCGroupAndProcessMemoryTr
   std::vector<uint64_t> encoded_values(
       static_cast<size_t>(CGroupAndProcessMemoryUsageEncodingIndex::kEnd));
   encoded_values[static_cast<size_t>(CGroupAndProcessMemoryUsageEncodingIndex::kCGroupNameHash)] =
-      GetStringHashAndSendToListenerIfNecessary(cgroup_memory_usage.cgroup_name());
+      GetStringKeyAndSendToListenerIfNecessary(cgroup_memory_usage.cgroup_name());
   encoded_values[static_cast<size_t>(CGroupAndProcessMemoryUsageEncodingIndex::kCGroupLimitBytes)] =
       orbit_api::Encode<uint64_t>(cgroup_memory_usage.limit_bytes());
   encoded_values[static_cast<size_t>(CGroupAndProcessMemoryUsageEncodingIndex::kCGroupRssBytes)] =
@@ -536,7 +554,7 @@ void CaptureEventProcessorForListener::ExtractAndProcessPageFaultsTrackingTimer(
   encoded_values[static_cast<size_t>(PageFaultsEncodingIndex::kSystemMajorPageFaults)] =
       orbit_api::Encode<uint64_t>(system_memory_usage.pgmajfault());
   encoded_values[static_cast<size_t>(PageFaultsEncodingIndex::kCGroupNameHash)] =
-      GetStringHashAndSendToListenerIfNecessary(cgroup_memory_usage.cgroup_name());
+      GetStringKeyAndSendToListenerIfNecessary(cgroup_memory_usage.cgroup_name());
   encoded_values[static_cast<size_t>(PageFaultsEncodingIndex::kCGroupPageFaults)] =
       orbit_api::Encode<uint64_t>(cgroup_memory_usage.pgfault());
   encoded_values[static_cast<size_t>(PageFaultsEncodingIndex::kCGroupMajorPageFaults)] =
@@ -611,15 +629,17 @@ void CaptureEventProcessorForListener::ProcessThreadStateSlice(
 }
 
 void CaptureEventProcessorForListener::ProcessAddressInfo(const AddressInfo& address_info) {
-  CHECK(string_intern_pool_.contains(address_info.function_name_key()));
-  CHECK(string_intern_pool_.contains(address_info.module_name_key()));
-  std::string function_name = string_intern_pool_.at(address_info.function_name_key());
-  std::string module_name = string_intern_pool_.at(address_info.module_name_key());
+  std::optional<std::string_view> function_name =
+      string_intern_pool_.Get(address_info.function_name_key());
+  std::optional<std::string_view> module_name =
+      string_intern_pool_.Get(address_info.module_name_key());
+  CHECK(function_name.has_value());
+  CHECK(module_name.has_value());
 
   LinuxAddressInfo linux_address_info;
   linux_address_info.set_absolute_address(address_info.absolute_address());
-  linux_address_info.set_module_path(module_name);
-  linux_address_info.set_function_name(llvm::demangle(function_name));
+  linux_address_info.set_module_path(std::string{module_name.value()});
+  linux_address_info.set_function_name(llvm::demangle(std::string{function_name.value()}));
   linux_address_info.set_offset_in_function(address_info.offset_in_function());
   capture_listener_->OnAddressInfo(linux_address_info);
 }
@@ -722,14 +742,13 @@ void CaptureEventProcessorForListener::ProcessOutOfOrderEventsDiscardedEvent(
   capture_listener_->OnOutOfOrderEventsDiscardedEvent(out_of_order_events_discarded_event);
 }
 
-uint64_t CaptureEventProcessorForListener::GetStringHashAndSendToListenerIfNecessary(
-    const std::string& str) {
-  uint64_t hash = std::hash<std::string>{}(str);
-  if (!string_intern_pool_.contains(hash)) {
-    string_intern_pool_.emplace(hash, str);
-    capture_listener_->OnKeyAndString(hash, str);
+uint64_t CaptureEventProcessorForListener::GetStringKeyAndSendToListenerIfNecessary(
+    std::string_view str) {
+  auto [key, assigned] = string_intern_pool_.GetOrAssignKey(str);
+  if (assigned) {
+    capture_listener_->OnKeyAndString(key, std::string{str});
   }
-  return hash;
+  return key;
 }
 
 }  // namespace
@@ -16,10 +16,9 @@ using orbit_grpc_protos::GpuJob;
 using orbit_grpc_protos::GpuQueueSubmission;
 
 std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmission(
-    const GpuQueueSubmission& gpu_queue_submission,
-    const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
-    const std::function<uint64_t(const std::string& str)>&
-        get_string_hash_and_send_to_listener_if_necessary) {
+    const GpuQueueSubmission& gpu_queue_submission, const StringInternPool& string_intern_pool,
+    const std::function<uint64_t(std::string_view str)>&
+        get_string_key_and_send_to_listener_if_necessary) {
   int32_t thread_id = gpu_queue_submission.meta_info().tid();
   uint64_t pre_submission_cpu_timestamp =
       gpu_queue_submission.meta_info().pre_submission_cpu_timestamp();
@@ -50,7 +49,7 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmission(
 
   std::vector<TimerInfo> result = ProcessGpuQueueSubmissionWithMatchingGpuJob(
       gpu_queue_submission, *matching_gpu_job, string_intern_pool,
-      get_string_hash_and_send_to_listener_if_necessary);
+      get_string_key_and_send_to_listener_if_necessary);
 
   if (!HasUnprocessedBeginMarkers(thread_id, post_submission_cpu_timestamp)) {
     DeleteSavedGpuJob(thread_id, submission_cpu_timestamp);
@@ -58,9 +57,9 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmission(
   return result;
 }
 std::vector<orbit_client_protos::TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuJob(
-    const GpuJob& gpu_job, const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
-    const std::function<uint64_t(const std::string& str)>&
-        get_string_hash_and_send_to_listener_if_necessary) {
+    const GpuJob& gpu_job, const StringInternPool& string_intern_pool,
+    const std::function<uint64_t(std::string_view str)>&
+        get_string_key_and_send_to_listener_if_necessary) {
   int32_t thread_id = gpu_job.tid();
   uint64_t amdgpu_cs_ioctl_time_ns = gpu_job.amdgpu_cs_ioctl_time_ns();
   const GpuQueueSubmission* matching_gpu_submission =
@@ -82,7 +81,7 @@ std::vector<orbit_client_protos::TimerInfo> GpuQueueSubmissionProcessor::Process
 
   std::vector<TimerInfo> result = ProcessGpuQueueSubmissionWithMatchingGpuJob(
       *matching_gpu_submission, gpu_job, string_intern_pool,
-      get_string_hash_and_send_to_listener_if_necessary);
+      get_string_key_and_send_to_listener_if_necessary);
 
   if (!HasUnprocessedBeginMarkers(thread_id, post_submission_cpu_timestamp)) {
     DeleteSavedGpuSubmission(thread_id, post_submission_cpu_timestamp);
@@ -154,13 +153,12 @@ const GpuJob* GpuQueueSubmissionProcessor::FindMatchingGpuJob(
 
 std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmissionWithMatchingGpuJob(
     const GpuQueueSubmission& gpu_queue_submission, const GpuJob& matching_gpu_job,
-    const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
-    const std::function<uint64_t(const std::string& str)>&
-        get_string_hash_and_send_to_listener_if_necessary) {
+    const StringInternPool& string_intern_pool,
+    const std::function<uint64_t(std::string_view str)>&
+        get_string_key_and_send_to_listener_if_necessary) {
   std::vector<TimerInfo> result;
   uint64_t timeline_key = matching_gpu_job.timeline_key();
-  CHECK(string_intern_pool.contains(timeline_key));
-  std::string timeline = string_intern_pool.at(timeline_key);
+  CHECK(string_intern_pool.Contains(timeline_key));
 
   std::optional<GpuCommandBuffer> first_command_buffer =
       ExtractFirstCommandBuffer(gpu_queue_submission);
@@ -174,7 +172,7 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmissionWit
 
   std::vector<TimerInfo> command_buffer_timers =
       ProcessGpuCommandBuffers(gpu_queue_submission, matching_gpu_job, first_command_buffer,
-                               timeline_key, get_string_hash_and_send_to_listener_if_necessary);
+                               timeline_key, get_string_key_and_send_to_listener_if_necessary);
 
   result.insert(result.end(), command_buffer_timers.begin(), command_buffer_timers.end());
 
@@ -248,11 +246,11 @@ void GpuQueueSubmissionProcessor::DeleteSavedGpuSubmission(int32_t thread_id,
 std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuCommandBuffers(
     const GpuQueueSubmission& gpu_queue_submission, const GpuJob& matching_gpu_job,
     const std::optional<GpuCommandBuffer>& first_command_buffer, uint64_t timeline_hash,
-    const std::function<uint64_t(const std::string& str)>&
-        get_string_hash_and_send_to_listener_if_necessary) {
+    const std::function<uint64_t(std::string_view str)>&
+        get_string_key_and_send_to_listener_if_necessary) {
   constexpr const char* kCommandBufferLabel = "command buffer";
   uint64_t command_buffer_text_key =
-      get_string_hash_and_send_to_listener_if_necessary(kCommandBufferLabel);
+      get_string_key_and_send_to_listener_if_necessary(kCommandBufferLabel);
 
   int32_t thread_id = gpu_queue_submission.meta_info().tid();
   int32_t process_id = gpu_queue_submission.meta_info().pid();
@@ -0,0 +1,61 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CaptureClient/StringInternPool.h"
+
+#include <string.h>
+
+namespace orbit_capture_client {
+
+bool StringInternPool::Add(uint64_t key, std::string_view str) {
+  if (key_to_string_.contains(key)) return false;
+  key_to_string_.emplace(key, Store(str));
+  return true;
+}
+
+std::pair<uint64_t, bool> StringInternPool::GetOrAssignKey(std::string_view str) {
+  auto it = client_string_to_key_.find(str);
+  if (it != client_string_to_key_.end()) {
+    return {it->second, false};
+  }
+
+  // Only a malformed capture could contain such a key, but never hand out the same key twice.
+  while (key_to_string_.contains(next_client_key_)) {
+    ++next_client_key_;
+  }
+  const uint64_t key = next_client_key_++;
+  std::string_view stored_str = Store(str);
+  key_to_string_.emplace(key, stored_str);
+  client_string_to_key_.emplace(stored_str, key);
+  return {key, true};
+}
+
+std::optional<std::string_view> StringInternPool::Get(uint64_t key) const {
+  auto it = key_to_string_.find(key);
+  if (it == key_to_string_.end()) return std::nullopt;
+  return it->second;
+}
+
+std::string_view StringInternPool::Store(std::string_view str) {
+  if (str.empty()) return {};
+
+  // Large strings get their own allocation instead of wasting most of a chunk.
+  if (str.size() > kChunkSize / 4) {
+    const std::unique_ptr<char[]>& allocation =
+        large_strings_.emplace_back(std::make_unique<char[]>(str.size()));
+    memcpy(allocation.get(), str.data(), str.size());
+    return {allocation.get(), str.size()};
+  }
+
+  if (used_bytes_in_last_chunk_ + str.size() > kChunkSize) {
+    chunks_.emplace_back(std::make_unique<char[]>(kChunkSize));
+    used_bytes_in_last_chunk_ = 0;
+  }
+  char* destination = chunks_.back().get() + used_bytes_in_last_chunk_;
+  memcpy(destination, str.data(), str.size());
+  used_bytes_in_last_chunk_ += str.size();
+  return {destination, str.size()};
+}
+
+}  // namespace orbit_capture_client
@@ -0,0 +1,76 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CaptureClient/StringInternPool.h"
+
+namespace orbit_capture_client {
+
+TEST(StringInternPool, AddAndGet) {
+  StringInternPool pool;
+  EXPECT_TRUE(pool.Add(1, "first"));
+  EXPECT_TRUE(pool.Add(2, ""));
+  EXPECT_FALSE(pool.Add(1, "replacement"));
+
+  EXPECT_TRUE(pool.Contains(1));
+  EXPECT_EQ(pool.Get(1), "first");
+  EXPECT_TRUE(pool.Contains(2));
+  EXPECT_EQ(pool.Get(2), "");
+  EXPECT_FALSE(pool.Contains(3));
+  EXPECT_EQ(pool.Get(3), std::nullopt);
+}
+
+TEST(StringInternPool, GetOrAssignKeyReturnsSameKeyForSameString) {
+  StringInternPool pool;
+  auto [first_key, first_assigned] = pool.GetOrAssignKey("label");
+  EXPECT_TRUE(first_assigned);
+  EXPECT_GE(first_key, StringInternPool::kFirstClientKey);
+  EXPECT_EQ(pool.Get(first_key), "label");
+
+  auto [second_key, second_assigned] = pool.GetOrAssignKey(std::string{"label"});
+  EXPECT_FALSE(second_assigned);
+  EXPECT_EQ(second_key, first_key);
+
+  auto [other_key, other_assigned] = pool.GetOrAssignKey("other label");
+  EXPECT_TRUE(other_assigned);
+  EXPECT_NE(other_key, first_key);
+}
+
+TEST(StringInternPool, GetOrAssignKeyDoesNotReuseAddedKeys) {
+  StringInternPool pool;
+  EXPECT_TRUE(pool.Add(StringInternPool::kFirstClientKey, "added"));
+
+  auto [key, assigned] = pool.GetOrAssignKey("label");
+  EXPECT_TRUE(assigned);
+  EXPECT_NE(key, StringInternPool::kFirstClientKey);
+  EXPECT_EQ(pool.Get(StringInternPool::kFirstClientKey), "added");
+  EXPECT_EQ(pool.Get(key), "label");
+}
+
+TEST(StringInternPool, StringViewsStayValid) {
+  StringInternPool pool;
+  constexpr uint64_t kStringCount = 10'000;
+  const std::string large_string(100'000, 'x');
+  ASSERT_TRUE(pool.Add(0, large_string));
+  const std::string_view large_string_view = pool.Get(0).value();
+
+  std::vector<std::string_view> views;
+  for (uint64_t key = 1; key <= kStringCount; ++key) {
+    ASSERT_TRUE(pool.Add(key, std::to_string(key)));
+    views.push_back(pool.Get(key).value());
+  }
+
+  EXPECT_EQ(large_string_view, large_string);
+  for (uint64_t key = 1; key <= kStringCount; ++key) {
+    EXPECT_EQ(views[key - 1], std::to_string(key));
+  }
+}
+
+}  // namespace orbit_capture_client
@@ -11,8 +11,10 @@
 #include <algorithm>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "CaptureClient/StringInternPool.h"
 #include "capture.pb.h"
 #include "capture_data.pb.h"
 
@@ -38,19 +40,18 @@ class GpuQueueSubmissionProcessor {
   // returns an empty vector and stores the submission for later processing.
   [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessGpuQueueSubmission(
       const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission,
-      const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
-      const std::function<uint64_t(const std::string& str)>&
-          get_string_hash_and_send_to_listener_if_necessary);
+      const StringInternPool& string_intern_pool,
+      const std::function<uint64_t(std::string_view str)>&
+          get_string_key_and_send_to_listener_if_necessary);
 
   // If the matching `GpuQueueSubmission` has already been processed, it converts the
   // command buffer and debug marker information from this `GpuQueueSubmission` event into
   // `TimerInfo`s. Otherwise, it returns an empty vector and stores the `GpuJob for later
   // processing.
   [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessGpuJob(
-      const orbit_grpc_protos::GpuJob& gpu_job,
-      const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
-      const std::function<uint64_t(const std::string& str)>&
-          get_string_hash_and_send_to_listener_if_necessary);
+      const orbit_grpc_protos::GpuJob& gpu_job, const StringInternPool& string_intern_pool,
+      const std::function<uint64_t(std::string_view str)>&
+          get_string_key_and_send_to_listener_if_necessary);
 
   // In case we have recored the submission containing the "begin" of a certain debug marker, we
   // use the `begin_capture_time_ns_` as an approximation for the begin CPU timestamp.
@@ -64,17 +65,17 @@ class GpuQueueSubmissionProcessor {
   ProcessGpuQueueSubmissionWithMatchingGpuJob(
       const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission,
       const orbit_grpc_protos::GpuJob& matching_gpu_job,
-      const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
-      const std::function<uint64_t(const std::string& str)>&
-          get_string_hash_and_send_to_listener_if_necessary);
+      const StringInternPool& string_intern_pool,
+      const std::function<uint64_t(std::string_view str)>&
+          get_string_key_and_send_to_listener_if_necessary);
 
   [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessGpuCommandBuffers(
       const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission,
       const orbit_grpc_protos::GpuJob& matching_gpu_job,
       const std::optional<orbit_grpc_protos::GpuCommandBuffer>& first_command_buffer,
       uint64_t timeline_hash,
-      const std::function<uint64_t(const std::string& str)>&
-          get_string_hash_and_send_to_listener_if_necessary);
+      const std::function<uint64_t(std::string_view str)>&
+          get_string_key_and_send_to_listener_if_necessary);
 
   [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessGpuDebugMarkers(
       const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission,
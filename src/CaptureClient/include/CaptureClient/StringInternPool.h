@@ -0,0 +1,58 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_CLIENT_STRING_INTERN_POOL_H_
+#define CAPTURE_CLIENT_STRING_INTERN_POOL_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace orbit_capture_client {
+
+// The strings of a capture by key: the strings interned by OrbitService, with the keys it assigned,
+// and the strings that the client adds to the capture itself, with keys assigned here.
+//
+// The strings are copied once into chunks of memory that are only freed with the pool, so the
+// std::string_views returned stay valid as long as the pool exists. This class is not thread-safe.
+class StringInternPool {
+ public:
+  // OrbitService assigns keys from 1 upwards, so the keys assigned by GetOrAssignKey start from
+  // here to never collide with them.
+  static constexpr uint64_t kFirstClientKey = uint64_t{1} << 63;
+
+  // Adds a string interned by OrbitService. Returns false, keeping the previous string, if `key`
+  // is already present.
+  bool Add(uint64_t key, std::string_view str);
+
+  // Returns the key of a string that the client adds to the capture itself, e.g., the label of a
+  // GPU timer, assigning a new key the first time `str` is seen. The second element is true if the
+  // key was assigned by this call.
+  std::pair<uint64_t, bool> GetOrAssignKey(std::string_view str);
+
+  [[nodiscard]] std::optional<std::string_view> Get(uint64_t key) const;
+  [[nodiscard]] bool Contains(uint64_t key) const { return key_to_string_.contains(key); }
+
+ private:
+  std::string_view Store(std::string_view str);
+
+  static constexpr size_t kChunkSize = 64 * 1024;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  size_t used_bytes_in_last_chunk_ = kChunkSize;
+  std::vector<std::unique_ptr<char[]>> large_strings_;
+
+  absl::flat_hash_map<uint64_t, std::string_view> key_to_string_;
+  absl::flat_hash_map<std::string_view, uint64_t> client_string_to_key_;
+  uint64_t next_client_key_ = kFirstClientKey;
+};
+
+}  // namespace orbit_capture_client
+
+#endif  // CAPTURE_CLIENT_STRING_INTERN_POOL_H_
@@ -20,6 +20,9 @@ namespace orbit_capture_file {
 
 namespace {
 
+// Captures are written event by event, so buffer generously to keep the number of writes low.
+constexpr int kWriteBufferSize = 1024 * 1024;
+
 class CaptureFileOutputStreamImpl final : public CaptureFileOutputStream {
  public:
   explicit CaptureFileOutputStreamImpl(std::filesystem::path path) : path_{std::move(path)} {}
@@ -142,7 +145,7 @@ ErrorMessageOr<void> CaptureFileOutputStreamImpl::WriteHeader() {
   }
 
   // Prepare the protobuf stream to use to write to capture section.
-  file_output_stream_.emplace(fd_.get());
+  file_output_stream_.emplace(fd_.get(), kWriteBufferSize);
   coded_output_.emplace(&file_output_stream_.value());
 
   return outcome::success();
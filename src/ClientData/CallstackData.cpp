@@ -8,8 +8,13 @@
 #include <absl/container/flat_hash_set.h>
 
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <utility>
+#include <vector>
 
+#include "OrbitBase/Future.h"
+#include "OrbitBase/JoinFutures.h"
 #include "OrbitBase/Logging.h"
 #include "capture_data.pb.h"
 
@@ -22,8 +27,8 @@ void CallstackData::AddCallstackEvent(CallstackEvent callstack_event) {
   std::lock_guard lock(mutex_);
   CHECK(unique_callstacks_.contains(callstack_event.callstack_id()));
   RegisterTime(callstack_event.time());
-  callstack_events_by_tid_[callstack_event.thread_id()][callstack_event.time()] =
-      std::move(callstack_event);
+  GetOrCreateCallstackEventStoreOfTid(callstack_event.thread_id())
+      .AddEvent(callstack_event.time(), callstack_event.callstack_id());
 }
 
 void CallstackData::RegisterTime(uint64_t time) {
@@ -38,101 +43,139 @@ void CallstackData::AddUniqueCallstack(uint64_t callstack_id,
       std::make_shared<orbit_client_protos::CallstackInfo>(std::move(callstack));
 }
 
-uint32_t CallstackData::GetCallstackEventsCount() const {
+CallstackEventStore& CallstackData::GetOrCreateCallstackEventStoreOfTid(int32_t tid) {
+  std::unique_ptr<CallstackEventStore>& store = callstack_events_by_tid_[tid];
+  if (store == nullptr) {
+    store = std::make_unique<CallstackEventStore>();
+  }
+  return *store;
+}
+
+std::vector<std::pair<int32_t, const CallstackEventStore*>>
+CallstackData::GetCallstackEventStores() const {
+  std::lock_guard lock(mutex_);
+  std::vector<std::pair<int32_t, const CallstackEventStore*>> stores;
+  stores.reserve(callstack_events_by_tid_.size());
+  for (const auto& [tid, store] : callstack_events_by_tid_) {
+    stores.emplace_back(tid, store.get());
+  }
+  return stores;
+}
+
+const CallstackEventStore* CallstackData::GetCallstackEventStoreOfTid(int32_t tid) const {
   std::lock_guard lock(mutex_);
+  auto tid_and_events_it = callstack_events_by_tid_.find(tid);
+  if (tid_and_events_it == callstack_events_by_tid_.end()) {
+    return nullptr;
+  }
+  return tid_and_events_it->second.get();
+}
+
+namespace {
+
+// Calls `action` with a CallstackEvent for each event of `store` in [min_timestamp, max_timestamp].
+// The same CallstackEvent is reused for all calls.
+void ForEachCallstackEventOfStoreInTimeRange(
+    int32_t tid, const CallstackEventStore& store, uint64_t min_timestamp, uint64_t max_timestamp,
+    const std::function<void(const CallstackEvent&)>& action) {
+  CallstackEvent event;
+  event.set_thread_id(tid);
+  store.ForEachEventInTimeRange(min_timestamp, max_timestamp,
+                                [&event, &action](uint64_t timestamp, uint64_t callstack_id) {
+                                  event.set_time(timestamp);
+                                  event.set_callstack_id(callstack_id);
+                                  action(event);
+                                });
+}
+
+}  // namespace
+
+uint32_t CallstackData::GetCallstackEventsCount() const {
   uint32_t count = 0;
-  for (const auto& tid_and_events : callstack_events_by_tid_) {
-    count += tid_and_events.second.size();
+  for (const auto& [unused_tid, store] : GetCallstackEventStores()) {
+    count += store->size();
   }
   return count;
 }
 
 std::vector<orbit_client_protos::CallstackEvent> CallstackData::GetCallstackEventsInTimeRange(
     uint64_t time_begin, uint64_t time_end) const {
-  std::lock_guard lock(mutex_);
   std::vector<CallstackEvent> callstack_events;
-  for (const auto& tid_and_events : callstack_events_by_tid_) {
-    const std::map<uint64_t, CallstackEvent>& events = tid_and_events.second;
-    for (auto event_it = events.lower_bound(time_begin); event_it != events.end(); ++event_it) {
-      uint64_t time = event_it->first;
-      if (time < time_end) {
-        callstack_events.push_back(event_it->second);
-      } else {
-        break;
-      }
-    }
+  if (time_begin >= time_end) {
+    return callstack_events;
   }
+  ForEachCallstackEventInTimeRange(time_begin, time_end - 1,
+                                   [&callstack_events](const CallstackEvent& event) {
+                                     callstack_events.push_back(event);
+                                   });
   return callstack_events;
 }
 
 uint32_t CallstackData::GetCallstackEventsOfTidCount(int32_t thread_id) const {
-  std::lock_guard lock(mutex_);
-  const auto& tid_and_events_it = callstack_events_by_tid_.find(thread_id);
-  if (tid_and_events_it == callstack_events_by_tid_.end()) {
+  const CallstackEventStore* store = GetCallstackEventStoreOfTid(thread_id);
+  if (store == nullptr) {
     return 0;
   }
-  return tid_and_events_it->second.size();
+  return store->size();
 }
 
 std::vector<CallstackEvent> CallstackData::GetCallstackEventsOfTidInTimeRange(
     int32_t tid, uint64_t time_begin, uint64_t time_end) const {
-  std::lock_guard lock(mutex_);
   std::vector<CallstackEvent> callstack_events;
-
-  auto tid_and_events_it = callstack_events_by_tid_.find(tid);
-  if (tid_and_events_it == callstack_events_by_tid_.end()) {
+  if (time_begin >= time_end) {
     return callstack_events;
   }
-
-  const std::map<uint64_t, CallstackEvent>& events = tid_and_events_it->second;
-  for (auto event_it = events.lower_bound(time_begin); event_it != events.end(); ++event_it) {
-    uint64_t time = event_it->first;
-    if (time < time_end) {
-      callstack_events.push_back(event_it->second);
-    } else {
-      break;
-    }
-  }
+  ForEachCallstackEventOfTidInTimeRange(tid, time_begin, time_end - 1,
+                                        [&callstack_events](const CallstackEvent& event) {
+                                          callstack_events.push_back(event);
+                                        });
   return callstack_events;
 }
 
 void CallstackData::ForEachCallstackEvent(
     const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const {
-  std::lock_guard lock(mutex_);
-  for (const auto& [unused_tid, events] : callstack_events_by_tid_) {
-    for (const auto& [unused_timestamp, event] : events) {
-      action(event);
-    }
-  }
+  ForEachCallstackEventInTimeRange(0, std::numeric_limits<uint64_t>::max(), action);
 }
 
 void CallstackData::ForEachCallstackEventInTimeRange(
     uint64_t min_timestamp, uint64_t max_timestamp,
     const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const {
-  std::lock_guard lock(mutex_);
   CHECK(min_timestamp <= max_timestamp);
-  for (const auto& [unused_tid, events] : callstack_events_by_tid_) {
-    for (auto event_it = events.lower_bound(min_timestamp);
-         event_it != events.upper_bound(max_timestamp); ++event_it) {
-      action(event_it->second);
-    }
+  for (const auto& [tid, store] : GetCallstackEventStores()) {
+    ForEachCallstackEventOfStoreInTimeRange(tid, *store, min_timestamp, max_timestamp, action);
   }
 }
 
 void CallstackData::ForEachCallstackEventOfTidInTimeRange(
     int32_t tid, uint64_t min_timestamp, uint64_t max_timestamp,
     const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const {
-  std::lock_guard lock(mutex_);
   CHECK(min_timestamp <= max_timestamp);
-  const auto& tid_and_events_it = callstack_events_by_tid_.find(tid);
-  if (tid_and_events_it == callstack_events_by_tid_.end()) {
+  const CallstackEventStore* store = GetCallstackEventStoreOfTid(tid);
+  if (store == nullptr) {
+    return;
+  }
+  ForEachCallstackEventOfStoreInTimeRange(tid, *store, min_timestamp, max_timestamp, action);
+}
+
+void CallstackData::ForEachThreadCallstackEventsInParallel(
+    orbit_base::ThreadPool* thread_pool,
+    const std::function<void(int32_t thread_id, const CallstackEventStore& events)>& action)
+    const {
+  std::vector<std::pair<int32_t, const CallstackEventStore*>> stores = GetCallstackEventStores();
+  if (thread_pool == nullptr) {
+    for (const auto& [tid, store] : stores) {
+      action(tid, *store);
+    }
     return;
   }
-  const auto& events = tid_and_events_it->second;
-  for (auto event_it = events.lower_bound(min_timestamp);
-       event_it != events.upper_bound(max_timestamp); ++event_it) {
-    action(event_it->second);
+
+  std::vector<orbit_base::Future<void>> futures;
+  futures.reserve(stores.size());
+  for (const auto& [tid, store] : stores) {
+    futures.emplace_back(
+        thread_pool->Schedule([&action, tid = tid, store = store] { action(tid, *store); }));
   }
+  orbit_base::JoinFutures(absl::MakeConstSpan(futures)).Wait();
 }
 
 void CallstackData::AddCallstackFromKnownCallstackData(const CallstackEvent& event,
@@ -147,7 +190,7 @@ void CallstackData::AddCallstackFromKnownCallstackData(const CallstackEvent& eve
 
   // The insertion only happens if the hash isn't already present.
   unique_callstacks_.emplace(callstack_id, std::move(unique_callstack));
-  callstack_events_by_tid_[event.thread_id()][event.time()] = CallstackEvent(event);
+  GetOrCreateCallstackEventStoreOfTid(event.thread_id()).AddEvent(event.time(), callstack_id);
 }
 
 const orbit_client_protos::CallstackInfo* CallstackData::GetCallstack(uint64_t callstack_id) const {
@@ -193,16 +236,17 @@ void CallstackData::UpdateCallstackTypeBasedOnMajorityStart() {
 
   absl::flat_hash_set<uint64_t> callstack_ids_to_filter;
 
-  for (auto& [tid, timestamps_and_callstack_events] : callstack_events_by_tid_) {
+  for (const auto& [tid, callstack_events] : callstack_events_by_tid_) {
     uint64_t count_for_this_thread = 0;
 
     // Count the number of occurrences of each outer frame for this thread.
     absl::flat_hash_map<uint64_t, uint64_t> count_by_outer_frame;
-    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
-      const CallstackInfo& callstack = *unique_callstacks_.at(event.callstack_id());
+    callstack_events->ForEachEvent([this, &count_for_this_thread, &count_by_outer_frame](
+                                       uint64_t /*timestamp_ns*/, uint64_t callstack_id) {
+      const CallstackInfo& callstack = *unique_callstacks_.at(callstack_id);
       CHECK(callstack.type() != CallstackInfo::kFilteredByMajorityOutermostFrame);
       if (callstack.type() != CallstackInfo::kComplete) {
-        continue;
+        return;
       }
       ++count_for_this_thread;
 
@@ -210,7 +254,7 @@ void CallstackData::UpdateCallstackTypeBasedOnMajorityStart() {
       CHECK(!frames.empty());
       uint64_t outer_frame = *frames.rbegin();
       ++count_by_outer_frame[outer_frame];
-    }
+    });
 
     // Find the outer frame with the most occurrences.
     if (count_by_outer_frame.empty()) {
@@ -240,19 +284,20 @@ void CallstackData::UpdateCallstackTypeBasedOnMajorityStart() {
     // doesn't match the (super)majority outer frame.
     // Note that if a CallstackEvent from another thread references a filtered CallstackInfo, that
     // CallstackEvent will also be affected.
-    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
-      const CallstackInfo& callstack = *unique_callstacks_.at(event.callstack_id());
+    callstack_events->ForEachEvent([this, majority_outer_frame, &callstack_ids_to_filter](
+                                       uint64_t /*timestamp_ns*/, uint64_t callstack_id) {
+      const CallstackInfo& callstack = *unique_callstacks_.at(callstack_id);
       CHECK(callstack.type() != CallstackInfo::kFilteredByMajorityOutermostFrame);
       if (callstack.type() != CallstackInfo::kComplete) {
-        continue;
+        return;
       }
 
-      const auto& frames = unique_callstacks_.at(event.callstack_id())->frames();
+      const auto& frames = callstack.frames();
       CHECK(!frames.empty());
       if (*frames.rbegin() != majority_outer_frame) {
-        callstack_ids_to_filter.insert(event.callstack_id());
+        callstack_ids_to_filter.insert(callstack_id);
       }
-    }
+    });
   }
 
   // Change the type of the recorded CallstackInfos.
@@ -264,13 +309,14 @@ void CallstackData::UpdateCallstackTypeBasedOnMajorityStart() {
 
   // Count how many CallstackEvents had their CallstackInfo affected by the type change.
   uint64_t affected_event_count = 0;
-  for (auto& [tid, timestamps_and_callstack_events] : callstack_events_by_tid_) {
-    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
-      if (unique_callstacks_.at(event.callstack_id())->type() ==
-          CallstackInfo::kFilteredByMajorityOutermostFrame) {
-        ++affected_event_count;
-      }
-    }
+  for (const auto& [unused_tid, callstack_events] : callstack_events_by_tid_) {
+    callstack_events->ForEachEvent(
+        [this, &affected_event_count](uint64_t /*timestamp_ns*/, uint64_t callstack_id) {
+          if (unique_callstacks_.at(callstack_id)->type() ==
+              CallstackInfo::kFilteredByMajorityOutermostFrame) {
+            ++affected_event_count;
+          }
+        });
   }
 
   uint32_t callstack_event_count = GetCallstackEventsCount();
@@ -7,10 +7,14 @@
 
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <tuple>
 #include <vector>
 
 #include "ClientData/CallstackData.h"
+#include "OrbitBase/ThreadPool.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "capture_data.pb.h"
 
 using orbit_client_protos::CallstackEvent;
@@ -162,4 +166,55 @@ TEST(CallstackData, FilterCallstackEventsBasedOnMajorityStart) {
       testing::Pointwise(CallstackEventEq(), std::vector<CallstackEvent>{event8, event9, event10}));
 }
 
+TEST(CallstackData, ForEachThreadCallstackEventsInParallel) {
+  CallstackData callstack_data;
+
+  const uint64_t cs_id = 12;
+  CallstackInfo cs;
+  cs.add_frames(0x11);
+  cs.add_frames(0x10);
+  cs.set_type(CallstackInfo::kComplete);
+  callstack_data.AddUniqueCallstack(cs_id, cs);
+
+  constexpr int32_t kThreadCount = 20;
+  constexpr int32_t kFirstTid = 42;
+  for (int32_t tid = kFirstTid; tid < kFirstTid + kThreadCount; ++tid) {
+    for (int32_t event_index = 0; event_index <= tid - kFirstTid; ++event_index) {
+      CallstackEvent event;
+      event.set_time(1000 * tid + event_index);
+      event.set_thread_id(tid);
+      event.set_callstack_id(cs_id);
+      callstack_data.AddCallstackEvent(event);
+    }
+  }
+
+  auto count_events_by_tid = [&callstack_data](orbit_base::ThreadPool* thread_pool) {
+    absl::Mutex mutex;
+    absl::flat_hash_map<int32_t, size_t> tid_to_event_count;
+    callstack_data.ForEachThreadCallstackEventsInParallel(
+        thread_pool,
+        [&mutex, &tid_to_event_count](int32_t tid, const CallstackEventStore& events) {
+          events.ForEachEvent([tid](uint64_t timestamp, uint64_t /*callstack_id*/) {
+            EXPECT_EQ(timestamp / 1000, tid);
+          });
+          absl::MutexLock lock(&mutex);
+          EXPECT_TRUE(tid_to_event_count.emplace(tid, events.size()).second);
+        });
+    return tid_to_event_count;
+  };
+
+  absl::flat_hash_map<int32_t, size_t> expected_tid_to_event_count;
+  for (int32_t tid = kFirstTid; tid < kFirstTid + kThreadCount; ++tid) {
+    expected_tid_to_event_count.emplace(tid, tid - kFirstTid + 1);
+  }
+
+  EXPECT_EQ(count_events_by_tid(nullptr), expected_tid_to_event_count);
+
+  std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+      orbit_base::ThreadPool::Create(/*thread_pool_min_size=*/4, /*thread_pool_max_size=*/4,
+                                     /*thread_ttl=*/absl::Seconds(1));
+  EXPECT_EQ(count_events_by_tid(thread_pool.get()), expected_tid_to_event_count);
+  thread_pool->ShutdownAndWait();
+}
+
 }  // namespace orbit_client_data
@@ -0,0 +1,89 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/CallstackEventStore.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace orbit_client_data {
+
+void CallstackEventStore::AddEvent(uint64_t timestamp, uint64_t callstack_id) {
+  absl::MutexLock lock(&mutex_);
+  if (chunks_.empty()) {
+    AppendEvent(timestamp, callstack_id);
+    return;
+  }
+  const Chunk& last_chunk = *chunks_.back();
+  if (timestamp > last_chunk.timestamps[last_chunk.size - 1]) {
+    AppendEvent(timestamp, callstack_id);
+  } else {
+    InsertEventOutOfOrder(timestamp, callstack_id);
+  }
+}
+
+void CallstackEventStore::AppendEvent(uint64_t timestamp, uint64_t callstack_id) {
+  if (chunks_.empty() || chunks_.back()->size == chunks_.back()->capacity) {
+    chunks_.push_back(std::make_shared<Chunk>(kChunkSize));
+  }
+  Chunk& chunk = *chunks_.back();
+  chunk.timestamps[chunk.size] = timestamp;
+  chunk.callstack_ids[chunk.size] = callstack_id;
+  ++chunk.size;
+  ++size_;
+}
+
+void CallstackEventStore::InsertEventOutOfOrder(uint64_t timestamp, uint64_t callstack_id) {
+  // The event belongs to the last chunk that starts at or before it, or to the first chunk.
+  auto chunk_it = std::upper_bound(chunks_.begin(), chunks_.end(), timestamp,
+                                   [](uint64_t timestamp, const std::shared_ptr<Chunk>& chunk) {
+                                     return timestamp < chunk->timestamps[0];
+                                   });
+  if (chunk_it != chunks_.begin()) --chunk_it;
+  const Chunk& old_chunk = **chunk_it;
+  const uint64_t* old_timestamps = old_chunk.timestamps.get();
+  const uint64_t* old_callstack_ids = old_chunk.callstack_ids.get();
+  const size_t old_size = old_chunk.size;
+
+  const size_t index =
+      std::lower_bound(old_timestamps, old_timestamps + old_size, timestamp) - old_timestamps;
+  const bool replaces_event = index < old_size && old_timestamps[index] == timestamp;
+
+  // If the old chunk was full, the new one is full as well, so that events are appended to a new
+  // chunk after it.
+  const size_t new_size = replaces_event ? old_size : old_size + 1;
+  auto new_chunk = std::make_shared<Chunk>(std::max(old_chunk.capacity, new_size));
+  uint64_t* new_timestamps = new_chunk->timestamps.get();
+  uint64_t* new_callstack_ids = new_chunk->callstack_ids.get();
+  std::copy(old_timestamps, old_timestamps + index, new_timestamps);
+  std::copy(old_callstack_ids, old_callstack_ids + index, new_callstack_ids);
+  new_timestamps[index] = timestamp;
+  new_callstack_ids[index] = callstack_id;
+  const size_t old_tail_begin = replaces_event ? index + 1 : index;
+  std::copy(old_timestamps + old_tail_begin, old_timestamps + old_size,
+            new_timestamps + index + 1);
+  std::copy(old_callstack_ids + old_tail_begin, old_callstack_ids + old_size,
+            new_callstack_ids + index + 1);
+  new_chunk->size = new_size;
+
+  if (!replaces_event) ++size_;
+  *chunk_it = std::move(new_chunk);
+}
+
+absl::InlinedVector<CallstackEventStore::ChunkSnapshot, 2> CallstackEventStore::GetChunkSnapshots(
+    uint64_t min_timestamp, uint64_t max_timestamp) const {
+  absl::MutexLock lock(&mutex_);
+  // Skip the chunks that end before `min_timestamp`.
+  auto chunk_it = std::partition_point(
+      chunks_.begin(), chunks_.end(), [min_timestamp](const std::shared_ptr<Chunk>& chunk) {
+        return chunk->timestamps[chunk->size - 1] < min_timestamp;
+      });
+  absl::InlinedVector<ChunkSnapshot, 2> snapshots;
+  for (; chunk_it != chunks_.end() && (*chunk_it)->timestamps[0] <= max_timestamp; ++chunk_it) {
+    snapshots.push_back({*chunk_it, (*chunk_it)->size});
+  }
+  return snapshots;
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,123 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "ClientData/CallstackEventStore.h"
+
+namespace orbit_client_data {
+
+namespace {
+
+std::vector<std::pair<uint64_t, uint64_t>> GetEventsInTimeRange(const CallstackEventStore& store,
+                                                                 uint64_t min_timestamp,
+                                                                 uint64_t max_timestamp) {
+  std::vector<std::pair<uint64_t, uint64_t>> events;
+  store.ForEachEventInTimeRange(min_timestamp, max_timestamp,
+                                [&events](uint64_t timestamp, uint64_t callstack_id) {
+                                  events.emplace_back(timestamp, callstack_id);
+                                });
+  return events;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> GetAllEvents(const CallstackEventStore& store) {
+  return GetEventsInTimeRange(store, 0, std::numeric_limits<uint64_t>::max());
+}
+
+}  // namespace
+
+TEST(CallstackEventStore, Empty) {
+  CallstackEventStore store;
+  EXPECT_EQ(store.size(), 0);
+  EXPECT_THAT(GetAllEvents(store), testing::IsEmpty());
+}
+
+TEST(CallstackEventStore, RangeQueriesAcrossChunks) {
+  CallstackEventStore store;
+  constexpr uint64_t kEventCount = 3 * CallstackEventStore::kChunkSize + 10;
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    store.AddEvent(10 * i, i % 7);
+  }
+  EXPECT_EQ(store.size(), kEventCount);
+
+  std::vector<std::pair<uint64_t, uint64_t>> all_events = GetAllEvents(store);
+  ASSERT_EQ(all_events.size(), kEventCount);
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    EXPECT_EQ(all_events[i], std::make_pair(10 * i, i % 7));
+  }
+
+  // Both bounds are inclusive, and the range spans a chunk boundary.
+  constexpr uint64_t kFirst = CallstackEventStore::kChunkSize - 2;
+  std::vector<std::pair<uint64_t, uint64_t>> events =
+      GetEventsInTimeRange(store, 10 * kFirst, 10 * (kFirst + 4));
+  ASSERT_EQ(events.size(), 5);
+  for (uint64_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(events[i].first, 10 * (kFirst + i));
+  }
+
+  EXPECT_THAT(GetEventsInTimeRange(store, 11, 19), testing::IsEmpty());
+  EXPECT_THAT(GetEventsInTimeRange(store, 10 * kEventCount, 20 * kEventCount), testing::IsEmpty());
+  EXPECT_THAT(GetEventsInTimeRange(store, 20, 10), testing::IsEmpty());
+}
+
+TEST(CallstackEventStore, OutOfOrderAndDuplicateEvents) {
+  CallstackEventStore store;
+  constexpr uint64_t kEventCount = 2 * CallstackEventStore::kChunkSize;
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    store.AddEvent(10 * i + 10, 1);
+  }
+
+  // Into the first, full chunk, before all events and in the middle.
+  store.AddEvent(5, 2);
+  store.AddEvent(15, 3);
+  // Into the last chunk, which is full as well.
+  store.AddEvent(10 * kEventCount - 5, 4);
+  // Replaces an existing event.
+  store.AddEvent(30, 5);
+  // Appended to a new chunk.
+  store.AddEvent(10 * kEventCount + 20, 6);
+  EXPECT_EQ(store.size(), kEventCount + 4);
+
+  std::vector<std::pair<uint64_t, uint64_t>> events = GetAllEvents(store);
+  ASSERT_EQ(events.size(), kEventCount + 4);
+  for (size_t i = 1; i < events.size(); ++i) {
+    EXPECT_LT(events[i - 1].first, events[i].first);
+  }
+  EXPECT_EQ(events[0], std::make_pair(uint64_t{5}, uint64_t{2}));
+  EXPECT_EQ(events[2], std::make_pair(uint64_t{15}, uint64_t{3}));
+  EXPECT_EQ(events[4], std::make_pair(uint64_t{30}, uint64_t{5}));
+  EXPECT_EQ(events[events.size() - 3], std::make_pair(10 * kEventCount - 5, uint64_t{4}));
+  EXPECT_EQ(events.back(), std::make_pair(10 * kEventCount + 20, uint64_t{6}));
+
+  EXPECT_THAT(GetEventsInTimeRange(store, 11, 29),
+              testing::ElementsAre(std::make_pair(uint64_t{15}, uint64_t{3}),
+                                   std::make_pair(uint64_t{20}, uint64_t{1})));
+}
+
+TEST(CallstackEventStore, EventsCanBeAddedWhileIterating) {
+  CallstackEventStore store;
+  for (uint64_t i = 0; i < CallstackEventStore::kChunkSize; ++i) {
+    store.AddEvent(i, 1);
+  }
+
+  uint64_t visited_count = 0;
+  store.ForEachEvent([&store, &visited_count](uint64_t timestamp, uint64_t /*callstack_id*/) {
+    ++visited_count;
+    store.AddEvent(CallstackEventStore::kChunkSize + timestamp, 2);
+    store.AddEvent(timestamp, 3);
+  });
+  EXPECT_EQ(visited_count, CallstackEventStore::kChunkSize);
+  EXPECT_EQ(store.size(), 2 * CallstackEventStore::kChunkSize);
+  for (const auto& [timestamp, callstack_id] : GetAllEvents(store)) {
+    EXPECT_EQ(callstack_id, timestamp < CallstackEventStore::kChunkSize ? 3 : 2);
+  }
+}
+
+}  // namespace orbit_client_data
@@ -18,7 +18,6 @@
 using orbit_client_protos::FunctionInfo;
 using orbit_client_protos::FunctionStats;
 using orbit_client_protos::LinuxAddressInfo;
-using orbit_client_protos::ThreadStateSliceInfo;
 
 using orbit_grpc_protos::CaptureStarted;
 using orbit_grpc_protos::InstrumentedFunction;
@@ -50,27 +49,13 @@ CaptureData::CaptureData(ModuleManager* module_manager, const CaptureStarted& ca
   }
 }
 
-void CaptureData::ForEachThreadStateSliceIntersectingTimeRange(
-    int32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp,
-    const std::function<void(const ThreadStateSliceInfo&)>& action) const {
+const ThreadStateSliceStore* CaptureData::FindThreadStateSliceStore(int32_t thread_id) const {
   absl::MutexLock lock{&thread_state_slices_mutex_};
   auto tid_thread_state_slices_it = thread_state_slices_.find(thread_id);
   if (tid_thread_state_slices_it == thread_state_slices_.end()) {
-    return;
-  }
-
-  const std::vector<ThreadStateSliceInfo>& tid_thread_state_slices =
-      tid_thread_state_slices_it->second;
-  auto slice_it = std::lower_bound(tid_thread_state_slices.begin(), tid_thread_state_slices.end(),
-                                   min_timestamp,
-                                   [](const ThreadStateSliceInfo& slice, uint64_t min_timestamp) {
-                                     return slice.end_timestamp_ns() < min_timestamp;
-                                   });
-  while (slice_it != tid_thread_state_slices.end() &&
-         slice_it->begin_timestamp_ns() < max_timestamp) {
-    action(*slice_it);
-    ++slice_it;
+    return nullptr;
   }
+  return tid_thread_state_slices_it->second.get();
 }
 
 const FunctionStats& CaptureData::GetFunctionStatsOrDefault(
@@ -103,6 +88,17 @@ void CaptureData::UpdateFunctionStats(uint64_t instrumented_function_id, uint64_
   if (stats.min_ns() == 0 || elapsed_nanos < stats.min_ns()) {
     stats.set_min_ns(elapsed_nanos);
   }
+
+  absl::MutexLock lock{&function_histograms_mutex_};
+  function_histograms_[instrumented_function_id].Add(elapsed_nanos);
+}
+
+uint64_t CaptureData::GetFunctionDurationPercentile(uint64_t instrumented_function_id,
+                                                    double percentile) const {
+  absl::MutexLock lock{&function_histograms_mutex_};
+  auto it = function_histograms_.find(instrumented_function_id);
+  if (it == function_histograms_.end()) return 0;
+  return it->second.GetPercentile(percentile);
 }
 
 void CaptureData::OnCaptureComplete(
@@ -164,6 +160,7 @@ std::optional<uint64_t> CaptureData::FindInstrumentedFunctionIdSlow(
 }
 
 const LinuxAddressInfo* CaptureData::GetAddressInfo(uint64_t absolute_address) const {
+  absl::MutexLock lock{&address_infos_mutex_};
   auto address_info_it = address_infos_.find(absolute_address);
   if (address_info_it == address_infos_.end()) {
     return nullptr;
@@ -174,6 +171,7 @@ const LinuxAddressInfo* CaptureData::GetAddressInfo(uint64_t absolute_address) c
 void CaptureData::InsertAddressInfo(LinuxAddressInfo address_info) {
   const uint64_t absolute_address = address_info.absolute_address();
   const uint64_t absolute_function_address = absolute_address - address_info.offset_in_function();
+  absl::MutexLock lock{&address_infos_mutex_};
   // Ensure we know the symbols also for the resolved function address;
   if (!address_infos_.contains(absolute_function_address)) {
     LinuxAddressInfo function_info;
@@ -192,12 +190,11 @@ const std::string& CaptureData::GetFunctionNameByAddress(uint64_t absolute_addre
   if (function != nullptr) {
     return orbit_client_data::function_utils::GetDisplayName(*function);
   }
-  const auto address_info_it = address_infos_.find(absolute_address);
-  if (address_info_it == address_infos_.end()) {
+  const LinuxAddressInfo* address_info = GetAddressInfo(absolute_address);
+  if (address_info == nullptr) {
     return kUnknownFunctionOrModuleName;
   }
-  const LinuxAddressInfo& address_info = address_info_it->second;
-  const std::string& function_name = address_info.function_name();
+  const std::string& function_name = address_info->function_name();
   if (function_name.empty()) {
     return kUnknownFunctionOrModuleName;
   }
@@ -276,12 +273,11 @@ const std::string& CaptureData::GetModulePathByAddress(uint64_t absolute_address
   if (module_data != nullptr) {
     return module_data->file_path();
   }
-  const auto address_info_it = address_infos_.find(absolute_address);
-  if (address_info_it == address_infos_.end()) {
+  const LinuxAddressInfo* address_info = GetAddressInfo(absolute_address);
+  if (address_info == nullptr) {
     return kUnknownFunctionOrModuleName;
   }
-  const LinuxAddressInfo& address_info = address_info_it->second;
-  const std::string& module_path = address_info.module_path();
+  const std::string& module_path = address_info->module_path();
   if (module_path.empty()) {
     return kUnknownFunctionOrModuleName;
   }
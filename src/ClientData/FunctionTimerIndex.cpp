@@ -0,0 +1,86 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/FunctionTimerIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+using orbit_client_protos::TimerInfo;
+
+namespace orbit_client_data {
+
+namespace {
+
+[[nodiscard]] bool IsEndTimeLessThan(const TimerInfo* timer_info, uint64_t time) {
+  return timer_info->end() < time;
+}
+
+[[nodiscard]] bool IsTimeLessThanEndTime(uint64_t time, const TimerInfo* timer_info) {
+  return time < timer_info->end();
+}
+
+void InsertSortedByEndTime(const TimerInfo* timer_info, std::vector<const TimerInfo*>* timers) {
+  if (timers->empty() || timers->back()->end() <= timer_info->end()) {
+    timers->push_back(timer_info);
+    return;
+  }
+  timers->insert(
+      std::upper_bound(timers->begin(), timers->end(), timer_info->end(), IsTimeLessThanEndTime),
+      timer_info);
+}
+
+}  // namespace
+
+void FunctionTimerIndex::Add(const TimerInfo& timer_info) {
+  absl::MutexLock lock(&mutex_);
+  InsertSortedByEndTime(&timer_info, &timers_by_function_id_[timer_info.function_id()]);
+  InsertSortedByEndTime(&timer_info, &timers_by_function_id_and_thread_id_[std::make_pair(
+                                         timer_info.function_id(), timer_info.thread_id())]);
+}
+
+const FunctionTimerIndex::SortedTimers* FunctionTimerIndex::GetSortedTimers(
+    uint64_t function_id, std::optional<int32_t> thread_id) const {
+  if (thread_id.has_value()) {
+    auto it = timers_by_function_id_and_thread_id_.find(
+        std::make_pair(function_id, thread_id.value()));
+    return it != timers_by_function_id_and_thread_id_.end() ? &it->second : nullptr;
+  }
+  auto it = timers_by_function_id_.find(function_id);
+  return it != timers_by_function_id_.end() ? &it->second : nullptr;
+}
+
+const TimerInfo* FunctionTimerIndex::FindNext(uint64_t function_id, uint64_t time,
+                                              std::optional<int32_t> thread_id) const {
+  absl::MutexLock lock(&mutex_);
+  const SortedTimers* timers = GetSortedTimers(function_id, thread_id);
+  if (timers == nullptr) return nullptr;
+
+  auto it = std::upper_bound(timers->begin(), timers->end(), time, IsTimeLessThanEndTime);
+  return it != timers->end() ? *it : nullptr;
+}
+
+const TimerInfo* FunctionTimerIndex::FindPrevious(uint64_t function_id, uint64_t time,
+                                                  std::optional<int32_t> thread_id) const {
+  absl::MutexLock lock(&mutex_);
+  const SortedTimers* timers = GetSortedTimers(function_id, thread_id);
+  if (timers == nullptr) return nullptr;
+
+  auto it = std::lower_bound(timers->begin(), timers->end(), time, IsEndTimeLessThan);
+  return it != timers->begin() ? *std::prev(it) : nullptr;
+}
+
+std::vector<const TimerInfo*> FunctionTimerIndex::GetTimers(uint64_t function_id,
+                                                            uint64_t min_end_time,
+                                                            uint64_t max_end_time) const {
+  absl::MutexLock lock(&mutex_);
+  const SortedTimers* timers = GetSortedTimers(function_id, std::nullopt);
+  if (timers == nullptr || min_end_time > max_end_time) return {};
+
+  auto begin = std::lower_bound(timers->begin(), timers->end(), min_end_time, IsEndTimeLessThan);
+  auto end = std::upper_bound(begin, timers->end(), max_end_time, IsTimeLessThanEndTime);
+  return {begin, end};
+}
+
+}  // namespace orbit_client_data
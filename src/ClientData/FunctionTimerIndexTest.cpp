@@ -0,0 +1,82 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ClientData/FunctionTimerIndex.h"
+#include "ClientData/TimerChain.h"
+#include "capture_data.pb.h"
+
+using orbit_client_protos::TimerInfo;
+
+namespace orbit_client_data {
+
+namespace {
+
+constexpr uint64_t kFunctionId = 1;
+constexpr uint64_t kOtherFunctionId = 2;
+constexpr int32_t kThreadId = 10;
+constexpr int32_t kOtherThreadId = 11;
+
+const TimerInfo& AddTimer(uint64_t function_id, int32_t thread_id, uint64_t start, uint64_t end,
+                          TimerChain* chain, FunctionTimerIndex* index) {
+  TimerInfo timer;
+  timer.set_function_id(function_id);
+  timer.set_thread_id(thread_id);
+  timer.set_start(start);
+  timer.set_end(end);
+  const TimerInfo& stored_timer = chain->emplace_back(timer);
+  index->Add(stored_timer);
+  return stored_timer;
+}
+
+}  // namespace
+
+TEST(FunctionTimerIndex, FindNextAndPrevious) {
+  TimerChain chain;
+  FunctionTimerIndex index;
+  const TimerInfo& first = AddTimer(kFunctionId, kThreadId, 0, 10, &chain, &index);
+  const TimerInfo& other_thread = AddTimer(kFunctionId, kOtherThreadId, 15, 30, &chain, &index);
+  AddTimer(kOtherFunctionId, kThreadId, 12, 25, &chain, &index);
+  // Added out of order.
+  const TimerInfo& second = AddTimer(kFunctionId, kThreadId, 12, 20, &chain, &index);
+
+  EXPECT_EQ(index.FindNext(kFunctionId, 0), &first);
+  EXPECT_EQ(index.FindNext(kFunctionId, 10), &second);
+  EXPECT_EQ(index.FindNext(kFunctionId, 20), &other_thread);
+  EXPECT_EQ(index.FindNext(kFunctionId, 20, kThreadId), nullptr);
+  EXPECT_EQ(index.FindNext(kFunctionId, 30), nullptr);
+
+  EXPECT_EQ(index.FindPrevious(kFunctionId, std::numeric_limits<uint64_t>::max()), &other_thread);
+  EXPECT_EQ(index.FindPrevious(kFunctionId, 30), &second);
+  EXPECT_EQ(index.FindPrevious(kFunctionId, 30, kOtherThreadId), nullptr);
+  EXPECT_EQ(index.FindPrevious(kFunctionId, 20), &first);
+  EXPECT_EQ(index.FindPrevious(kFunctionId, 10), nullptr);
+
+  EXPECT_EQ(index.FindNext(3, 0), nullptr);
+  EXPECT_EQ(index.FindPrevious(3, 100), nullptr);
+}
+
+TEST(FunctionTimerIndex, GetTimers) {
+  TimerChain chain;
+  FunctionTimerIndex index;
+  std::vector<const TimerInfo*> expected;
+  for (uint64_t i = 0; i < 100; ++i) {
+    const auto thread_id = static_cast<int32_t>(i % 3);
+    expected.push_back(&AddTimer(kFunctionId, thread_id, 10 * i, 10 * i + 5, &chain, &index));
+    AddTimer(kOtherFunctionId, thread_id, 10 * i, 10 * i + 5, &chain, &index);
+  }
+
+  EXPECT_EQ(index.GetTimers(kFunctionId), expected);
+  EXPECT_EQ(index.GetTimers(kFunctionId, 15, 35),
+            (std::vector<const TimerInfo*>{expected[1], expected[2], expected[3]}));
+  EXPECT_TRUE(index.GetTimers(kFunctionId, 16, 24).empty());
+  EXPECT_TRUE(index.GetTimers(3).empty());
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,108 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_client_data {
+
+namespace {
+
+constexpr uint32_t kSubBucketBits = 5;
+constexpr uint64_t kSubBucketCount = 1 << kSubBucketBits;
+
+[[nodiscard]] uint32_t GetIndexOfMostSignificantBit(uint64_t value) {
+  uint32_t index = 0;
+  for (uint32_t shift = 32; shift > 0; shift /= 2) {
+    if (value >> shift != 0) {
+      value >>= shift;
+      index += shift;
+    }
+  }
+  return index;
+}
+
+}  // namespace
+
+// Values below 2 * kSubBucketCount are their own bucket. Larger values with the most significant
+// bit at index kSubBucketBits + shift are bucketed by their kSubBucketBits + 1 most significant
+// bits, `value >> shift`, which is in [kSubBucketCount, 2 * kSubBucketCount).
+size_t LatencyHistogram::GetBucketIndex(uint64_t value) {
+  if (value < 2 * kSubBucketCount) return value;
+  const uint32_t shift = GetIndexOfMostSignificantBit(value) - kSubBucketBits;
+  return kSubBucketCount * shift + (value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketLowerBound(size_t bucket_index) {
+  if (bucket_index < 2 * kSubBucketCount) return bucket_index;
+  const uint64_t shift = bucket_index / kSubBucketCount - 1;
+  const uint64_t sub_bucket = bucket_index - kSubBucketCount * shift;
+  return sub_bucket << shift;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket_index) {
+  if (bucket_index < 2 * kSubBucketCount) return bucket_index;
+  const uint64_t shift = bucket_index / kSubBucketCount - 1;
+  const uint64_t sub_bucket = bucket_index - kSubBucketCount * shift;
+  // For the last bucket, the shift overflows to 0, which yields the maximum uint64_t as intended.
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::AddToBucket(size_t bucket_index, uint64_t count) {
+  if (counts_.empty()) {
+    first_bucket_index_ = bucket_index;
+    counts_.push_back(count);
+    return;
+  }
+  if (bucket_index < first_bucket_index_) {
+    counts_.insert(counts_.begin(), first_bucket_index_ - bucket_index, 0);
+    first_bucket_index_ = bucket_index;
+  } else if (bucket_index >= first_bucket_index_ + counts_.size()) {
+    counts_.resize(bucket_index - first_bucket_index_ + 1, 0);
+  }
+  counts_[bucket_index - first_bucket_index_] += count;
+}
+
+void LatencyHistogram::Add(uint64_t value) {
+  AddToBucket(GetBucketIndex(value), 1);
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  if (other.count_ == 0) return;
+  // Add the outermost buckets first, so that the storage is resized at most twice.
+  AddToBucket(other.first_bucket_index_, 0);
+  AddToBucket(other.first_bucket_index_ + other.counts_.size() - 1, 0);
+  for (size_t i = 0; i < other.counts_.size(); ++i) {
+    counts_[other.first_bucket_index_ + i - first_bucket_index_] += other.counts_[i];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+  CHECK(percentile >= 0 && percentile <= 100);
+  if (count_ == 0) return 0;
+
+  const auto rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100 * static_cast<double>(count_))));
+  uint64_t cumulative_count = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    cumulative_count += counts_[i];
+    if (cumulative_count >= rank) {
+      const uint64_t value = GetBucketUpperBound(first_bucket_index_ + i);
+      return std::clamp(value, min_, max_);
+    }
+  }
+  return max_;
+}
+
+}  // namespace orbit_client_data
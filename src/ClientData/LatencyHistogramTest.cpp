@@ -0,0 +1,80 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "ClientData/LatencyHistogram.h"
+
+namespace orbit_client_data {
+
+TEST(LatencyHistogram, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.GetPercentile(50), 0);
+}
+
+TEST(LatencyHistogram, BucketsCoverAllValues) {
+  EXPECT_EQ(LatencyHistogram::GetBucketIndex(0), 0);
+  EXPECT_EQ(LatencyHistogram::GetBucketIndex(63), 63);
+
+  uint64_t previous_upper_bound = 63;
+  for (size_t index = 64; previous_upper_bound != std::numeric_limits<uint64_t>::max(); ++index) {
+    const uint64_t lower_bound = LatencyHistogram::GetBucketLowerBound(index);
+    const uint64_t upper_bound = LatencyHistogram::GetBucketUpperBound(index);
+    ASSERT_EQ(lower_bound, previous_upper_bound + 1);
+    ASSERT_GE(upper_bound, lower_bound);
+    // The width of a bucket is at most 1/32 of its values.
+    ASSERT_LE(upper_bound - lower_bound, lower_bound / 32);
+    EXPECT_EQ(LatencyHistogram::GetBucketIndex(lower_bound), index);
+    EXPECT_EQ(LatencyHistogram::GetBucketIndex(upper_bound), index);
+    previous_upper_bound = upper_bound;
+  }
+}
+
+TEST(LatencyHistogram, Percentiles) {
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.Add(value * 1000);
+  }
+  EXPECT_EQ(histogram.count(), 1000);
+  EXPECT_EQ(histogram.min(), 1000);
+  EXPECT_EQ(histogram.max(), 1'000'000);
+  EXPECT_EQ(histogram.GetPercentile(100), 1'000'000);
+
+  for (double percentile : {0., 1., 25., 50., 90., 95., 99., 99.9}) {
+    const double expected = std::max(percentile * 10'000, 1000.);
+    const auto actual = static_cast<double>(histogram.GetPercentile(percentile));
+    EXPECT_GE(actual, expected);
+    EXPECT_LE(actual, expected * (1 + 1. / 32));
+  }
+}
+
+TEST(LatencyHistogram, Merge) {
+  LatencyHistogram low;
+  LatencyHistogram high;
+  LatencyHistogram all;
+  for (uint64_t value = 0; value < 500; ++value) {
+    low.Add(value);
+    all.Add(value);
+    high.Add(1'000'000 + value);
+    all.Add(1'000'000 + value);
+  }
+
+  LatencyHistogram merged;
+  merged.Merge(high);
+  merged.Merge(LatencyHistogram{});
+  merged.Merge(low);
+  EXPECT_EQ(merged.count(), all.count());
+  EXPECT_EQ(merged.min(), 0);
+  EXPECT_EQ(merged.max(), 1'000'499);
+  for (double percentile : {0., 10., 49.9, 50., 50.1, 75., 100.}) {
+    EXPECT_EQ(merged.GetPercentile(percentile), all.GetPercentile(percentile));
+  }
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,42 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/ThreadStateSliceStore.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace orbit_client_data {
+
+void ThreadStateSliceStore::AddSlice(uint64_t begin_timestamp_ns, uint64_t end_timestamp_ns,
+                                     ThreadState state) {
+  absl::MutexLock lock(&mutex_);
+  if (chunks_.empty() || chunks_.back()->size == kChunkSize) {
+    chunks_.push_back(std::make_unique<Chunk>());
+  }
+  Chunk& chunk = *chunks_.back();
+  chunk.begin_timestamps_ns[chunk.size] = begin_timestamp_ns;
+  chunk.end_timestamps_ns[chunk.size] = end_timestamp_ns;
+  chunk.states[chunk.size] = static_cast<uint8_t>(state);
+  ++chunk.size;
+  ++size_;
+}
+
+absl::InlinedVector<ThreadStateSliceStore::ChunkSnapshot, 2>
+ThreadStateSliceStore::GetChunkSnapshots(uint64_t min_timestamp, uint64_t max_timestamp) const {
+  absl::MutexLock lock(&mutex_);
+  // Skip the chunks that end before `min_timestamp`.
+  auto chunk_it = std::partition_point(
+      chunks_.begin(), chunks_.end(), [min_timestamp](const std::unique_ptr<Chunk>& chunk) {
+        return chunk->end_timestamps_ns[chunk->size - 1] < min_timestamp;
+      });
+  absl::InlinedVector<ChunkSnapshot, 2> snapshots;
+  for (; chunk_it != chunks_.end() && (*chunk_it)->begin_timestamps_ns[0] < max_timestamp;
+       ++chunk_it) {
+    snapshots.push_back({chunk_it->get(), (*chunk_it)->size});
+  }
+  return snapshots;
+}
+
+}  // namespace orbit_client_data
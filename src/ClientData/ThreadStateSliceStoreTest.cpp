@@ -0,0 +1,134 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include "ClientData/ThreadStateSliceStore.h"
+#include "capture_data.pb.h"
+
+using orbit_client_protos::ThreadStateSliceInfo;
+
+namespace orbit_client_data {
+
+namespace {
+
+using Slice = std::tuple<uint64_t, uint64_t, ThreadStateSliceStore::ThreadState>;
+
+std::vector<Slice> GetSlicesInTimeRange(const ThreadStateSliceStore& store, uint64_t min_timestamp,
+                                        uint64_t max_timestamp) {
+  std::vector<Slice> slices;
+  store.ForEachSliceIntersectingTimeRange(
+      min_timestamp, max_timestamp,
+      [&slices](uint64_t begin_timestamp_ns, uint64_t end_timestamp_ns,
+                ThreadStateSliceStore::ThreadState state) -> uint64_t {
+        slices.emplace_back(begin_timestamp_ns, end_timestamp_ns, state);
+        return 0;
+      });
+  return slices;
+}
+
+std::vector<Slice> GetAllSlices(const ThreadStateSliceStore& store) {
+  return GetSlicesInTimeRange(store, 0, std::numeric_limits<uint64_t>::max());
+}
+
+// Adds contiguous slices [10 * i, 10 * (i + 1)) for i in [0, count), alternating between running
+// and runnable.
+void AddContiguousSlices(ThreadStateSliceStore* store, uint64_t count) {
+  for (uint64_t i = 0; i < count; ++i) {
+    store->AddSlice(10 * i, 10 * (i + 1),
+                    i % 2 == 0 ? ThreadStateSliceInfo::kRunning : ThreadStateSliceInfo::kRunnable);
+  }
+}
+
+}  // namespace
+
+TEST(ThreadStateSliceStore, Empty) {
+  ThreadStateSliceStore store;
+  EXPECT_EQ(store.size(), 0);
+  EXPECT_THAT(GetAllSlices(store), testing::IsEmpty());
+}
+
+TEST(ThreadStateSliceStore, AddSliceKeepsAllFields) {
+  ThreadStateSliceStore store;
+  store.AddSlice(1, 5, ThreadStateSliceInfo::kUninterruptibleSleep);
+  store.AddSlice(5, 7, ThreadStateSliceInfo::kIdle);
+  store.AddSlice(9, 12, ThreadStateSliceInfo::kRunning);
+
+  EXPECT_EQ(store.size(), 3);
+  EXPECT_THAT(GetAllSlices(store),
+              testing::ElementsAre(Slice{1, 5, ThreadStateSliceInfo::kUninterruptibleSleep},
+                                   Slice{5, 7, ThreadStateSliceInfo::kIdle},
+                                   Slice{9, 12, ThreadStateSliceInfo::kRunning}));
+}
+
+TEST(ThreadStateSliceStore, ForEachSliceIntersectingTimeRange) {
+  ThreadStateSliceStore store;
+  store.AddSlice(10, 20, ThreadStateSliceInfo::kRunning);
+  store.AddSlice(20, 30, ThreadStateSliceInfo::kRunnable);
+  store.AddSlice(40, 50, ThreadStateSliceInfo::kRunning);
+
+  EXPECT_THAT(GetSlicesInTimeRange(store, 0, 10), testing::IsEmpty());
+  EXPECT_THAT(GetSlicesInTimeRange(store, 0, 11),
+              testing::ElementsAre(Slice{10, 20, ThreadStateSliceInfo::kRunning}));
+  EXPECT_THAT(GetSlicesInTimeRange(store, 20, 25),
+              testing::ElementsAre(Slice{10, 20, ThreadStateSliceInfo::kRunning},
+                                   Slice{20, 30, ThreadStateSliceInfo::kRunnable}));
+  EXPECT_THAT(GetSlicesInTimeRange(store, 31, 39), testing::IsEmpty());
+  EXPECT_THAT(GetSlicesInTimeRange(store, 25, 45),
+              testing::ElementsAre(Slice{20, 30, ThreadStateSliceInfo::kRunnable},
+                                   Slice{40, 50, ThreadStateSliceInfo::kRunning}));
+  EXPECT_THAT(GetSlicesInTimeRange(store, 51, 100), testing::IsEmpty());
+}
+
+TEST(ThreadStateSliceStore, ForEachSliceIntersectingTimeRangeAcrossChunks) {
+  ThreadStateSliceStore store;
+  constexpr uint64_t kSliceCount = 3 * ThreadStateSliceStore::kChunkSize + 5;
+  AddContiguousSlices(&store, kSliceCount);
+  EXPECT_EQ(store.size(), kSliceCount);
+  EXPECT_EQ(GetAllSlices(store).size(), kSliceCount);
+
+  constexpr uint64_t kFirstIndex = ThreadStateSliceStore::kChunkSize - 2;
+  constexpr uint64_t kLastIndex = 2 * ThreadStateSliceStore::kChunkSize + 1;
+  std::vector<Slice> slices =
+      GetSlicesInTimeRange(store, 10 * kFirstIndex + 5, 10 * kLastIndex + 5);
+  ASSERT_EQ(slices.size(), kLastIndex - kFirstIndex + 1);
+  for (uint64_t i = 0; i < slices.size(); ++i) {
+    const uint64_t index = kFirstIndex + i;
+    EXPECT_EQ(std::get<0>(slices[i]), 10 * index);
+    EXPECT_EQ(std::get<1>(slices[i]), 10 * (index + 1));
+    EXPECT_EQ(std::get<2>(slices[i]), index % 2 == 0 ? ThreadStateSliceInfo::kRunning
+                                                     : ThreadStateSliceInfo::kRunnable);
+  }
+}
+
+TEST(ThreadStateSliceStore, ActionCanSkipSlices) {
+  ThreadStateSliceStore store;
+  constexpr uint64_t kSliceCount = 2 * ThreadStateSliceStore::kChunkSize + 100;
+  AddContiguousSlices(&store, kSliceCount);
+
+  // Like a zoomed-out draw: visit one slice, then skip every slice ending within the next 1000 ns.
+  std::vector<uint64_t> visited_begins;
+  store.ForEachSliceIntersectingTimeRange(
+      0, std::numeric_limits<uint64_t>::max(),
+      [&visited_begins](uint64_t begin_timestamp_ns, uint64_t /*end_timestamp_ns*/,
+                        ThreadStateSliceStore::ThreadState /*state*/) -> uint64_t {
+        visited_begins.push_back(begin_timestamp_ns);
+        return begin_timestamp_ns + 1000;
+      });
+
+  // Slice [1000, 1010) ends after 1000, so it is the next one visited after [0, 10).
+  std::vector<uint64_t> expected_begins;
+  for (uint64_t begin = 0; begin < 10 * kSliceCount; begin += 1000) {
+    expected_begins.push_back(begin);
+  }
+  EXPECT_EQ(visited_begins, expected_begins);
+}
+
+}  // namespace orbit_client_data
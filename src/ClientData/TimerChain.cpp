@@ -13,13 +13,44 @@ using orbit_client_protos::TimerInfo;
 namespace orbit_client_data {
 
 bool TimerBlock::Intersects(uint64_t min, uint64_t max) const {
-  return (min <= max_timestamp_ && max >= min_timestamp_);
+  return (min <= max_timestamp_.load(std::memory_order_relaxed) &&
+          max >= min_timestamp_.load(std::memory_order_relaxed));
+}
+
+TimerGroupSummary TimerBlock::GetGroupSummary(size_t level, size_t group_index) const {
+  CHECK(level < kSummaryGroupSizes.size());
+  CHECK(group_index < kBlockSize / kSummaryGroupSizes[level]);
+  const size_t published_size = size();
+  switch (level) {
+    case 0: {
+      // The timestamps might already include timers that are not published yet, which only makes
+      // the summary more conservative.
+      TimerGroupSummary summary;
+      summary.min_start = min_timestamp_.load(std::memory_order_relaxed);
+      summary.max_end = max_timestamp_.load(std::memory_order_relaxed);
+      summary.count = static_cast<uint32_t>(published_size);
+      return summary;
+    }
+    case 1:
+      if ((group_index + 1) * kSummaryGroupSizes[level] > published_size) return {};
+      return coarse_summaries_[group_index];
+    default:
+      if ((group_index + 1) * kSummaryGroupSizes[level] > published_size) return {};
+      return fine_summaries_[group_index];
+  }
+}
+
+const LatencyHistogram* TimerBlock::GetFunctionHistogram(uint64_t function_id) const {
+  // The histograms of a block that is still being filled can be modified concurrently.
+  if (!at_capacity()) return nullptr;
+  auto it = histograms_by_function_id_.find(function_id);
+  return it != histograms_by_function_id_.end() ? &it->second : nullptr;
 }
 
 TimerChain::~TimerChain() {
   // Find last block in chain
   while (current_->next_ != nullptr) {
-    current_ = current_->next_;
+    current_ = current_->next_.load();
   }
 
   TimerBlock* prev = current_;
@@ -43,7 +74,7 @@ const TimerBlock* TimerChain::GetBlockContaining(const TimerInfo& element) const
         return block;
       }
     }
-    block = block->next_;
+    block = block->next_.load(std::memory_order_acquire);
   }
 
   return nullptr;
@@ -57,8 +88,9 @@ const TimerInfo* TimerChain::GetElementAfter(const TimerInfo& element) const {
     if (index < block->size() - 1) {
       return &block->data_[++index];
     }
-    if (block->next_ != nullptr && block->next_->size() != 0) {
-      return &block->next_->data_[0];
+    const TimerBlock* next = block->next_.load(std::memory_order_acquire);
+    if (next != nullptr && next->size() != 0) {
+      return &next->data_[0];
     }
   }
   return nullptr;
@@ -79,4 +111,29 @@ const TimerInfo* TimerChain::GetElementBefore(const TimerInfo& element) const {
   return nullptr;
 }
 
+void TimerChain::AddDurationsToHistogram(uint64_t function_id, uint64_t min_time,
+                                         uint64_t max_time, LatencyHistogram* histogram) const {
+  CHECK(histogram != nullptr);
+  for (const TimerBlock& block : *this) {
+    if (!block.Intersects(min_time, max_time)) continue;
+
+    const size_t block_size = block.size();
+    if (block_size == TimerBlock::kBlockSize &&
+        block.min_timestamp_.load(std::memory_order_relaxed) >= min_time &&
+        block.max_timestamp_.load(std::memory_order_relaxed) <= max_time) {
+      const LatencyHistogram* block_histogram = block.GetFunctionHistogram(function_id);
+      if (block_histogram != nullptr) histogram->Merge(*block_histogram);
+      continue;
+    }
+
+    for (size_t i = 0; i < block_size; ++i) {
+      const TimerInfo& timer_info = block[i];
+      if (timer_info.function_id() == function_id && timer_info.start() >= min_time &&
+          timer_info.end() <= max_time) {
+        histogram->Add(timer_info.end() - timer_info.start());
+      }
+    }
+  }
+}
+
 }  // namespace orbit_client_data
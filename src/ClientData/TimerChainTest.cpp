@@ -0,0 +1,184 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "ClientData/TimerChain.h"
+#include "capture_data.pb.h"
+
+using orbit_client_protos::TimerInfo;
+
+namespace orbit_client_data {
+
+namespace {
+
+TimerInfo CreateTimer(uint64_t start, uint64_t end, uint64_t function_id = 0) {
+  TimerInfo timer;
+  timer.set_start(start);
+  timer.set_end(end);
+  timer.set_function_id(function_id);
+  return timer;
+}
+
+}  // namespace
+
+TEST(TimerChain, GroupSummariesOfPartiallyFilledBlock) {
+  TimerChain chain;
+  constexpr uint64_t kNumTimers = 200;
+  for (uint64_t i = 0; i < kNumTimers; ++i) {
+    chain.emplace_back(CreateTimer(10 * i, 10 * i + 5));
+  }
+
+  const TimerBlock& block = *chain.begin();
+  ASSERT_EQ(block.size(), kNumTimers);
+
+  TimerGroupSummary block_summary = block.GetGroupSummary(0, 0);
+  EXPECT_EQ(block_summary.min_start, 0);
+  EXPECT_EQ(block_summary.max_end, 10 * (kNumTimers - 1) + 5);
+  EXPECT_EQ(block_summary.count, kNumTimers);
+
+  TimerGroupSummary coarse_summary = block.GetGroupSummary(1, 0);
+  EXPECT_EQ(coarse_summary.min_start, 0);
+  EXPECT_EQ(coarse_summary.max_end, 1275);
+  EXPECT_EQ(coarse_summary.count, 128);
+
+  // Groups that are not complete yet could still be modified, hence they have empty summaries.
+  TimerGroupSummary incomplete_summary = block.GetGroupSummary(1, 1);
+  EXPECT_EQ(incomplete_summary.count, 0);
+
+  TimerGroupSummary fine_summary = block.GetGroupSummary(2, 3);
+  EXPECT_EQ(fine_summary.min_start, 480);
+  EXPECT_EQ(fine_summary.max_end, 635);
+  EXPECT_EQ(fine_summary.count, 16);
+
+  TimerGroupSummary empty_summary = block.GetGroupSummary(2, 20);
+  EXPECT_EQ(empty_summary.count, 0);
+
+  EXPECT_DEATH((void)block.GetGroupSummary(3, 0), "");
+  EXPECT_DEATH((void)block.GetGroupSummary(1, 8), "");
+}
+
+TEST(TimerChain, GroupSummariesMatchTheTimersOfTheGroup) {
+  TimerChain chain;
+  // Use timers that are not sorted, and span multiple blocks.
+  std::vector<TimerInfo> timers;
+  for (uint64_t i = 0; i < 3000; ++i) {
+    const uint64_t start = (i * 7919) % 3001;
+    timers.push_back(CreateTimer(start, start + i % 13));
+    chain.emplace_back(timers.back());
+  }
+
+  size_t block_offset = 0;
+  for (const TimerBlock& block : chain) {
+    for (size_t level = 0; level < TimerBlock::kSummaryGroupSizes.size(); ++level) {
+      const size_t group_size = TimerBlock::kSummaryGroupSizes[level];
+      for (size_t group_index = 0; group_index * group_size < block.size(); ++group_index) {
+        TimerGroupSummary expected;
+        const bool is_complete = level == 0 || (group_index + 1) * group_size <= block.size();
+        for (size_t i = group_index * group_size;
+             is_complete && i < std::min((group_index + 1) * group_size, block.size()); ++i) {
+          const TimerInfo& timer = timers[block_offset + i];
+          expected.min_start = std::min(expected.min_start, timer.start());
+          expected.max_end = std::max(expected.max_end, timer.end());
+          ++expected.count;
+        }
+        TimerGroupSummary summary = block.GetGroupSummary(level, group_index);
+        EXPECT_EQ(summary.min_start, expected.min_start);
+        EXPECT_EQ(summary.max_end, expected.max_end);
+        EXPECT_EQ(summary.count, expected.count);
+      }
+    }
+    block_offset += block.size();
+  }
+  EXPECT_EQ(block_offset, timers.size());
+}
+
+TEST(TimerChain, AddDurationsToHistogram) {
+  constexpr uint64_t kFunctionId = 1;
+  constexpr uint64_t kOtherFunctionId = 2;
+  TimerChain chain;
+  // Two and a half blocks, durations of kFunctionId are 1 to 5 in turn.
+  constexpr uint64_t kNumTimers = 5 * TimerBlock::kBlockSize / 2;
+  for (uint64_t i = 0; i < kNumTimers; ++i) {
+    const uint64_t function_id = i % 2 == 0 ? kFunctionId : kOtherFunctionId;
+    chain.emplace_back(CreateTimer(10 * i, 10 * i + 1 + (i / 2) % 5, function_id));
+  }
+
+  const TimerBlock& first_block = *chain.begin();
+  ASSERT_NE(first_block.GetFunctionHistogram(kFunctionId), nullptr);
+  EXPECT_EQ(first_block.GetFunctionHistogram(kFunctionId)->count(), TimerBlock::kBlockSize / 2);
+  EXPECT_EQ(first_block.GetFunctionHistogram(3), nullptr);
+
+  auto count_expected = [&](uint64_t min_time, uint64_t max_time) {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < kNumTimers; i += 2) {
+      const uint64_t start = 10 * i;
+      const uint64_t end = 10 * i + 1 + (i / 2) % 5;
+      if (start >= min_time && end <= max_time) ++count;
+    }
+    return count;
+  };
+
+  LatencyHistogram whole_capture;
+  chain.AddDurationsToHistogram(kFunctionId, 0, std::numeric_limits<uint64_t>::max(),
+                                &whole_capture);
+  EXPECT_EQ(whole_capture.count(), kNumTimers / 2);
+  EXPECT_EQ(whole_capture.min(), 1);
+  EXPECT_EQ(whole_capture.max(), 5);
+  EXPECT_EQ(whole_capture.GetPercentile(50), 3);
+
+  // Starts and ends within the first and the third block.
+  LatencyHistogram range;
+  chain.AddDurationsToHistogram(kFunctionId, 5005, 22'003, &range);
+  EXPECT_EQ(range.count(), count_expected(5005, 22'003));
+}
+
+TEST(TimerChain, ReadWhileAddingTimers) {
+  constexpr uint64_t kFunctionId = 1;
+  constexpr uint64_t kNumTimers = 20 * TimerBlock::kBlockSize + 100;
+  TimerChain chain;
+  std::atomic<bool> done_adding = false;
+
+  std::thread adding_thread([&chain, &done_adding] {
+    for (uint64_t i = 0; i < kNumTimers; ++i) {
+      chain.emplace_back(CreateTimer(10 * i, 10 * i + 1 + i % 7, kFunctionId));
+    }
+    done_adding = true;
+  });
+
+  uint64_t previous_count = 0;
+  bool last_pass = false;
+  while (!last_pass) {
+    last_pass = done_adding;
+
+    LatencyHistogram histogram;
+    chain.AddDurationsToHistogram(kFunctionId, 0, std::numeric_limits<uint64_t>::max(),
+                                  &histogram);
+    EXPECT_GE(histogram.count(), previous_count);
+    EXPECT_LE(histogram.count(), kNumTimers);
+    previous_count = histogram.count();
+
+    for (const TimerBlock& block : chain) {
+      const size_t block_size = block.size();
+      for (size_t level = 1; level < TimerBlock::kSummaryGroupSizes.size(); ++level) {
+        const size_t group_size = TimerBlock::kSummaryGroupSizes[level];
+        for (size_t group_index = 0; group_index < block_size / group_size; ++group_index) {
+          EXPECT_EQ(block.GetGroupSummary(level, group_index).count, group_size);
+        }
+      }
+    }
+  }
+  adding_thread.join();
+
+  EXPECT_EQ(previous_count, kNumTimers);
+}
+
+}  // namespace orbit_client_data
@@ -9,12 +9,14 @@
 
 #include <functional>
 #include <limits>
-#include <map>
 #include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 #include "CallstackTypes.h"
+#include "ClientData/CallstackEventStore.h"
+#include "OrbitBase/ThreadPool.h"
 #include "absl/container/flat_hash_map.h"
 #include "capture_data.pb.h"
 
@@ -48,6 +50,7 @@ class CallstackData {
   [[nodiscard]] std::vector<orbit_client_protos::CallstackEvent> GetCallstackEventsOfTidInTimeRange(
       int32_t tid, uint64_t time_begin, uint64_t time_end) const;
 
+  // The events passed to `action` by the ForEach... methods are only valid during the call.
   void ForEachCallstackEvent(
       const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const;
 
@@ -59,6 +62,15 @@ class CallstackData {
       int32_t tid, uint64_t min_timestamp, uint64_t max_timestamp,
       const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const;
 
+  // Calls `action` once for every thread that has callstack events, passing the events of that
+  // thread. The calls are scheduled on `thread_pool` and can run concurrently
+  // (or are made from the calling thread if `thread_pool` is nullptr). All calls have completed
+  // when this method returns.
+  void ForEachThreadCallstackEventsInParallel(
+      orbit_base::ThreadPool* thread_pool,
+      const std::function<void(int32_t thread_id, const CallstackEventStore& events)>& action)
+      const;
+
   [[nodiscard]] uint64_t max_time() const {
     std::lock_guard lock(mutex_);
     return max_time_;
@@ -92,13 +104,20 @@ class CallstackData {
 
   void RegisterTime(uint64_t time);
 
+  [[nodiscard]] CallstackEventStore& GetOrCreateCallstackEventStoreOfTid(int32_t tid);
+
+  [[nodiscard]] std::vector<std::pair<int32_t, const CallstackEventStore*>>
+  GetCallstackEventStores() const;
+  [[nodiscard]] const CallstackEventStore* GetCallstackEventStoreOfTid(int32_t tid) const;
+
   // Use a reentrant mutex so that calls to the ForEach... methods can be nested.
   // E.g., one might want to nest ForEachCallstackEvent and ForEachFrameInCallstack.
   mutable std::recursive_mutex mutex_;
   absl::flat_hash_map<uint64_t, std::shared_ptr<orbit_client_protos::CallstackInfo>>
       unique_callstacks_ GUARDED_BY(mutex_);
-  absl::flat_hash_map<int32_t, std::map<uint64_t, orbit_client_protos::CallstackEvent>>
-      callstack_events_by_tid_ GUARDED_BY(mutex_);
+  // The stores are never removed, so they can be accessed without holding `mutex_` once retrieved.
+  absl::flat_hash_map<int32_t, std::unique_ptr<CallstackEventStore>> callstack_events_by_tid_
+      GUARDED_BY(mutex_);
 
   uint64_t max_time_ GUARDED_BY(mutex_) = 0;
   uint64_t min_time_ GUARDED_BY(mutex_) = std::numeric_limits<uint64_t>::max();
@@ -0,0 +1,103 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_CALLSTACK_EVENT_STORE_H_
+#define CLIENT_DATA_CALLSTACK_EVENT_STORE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/inlined_vector.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace orbit_client_data {
+
+// Append-only storage of the callstack events (timestamp and callstack id) of a single thread,
+// sorted by timestamp. Instead of a node per event, timestamps and callstack ids are kept in two
+// parallel arrays, split into chunks of `kChunkSize` events, so that an event takes 16 bytes and a
+// range query is a binary search followed by a linear scan over contiguous memory.
+//
+// Only the end of the last chunk is ever written to. The events of a chunk up to its published
+// size are immutable: the rare event that doesn't arrive in order, or that replaces the event with
+// the same timestamp, is inserted into a copy of the affected chunk, which then replaces it. The
+// mutex is therefore only held while taking a snapshot of the relevant chunks, and the events are
+// visited without holding it, concurrently to events being added.
+class CallstackEventStore {
+ public:
+  static constexpr size_t kChunkSize = 1024;
+
+  // If an event with the same timestamp already exists, its callstack id is replaced.
+  void AddEvent(uint64_t timestamp, uint64_t callstack_id);
+
+  [[nodiscard]] size_t size() const {
+    absl::MutexLock lock(&mutex_);
+    return size_;
+  }
+
+  // Calls `action(uint64_t timestamp, uint64_t callstack_id)` for every event with timestamp in
+  // [min_timestamp, max_timestamp], in order of timestamp. `action` can add events to this store,
+  // but they are not guaranteed to be visited.
+  template <typename Action>
+  void ForEachEventInTimeRange(uint64_t min_timestamp, uint64_t max_timestamp,
+                               Action&& action) const {
+    if (min_timestamp > max_timestamp) return;
+    for (const ChunkSnapshot& snapshot : GetChunkSnapshots(min_timestamp, max_timestamp)) {
+      const uint64_t* timestamps = snapshot.chunk->timestamps.get();
+      const uint64_t* callstack_ids = snapshot.chunk->callstack_ids.get();
+      const uint64_t* begin =
+          std::lower_bound(timestamps, timestamps + snapshot.size, min_timestamp);
+      const uint64_t* end = std::upper_bound(begin, timestamps + snapshot.size, max_timestamp);
+      for (const uint64_t* timestamp = begin; timestamp != end; ++timestamp) {
+        action(*timestamp, callstack_ids[timestamp - timestamps]);
+      }
+    }
+  }
+
+  template <typename Action>
+  void ForEachEvent(Action&& action) const {
+    ForEachEventInTimeRange(0, std::numeric_limits<uint64_t>::max(), std::forward<Action>(action));
+  }
+
+ private:
+  struct Chunk {
+    explicit Chunk(size_t capacity)
+        : capacity{capacity},
+          timestamps{std::make_unique<uint64_t[]>(capacity)},
+          callstack_ids{std::make_unique<uint64_t[]>(capacity)} {}
+
+    const size_t capacity;
+    std::unique_ptr<uint64_t[]> timestamps;
+    std::unique_ptr<uint64_t[]> callstack_ids;
+    // Only accessed while holding `mutex_`. Events at indices below `size` are never modified
+    // again, which is why they can be read without holding `mutex_` once `size` was read.
+    size_t size = 0;
+  };
+
+  struct ChunkSnapshot {
+    std::shared_ptr<const Chunk> chunk;
+    size_t size;
+  };
+
+  [[nodiscard]] absl::InlinedVector<ChunkSnapshot, 2> GetChunkSnapshots(
+      uint64_t min_timestamp, uint64_t max_timestamp) const;
+
+  void AppendEvent(uint64_t timestamp, uint64_t callstack_id) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void InsertEventOutOfOrder(uint64_t timestamp, uint64_t callstack_id)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  // Chunks are sorted and don't overlap, and none of them is empty.
+  std::vector<std::shared_ptr<Chunk>> chunks_ GUARDED_BY(mutex_);
+  size_t size_ GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_CALLSTACK_EVENT_STORE_H_
@@ -7,6 +7,7 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/container/node_hash_map.h>
 #include <absl/synchronization/mutex.h>
 
 #include <algorithm>
@@ -22,10 +23,12 @@
 
 #include "ClientData/CallstackData.h"
 #include "ClientData/FunctionInfoSet.h"
+#include "ClientData/LatencyHistogram.h"
 #include "ClientData/ModuleData.h"
 #include "ClientData/ModuleManager.h"
 #include "ClientData/PostProcessedSamplingData.h"
 #include "ClientData/ProcessData.h"
+#include "ClientData/ThreadStateSliceStore.h"
 #include "ClientData/TimerChain.h"
 #include "ClientData/TimestampIntervalSet.h"
 #include "ClientData/TracepointCustom.h"
@@ -70,11 +73,14 @@ class CaptureData {
 
   [[nodiscard]] absl::Time capture_start_time() const { return capture_start_time_; }
 
-  [[nodiscard]] const absl::flat_hash_map<uint64_t, orbit_client_protos::LinuxAddressInfo>&
+  // Returns a copy, as address infos can be inserted concurrently.
+  [[nodiscard]] absl::flat_hash_map<uint64_t, orbit_client_protos::LinuxAddressInfo>
   address_infos() const {
-    return address_infos_;
+    absl::MutexLock lock{&address_infos_mutex_};
+    return {address_infos_.begin(), address_infos_.end()};
   }
 
+  // The returned address info stays valid and unchanged while further ones are inserted.
   [[nodiscard]] const orbit_client_protos::LinuxAddressInfo* GetAddressInfo(
       uint64_t absolute_address) const;
 
@@ -99,41 +105,52 @@ class CaptureData {
 
   static const std::string kUnknownFunctionOrModuleName;
 
-  [[nodiscard]] const absl::flat_hash_map<int32_t, std::string>& thread_names() const {
+  // Thread names can be added and changed concurrently, hence these return copies.
+  [[nodiscard]] absl::flat_hash_map<int32_t, std::string> thread_names() const {
+    absl::MutexLock lock{&thread_names_mutex_};
     return thread_names_;
   }
 
-  [[nodiscard]] const std::string& GetThreadName(int32_t thread_id) const {
-    static const std::string kEmptyString;
+  [[nodiscard]] std::string GetThreadName(int32_t thread_id) const {
+    absl::MutexLock lock{&thread_names_mutex_};
     auto it = thread_names_.find(thread_id);
-    return it != thread_names_.end() ? it->second : kEmptyString;
+    return it != thread_names_.end() ? it->second : std::string{};
   }
 
   void AddOrAssignThreadName(int32_t thread_id, std::string thread_name) {
+    absl::MutexLock lock{&thread_names_mutex_};
     thread_names_.insert_or_assign(thread_id, std::move(thread_name));
   }
 
-  [[nodiscard]] const absl::flat_hash_map<int32_t,
-                                          std::vector<orbit_client_protos::ThreadStateSliceInfo>>&
-  thread_state_slices() const {
-    return thread_state_slices_;
-  }
-
   [[nodiscard]] bool HasThreadStatesForThread(int32_t tid) const {
     absl::MutexLock lock{&thread_state_slices_mutex_};
     return thread_state_slices_.count(tid) > 0;
   }
 
-  void AddThreadStateSlice(orbit_client_protos::ThreadStateSliceInfo state_slice) {
-    absl::MutexLock lock{&thread_state_slices_mutex_};
-    thread_state_slices_[state_slice.tid()].emplace_back(std::move(state_slice));
+  void AddThreadStateSlice(const orbit_client_protos::ThreadStateSliceInfo& state_slice) {
+    ThreadStateSliceStore* store;
+    {
+      absl::MutexLock lock{&thread_state_slices_mutex_};
+      std::unique_ptr<ThreadStateSliceStore>& tid_store = thread_state_slices_[state_slice.tid()];
+      if (tid_store == nullptr) tid_store = std::make_unique<ThreadStateSliceStore>();
+      store = tid_store.get();
+    }
+    store->AddSlice(state_slice.begin_timestamp_ns(), state_slice.end_timestamp_ns(),
+                    state_slice.thread_state());
   }
 
-  // Allows the caller to iterate `action` over all the thread state slices of the specified thread
-  // in the time range while holding for the whole time the internal mutex, acquired only once.
-  void ForEachThreadStateSliceIntersectingTimeRange(
-      int32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp,
-      const std::function<void(const orbit_client_protos::ThreadStateSliceInfo&)>& action) const;
+  // Calls `action` on the thread state slices of the specified thread in the time range, see
+  // ThreadStateSliceStore::ForEachSliceIntersectingTimeRange. The slices are visited without
+  // holding the internal mutex, so slices can keep being added in the meantime.
+  template <typename Action>
+  void ForEachThreadStateSliceIntersectingTimeRange(int32_t thread_id, uint64_t min_timestamp,
+                                                    uint64_t max_timestamp,
+                                                    Action&& action) const {
+    const ThreadStateSliceStore* store = FindThreadStateSliceStore(thread_id);
+    if (store == nullptr) return;
+    store->ForEachSliceIntersectingTimeRange(min_timestamp, max_timestamp,
+                                             std::forward<Action>(action));
+  }
 
   [[nodiscard]] const absl::flat_hash_map<uint64_t, orbit_client_protos::FunctionStats>&
   functions_stats() const {
@@ -143,8 +160,14 @@ class CaptureData {
   [[nodiscard]] const orbit_client_protos::FunctionStats& GetFunctionStatsOrDefault(
       uint64_t instrumented_function_id) const;
 
+  // Also adds `elapsed_nanos` to the latency histogram of the function.
   void UpdateFunctionStats(uint64_t instrumented_function_id, uint64_t elapsed_nanos);
 
+  // Returns the `percentile`-th percentile of the durations of the function over the whole capture,
+  // see LatencyHistogram::GetPercentile. Can be called while the capture is running.
+  [[nodiscard]] uint64_t GetFunctionDurationPercentile(uint64_t instrumented_function_id,
+                                                       double percentile) const;
+
   void OnCaptureComplete(const std::vector<const orbit_client_data::TimerChain*>& chains);
 
   [[nodiscard]] const CallstackData& GetCallstackData() const { return callstack_data_; };
@@ -252,15 +275,26 @@ class CaptureData {
 
   std::optional<PostProcessedSamplingData> post_processed_sampling_data_;
 
-  absl::flat_hash_map<uint64_t, orbit_client_protos::LinuxAddressInfo> address_infos_;
+  // Entries are never modified nor removed, and node_hash_map keeps them in place, so they can be
+  // accessed without holding `address_infos_mutex_` once they were found.
+  absl::node_hash_map<uint64_t, orbit_client_protos::LinuxAddressInfo> address_infos_
+      GUARDED_BY(address_infos_mutex_);
+  mutable absl::Mutex address_infos_mutex_;
 
   absl::flat_hash_map<uint64_t, orbit_client_protos::FunctionStats> functions_stats_;
+  absl::flat_hash_map<uint64_t, LatencyHistogram> function_histograms_
+      GUARDED_BY(function_histograms_mutex_);
+  mutable absl::Mutex function_histograms_mutex_;
+
+  absl::flat_hash_map<int32_t, std::string> thread_names_ GUARDED_BY(thread_names_mutex_);
+  mutable absl::Mutex thread_names_mutex_;
 
-  absl::flat_hash_map<int32_t, std::string> thread_names_;
+  [[nodiscard]] const ThreadStateSliceStore* FindThreadStateSliceStore(int32_t thread_id) const;
 
-  // For each thread, assume sorted by timestamp and not overlapping.
-  absl::flat_hash_map<int32_t, std::vector<orbit_client_protos::ThreadStateSliceInfo>>
-      thread_state_slices_ GUARDED_BY(thread_state_slices_mutex_);
+  // For each thread, assume sorted by timestamp and not overlapping. The stores are never removed
+  // nor replaced, so they can be accessed without holding `thread_state_slices_mutex_`.
+  absl::flat_hash_map<int32_t, std::unique_ptr<ThreadStateSliceStore>> thread_state_slices_
+      GUARDED_BY(thread_state_slices_mutex_);
   mutable absl::Mutex thread_state_slices_mutex_;
 
   // Only access this field from the main thread.
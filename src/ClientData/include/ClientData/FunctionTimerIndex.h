@@ -0,0 +1,61 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_FUNCTION_TIMER_INDEX_H_
+#define CLIENT_DATA_FUNCTION_TIMER_INDEX_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "capture_data.pb.h"
+
+namespace orbit_client_data {
+
+// Keeps references to the timers of each function sorted by end time, in total and per thread.
+// This allows to find the call of a function right before or after a point in time, and the calls
+// in a time range, in O(log n) instead of iterating over all timers of the capture.
+//
+// The index doesn't own the timers, they need to outlive it and must not move, as is the case for
+// timers stored in a TimerChain. Timers can be added from a different thread than the one querying.
+class FunctionTimerIndex {
+ public:
+  // Timers mostly arrive in the order of their end time, in which case adding takes O(1).
+  void Add(const orbit_client_protos::TimerInfo& timer_info);
+
+  // Returns the call of the function with the smallest end time greater than `time`, or nullptr.
+  [[nodiscard]] const orbit_client_protos::TimerInfo* FindNext(
+      uint64_t function_id, uint64_t time, std::optional<int32_t> thread_id = std::nullopt) const;
+  // Returns the call of the function with the greatest end time less than `time`, or nullptr.
+  [[nodiscard]] const orbit_client_protos::TimerInfo* FindPrevious(
+      uint64_t function_id, uint64_t time, std::optional<int32_t> thread_id = std::nullopt) const;
+
+  // Returns the calls of the function with end time in [min_end_time, max_end_time], sorted by end
+  // time.
+  [[nodiscard]] std::vector<const orbit_client_protos::TimerInfo*> GetTimers(
+      uint64_t function_id, uint64_t min_end_time = 0,
+      uint64_t max_end_time = std::numeric_limits<uint64_t>::max()) const;
+
+ private:
+  using SortedTimers = std::vector<const orbit_client_protos::TimerInfo*>;
+
+  [[nodiscard]] const SortedTimers* GetSortedTimers(uint64_t function_id,
+                                                    std::optional<int32_t> thread_id) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<uint64_t, SortedTimers> timers_by_function_id_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::pair<uint64_t, int32_t>, SortedTimers>
+      timers_by_function_id_and_thread_id_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_FUNCTION_TIMER_INDEX_H_
@@ -0,0 +1,55 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_LATENCY_HISTOGRAM_H_
+#define CLIENT_DATA_LATENCY_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+namespace orbit_client_data {
+
+// Histogram of durations with log-linear buckets, in the style of HdrHistogram: values below 64
+// have their own bucket, above that each power of two is split into 32 buckets. This bounds the
+// relative error of percentiles by 1/32 (about 3%) for any range of durations.
+//
+// Only the buckets between the smallest and the largest value added are stored, which keeps the
+// histogram of a function small, as its durations usually span a few orders of magnitude at most.
+// Histograms can be merged, e.g. to combine the histograms of blocks of timers.
+class LatencyHistogram {
+ public:
+  void Add(uint64_t value);
+  void Merge(const LatencyHistogram& other);
+
+  [[nodiscard]] uint64_t count() const { return count_; }
+  [[nodiscard]] uint64_t min() const { return min_; }
+  [[nodiscard]] uint64_t max() const { return max_; }
+
+  // Returns the smallest value such that `percentile` percent of the values are less than or equal
+  // to it, up to the resolution of the buckets. `percentile` is in [0, 100]. Returns 0 if the
+  // histogram is empty.
+  [[nodiscard]] uint64_t GetPercentile(double percentile) const;
+
+  [[nodiscard]] static size_t GetBucketIndex(uint64_t value);
+  // The smallest and the largest value that fall into the bucket with index `bucket_index`.
+  [[nodiscard]] static uint64_t GetBucketLowerBound(size_t bucket_index);
+  [[nodiscard]] static uint64_t GetBucketUpperBound(size_t bucket_index);
+
+ private:
+  void AddToBucket(size_t bucket_index, uint64_t count);
+
+  // counts_[i] is the number of values in the bucket with index first_bucket_index_ + i.
+  size_t first_bucket_index_ = 0;
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_LATENCY_HISTOGRAM_H_
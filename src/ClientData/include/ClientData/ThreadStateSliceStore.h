@@ -0,0 +1,102 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_THREAD_STATE_SLICE_STORE_H_
+#define CLIENT_DATA_THREAD_STATE_SLICE_STORE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/inlined_vector.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "capture_data.pb.h"
+
+namespace orbit_client_data {
+
+// Append-only storage of the thread state slices of a single thread, which are expected to be added
+// sorted by time and not overlapping. Instead of a ThreadStateSliceInfo per slice, begin
+// timestamps, end timestamps and states are kept in three parallel arrays, split into chunks of
+// `kChunkSize` slices, so that a slice takes 17 bytes and a range query is a binary search followed
+// by a scan over contiguous memory.
+//
+// Only the end of the last chunk is ever written to, and the slices of a chunk up to its published
+// size are immutable. The mutex is therefore only held while taking a snapshot of the relevant
+// chunks, and the slices are visited without holding it, concurrently to slices being added.
+class ThreadStateSliceStore {
+ public:
+  using ThreadState = orbit_client_protos::ThreadStateSliceInfo::ThreadState;
+
+  static constexpr size_t kChunkSize = 1024;
+
+  void AddSlice(uint64_t begin_timestamp_ns, uint64_t end_timestamp_ns, ThreadState state);
+
+  [[nodiscard]] size_t size() const {
+    absl::MutexLock lock(&mutex_);
+    return size_;
+  }
+
+  // Calls `action(uint64_t begin_timestamp_ns, uint64_t end_timestamp_ns, ThreadState state)` for
+  // every slice that intersects [min_timestamp, max_timestamp), in order of time. `action` returns
+  // a timestamp: the following slices that end at or before it are skipped with a binary search
+  // instead of being visited, e.g., because they would be drawn over the same pixel. Returning 0
+  // skips nothing.
+  template <typename Action>
+  void ForEachSliceIntersectingTimeRange(uint64_t min_timestamp, uint64_t max_timestamp,
+                                         Action&& action) const {
+    uint64_t skip_until_ns = 0;
+    for (const ChunkSnapshot& snapshot : GetChunkSnapshots(min_timestamp, max_timestamp)) {
+      const uint64_t* begins = snapshot.chunk->begin_timestamps_ns.get();
+      const uint64_t* ends = snapshot.chunk->end_timestamps_ns.get();
+      const uint8_t* states = snapshot.chunk->states.get();
+      const uint64_t* ends_end = ends + snapshot.size;
+
+      const uint64_t* end = std::lower_bound(ends, ends_end, min_timestamp);
+      if (skip_until_ns != 0) end = std::upper_bound(end, ends_end, skip_until_ns);
+      while (end != ends_end) {
+        const size_t index = end - ends;
+        if (begins[index] >= max_timestamp) return;
+        skip_until_ns = action(begins[index], ends[index], static_cast<ThreadState>(states[index]));
+        ++end;
+        if (skip_until_ns != 0) end = std::upper_bound(end, ends_end, skip_until_ns);
+      }
+    }
+  }
+
+ private:
+  struct Chunk {
+    Chunk()
+        : begin_timestamps_ns{std::make_unique<uint64_t[]>(kChunkSize)},
+          end_timestamps_ns{std::make_unique<uint64_t[]>(kChunkSize)},
+          states{std::make_unique<uint8_t[]>(kChunkSize)} {}
+
+    std::unique_ptr<uint64_t[]> begin_timestamps_ns;
+    std::unique_ptr<uint64_t[]> end_timestamps_ns;
+    std::unique_ptr<uint8_t[]> states;
+    // Only accessed while holding `mutex_`. Slices at indices below `size` are never modified
+    // again, which is why they can be read without holding `mutex_` once `size` was read.
+    size_t size = 0;
+  };
+
+  struct ChunkSnapshot {
+    const Chunk* chunk;
+    size_t size;
+  };
+
+  [[nodiscard]] absl::InlinedVector<ChunkSnapshot, 2> GetChunkSnapshots(
+      uint64_t min_timestamp, uint64_t max_timestamp) const;
+
+  mutable absl::Mutex mutex_;
+  // Chunks are never removed, and none of them is empty.
+  std::vector<std::unique_ptr<Chunk>> chunks_ GUARDED_BY(mutex_);
+  size_t size_ GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_THREAD_STATE_SLICE_STORE_H_
@@ -5,43 +5,76 @@
 #ifndef CLIENT_DATA_TIMER_CHAIN_H_
 #define CLIENT_DATA_TIMER_CHAIN_H_
 
+#include <absl/container/flat_hash_map.h>
+
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <iosfwd>
 #include <limits>
 
+#include "ClientData/LatencyHistogram.h"
+#include "GrpcProtos/Constants.h"
 #include "OrbitBase/Logging.h"
 #include "capture_data.pb.h"
 
 namespace orbit_client_data {
 
+// Summary of a group of consecutive timers in a TimerBlock: the earliest start, the latest end and
+// the number of timers in the group.
+struct TimerGroupSummary {
+  uint64_t min_start = std::numeric_limits<uint64_t>::max();
+  uint64_t max_end = std::numeric_limits<uint64_t>::min();
+  uint32_t count = 0;
+};
+
 // TimerBlock is a straightforward specialization of Block (see BlockChain.h) with the added bonus
 // that it keeps track of the minimum and maximum timestamps of all timers added to it. This allows
 // trivial rejection of an entire block by using the Intersects(t_min, t_max) method. This
 // effectively tests if any of the timers stored in this block intersects with the [t_min, t_max]
 // interval.
+//
+// The same information is also kept at finer resolutions, for groups of consecutive timers of the
+// sizes in kSummaryGroupSizes. When zoomed out, this allows the renderer to skip entire groups of
+// timers that would only draw over an already drawn pixel, instead of looking at each timer.
+//
+// Finally, the block keeps a histogram of the durations of the timers of each function, so that
+// statistics over a time range only need to look at the timers of blocks partially in the range.
+//
+// A single thread can add timers while other threads read the block. A timer is only published,
+// by incrementing the size with release semantics, after the summaries and histograms were updated
+// with it. Readers only look at summaries of groups and histograms of blocks that are complete, as
+// these are never modified again.
 class TimerBlock {
   friend class TimerChain;
   friend class TimerChainIterator;
 
  public:
-  explicit TimerBlock(TimerBlock* prev)
-      : prev_(prev),
-        next_(nullptr),
-        min_timestamp_(std::numeric_limits<uint64_t>::max()),
-        max_timestamp_(std::numeric_limits<uint64_t>::min()) {
-    data_.reserve(kBlockSize);
-  }
+  explicit TimerBlock(TimerBlock* prev) : prev_(prev) { data_.reserve(kBlockSize); }
 
   // Append a new element to the end of the block using placement-new.
   template <class... Args>
   const orbit_client_protos::TimerInfo& emplace_back(Args&&... args) {
-    CHECK(size() < kBlockSize);
+    // Only the thread adding timers writes `size_`.
+    const size_t index = size_.load(std::memory_order_relaxed);
+    CHECK(index < kBlockSize);
+    // As `data_` has reserved kBlockSize elements, this never moves the published elements.
     const orbit_client_protos::TimerInfo& timer_info =
         data_.emplace_back(std::forward<Args>(args)...);
-    min_timestamp_ = std::min(timer_info.start(), min_timestamp_);
-    max_timestamp_ = std::max(timer_info.end(), max_timestamp_);
+    if (timer_info.start() < min_timestamp_.load(std::memory_order_relaxed)) {
+      min_timestamp_.store(timer_info.start(), std::memory_order_relaxed);
+    }
+    if (timer_info.end() > max_timestamp_.load(std::memory_order_relaxed)) {
+      max_timestamp_.store(timer_info.end(), std::memory_order_relaxed);
+    }
+    AddToSummary(&coarse_summaries_[index / kSummaryGroupSizes[1]], timer_info);
+    AddToSummary(&fine_summaries_[index / kSummaryGroupSizes[2]], timer_info);
+    if (timer_info.function_id() != orbit_grpc_protos::kInvalidFunctionId) {
+      histograms_by_function_id_[timer_info.function_id()].Add(timer_info.end() -
+                                                               timer_info.start());
+    }
+    size_.store(index + 1, std::memory_order_release);
     return timer_info;
   }
 
@@ -50,22 +83,47 @@ class TimerBlock {
   // that have so far been added to this block.
   [[nodiscard]] bool Intersects(uint64_t min, uint64_t max) const;
 
-  [[nodiscard]] size_t size() const { return data_.size(); }
+  [[nodiscard]] size_t size() const { return size_.load(std::memory_order_acquire); }
   [[nodiscard]] bool at_capacity() const { return size() == kBlockSize; }
 
   [[nodiscard]] const orbit_client_protos::TimerInfo& operator[](std::size_t idx) const {
     return data_[idx];
   }
 
- private:
   static constexpr size_t kBlockSize = 1024;
+  // Sizes of the groups of timers that are summarized, from the coarsest level (the entire block)
+  // to the finest. Each size divides the previous one.
+  static constexpr std::array<size_t, 3> kSummaryGroupSizes{kBlockSize, 128, 16};
+
+  // Returns the summary of the `group_index`-th group of kSummaryGroupSizes[level] timers, i.e.,
+  // of the timers with indices in [group_index * group_size, (group_index + 1) * group_size). For
+  // the finer levels, a group that is not complete yet has an empty summary.
+  [[nodiscard]] TimerGroupSummary GetGroupSummary(size_t level, size_t group_index) const;
+
+  // Returns the histogram of the durations of the timers of the function in this block, or nullptr
+  // if the block contains no such timer or is not at capacity yet.
+  [[nodiscard]] const LatencyHistogram* GetFunctionHistogram(uint64_t function_id) const;
+
+ private:
+  static void AddToSummary(TimerGroupSummary* summary,
+                           const orbit_client_protos::TimerInfo& timer_info) {
+    summary->min_start = std::min(timer_info.start(), summary->min_start);
+    summary->max_end = std::max(timer_info.end(), summary->max_end);
+    ++summary->count;
+  }
 
   TimerBlock* prev_;
-  TimerBlock* next_;
+  std::atomic<TimerBlock*> next_ = nullptr;
   std::vector<orbit_client_protos::TimerInfo> data_;
+  // The number of elements of `data_` that are published to readers.
+  std::atomic<size_t> size_ = 0;
+
+  std::atomic<uint64_t> min_timestamp_ = std::numeric_limits<uint64_t>::max();
+  std::atomic<uint64_t> max_timestamp_ = std::numeric_limits<uint64_t>::min();
 
-  uint64_t min_timestamp_;
-  uint64_t max_timestamp_;
+  std::array<TimerGroupSummary, kBlockSize / kSummaryGroupSizes[1]> coarse_summaries_;
+  std::array<TimerGroupSummary, kBlockSize / kSummaryGroupSizes[2]> fine_summaries_;
+  absl::flat_hash_map<uint64_t, LatencyHistogram> histograms_by_function_id_;
 };  // TimerChainIterator iterates over all *blocks* of the chain, not the
 // individual items (TimerInfo instances) that are stored in the blocks (this is
 // different from the BlockIterator in BlockChain.h).
@@ -81,7 +139,7 @@ class TimerChainIterator {
 
   bool operator==(const TimerChainIterator& other) const { return block_ == other.block_; }
   TimerChainIterator& operator++() {
-    block_ = block_->next_;
+    block_ = block_->next_.load(std::memory_order_acquire);
     return *this;
   }
 
@@ -125,6 +183,13 @@ class TimerChain {
   [[nodiscard]] const orbit_client_protos::TimerInfo* GetElementBefore(
       const orbit_client_protos::TimerInfo& element) const;
 
+  // Adds the durations of the timers of the function that lie entirely within [min_time,
+  // max_time] to `histogram`. The histograms of full blocks within the range are merged, only the
+  // timers of the other blocks are looked at individually. This can be called while timers are
+  // added from another thread: the timers added concurrently might or might not be considered.
+  void AddDurationsToHistogram(uint64_t function_id, uint64_t min_time, uint64_t max_time,
+                               LatencyHistogram* histogram) const;
+
   [[nodiscard]] TimerChainIterator begin() const { return TimerChainIterator(root_); }
 
   [[nodiscard]] TimerChainIterator end() const { return TimerChainIterator(nullptr); }
@@ -132,8 +197,9 @@ class TimerChain {
  private:
   void AllocateNewBlock() {
     CHECK(current_->next_ == nullptr);
-    current_->next_ = new TimerBlock(current_);
-    current_ = current_->next_;
+    auto* new_block = new TimerBlock(current_);
+    current_->next_.store(new_block, std::memory_order_release);
+    current_ = new_block;
     ++num_blocks_;
   }
 
@@ -0,0 +1,48 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientModel/SamplingDataAggregator.h"
+
+#include <utility>
+
+using orbit_client_data::CallstackData;
+using orbit_client_data::CaptureData;
+using orbit_client_data::PostProcessedSamplingData;
+using orbit_client_protos::CallstackEvent;
+
+namespace orbit_client_model {
+
+void SamplingDataAggregator::AddCallstackEvent(const CallstackEvent& callstack_event) {
+  absl::MutexLock lock(&mutex_);
+  thread_id_to_callstack_id_to_count_[callstack_event.thread_id()]
+                                     [callstack_event.callstack_id()]++;
+  ++samples_count_;
+}
+
+void SamplingDataAggregator::Clear() {
+  absl::MutexLock lock(&mutex_);
+  thread_id_to_callstack_id_to_count_.clear();
+  samples_count_ = 0;
+}
+
+uint64_t SamplingDataAggregator::GetSamplesCount() const {
+  absl::MutexLock lock(&mutex_);
+  return samples_count_;
+}
+
+PostProcessedSamplingData SamplingDataAggregator::CreatePostProcessedSamplingData(
+    const CallstackData& callstack_data, const CaptureData& capture_data, bool generate_summary,
+    orbit_base::ThreadPool* thread_pool) const {
+  ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count;
+  {
+    // Only copy the counts while holding the lock, so that adding events is not blocked for long.
+    absl::MutexLock lock(&mutex_);
+    thread_id_to_callstack_id_to_count = thread_id_to_callstack_id_to_count_;
+  }
+  return CreatePostProcessedSamplingDataFromCallstackCounts(
+      std::move(thread_id_to_callstack_id_to_count), callstack_data, capture_data,
+      generate_summary, thread_pool);
+}
+
+}  // namespace orbit_client_model
@@ -0,0 +1,136 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/container/flat_hash_set.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "ClientData/CaptureData.h"
+#include "ClientData/ModuleManager.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientModel/SamplingDataAggregator.h"
+#include "ClientModel/SamplingDataPostProcessor.h"
+#include "OrbitBase/ThreadConstants.h"
+#include "capture_data.pb.h"
+
+using orbit_client_data::CaptureData;
+using orbit_client_data::ModuleManager;
+using orbit_client_data::PostProcessedSamplingData;
+using orbit_client_data::ThreadSampleData;
+
+using orbit_client_protos::CallstackEvent;
+using orbit_client_protos::CallstackInfo;
+
+using orbit_grpc_protos::CaptureStarted;
+
+namespace orbit_client_model {
+
+namespace {
+
+class SamplingDataAggregatorTest : public ::testing::Test {
+ protected:
+  void AddCallstackInfo(uint64_t callstack_id, const std::vector<uint64_t>& callstack_frames,
+                        CallstackInfo::CallstackType callstack_type) {
+    CallstackInfo callstack_info;
+    *callstack_info.mutable_frames() = {callstack_frames.begin(), callstack_frames.end()};
+    callstack_info.set_type(callstack_type);
+    capture_data_.AddUniqueCallstack(callstack_id, std::move(callstack_info));
+  }
+
+  // Feeds the event both to the CaptureData and to the SamplingDataAggregator, like OrbitApp does.
+  void AddCallstackEvent(uint64_t callstack_id, int32_t thread_id) {
+    current_callstack_timestamp_ns_ += 100;
+    CallstackEvent callstack_event;
+    callstack_event.set_time(current_callstack_timestamp_ns_);
+    callstack_event.set_callstack_id(callstack_id);
+    callstack_event.set_thread_id(thread_id);
+    aggregator_.AddCallstackEvent(callstack_event);
+    capture_data_.AddCallstackEvent(std::move(callstack_event));
+  }
+
+  void ExpectAggregatorMatchesPostProcessingAllEvents() {
+    PostProcessedSamplingData expected = CreatePostProcessedSamplingData(
+        capture_data_.GetCallstackData(), capture_data_, /*generate_summary=*/true);
+    PostProcessedSamplingData actual =
+        aggregator_.CreatePostProcessedSamplingData(capture_data_.GetCallstackData(), capture_data_,
+                                                    /*generate_summary=*/true);
+
+    EXPECT_EQ(aggregator_.GetSamplesCount(),
+              capture_data_.GetCallstackData().GetCallstackEventsCount());
+    ASSERT_EQ(actual.GetThreadSampleData().size(), expected.GetThreadSampleData().size());
+    for (const ThreadSampleData& expected_data : expected.GetThreadSampleData()) {
+      const ThreadSampleData* actual_data =
+          actual.GetThreadSampleDataByThreadId(expected_data.thread_id);
+      ASSERT_NE(actual_data, nullptr);
+      EXPECT_EQ(actual_data->samples_count, expected_data.samples_count);
+      EXPECT_EQ(actual_data->sampled_callstack_id_to_count,
+                expected_data.sampled_callstack_id_to_count);
+      EXPECT_EQ(actual_data->sampled_address_to_count, expected_data.sampled_address_to_count);
+      EXPECT_EQ(actual_data->resolved_address_to_count, expected_data.resolved_address_to_count);
+      EXPECT_EQ(actual_data->resolved_address_to_exclusive_count,
+                expected_data.resolved_address_to_exclusive_count);
+      EXPECT_EQ(actual_data->resolved_address_to_error_count,
+                expected_data.resolved_address_to_error_count);
+      EXPECT_EQ(actual_data->sorted_count_to_resolved_address,
+                expected_data.sorted_count_to_resolved_address);
+    }
+  }
+
+  static constexpr int32_t kThreadId1 = 42;
+  static constexpr int32_t kThreadId2 = 43;
+  static constexpr uint64_t kCallstack1Id = 1;
+  static constexpr uint64_t kCallstack2Id = 2;
+  static constexpr uint64_t kCallstack3Id = 3;
+
+  ModuleManager module_manager_;
+  CaptureData capture_data_{&module_manager_, CaptureStarted{}, std::filesystem::path{},
+                            absl::flat_hash_set<uint64_t>{}};
+  SamplingDataAggregator aggregator_;
+  uint64_t current_callstack_timestamp_ns_ = 0;
+};
+
+TEST_F(SamplingDataAggregatorTest, EmptyAggregatorCreatesEmptySamplingData) {
+  PostProcessedSamplingData post_processed_sampling_data =
+      aggregator_.CreatePostProcessedSamplingData(capture_data_.GetCallstackData(), capture_data_);
+  EXPECT_EQ(aggregator_.GetSamplesCount(), 0);
+  EXPECT_TRUE(post_processed_sampling_data.GetThreadSampleData().empty());
+  EXPECT_EQ(post_processed_sampling_data.GetSummary(), nullptr);
+}
+
+TEST_F(SamplingDataAggregatorTest, MatchesPostProcessingAllEventsWhileEventsArrive) {
+  AddCallstackInfo(kCallstack1Id, {0x31, 0x21, 0x11}, CallstackInfo::kComplete);
+  AddCallstackInfo(kCallstack2Id, {0x41, 0x31, 0x31, 0x11}, CallstackInfo::kComplete);
+  AddCallstackInfo(kCallstack3Id, {0x32, 0x11}, CallstackInfo::kDwarfUnwindingError);
+
+  AddCallstackEvent(kCallstack1Id, kThreadId1);
+  AddCallstackEvent(kCallstack1Id, kThreadId1);
+  AddCallstackEvent(kCallstack2Id, kThreadId2);
+  ExpectAggregatorMatchesPostProcessingAllEvents();
+
+  AddCallstackEvent(kCallstack3Id, kThreadId1);
+  AddCallstackEvent(kCallstack2Id, kThreadId1);
+  AddCallstackEvent(kCallstack1Id, kThreadId2);
+  ExpectAggregatorMatchesPostProcessingAllEvents();
+}
+
+TEST_F(SamplingDataAggregatorTest, ClearRemovesAllSamples) {
+  AddCallstackInfo(kCallstack1Id, {0x31, 0x21, 0x11}, CallstackInfo::kComplete);
+  AddCallstackEvent(kCallstack1Id, kThreadId1);
+  EXPECT_EQ(aggregator_.GetSamplesCount(), 1);
+
+  aggregator_.Clear();
+
+  EXPECT_EQ(aggregator_.GetSamplesCount(), 0);
+  PostProcessedSamplingData post_processed_sampling_data =
+      aggregator_.CreatePostProcessedSamplingData(capture_data_.GetCallstackData(), capture_data_);
+  EXPECT_TRUE(post_processed_sampling_data.GetThreadSampleData().empty());
+}
+
+}  // namespace
+
+}  // namespace orbit_client_model
@@ -8,27 +8,32 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "ClientData/CallstackEventStore.h"
 #include "ClientData/CallstackTypes.h"
+#include "OrbitBase/Future.h"
+#include "OrbitBase/JoinFutures.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ThreadConstants.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
 #include "capture_data.pb.h"
 
 using orbit_client_data::CallstackData;
+using orbit_client_data::CallstackEventStore;
 using orbit_client_data::CaptureData;
 using orbit_client_data::PostProcessedSamplingData;
 using orbit_client_data::SampledFunction;
 using orbit_client_data::ThreadID;
 using orbit_client_data::ThreadSampleData;
 
-using orbit_client_protos::CallstackEvent;
 using orbit_client_protos::CallstackInfo;
 
 namespace orbit_client_model {
@@ -98,9 +103,32 @@ class SamplingDataPostProcessor {
   SamplingDataPostProcessor& operator=(SamplingDataPostProcessor&& other) = default;
 
   PostProcessedSamplingData ProcessSamples(const CallstackData& callstack_data,
-                                           const CaptureData& capture_data, bool generate_summary);
+                                           const CaptureData& capture_data, bool generate_summary,
+                                           orbit_base::ThreadPool* thread_pool);
+
+  PostProcessedSamplingData ProcessCallstackCounts(
+      ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count,
+      const CallstackData& callstack_data, const CaptureData& capture_data, bool generate_summary,
+      orbit_base::ThreadPool* thread_pool);
 
  private:
+  // What a sampled callstack contributes to the statistics of a thread, per sample.
+  struct ExpandedCallstack {
+    bool is_complete = false;
+    uint64_t resolved_innermost_frame = 0;
+    std::vector<uint64_t> unique_frames;
+    std::vector<uint64_t> unique_resolved_frames;
+  };
+
+  // Requires ResolveCallstacks to have been called. Can be called concurrently.
+  [[nodiscard]] ExpandedCallstack ExpandCallstack(const CallstackData& callstack_data,
+                                                  uint64_t callstack_id) const;
+
+  static void AccumulateThreadSampleData(
+      const absl::flat_hash_map<uint64_t, size_t>& sampled_callstack_id_to_index,
+      const std::vector<ExpandedCallstack>& expanded_callstacks,
+      ThreadSampleData* thread_sample_data);
+
   void SortByThreadUsage();
 
   void ResolveCallstacks(const CallstackData& callstack_data, const CaptureData& capture_data);
@@ -125,97 +153,134 @@ class SamplingDataPostProcessor {
 
 PostProcessedSamplingData CreatePostProcessedSamplingData(const CallstackData& callstack_data,
                                                           const CaptureData& capture_data,
-                                                          bool generate_summary) {
-  return SamplingDataPostProcessor{}.ProcessSamples(callstack_data, capture_data, generate_summary);
+                                                          bool generate_summary,
+                                                          orbit_base::ThreadPool* thread_pool) {
+  return SamplingDataPostProcessor{}.ProcessSamples(callstack_data, capture_data, generate_summary,
+                                                    thread_pool);
 }
 
-namespace {
-PostProcessedSamplingData SamplingDataPostProcessor::ProcessSamples(
-    const CallstackData& callstack_data, const CaptureData& capture_data, bool generate_summary) {
-  // Unique call stacks and per thread data
-  callstack_data.ForEachCallstackEvent(
-      [this, &callstack_data, generate_summary](const CallstackEvent& event) {
-        CHECK(callstack_data.HasCallstack(event.callstack_id()));
-        const orbit_client_protos::CallstackInfo* callstack_info =
-            callstack_data.GetCallstack(event.callstack_id());
-
-        // For non-kComplete callstacks, only use the innermost frame for statistics, as it's the
-        // only one known to be correct. Note that, in the vast majority of cases, the innermost
-        // frame is also the only one available.
-        absl::flat_hash_set<uint64_t> unique_frames;
-        CHECK(!callstack_info->frames().empty());
-        if (callstack_info->type() == CallstackInfo::kComplete) {
-          for (uint64_t frame : callstack_info->frames()) {
-            unique_frames.insert(frame);
-          }
-        } else {
-          unique_frames.insert(callstack_info->frames(0));
-        }
-
-        ThreadSampleData* thread_sample_data = &thread_id_to_sample_data_[event.thread_id()];
-        thread_sample_data->samples_count++;
-        thread_sample_data->sampled_callstack_id_to_count[event.callstack_id()]++;
-        for (uint64_t frame : unique_frames) {
-          thread_sample_data->sampled_address_to_count[frame]++;
-        }
-
-        if (!generate_summary) {
-          return;
-        }
-        ThreadSampleData* all_thread_sample_data =
-            &thread_id_to_sample_data_[orbit_base::kAllProcessThreadsTid];
-        all_thread_sample_data->samples_count++;
-        all_thread_sample_data->sampled_callstack_id_to_count[event.callstack_id()]++;
-        for (uint64_t frame : unique_frames) {
-          all_thread_sample_data->sampled_address_to_count[frame]++;
-        }
-      });
+PostProcessedSamplingData CreatePostProcessedSamplingDataFromCallstackCounts(
+    ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count,
+    const CallstackData& callstack_data, const CaptureData& capture_data, bool generate_summary,
+    orbit_base::ThreadPool* thread_pool) {
+  return SamplingDataPostProcessor{}.ProcessCallstackCounts(
+      std::move(thread_id_to_callstack_id_to_count), callstack_data, capture_data,
+      generate_summary, thread_pool);
+}
 
-  ResolveCallstacks(callstack_data, capture_data);
+namespace {
 
-  for (auto& sample_data_it : thread_id_to_sample_data_) {
-    ThreadSampleData* thread_sample_data = &sample_data_it.second;
+// Runs `action(index)` for every index in [0, size). The indices are split into contiguous chunks
+// that are scheduled on `thread_pool`, or the indices are processed on the calling thread if
+// `thread_pool` is nullptr.
+void ForEachIndexInParallel(orbit_base::ThreadPool* thread_pool, size_t size,
+                            const std::function<void(size_t)>& action) {
+  if (thread_pool == nullptr || size <= 1) {
+    for (size_t index = 0; index < size; ++index) {
+      action(index);
+    }
+    return;
+  }
 
-    // Address count per sample per thread
-    for (const auto& [sampled_callstack_id, callstack_count] :
-         thread_sample_data->sampled_callstack_id_to_count) {
-      uint64_t resolved_callstack_id = original_id_to_resolved_callstack_id_[sampled_callstack_id];
-      const CallstackInfo& resolved_callstack = id_to_resolved_callstack_[resolved_callstack_id];
+  const size_t number_of_tasks = std::min(size, thread_pool->GetPoolSize());
+  const size_t indices_per_task = (size + number_of_tasks - 1) / number_of_tasks;
+  std::vector<orbit_base::Future<void>> futures;
+  futures.reserve(number_of_tasks);
+  for (size_t begin = 0; begin < size; begin += indices_per_task) {
+    const size_t end = std::min(begin + indices_per_task, size);
+    futures.emplace_back(thread_pool->Schedule([begin, end, &action] {
+      for (size_t index = begin; index < end; ++index) {
+        action(index);
+      }
+    }));
+  }
+  orbit_base::JoinFutures(absl::MakeConstSpan(futures)).Wait();
+}
 
-      // "Exclusive" stat.
-      CHECK(!resolved_callstack.frames().empty());
-      thread_sample_data->resolved_address_to_exclusive_count[resolved_callstack.frames(0)] +=
-          callstack_count;
+PostProcessedSamplingData SamplingDataPostProcessor::ProcessSamples(
+    const CallstackData& callstack_data, const CaptureData& capture_data, bool generate_summary,
+    orbit_base::ThreadPool* thread_pool) {
+  // First phase: only count how many times each callstack was sampled in each thread. The frames
+  // are only looked at once per unique callstack in ProcessCallstackCounts, instead of once per
+  // sample.
+  absl::Mutex mutex;
+  ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count;
+  callstack_data.ForEachThreadCallstackEventsInParallel(
+      thread_pool, [&mutex, &thread_id_to_callstack_id_to_count](
+                       ThreadID thread_id, const CallstackEventStore& events) {
+        absl::flat_hash_map<uint64_t, uint32_t> callstack_id_to_count;
+        events.ForEachEvent(
+            [&callstack_id_to_count](uint64_t /*timestamp*/, uint64_t callstack_id) {
+              callstack_id_to_count[callstack_id]++;
+            });
+        absl::MutexLock lock(&mutex);
+        thread_id_to_callstack_id_to_count.insert_or_assign(thread_id,
+                                                            std::move(callstack_id_to_count));
+      });
 
-      absl::flat_hash_set<uint64_t> unique_resolved_addresses;
-      if (resolved_callstack.type() == CallstackInfo::kComplete) {
-        for (uint64_t resolved_address : resolved_callstack.frames()) {
-          unique_resolved_addresses.insert(resolved_address);
-        }
-      } else {
-        // For non-kComplete callstacks, only use the innermost frame for statistics.
-        unique_resolved_addresses.insert(resolved_callstack.frames(0));
-      }
+  return ProcessCallstackCounts(std::move(thread_id_to_callstack_id_to_count), callstack_data,
+                                capture_data, generate_summary, thread_pool);
+}
 
-      // "Inclusive" stat.
-      for (uint64_t resolved_address : unique_resolved_addresses) {
-        thread_sample_data->resolved_address_to_count[resolved_address] += callstack_count;
-      }
+PostProcessedSamplingData SamplingDataPostProcessor::ProcessCallstackCounts(
+    ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count,
+    const CallstackData& callstack_data, const CaptureData& capture_data, bool generate_summary,
+    orbit_base::ThreadPool* thread_pool) {
+  for (auto& [thread_id, callstack_id_to_count] : thread_id_to_callstack_id_to_count) {
+    ThreadSampleData thread_sample_data;
+    for (const auto& [unused_callstack_id, count] : callstack_id_to_count) {
+      thread_sample_data.samples_count += count;
+    }
+    thread_sample_data.sampled_callstack_id_to_count = std::move(callstack_id_to_count);
+    thread_id_to_sample_data_.insert_or_assign(thread_id, std::move(thread_sample_data));
+  }
 
-      // "Unwind errors" stat.
-      if (resolved_callstack.type() != CallstackInfo::kComplete) {
-        thread_sample_data->resolved_address_to_error_count[resolved_callstack.frames(0)] +=
-            callstack_count;
+  if (generate_summary && !thread_id_to_sample_data_.empty()) {
+    ThreadSampleData all_thread_sample_data;
+    for (const auto& [unused_thread_id, thread_sample_data] : thread_id_to_sample_data_) {
+      all_thread_sample_data.samples_count += thread_sample_data.samples_count;
+      for (const auto& [callstack_id, count] : thread_sample_data.sampled_callstack_id_to_count) {
+        all_thread_sample_data.sampled_callstack_id_to_count[callstack_id] += count;
       }
     }
+    thread_id_to_sample_data_.insert_or_assign(orbit_base::kAllProcessThreadsTid,
+                                               std::move(all_thread_sample_data));
+  }
 
-    // For each thread, sort resolved (function) addresses by inclusive count.
-    for (const auto& address_count_it : thread_sample_data->resolved_address_to_count) {
-      const uint64_t address = address_count_it.first;
-      const uint32_t count = address_count_it.second;
-      thread_sample_data->sorted_count_to_resolved_address.insert(std::make_pair(count, address));
+  ResolveCallstacks(callstack_data, capture_data);
+
+  // Second phase: expand each sampled callstack once...
+  std::vector<uint64_t> sampled_callstack_ids;
+  absl::flat_hash_map<uint64_t, size_t> sampled_callstack_id_to_index;
+  for (const auto& [unused_thread_id, thread_sample_data] : thread_id_to_sample_data_) {
+    for (const auto& [callstack_id, unused_count] :
+         thread_sample_data.sampled_callstack_id_to_count) {
+      if (sampled_callstack_id_to_index.try_emplace(callstack_id, sampled_callstack_ids.size())
+              .second) {
+        sampled_callstack_ids.push_back(callstack_id);
+      }
     }
   }
+  std::vector<ExpandedCallstack> expanded_callstacks(sampled_callstack_ids.size());
+  ForEachIndexInParallel(thread_pool, sampled_callstack_ids.size(),
+                         [this, &callstack_data, &sampled_callstack_ids,
+                          &expanded_callstacks](size_t index) {
+                           expanded_callstacks[index] =
+                               ExpandCallstack(callstack_data, sampled_callstack_ids[index]);
+                         });
+
+  // ...and then accumulate the statistics of each thread from the sample counts.
+  std::vector<ThreadSampleData*> thread_sample_datas;
+  thread_sample_datas.reserve(thread_id_to_sample_data_.size());
+  for (auto& [unused_thread_id, thread_sample_data] : thread_id_to_sample_data_) {
+    thread_sample_datas.push_back(&thread_sample_data);
+  }
+  ForEachIndexInParallel(
+      thread_pool, thread_sample_datas.size(),
+      [&thread_sample_datas, &sampled_callstack_id_to_index, &expanded_callstacks](size_t index) {
+        AccumulateThreadSampleData(sampled_callstack_id_to_index, expanded_callstacks,
+                                   thread_sample_datas[index]);
+      });
 
   FillThreadSampleDataSampleReports(capture_data);
 
@@ -227,6 +292,86 @@ PostProcessedSamplingData SamplingDataPostProcessor::ProcessSamples(
       std::move(function_address_to_sampled_callstack_ids_), std::move(sorted_thread_sample_data_));
 }
 
+SamplingDataPostProcessor::ExpandedCallstack SamplingDataPostProcessor::ExpandCallstack(
+    const CallstackData& callstack_data, uint64_t callstack_id) const {
+  CHECK(callstack_data.HasCallstack(callstack_id));
+  const CallstackInfo* callstack_info = callstack_data.GetCallstack(callstack_id);
+  CHECK(!callstack_info->frames().empty());
+
+  auto resolved_callstack_id_it = original_id_to_resolved_callstack_id_.find(callstack_id);
+  CHECK(resolved_callstack_id_it != original_id_to_resolved_callstack_id_.end());
+  auto resolved_callstack_it = id_to_resolved_callstack_.find(resolved_callstack_id_it->second);
+  CHECK(resolved_callstack_it != id_to_resolved_callstack_.end());
+  const CallstackInfo& resolved_callstack = resolved_callstack_it->second;
+  CHECK(!resolved_callstack.frames().empty());
+
+  ExpandedCallstack expanded_callstack;
+  expanded_callstack.is_complete = callstack_info->type() == CallstackInfo::kComplete;
+  expanded_callstack.resolved_innermost_frame = resolved_callstack.frames(0);
+
+  // For non-kComplete callstacks, only use the innermost frame for statistics, as it's the only
+  // one known to be correct. Note that, in the vast majority of cases, the innermost frame is also
+  // the only one available.
+  if (expanded_callstack.is_complete) {
+    expanded_callstack.unique_frames = {callstack_info->frames().begin(),
+                                        callstack_info->frames().end()};
+    expanded_callstack.unique_resolved_frames = {resolved_callstack.frames().begin(),
+                                                 resolved_callstack.frames().end()};
+  } else {
+    expanded_callstack.unique_frames = {callstack_info->frames(0)};
+    expanded_callstack.unique_resolved_frames = {resolved_callstack.frames(0)};
+  }
+  for (std::vector<uint64_t>* frames :
+       {&expanded_callstack.unique_frames, &expanded_callstack.unique_resolved_frames}) {
+    std::sort(frames->begin(), frames->end());
+    frames->erase(std::unique(frames->begin(), frames->end()), frames->end());
+  }
+  return expanded_callstack;
+}
+
+void SamplingDataPostProcessor::AccumulateThreadSampleData(
+    const absl::flat_hash_map<uint64_t, size_t>& sampled_callstack_id_to_index,
+    const std::vector<ExpandedCallstack>& expanded_callstacks,
+    ThreadSampleData* thread_sample_data) {
+  for (const auto& [sampled_callstack_id, callstack_count] :
+       thread_sample_data->sampled_callstack_id_to_count) {
+    const ExpandedCallstack& expanded_callstack =
+        expanded_callstacks[sampled_callstack_id_to_index.at(sampled_callstack_id)];
+
+    for (uint64_t frame : expanded_callstack.unique_frames) {
+      thread_sample_data->sampled_address_to_count[frame] += callstack_count;
+    }
+
+    // "Exclusive" stat.
+    thread_sample_data
+        ->resolved_address_to_exclusive_count[expanded_callstack.resolved_innermost_frame] +=
+        callstack_count;
+
+    // "Inclusive" stat.
+    for (uint64_t resolved_address : expanded_callstack.unique_resolved_frames) {
+      thread_sample_data->resolved_address_to_count[resolved_address] += callstack_count;
+    }
+
+    // "Unwind errors" stat.
+    if (!expanded_callstack.is_complete) {
+      thread_sample_data
+          ->resolved_address_to_error_count[expanded_callstack.resolved_innermost_frame] +=
+          callstack_count;
+    }
+  }
+
+  // Sort resolved (function) addresses by inclusive count. Insert them by increasing address, so
+  // that the order of addresses with the same count doesn't depend on the iteration order of the
+  // hash map, which can differ between runs.
+  std::vector<std::pair<uint64_t, uint32_t>> addresses_and_counts(
+      thread_sample_data->resolved_address_to_count.begin(),
+      thread_sample_data->resolved_address_to_count.end());
+  std::sort(addresses_and_counts.begin(), addresses_and_counts.end());
+  for (const auto& [address, count] : addresses_and_counts) {
+    thread_sample_data->sorted_count_to_resolved_address.insert(std::make_pair(count, address));
+  }
+}
+
 void SamplingDataPostProcessor::SortByThreadUsage() {
   sorted_thread_sample_data_.reserve(thread_id_to_sample_data_.size());
 
@@ -6,12 +6,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <vector>
 
 #include "ClientData/CaptureData.h"
 #include "ClientData/ModuleManager.h"
 #include "ClientModel/SamplingDataPostProcessor.h"
 #include "OrbitBase/ThreadConstants.h"
+#include "OrbitBase/ThreadPool.h"
 #include "capture_data.pb.h"
 
 using orbit_client_data::CallstackCount;
@@ -353,6 +355,15 @@ class SamplingDataPostProcessorTest : public ::testing::Test {
                                             /*generate_summary=*/true);
   }
 
+  void CreatePostProcessedSamplingDataWithSummaryOnThreadPool() {
+    std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+        orbit_base::ThreadPool::Create(/*thread_pool_min_size=*/4, /*thread_pool_max_size=*/4,
+                                       /*thread_ttl=*/absl::Seconds(1));
+    ppsd_ = CreatePostProcessedSamplingData(capture_data_.GetCallstackData(), capture_data_,
+                                            /*generate_summary=*/true, thread_pool.get());
+    thread_pool->ShutdownAndWait();
+  }
+
   PostProcessedSamplingData ppsd_;
 
   void VerifyNoCallstackInfos() {
@@ -1698,4 +1709,69 @@ TEST_F(SamplingDataPostProcessorTest, TwoThreadsWithSummaryWithMixedCallstackTyp
   VerifyEmptySortedCallstackReport(kThreadIdNotSampled);
 }
 
+TEST_F(SamplingDataPostProcessorTest, TwoThreadsWithSummaryWithMixedCallstackTypesOnThreadPool) {
+  AddAllCallstackInfosWithMixedCallstackTypes();
+  AddAllAddressInfos();
+
+  AddCallstackEventsInThreadId1And2();
+
+  CreatePostProcessedSamplingDataWithSummaryOnThreadPool();
+
+  VerifyAllCallstackInfosWithMixedCallstackTypes();
+
+  EXPECT_EQ(ppsd_.GetThreadSampleData().size(), 3);
+  ASSERT_NE(ppsd_.GetSummary(), nullptr);
+
+  ASSERT_NE(ppsd_.GetThreadSampleDataByThreadId(kThreadId1), nullptr);
+  ASSERT_NE(ppsd_.GetThreadSampleDataByThreadId(kThreadId2), nullptr);
+  EXPECT_THAT(ppsd_.GetThreadSampleData(),
+              ElementsAre(ThreadSampleDataEq(*ppsd_.GetSummary()),
+                          ThreadSampleDataEq(*ppsd_.GetThreadSampleDataByThreadId(kThreadId2)),
+                          ThreadSampleDataEq(*ppsd_.GetThreadSampleDataByThreadId(kThreadId1))));
+
+  VerifyThreadSampleDataForCallstackEventsAllInTheSameThreadWithMixedCallstackTypes(
+      *ppsd_.GetSummary(), orbit_base::kAllProcessThreadsTid);
+  VerifyThreadSampleDataForCallstackEventsInThreadId1WithMixedCallstackTypes(
+      *ppsd_.GetThreadSampleDataByThreadId(kThreadId1));
+  VerifyThreadSampleDataForCallstackEventsInThreadId2WithMixedCallstackTypes(
+      *ppsd_.GetThreadSampleDataByThreadId(kThreadId2));
+
+  VerifyGetCountOfFunctionWithMixedCallstackTypes();
+
+  VerifySortedCallstackReportForCallstackEventsAllInTheSameThreadWithMixedCallstackTypes(
+      orbit_base::kAllProcessThreadsTid);
+  VerifySortedCallstackReportForCallstackEventsInThreadId1WithMixedCallstackTypes();
+  VerifySortedCallstackReportForCallstackEventsInThreadId2WithMixedCallstackTypes();
+  VerifyEmptySortedCallstackReport(kThreadIdNotSampled);
+}
+
+TEST_F(SamplingDataPostProcessorTest, ManyThreadsOnThreadPoolGiveSameResultAsOnCallingThread) {
+  AddAllCallstackInfosWithMixedCallstackTypes();
+  AddAllAddressInfos();
+
+  constexpr int32_t kThreadCount = 50;
+  const std::vector<uint64_t> callstack_ids{kCallstack1Id, kCallstack2Id, kCallstack3Id,
+                                            kCallstack4Id};
+  for (int32_t thread_index = 0; thread_index < kThreadCount; ++thread_index) {
+    for (int32_t sample_index = 0; sample_index <= thread_index; ++sample_index) {
+      AddCallstackEvent(callstack_ids[(thread_index + sample_index) % callstack_ids.size()],
+                        kThreadId1 + thread_index);
+    }
+  }
+
+  CreatePostProcessedSamplingDataWithSummary();
+  PostProcessedSamplingData expected_ppsd = std::move(ppsd_);
+  CreatePostProcessedSamplingDataWithSummaryOnThreadPool();
+
+  ASSERT_EQ(ppsd_.GetThreadSampleData().size(), kThreadCount + 1);
+  ASSERT_EQ(expected_ppsd.GetThreadSampleData().size(), kThreadCount + 1);
+  for (const ThreadSampleData& expected_thread_sample_data :
+       expected_ppsd.GetThreadSampleData()) {
+    const ThreadSampleData* thread_sample_data =
+        ppsd_.GetThreadSampleDataByThreadId(expected_thread_sample_data.thread_id);
+    ASSERT_NE(thread_sample_data, nullptr);
+    EXPECT_THAT(*thread_sample_data, ThreadSampleDataEq(expected_thread_sample_data));
+  }
+}
+
 }  // namespace orbit_client_model
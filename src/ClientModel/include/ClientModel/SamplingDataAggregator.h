@@ -0,0 +1,46 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_MODEL_SAMPLING_DATA_AGGREGATOR_H_
+#define CLIENT_MODEL_SAMPLING_DATA_AGGREGATOR_H_
+
+#include <absl/synchronization/mutex.h>
+
+#include <cstdint>
+
+#include "ClientData/CallstackData.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientModel/SamplingDataPostProcessor.h"
+#include "OrbitBase/ThreadPool.h"
+#include "capture_data.pb.h"
+
+namespace orbit_client_model {
+
+// Counts the samples of each callstack per thread while callstack events arrive during a capture.
+// This allows to create the PostProcessedSamplingData (and from it, the call trees) of the capture
+// so far at any time, at a cost that depends on the number of unique callstacks and not on the
+// number of samples received. This class is thread-safe.
+class SamplingDataAggregator {
+ public:
+  void AddCallstackEvent(const orbit_client_protos::CallstackEvent& callstack_event);
+  void Clear();
+
+  [[nodiscard]] uint64_t GetSamplesCount() const;
+
+  // `callstack_data` needs to contain the unique callstacks of all the callstack events added.
+  [[nodiscard]] orbit_client_data::PostProcessedSamplingData CreatePostProcessedSamplingData(
+      const orbit_client_data::CallstackData& callstack_data,
+      const orbit_client_data::CaptureData& capture_data, bool generate_summary = true,
+      orbit_base::ThreadPool* thread_pool = nullptr) const;
+
+ private:
+  mutable absl::Mutex mutex_;
+  ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count_ ABSL_GUARDED_BY(mutex_);
+  uint64_t samples_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace orbit_client_model
+
+#endif  // CLIENT_MODEL_SAMPLING_DATA_AGGREGATOR_H_
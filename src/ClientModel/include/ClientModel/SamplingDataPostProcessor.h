@@ -5,14 +5,36 @@
 #ifndef CLIENT_MODEL_SAMPLING_DATA_POST_PROCESSOR_H_
 #define CLIENT_MODEL_SAMPLING_DATA_POST_PROCESSOR_H_
 
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+
 #include "ClientData/CallstackData.h"
+#include "ClientData/CallstackTypes.h"
 #include "ClientData/CaptureData.h"
 #include "ClientData/PostProcessedSamplingData.h"
+#include "OrbitBase/ThreadPool.h"
 
 namespace orbit_client_model {
+// If `thread_pool` is not nullptr, the work is distributed over its threads. The calling thread
+// blocks until the result is ready in any case, so it must not be one of the threads of the pool.
 orbit_client_data::PostProcessedSamplingData CreatePostProcessedSamplingData(
     const orbit_client_data::CallstackData& callstack_data,
-    const orbit_client_data::CaptureData& capture_data, bool generate_summary = true);
+    const orbit_client_data::CaptureData& capture_data, bool generate_summary = true,
+    orbit_base::ThreadPool* thread_pool = nullptr);
+
+// The number of samples of each callstack id, per thread id.
+using ThreadIdToCallstackIdToCount =
+    absl::flat_hash_map<orbit_client_data::ThreadID, absl::flat_hash_map<uint64_t, uint32_t>>;
+
+// Like CreatePostProcessedSamplingData, but starting from the number of samples of each callstack
+// instead of from the individual callstack events. Only the unique callstacks of `callstack_data`
+// are used.
+orbit_client_data::PostProcessedSamplingData CreatePostProcessedSamplingDataFromCallstackCounts(
+    ThreadIdToCallstackIdToCount thread_id_to_callstack_id_to_count,
+    const orbit_client_data::CallstackData& callstack_data,
+    const orbit_client_data::CaptureData& capture_data, bool generate_summary = true,
+    orbit_base::ThreadPool* thread_pool = nullptr);
 }  // namespace orbit_client_model
 
 #endif  // CLIENT_MODEL_SAMPLING_DATA_POST_PROCESSOR_H_
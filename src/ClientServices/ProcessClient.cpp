@@ -4,6 +4,7 @@
 
 #include "ClientServices/ProcessClient.h"
 
+#include <absl/container/flat_hash_map.h>
 #include <grpcpp/grpcpp.h>
 
 #include <chrono>
@@ -26,10 +27,12 @@ using orbit_grpc_protos::GetModuleListRequest;
 using orbit_grpc_protos::GetModuleListResponse;
 using orbit_grpc_protos::GetProcessListRequest;
 using orbit_grpc_protos::GetProcessListResponse;
+using orbit_grpc_protos::GetProcessListUpdatesRequest;
 using orbit_grpc_protos::GetProcessMemoryRequest;
 using orbit_grpc_protos::GetProcessMemoryResponse;
 using orbit_grpc_protos::ModuleInfo;
 using orbit_grpc_protos::ProcessInfo;
+using orbit_grpc_protos::ProcessListUpdate;
 
 constexpr uint64_t kGrpcDefaultTimeoutMilliseconds = 3000;
 
@@ -63,6 +66,41 @@ ErrorMessageOr<std::vector<orbit_grpc_protos::ProcessInfo>> ProcessClient::GetPr
   return std::vector<ProcessInfo>(processes.begin(), processes.end());
 }
 
+ErrorMessageOr<void> ProcessClient::ReceiveProcessListUpdates(
+    grpc::ClientContext* context, absl::Duration refresh_interval,
+    const std::function<void(std::vector<ProcessInfo>)>& listener) {
+  GetProcessListUpdatesRequest request;
+  request.set_refresh_interval_ms(absl::ToInt64Milliseconds(refresh_interval));
+  std::unique_ptr<grpc::ClientReader<ProcessListUpdate>> reader =
+      process_service_->GetProcessListUpdates(context, request);
+
+  absl::flat_hash_map<int32_t, ProcessInfo> processes;
+  ProcessListUpdate update;
+  while (reader->Read(&update)) {
+    for (int32_t pid : update.removed_pids()) {
+      processes.erase(pid);
+    }
+    for (ProcessInfo& process_info : *update.mutable_updated_processes()) {
+      processes.insert_or_assign(process_info.pid(), std::move(process_info));
+    }
+
+    std::vector<ProcessInfo> process_list;
+    process_list.reserve(processes.size());
+    for (const auto& [unused_pid, process_info] : processes) {
+      process_list.push_back(process_info);
+    }
+    listener(std::move(process_list));
+  }
+
+  grpc::Status status = reader->Finish();
+  if (!status.ok()) {
+    ERROR("gRPC call to GetProcessListUpdates failed: %s (error_code=%d)", status.error_message(),
+          status.error_code());
+    return ErrorMessage(status.error_message());
+  }
+  return outcome::success();
+}
+
 ErrorMessageOr<std::vector<ModuleInfo>> ProcessClient::LoadModuleList(int32_t pid) {
   ORBIT_SCOPE_FUNCTION;
   GetModuleListRequest request;
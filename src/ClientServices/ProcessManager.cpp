@@ -52,12 +52,18 @@ class ProcessManagerImpl final : public ProcessManager {
 
  private:
   void WorkerFunction();
+  // Returns whether the process list was received at least once.
+  [[nodiscard]] bool ReceiveProcessListUpdates();
+  void PollProcessList();
+  void CallProcessListUpdateListener(std::vector<ProcessInfo> processes);
 
   std::unique_ptr<ProcessClient> process_client_;
 
   absl::Duration refresh_timeout_;
   absl::Mutex shutdown_mutex_;
-  bool shutdown_initiated_;
+  bool shutdown_initiated_ ABSL_GUARDED_BY(shutdown_mutex_);
+  // The context of the running call to GetProcessListUpdates, if any, to cancel it on shutdown.
+  grpc::ClientContext* process_list_updates_context_ ABSL_GUARDED_BY(shutdown_mutex_) = nullptr;
 
   absl::Mutex process_list_update_listener_mutex_;
   std::function<void(std::vector<orbit_grpc_protos::ProcessInfo>)> process_list_update_listener_;
@@ -93,6 +99,9 @@ void ProcessManagerImpl::Start() {
 void ProcessManagerImpl::ShutdownAndWait() noexcept {
   shutdown_mutex_.Lock();
   shutdown_initiated_ = true;
+  if (process_list_updates_context_ != nullptr) {
+    process_list_updates_context_->TryCancel();
+  }
   shutdown_mutex_.Unlock();
   if (worker_thread_.joinable()) {
     worker_thread_.join();
@@ -102,6 +111,44 @@ void ProcessManagerImpl::ShutdownAndWait() noexcept {
 bool IsTrue(bool* var) { return *var; }
 
 void ProcessManagerImpl::WorkerFunction() {
+  // The service streams the changes of the process list, which is much cheaper than sending the
+  // whole list every time. Services that don't support this yet are polled instead.
+  while (ReceiveProcessListUpdates()) {
+    // The stream ended, e.g., because the connection was lost. Retry after a while, unless
+    // shutdown was initiated.
+    if (shutdown_mutex_.LockWhenWithTimeout(absl::Condition(IsTrue, &shutdown_initiated_),
+                                            refresh_timeout_)) {
+      shutdown_mutex_.Unlock();
+      return;
+    }
+    shutdown_mutex_.Unlock();
+  }
+  PollProcessList();
+}
+
+bool ProcessManagerImpl::ReceiveProcessListUpdates() {
+  grpc::ClientContext context;
+  {
+    absl::MutexLock lock(&shutdown_mutex_);
+    if (shutdown_initiated_) return true;
+    process_list_updates_context_ = &context;
+  }
+
+  bool received_process_list = false;
+  // Errors are logged by ProcessClient.
+  (void)process_client_->ReceiveProcessListUpdates(
+      &context, refresh_timeout_,
+      [this, &received_process_list](std::vector<ProcessInfo> processes) {
+        received_process_list = true;
+        CallProcessListUpdateListener(std::move(processes));
+      });
+
+  absl::MutexLock lock(&shutdown_mutex_);
+  process_list_updates_context_ = nullptr;
+  return received_process_list || shutdown_initiated_;
+}
+
+void ProcessManagerImpl::PollProcessList() {
   while (true) {
     if (shutdown_mutex_.LockWhenWithTimeout(absl::Condition(IsTrue, &shutdown_initiated_),
                                             refresh_timeout_)) {
@@ -117,10 +164,14 @@ void ProcessManagerImpl::WorkerFunction() {
       continue;
     }
 
-    absl::MutexLock callback_lock(&process_list_update_listener_mutex_);
-    if (process_list_update_listener_) {
-      process_list_update_listener_(std::move(result.value()));
-    }
+    CallProcessListUpdateListener(std::move(result.value()));
+  }
+}
+
+void ProcessManagerImpl::CallProcessListUpdateListener(std::vector<ProcessInfo> processes) {
+  absl::MutexLock callback_lock(&process_list_update_listener_mutex_);
+  if (process_list_update_listener_) {
+    process_list_update_listener_(std::move(processes));
   }
 }
 
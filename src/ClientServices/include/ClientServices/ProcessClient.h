@@ -5,9 +5,11 @@
 #ifndef CLIENT_SERVICES_PROCESS_CLIENT_H_
 #define CLIENT_SERVICES_PROCESS_CLIENT_H_
 
+#include <absl/time/time.h>
 #include <stdint.h>
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -29,6 +31,13 @@ class ProcessClient {
 
   [[nodiscard]] ErrorMessageOr<std::vector<orbit_grpc_protos::ProcessInfo>> GetProcessList();
 
+  // Asks the service to refresh the process list every `refresh_interval`, and calls `listener`
+  // with the complete list every time the service reports that it changed. The service only sends
+  // what changed. Blocks until the call fails or is cancelled through `context`.
+  [[nodiscard]] ErrorMessageOr<void> ReceiveProcessListUpdates(
+      grpc::ClientContext* context, absl::Duration refresh_interval,
+      const std::function<void(std::vector<orbit_grpc_protos::ProcessInfo>)>& listener);
+
   [[nodiscard]] ErrorMessageOr<std::vector<orbit_grpc_protos::ModuleInfo>> LoadModuleList(
       int32_t pid);
 
@@ -7,9 +7,12 @@
 #include <algorithm>
 #include <limits>
 #include <optional>
+#include <vector>
 
 #include "ClientData/PostProcessedSamplingData.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+#include "symbol.pb.h"
 
 namespace orbit_code_report {
 
@@ -19,20 +22,29 @@ SourceCodeReport::SourceCodeReport(std::string_view source_file,
                                    const orbit_client_data::ThreadSampleData& thread_sample_data,
                                    uint32_t total_samples_in_capture)
     : total_samples_in_capture_(total_samples_in_capture) {
-  for (size_t offset = 0; offset < function.size(); ++offset) {
-    const uint32_t current_samples =
-        thread_sample_data.GetCountForAddress(absolute_address + offset);
-    if (current_samples == 0) continue;
+  const ErrorMessageOr<std::vector<orbit_object_utils::AddressRangeLineInfo>> line_infos =
+      elf_file->GetLineInfosOfAddressRange(function.address(),
+                                           function.address() + function.size());
+  if (line_infos.has_error()) {
+    ERROR("Unable to get line info for function \"%s\": %s", function.pretty_name(),
+          line_infos.error().message());
+    return;
+  }
 
-    const auto maybe_current_line_info = elf_file->GetLineInfo(function.address() + offset);
-    if (!maybe_current_line_info.has_value()) continue;
+  for (const orbit_object_utils::AddressRangeLineInfo& range : line_infos.value()) {
+    uint32_t current_samples = 0;
+    for (uint64_t address = range.start_address; address < range.end_address; ++address) {
+      current_samples +=
+          thread_sample_data.GetCountForAddress(absolute_address + address - function.address());
+    }
+    if (current_samples == 0) continue;
 
-    const auto& current_line_info = maybe_current_line_info.value();
+    const orbit_grpc_protos::LineInfo& current_line_info = range.line_info;
     if (source_file != current_line_info.source_file()) {
       ERROR(
           "Was trying to gather sampling data for function \"%s\" but the debug information "
           "tells me the function address %#x is defined in a different source file.",
-          function.pretty_name(), function.address() + offset);
+          function.pretty_name(), range.start_address);
       ERROR("Expected: %s", source_file);
       ERROR("Actual: %s", current_line_info.source_file());
       continue;
@@ -5,6 +5,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "ClientData/PostProcessedSamplingData.h"
 #include "CodeReport/SourceCodeReport.h"
 #include "ObjectUtils/ObjectFile.h"
@@ -26,6 +28,8 @@ class MockElfFile : public orbit_object_utils::ElfFile {
   MOCK_METHOD(std::string, GetSoname, (), (const, override));
   MOCK_METHOD(std::string, GetBuildId, (), (const, override));
   MOCK_METHOD(ErrorMessageOr<orbit_grpc_protos::LineInfo>, GetLineInfo, (uint64_t), (override));
+  MOCK_METHOD(ErrorMessageOr<std::vector<orbit_object_utils::AddressRangeLineInfo>>,
+              GetLineInfosOfAddressRange, (uint64_t, uint64_t), (override));
   MOCK_METHOD(ErrorMessageOr<orbit_grpc_protos::LineInfo>, GetDeclarationLocationOfFunction,
               (uint64_t), (override));
   MOCK_METHOD(std::optional<orbit_object_utils::GnuDebugLinkInfo>, GetGnuDebugLinkInfo, (),
@@ -49,6 +53,8 @@ TEST(SourceCodeReport, Empty) {
 
   MockElfFile elf_file{};
   EXPECT_CALL(elf_file, GetLineInfo).Times(0);
+  EXPECT_CALL(elf_file, GetLineInfosOfAddressRange)
+      .WillRepeatedly(testing::Return(std::vector<orbit_object_utils::AddressRangeLineInfo>{}));
 
   orbit_client_data::ThreadSampleData sample_data{};
 
@@ -69,9 +75,12 @@ TEST(SourceCodeReport, Simple) {
   orbit_grpc_protos::LineInfo static_line_info{};
   static_line_info.set_source_file("main.cpp");
   static_line_info.set_source_line(55);
-  EXPECT_CALL(elf_file, GetLineInfo)
-      .Times(static_cast<int>(function_info.size()))
-      .WillRepeatedly(testing::Return(static_line_info));
+  EXPECT_CALL(elf_file, GetLineInfo).Times(0);
+  EXPECT_CALL(elf_file, GetLineInfosOfAddressRange(function_info.address(),
+                                                   function_info.address() + function_info.size()))
+      .WillOnce(testing::Return(std::vector<orbit_object_utils::AddressRangeLineInfo>{
+          {function_info.address(), function_info.address() + function_info.size(),
+           static_line_info}}));
 
   constexpr size_t kAbsoluteAddress = 0x8000;
 
@@ -107,9 +116,12 @@ TEST(SourceCodeReport, NonMatchingSourceFileName) {
   orbit_grpc_protos::LineInfo static_line_info{};
   static_line_info.set_source_file("main.cpp");
   static_line_info.set_source_line(55);
-  EXPECT_CALL(elf_file, GetLineInfo)
-      .Times(static_cast<int>(function_info.size()))
-      .WillRepeatedly(testing::Return(static_line_info));
+  EXPECT_CALL(elf_file, GetLineInfo).Times(0);
+  EXPECT_CALL(elf_file, GetLineInfosOfAddressRange(function_info.address(),
+                                                   function_info.address() + function_info.size()))
+      .WillOnce(testing::Return(std::vector<orbit_object_utils::AddressRangeLineInfo>{
+          {function_info.address(), function_info.address() + function_info.size(),
+           static_line_info}}));
 
   constexpr size_t kAbsoluteAddress = 0x8000;
 
@@ -131,4 +143,41 @@ TEST(SourceCodeReport, NonMatchingSourceFileName) {
     EXPECT_FALSE(report.GetNumSamplesAtLine(line_number).has_value());
   }
 }
+
+TEST(SourceCodeReport, MultipleLines) {
+  orbit_client_protos::FunctionInfo function_info{};
+  function_info.set_pretty_name("main()");
+  function_info.set_address(0x42);
+  function_info.set_size(0x30);
+
+  MockElfFile elf_file{};
+  orbit_grpc_protos::LineInfo first_line_info{};
+  first_line_info.set_source_file("main.cpp");
+  first_line_info.set_source_line(55);
+  orbit_grpc_protos::LineInfo second_line_info{};
+  second_line_info.set_source_file("main.cpp");
+  second_line_info.set_source_line(57);
+  // The addresses 0x52 to 0x5f have no line info.
+  EXPECT_CALL(elf_file, GetLineInfosOfAddressRange(0x42, 0x72))
+      .WillOnce(testing::Return(std::vector<orbit_object_utils::AddressRangeLineInfo>{
+          {0x42, 0x52, first_line_info}, {0x60, 0x72, second_line_info}}));
+
+  constexpr size_t kAbsoluteAddress = 0x8000;
+
+  orbit_client_data::ThreadSampleData sample_data{};
+  sample_data.sampled_address_to_count[kAbsoluteAddress] = 2;
+  sample_data.sampled_address_to_count[kAbsoluteAddress + 0xf] = 3;
+  sample_data.sampled_address_to_count[kAbsoluteAddress + 0x10] = 4;
+  sample_data.sampled_address_to_count[kAbsoluteAddress + 0x2f] = 5;
+
+  SourceCodeReport report{"main.cpp", function_info, kAbsoluteAddress,
+                          &elf_file,  sample_data,   0x6666};
+
+  EXPECT_EQ(report.GetNumSamplesInFunction(), 10);
+  EXPECT_FALSE(report.GetNumSamplesAtLine(54).has_value());
+  EXPECT_EQ(report.GetNumSamplesAtLine(55), 5);
+  EXPECT_EQ(report.GetNumSamplesAtLine(56), 0);
+  EXPECT_EQ(report.GetNumSamplesAtLine(57), 5);
+  EXPECT_FALSE(report.GetNumSamplesAtLine(58).has_value());
+}
 }  // namespace orbit_code_report
@@ -4,56 +4,207 @@
 
 #include "FramePointerValidator/FramePointerValidator.h"
 
+#include <absl/base/thread_annotations.h>
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <capstone/capstone.h>
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
-#include <ios>
-#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <utility>
 
 #include "FramePointerValidator/FunctionFramePointerValidator.h"
 #include "OrbitBase/Logging.h"
-#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/ThreadUtils.h"
 #include "OrbitBase/UniqueResource.h"
 
+#if defined(__linux)
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/SafeStrerror.h"
+#else
+#include "OrbitBase/ReadFileToString.h"
+#endif
+
 using orbit_grpc_protos::CodeBlock;
 
-std::optional<std::vector<CodeBlock>> FramePointerValidator::GetFpoFunctions(
-    const std::vector<CodeBlock>& functions, const std::filesystem::path& file_name,
-    bool is_64_bit) {
-  std::vector<CodeBlock> result;
+namespace {
 
-  cs_mode mode = is_64_bit ? CS_MODE_64 : CS_MODE_32;
-  csh temp_handle;
-  if (cs_open(CS_ARCH_X86, mode, &temp_handle) != CS_ERR_OK) {
-    ERROR("Unable to open capstone.");
-    return {};
+// Functions are handed out to the threads in batches of this many, so that a thread that gets a
+// few large functions doesn't hold up the others.
+constexpr size_t kFunctionsPerBatch = 256;
+
+// The content of the module. On Linux, the file is mapped instead of read, so that it is neither
+// copied nor read beyond the pages that contain the functions being validated.
+class ModuleContent {
+ public:
+  ModuleContent() = default;
+  ModuleContent(const ModuleContent&) = delete;
+  ModuleContent& operator=(const ModuleContent&) = delete;
+  ~ModuleContent() {
+#if defined(__linux)
+    if (mapping_ != nullptr) munmap(mapping_, content_.size());
+#endif
   }
-  orbit_base::unique_resource handle{temp_handle, [](csh handle) { cs_close(&handle); }};
 
-  cs_option(handle.get(), CS_OPT_DETAIL, CS_OPT_ON);
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<ModuleContent>> Load(
+      const std::filesystem::path& file_name);
 
-  ErrorMessageOr<std::string> binary_or_error = orbit_base::ReadFileToString(file_name);
-  if (binary_or_error.has_error()) {
-    ERROR("%s", binary_or_error.error().message());
-    return {};
+  [[nodiscard]] std::string_view GetContent() const { return content_; }
+
+ private:
+#if defined(__linux)
+  void* mapping_ = nullptr;
+#else
+  std::string data_;
+#endif
+  std::string_view content_;
+};
+
+ErrorMessageOr<std::unique_ptr<ModuleContent>> ModuleContent::Load(
+    const std::filesystem::path& file_name) {
+  auto module_content = std::make_unique<ModuleContent>();
+#if defined(__linux)
+  OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForReading(file_name));
+  struct stat file_stat {};
+  if (fstat(fd.get(), &file_stat) == -1) {
+    return ErrorMessage{absl::StrFormat("Unable to get size of \"%s\": %s", file_name.string(),
+                                        SafeStrerror(errno))};
+  }
+  const auto size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0) return module_content;
+
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    return ErrorMessage{
+        absl::StrFormat("Unable to map \"%s\": %s", file_name.string(), SafeStrerror(errno))};
   }
+  module_content->mapping_ = mapping;
+  module_content->content_ = std::string_view{static_cast<const char*>(mapping), size};
+#else
+  OUTCOME_TRY(auto&& data, orbit_base::ReadFileToString(file_name));
+  module_content->data_ = std::move(data);
+  module_content->content_ = module_content->data_;
+#endif
+  return module_content;
+}
+
+// Validates `functions` on up to one thread per core, each with its own capstone handle, and
+// calls `consumer` with the indices into `functions` of the functions where validation failed.
+ErrorMessageOr<void> ValidateFunctions(const std::vector<CodeBlock>& functions,
+                                       const std::filesystem::path& file_name, bool is_64_bit,
+                                       const std::function<void(std::vector<size_t>)>& consumer) {
+  const size_t batch_count = (functions.size() + kFunctionsPerBatch - 1) / kFunctionsPerBatch;
+  if (batch_count == 0) return outcome::success();
+
+  OUTCOME_TRY(auto&& module_content, ModuleContent::Load(file_name));
+  const std::string_view content = module_content->GetContent();
 
-  for (const auto& function : functions) {
-    uint64_t function_size = function.size();
-    if (function_size == 0) {
-      continue;
+  std::atomic<size_t> next_batch = 0;
+  absl::Mutex mutex;
+  // Guarded by `mutex`, as are the calls of `consumer`.
+  std::optional<ErrorMessage> error;
+
+  auto validate_batches = [&] {
+    csh temp_handle;
+    if (cs_open(CS_ARCH_X86, is_64_bit ? CS_MODE_64 : CS_MODE_32, &temp_handle) != CS_ERR_OK) {
+      absl::MutexLock lock(&mutex);
+      error = ErrorMessage{"Unable to open capstone."};
+      return;
     }
+    orbit_base::unique_resource handle{temp_handle, [](csh handle) { cs_close(&handle); }};
+    cs_option(handle.get(), CS_OPT_DETAIL, CS_OPT_ON);
+
+    for (size_t batch = next_batch++; batch < batch_count; batch = next_batch++) {
+      std::vector<size_t> fpo_function_indices;
+      const size_t batch_end = std::min((batch + 1) * kFunctionsPerBatch, functions.size());
+      for (size_t index = batch * kFunctionsPerBatch; index < batch_end; ++index) {
+        const CodeBlock& function = functions[index];
+        if (function.size() == 0) continue;
 
-    const std::string& content = binary_or_error.value();
-    FunctionFramePointerValidator validator{handle.get(), content.data() + function.offset(),
-                                            static_cast<size_t>(function.size())};
+        if (function.offset() > content.size() ||
+            function.size() > content.size() - function.offset()) {
+          absl::MutexLock lock(&mutex);
+          error = ErrorMessage{absl::StrFormat(
+              "Function at offset %#x with size %u is not part of \"%s\"", function.offset(),
+              function.size(), file_name.string())};
+          return;
+        }
 
-    if (!validator.Validate()) {
-      result.push_back(function);
+        FunctionFramePointerValidator validator{handle.get(), content.data() + function.offset(),
+                                                static_cast<size_t>(function.size())};
+        if (!validator.Validate()) {
+          fpo_function_indices.push_back(index);
+        }
+      }
+
+      absl::MutexLock lock(&mutex);
+      if (error.has_value()) return;
+      if (!fpo_function_indices.empty()) consumer(std::move(fpo_function_indices));
     }
+  };
+
+  const size_t thread_count =
+      std::clamp<size_t>(std::thread::hardware_concurrency(), 1, batch_count);
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back([&validate_batches] {
+      orbit_base::SetCurrentThreadName("FpValidator");
+      validate_batches();
+    });
+  }
+  validate_batches();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  if (error.has_value()) return error.value();
+  return outcome::success();
+}
+
+}  // namespace
+
+std::optional<std::vector<CodeBlock>> FramePointerValidator::GetFpoFunctions(
+    const std::vector<CodeBlock>& functions, const std::filesystem::path& file_name,
+    bool is_64_bit) {
+  std::vector<size_t> fpo_function_indices;
+  ErrorMessageOr<void> validation_result =
+      ValidateFunctions(functions, file_name, is_64_bit, [&](std::vector<size_t> indices) {
+        fpo_function_indices.insert(fpo_function_indices.end(), indices.begin(), indices.end());
+      });
+  if (validation_result.has_error()) {
+    ERROR("%s", validation_result.error().message());
+    return {};
+  }
+
+  // Keep the order of `functions`.
+  std::sort(fpo_function_indices.begin(), fpo_function_indices.end());
+  std::vector<CodeBlock> result;
+  result.reserve(fpo_function_indices.size());
+  for (size_t index : fpo_function_indices) {
+    result.push_back(functions[index]);
   }
   return result;
 }
+
+ErrorMessageOr<void> FramePointerValidator::GetFpoFunctions(
+    const std::vector<CodeBlock>& functions, const std::filesystem::path& file_name,
+    bool is_64_bit, const std::function<void(std::vector<CodeBlock>)>& consumer) {
+  return ValidateFunctions(functions, file_name, is_64_bit, [&](std::vector<size_t> indices) {
+    std::vector<CodeBlock> fpo_functions;
+    fpo_functions.reserve(indices.size());
+    for (size_t index : indices) {
+      fpo_functions.push_back(functions[index]);
+    }
+    consumer(std::move(fpo_functions));
+  });
+}
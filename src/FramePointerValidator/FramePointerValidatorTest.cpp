@@ -25,28 +25,55 @@
 using orbit_grpc_protos::CodeBlock;
 using orbit_grpc_protos::SymbolInfo;
 
-TEST(FramePointerValidator, GetFpoFunctions) {
-  const std::filesystem::path test_elf_file = orbit_test::GetTestdataDir() / "hello_world_elf";
+namespace {
 
-  auto elf_file = orbit_object_utils::CreateElfFile(test_elf_file);
-  ASSERT_FALSE(elf_file.has_error()) << elf_file.error().message();
+struct TestFunctions {
+  std::filesystem::path file_path;
+  uint64_t load_bias;
+  std::vector<SymbolInfo> symbol_infos;
+  std::vector<CodeBlock> function_infos;
+};
 
-  const auto symbols_result = elf_file.value()->LoadDebugSymbols();
-  ASSERT_FALSE(symbols_result.has_error()) << symbols_result.error().message();
-  uint64_t load_bias = symbols_result.value().load_bias();
-  const std::vector<SymbolInfo> symbol_infos(symbols_result.value().symbol_infos().begin(),
-                                             symbols_result.value().symbol_infos().end());
+TestFunctions GetTestFunctions() {
+  TestFunctions result;
+  result.file_path = orbit_test::GetTestdataDir() / "hello_world_elf";
 
-  std::vector<CodeBlock> function_infos;
+  auto elf_file = orbit_object_utils::CreateElfFile(result.file_path);
+  CHECK(!elf_file.has_error());
 
-  std::transform(symbol_infos.begin(), symbol_infos.end(), std::back_inserter(function_infos),
-                 [&load_bias](const SymbolInfo& s) -> CodeBlock {
-                   CodeBlock result;
+  const auto symbols_result = elf_file.value()->LoadDebugSymbols();
+  CHECK(!symbols_result.has_error());
+  result.load_bias = symbols_result.value().load_bias();
+  result.symbol_infos.assign(symbols_result.value().symbol_infos().begin(),
+                             symbols_result.value().symbol_infos().end());
+
+  std::transform(result.symbol_infos.begin(), result.symbol_infos.end(),
+                 std::back_inserter(result.function_infos),
+                 [load_bias = result.load_bias](const SymbolInfo& s) -> CodeBlock {
+                   CodeBlock code_block;
                    uint64_t symbol_offset = s.address() - load_bias;
-                   result.set_offset(symbol_offset);
-                   result.set_size(s.size());
-                   return result;
+                   code_block.set_offset(symbol_offset);
+                   code_block.set_size(s.size());
+                   return code_block;
                  });
+  return result;
+}
+
+std::vector<uint64_t> GetOffsets(const std::vector<CodeBlock>& code_blocks) {
+  std::vector<uint64_t> offsets;
+  std::transform(code_blocks.begin(), code_blocks.end(), std::back_inserter(offsets),
+                 [](const CodeBlock& code_block) { return code_block.offset(); });
+  return offsets;
+}
+
+}  // namespace
+
+TEST(FramePointerValidator, GetFpoFunctions) {
+  const TestFunctions test_functions = GetTestFunctions();
+  const std::filesystem::path& test_elf_file = test_functions.file_path;
+  const uint64_t load_bias = test_functions.load_bias;
+  const std::vector<SymbolInfo>& symbol_infos = test_functions.symbol_infos;
+  const std::vector<CodeBlock>& function_infos = test_functions.function_infos;
 
   std::optional<std::vector<CodeBlock>> fpo_functions =
       FramePointerValidator::GetFpoFunctions(function_infos, test_elf_file, true);
@@ -73,3 +100,84 @@ TEST(FramePointerValidator, GetFpoFunctions) {
   EXPECT_THAT(fpo_function_names,
               testing::UnorderedElementsAre("_start", "main", "__libc_csu_init"));
 }
+
+TEST(FramePointerValidator, GetFpoFunctionsIncrementally) {
+  const TestFunctions test_functions = GetTestFunctions();
+
+  std::optional<std::vector<CodeBlock>> expected_fpo_functions =
+      FramePointerValidator::GetFpoFunctions(test_functions.function_infos,
+                                             test_functions.file_path, true);
+  ASSERT_TRUE(expected_fpo_functions.has_value());
+
+  std::vector<CodeBlock> fpo_functions;
+  ErrorMessageOr<void> result = FramePointerValidator::GetFpoFunctions(
+      test_functions.function_infos, test_functions.file_path, true,
+      [&fpo_functions](std::vector<CodeBlock> functions) {
+        EXPECT_FALSE(functions.empty());
+        fpo_functions.insert(fpo_functions.end(), functions.begin(), functions.end());
+      });
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+
+  EXPECT_THAT(GetOffsets(fpo_functions),
+              testing::UnorderedElementsAreArray(GetOffsets(expected_fpo_functions.value())));
+}
+
+// Validates enough functions for them to be split across several threads.
+TEST(FramePointerValidator, GetFpoFunctionsOfManyFunctions) {
+  const TestFunctions test_functions = GetTestFunctions();
+
+  std::optional<std::vector<CodeBlock>> fpo_functions_once =
+      FramePointerValidator::GetFpoFunctions(test_functions.function_infos,
+                                             test_functions.file_path, true);
+  ASSERT_TRUE(fpo_functions_once.has_value());
+
+  constexpr size_t kRepetitions = 1000;
+  std::vector<CodeBlock> function_infos;
+  std::vector<CodeBlock> expected_fpo_functions;
+  for (size_t i = 0; i < kRepetitions; ++i) {
+    function_infos.insert(function_infos.end(), test_functions.function_infos.begin(),
+                          test_functions.function_infos.end());
+    expected_fpo_functions.insert(expected_fpo_functions.end(), fpo_functions_once->begin(),
+                                  fpo_functions_once->end());
+  }
+
+  std::optional<std::vector<CodeBlock>> fpo_functions =
+      FramePointerValidator::GetFpoFunctions(function_infos, test_functions.file_path, true);
+  ASSERT_TRUE(fpo_functions.has_value());
+  // The result is in the order of the input, even though it was computed on several threads.
+  EXPECT_EQ(GetOffsets(fpo_functions.value()), GetOffsets(expected_fpo_functions));
+
+  size_t fpo_function_count = 0;
+  ErrorMessageOr<void> result = FramePointerValidator::GetFpoFunctions(
+      function_infos, test_functions.file_path, true,
+      [&fpo_function_count](std::vector<CodeBlock> functions) {
+        fpo_function_count += functions.size();
+      });
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(fpo_function_count, expected_fpo_functions.size());
+}
+
+TEST(FramePointerValidator, GetFpoFunctionsFailsForFunctionOutsideOfFile) {
+  TestFunctions test_functions = GetTestFunctions();
+  CodeBlock function_outside_of_file;
+  function_outside_of_file.set_offset(std::filesystem::file_size(test_functions.file_path) - 1);
+  function_outside_of_file.set_size(16);
+  test_functions.function_infos.push_back(function_outside_of_file);
+
+  EXPECT_FALSE(FramePointerValidator::GetFpoFunctions(test_functions.function_infos,
+                                                      test_functions.file_path, true)
+                   .has_value());
+
+  ErrorMessageOr<void> result = FramePointerValidator::GetFpoFunctions(
+      test_functions.function_infos, test_functions.file_path, true,
+      [](std::vector<CodeBlock> /*functions*/) {});
+  ASSERT_TRUE(result.has_error());
+  EXPECT_THAT(result.error().message(), testing::HasSubstr("is not part of"));
+}
+
+TEST(FramePointerValidator, GetFpoFunctionsFailsForNonExistingFile) {
+  TestFunctions test_functions = GetTestFunctions();
+  EXPECT_FALSE(FramePointerValidator::GetFpoFunctions(test_functions.function_infos,
+                                                      "/does/not/exist", true)
+                   .has_value());
+}
@@ -6,9 +6,11 @@
 #define FRAME_POINTER_VALIDATOR_FRAME_POINTER_VALIDATOR_H_
 
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <vector>
 
+#include "OrbitBase/Result.h"
 #include "code_block.pb.h"
 
 class FramePointerValidator {
@@ -19,6 +21,15 @@ class FramePointerValidator {
   static std::optional<std::vector<orbit_grpc_protos::CodeBlock>> GetFpoFunctions(
       const std::vector<orbit_grpc_protos::CodeBlock>& functions,
       const std::filesystem::path& file_name, bool is_64_bit);
+
+  // Same as above, but instead of returning all functions at the end, calls `consumer` with the
+  // functions where validation failed as soon as a batch of functions has been validated. The
+  // functions are validated on several threads, so batches are not in the order of `functions`.
+  // Calls of `consumer` don't overlap.
+  static ErrorMessageOr<void> GetFpoFunctions(
+      const std::vector<orbit_grpc_protos::CodeBlock>& functions,
+      const std::filesystem::path& file_name, bool is_64_bit,
+      const std::function<void(std::vector<orbit_grpc_protos::CodeBlock>)>& consumer);
 };
 
 #endif  // FRAME_POINTER_VALIDATOR_FRAME_POINTER_VALIDATOR_H_
@@ -5,6 +5,8 @@
 #include "ObjectUtils/ElfFile.h"
 
 #include <absl/base/casts.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include <llvm/ADT/ArrayRef.h>
@@ -14,6 +16,7 @@
 #include <llvm/BinaryFormat/ELF.h>
 #include <llvm/DebugInfo/DWARF/DWARFContext.h>
 #include <llvm/DebugInfo/DWARF/DWARFDebugLine.h>
+#include <llvm/DebugInfo/DWARF/DWARFDie.h>
 #include <llvm/DebugInfo/DWARF/DWARFFormValue.h>
 #include <llvm/DebugInfo/Symbolize/Symbolize.h>
 #include <llvm/Demangle/Demangle.h>
@@ -29,6 +32,7 @@
 #include <llvm/Support/MathExtras.h>
 #include <llvm/Support/MemoryBuffer.h>
 
+#include <algorithm>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -72,6 +76,8 @@ class ElfFileImpl : public ElfFile {
   [[nodiscard]] std::string GetSoname() const override;
   [[nodiscard]] const std::filesystem::path& GetFilePath() const override;
   [[nodiscard]] ErrorMessageOr<LineInfo> GetLineInfo(uint64_t address) override;
+  [[nodiscard]] ErrorMessageOr<std::vector<AddressRangeLineInfo>> GetLineInfosOfAddressRange(
+      uint64_t start_address, uint64_t end_address) override;
   [[nodiscard]] ErrorMessageOr<LineInfo> GetDeclarationLocationOfFunction(
       uint64_t address) override;
   [[nodiscard]] std::optional<GnuDebugLinkInfo> GetGnuDebugLinkInfo() const override;
@@ -81,11 +87,14 @@ class ElfFileImpl : public ElfFile {
   ErrorMessageOr<void> InitProgramHeaders();
   ErrorMessageOr<void> InitDynamicEntries();
   ErrorMessageOr<SymbolInfo> CreateSymbolInfo(const llvm::object::ELFSymbolRef& symbol_ref);
+  // Created on first use. Caches the parsed compile units and their line tables.
+  ErrorMessageOr<llvm::DWARFContext*> GetDwarfContext();
 
   const std::filesystem::path file_path_;
   llvm::object::OwningBinary<llvm::object::ObjectFile> owning_binary_;
   llvm::object::ELFObjectFile<ElfT>* object_file_;
   llvm::symbolize::LLVMSymbolizer symbolizer_;
+  std::unique_ptr<llvm::DWARFContext> dwarf_context_;
   std::string build_id_;
   std::string soname_;
   bool has_symtab_section_;
@@ -144,6 +153,65 @@ ErrorMessageOr<GnuDebugLinkInfo> ReadGnuDebuglinkSection(
   return gnu_debuglink_info;
 }
 
+// Collects the inlined subroutines that are directly part of the function `die`, i.e., that are not
+// themselves inlined into another inlined subroutine.
+void CollectOutermostInlinedSubroutines(const llvm::DWARFDie& die,
+                                        std::vector<llvm::DWARFDie>* inlined_subroutines) {
+  for (const llvm::DWARFDie& child : die.children()) {
+    if (child.getTag() == llvm::dwarf::DW_TAG_inlined_subroutine) {
+      inlined_subroutines->push_back(child);
+    } else if (child.getTag() != llvm::dwarf::DW_TAG_subprogram) {
+      // Lexical blocks and the like can contain inlined subroutines of this function as well.
+      CollectOutermostInlinedSubroutines(child, inlined_subroutines);
+    }
+  }
+}
+
+// Returns the outermost DW_TAG_subprogram or DW_TAG_inlined_subroutine that contains `address`,
+// which is the function the symbolizer reports as the last frame.
+llvm::DWARFDie GetOutermostSubroutineForAddress(llvm::DWARFCompileUnit* compile_unit,
+                                                uint64_t address) {
+  llvm::DWARFDie outermost_subroutine;
+  for (llvm::DWARFDie die = compile_unit->getSubroutineForAddress(address); die.isValid();
+       die = die.getParent()) {
+    if (die.isSubroutineDIE()) outermost_subroutine = die;
+  }
+  return outermost_subroutine;
+}
+
+// A range of addresses that is attributed to a line of a file in the line table.
+struct LineTableRange {
+  uint64_t start_address;
+  uint64_t end_address;
+  uint64_t file_index;
+  uint32_t line;
+};
+
+// Removes the parts of `ranges` that are covered by one of `covering_ranges`. Both need to be
+// sorted by address and must not overlap with themselves.
+std::vector<LineTableRange> SubtractRanges(const std::vector<LineTableRange>& ranges,
+                                           const std::vector<LineTableRange>& covering_ranges) {
+  std::vector<LineTableRange> result;
+  auto covering_range = covering_ranges.begin();
+  for (LineTableRange range : ranges) {
+    while (covering_range != covering_ranges.end() &&
+           covering_range->end_address <= range.start_address) {
+      ++covering_range;
+    }
+    for (auto it = covering_range;
+         it != covering_ranges.end() && it->start_address < range.end_address; ++it) {
+      if (range.start_address < it->start_address) {
+        LineTableRange uncovered_part = range;
+        uncovered_part.end_address = it->start_address;
+        result.push_back(uncovered_part);
+      }
+      range.start_address = std::max(range.start_address, it->end_address);
+    }
+    if (range.start_address < range.end_address) result.push_back(range);
+  }
+  return result;
+}
+
 template <typename ElfT>
 ElfFileImpl<ElfT>::ElfFileImpl(std::filesystem::path file_path,
                                llvm::object::OwningBinary<llvm::object::ObjectFile>&& owning_binary)
@@ -520,11 +588,119 @@ ErrorMessageOr<LineInfo> orbit_object_utils::ElfFileImpl<ElfT>::GetLineInfo(uint
   return line_info;
 }
 
+template <typename ElfT>
+ErrorMessageOr<llvm::DWARFContext*> ElfFileImpl<ElfT>::GetDwarfContext() {
+  if (dwarf_context_ == nullptr) {
+    dwarf_context_ = llvm::DWARFContext::create(*owning_binary_.getBinary());
+    if (dwarf_context_ == nullptr) return ErrorMessage{"Could not read DWARF information."};
+  }
+  return dwarf_context_.get();
+}
+
+template <typename ElfT>
+ErrorMessageOr<std::vector<AddressRangeLineInfo>>
+orbit_object_utils::ElfFileImpl<ElfT>::GetLineInfosOfAddressRange(uint64_t start_address,
+                                                                  uint64_t end_address) {
+  CHECK(has_debug_info_section_);
+  std::vector<AddressRangeLineInfo> line_infos;
+  if (start_address >= end_address) return line_infos;
+
+  OUTCOME_TRY(auto&& dwarf_context, GetDwarfContext());
+  llvm::DWARFCompileUnit* const compile_unit = dwarf_context->getCompileUnitForOffset(
+      dwarf_context->getDebugAranges()->findAddress(start_address));
+  if (compile_unit == nullptr) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to get line info for address=0x%x", start_address));
+  }
+  const llvm::DWARFDebugLine::LineTable* const line_table =
+      dwarf_context->getLineTableForUnit(compile_unit);
+  if (line_table == nullptr) return ErrorMessage{"Line Table was missing in debug information"};
+
+  std::vector<uint32_t> row_indices;
+  line_table->lookupAddressRange(
+      {start_address, llvm::object::SectionedAddress::UndefSection}, end_address - start_address,
+      row_indices);
+
+  // The symbolizer attributes an address to the innermost function that contains it, and reports
+  // the functions it is inlined into as further frames. GetLineInfo returns the last frame, so an
+  // address that belongs to code inlined into a function is attributed to the call site in that
+  // function, and all other addresses to the line in the line table.
+  std::vector<LineTableRange> line_table_ranges;
+  std::vector<LineTableRange> call_site_ranges;
+  absl::flat_hash_set<uint64_t> visited_functions;
+  for (uint32_t row_index : row_indices) {
+    const llvm::DWARFDebugLine::Row& row = line_table->Rows[row_index];
+    // A sequence always ends with an end_sequence row, which starts no range.
+    if (row.EndSequence || row_index + 1 >= line_table->Rows.size()) continue;
+    const uint64_t range_start = std::max(row.Address.Address, start_address);
+    const uint64_t range_end =
+        std::min(line_table->Rows[row_index + 1].Address.Address, end_address);
+    if (range_start >= range_end) continue;
+    line_table_ranges.push_back({range_start, range_end, row.File, row.Line});
+
+    const llvm::DWARFDie function = GetOutermostSubroutineForAddress(compile_unit, range_start);
+    if (!function.isValid() || !visited_functions.insert(function.getOffset()).second) continue;
+    std::vector<llvm::DWARFDie> inlined_subroutines;
+    CollectOutermostInlinedSubroutines(function, &inlined_subroutines);
+    for (const llvm::DWARFDie& inlined_subroutine : inlined_subroutines) {
+      auto address_ranges_or_error = inlined_subroutine.getAddressRanges();
+      if (!address_ranges_or_error) {
+        llvm::consumeError(address_ranges_or_error.takeError());
+        continue;
+      }
+      uint32_t call_file = 0;
+      uint32_t call_line = 0;
+      uint32_t call_column = 0;
+      uint32_t call_discriminator = 0;
+      inlined_subroutine.getCallerFrame(call_file, call_line, call_column, call_discriminator);
+      for (const llvm::DWARFAddressRange& address_range : address_ranges_or_error.get()) {
+        const uint64_t call_site_start = std::max(address_range.LowPC, start_address);
+        const uint64_t call_site_end = std::min(address_range.HighPC, end_address);
+        if (call_site_start >= call_site_end) continue;
+        call_site_ranges.push_back({call_site_start, call_site_end, call_file, call_line});
+      }
+    }
+  }
+
+  auto by_start_address = [](const LineTableRange& lhs, const LineTableRange& rhs) {
+    return lhs.start_address < rhs.start_address;
+  };
+  std::sort(call_site_ranges.begin(), call_site_ranges.end(), by_start_address);
+  std::vector<LineTableRange> ranges = SubtractRanges(line_table_ranges, call_site_ranges);
+  ranges.insert(ranges.end(), call_site_ranges.begin(), call_site_ranges.end());
+  std::sort(ranges.begin(), ranges.end(), by_start_address);
+
+  // Resolving the file name is the expensive part, and functions only consist of a few files.
+  // Addresses whose file can't be resolved have no line info, as for GetLineInfo.
+  absl::flat_hash_map<uint64_t, std::string> file_names;
+  for (const LineTableRange& range : ranges) {
+    auto [file_name_it, inserted] = file_names.try_emplace(range.file_index);
+    if (inserted) {
+      line_table->getFileNameByIndex(range.file_index, compile_unit->getCompilationDir(),
+                                     llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+                                     file_name_it->second);
+    }
+    const std::string& file_name = file_name_it->second;
+    if (file_name.empty()) continue;
+
+    if (!line_infos.empty() && line_infos.back().end_address == range.start_address &&
+        line_infos.back().line_info.source_line() == range.line &&
+        line_infos.back().line_info.source_file() == file_name) {
+      line_infos.back().end_address = range.end_address;
+      continue;
+    }
+    AddressRangeLineInfo line_info{range.start_address, range.end_address, {}};
+    line_info.line_info.set_source_file(file_name);
+    line_info.line_info.set_source_line(range.line);
+    line_infos.push_back(std::move(line_info));
+  }
+  return line_infos;
+}
+
 template <typename ElfT>
 ErrorMessageOr<LineInfo> orbit_object_utils::ElfFileImpl<ElfT>::GetDeclarationLocationOfFunction(
     uint64_t address) {
-  const auto dwarf_context = llvm::DWARFContext::create(*owning_binary_.getBinary());
-  if (dwarf_context == nullptr) return ErrorMessage{"Could not read DWARF information."};
+  OUTCOME_TRY(auto&& dwarf_context, GetDwarfContext());
 
   const auto offset = dwarf_context->getDebugAranges()->findAddress(address);
   auto* const compile_unit = dwarf_context->getCompileUnitForOffset(offset);
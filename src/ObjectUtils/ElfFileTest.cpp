@@ -5,6 +5,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <iterator>
 #include <memory>
@@ -317,6 +318,77 @@ TEST(ElfFile, LineInfoInlining) {
             "LineInfoTestBinary.cpp");
 }
 
+// GetLineInfosOfAddressRange needs to agree with GetLineInfo for every single address.
+static void ExpectLineInfosOfAddressRangeMatchLineInfos(ElfFile* elf_file, uint64_t start_address,
+                                                        uint64_t end_address) {
+  ErrorMessageOr<std::vector<orbit_object_utils::AddressRangeLineInfo>> line_infos =
+      elf_file->GetLineInfosOfAddressRange(start_address, end_address);
+  ASSERT_THAT(line_infos, HasNoError());
+  ASSERT_FALSE(line_infos.value().empty());
+
+  auto range = line_infos.value().begin();
+  for (uint64_t address = start_address; address < end_address; ++address) {
+    while (range != line_infos.value().end() && range->end_address <= address) ++range;
+    ErrorMessageOr<orbit_grpc_protos::LineInfo> line_info = elf_file->GetLineInfo(address);
+    if (range == line_infos.value().end() || range->start_address > address) {
+      EXPECT_TRUE(line_info.has_error()) << absl::StrFormat("address=%#x", address);
+      continue;
+    }
+    ASSERT_THAT(line_info, HasNoError());
+    EXPECT_EQ(range->line_info.source_file(), line_info.value().source_file())
+        << absl::StrFormat("address=%#x", address);
+    EXPECT_EQ(range->line_info.source_line(), line_info.value().source_line())
+        << absl::StrFormat("address=%#x", address);
+  }
+}
+
+TEST(ElfFile, GetLineInfosOfAddressRange) {
+  const std::filesystem::path file_path =
+      orbit_test::GetTestdataDir() / "hello_world_elf_with_debug_info";
+
+  auto hello_world = CreateElfFile(file_path);
+  ASSERT_THAT(hello_world, HasNoError());
+
+  ErrorMessageOr<std::vector<orbit_object_utils::AddressRangeLineInfo>> line_infos =
+      hello_world.value()->GetLineInfosOfAddressRange(0x1140, 0x1151);
+  ASSERT_THAT(line_infos, HasNoError());
+  ASSERT_GE(line_infos.value().size(), 2);
+  EXPECT_EQ(line_infos.value().front().start_address, 0x1140);
+  EXPECT_EQ(line_infos.value().front().line_info.source_line(), 3);
+  EXPECT_EQ(line_infos.value().back().end_address, 0x1151);
+  EXPECT_EQ(line_infos.value().back().line_info.source_line(), 4);
+
+  ExpectLineInfosOfAddressRangeMatchLineInfos(hello_world.value().get(), 0x1140, 0x1160);
+
+  line_infos = hello_world.value()->GetLineInfosOfAddressRange(0x1140, 0x1140);
+  ASSERT_THAT(line_infos, HasNoError());
+  EXPECT_TRUE(line_infos.value().empty());
+}
+
+TEST(ElfFile, GetLineInfosOfAddressRangeInlining) {
+  const std::filesystem::path file_path = orbit_test::GetTestdataDir() / "line_info_test_binary";
+
+  auto program = CreateElfFile(file_path);
+  ASSERT_THAT(program, HasNoError());
+
+  constexpr uint64_t kAddressOfMainFunction = 0x401140;
+  constexpr uint64_t kFirstInstructionOfInlinedPrintHelloWorld = 0x401141;
+  ErrorMessageOr<std::vector<orbit_object_utils::AddressRangeLineInfo>> line_infos =
+      program.value()->GetLineInfosOfAddressRange(kAddressOfMainFunction,
+                                                  kAddressOfMainFunction + 0x40);
+  ASSERT_THAT(line_infos, HasNoError());
+  auto inlined_range =
+      std::find_if(line_infos.value().begin(), line_infos.value().end(), [](const auto& range) {
+        return range.start_address <= kFirstInstructionOfInlinedPrintHelloWorld &&
+               kFirstInstructionOfInlinedPrintHelloWorld < range.end_address;
+      });
+  ASSERT_NE(inlined_range, line_infos.value().end());
+  EXPECT_EQ(inlined_range->line_info.source_line(), 13);
+
+  ExpectLineInfosOfAddressRangeMatchLineInfos(program.value().get(), kAddressOfMainFunction,
+                                              kAddressOfMainFunction + 0x40);
+}
+
 TEST(ElfFile, CompressedDebugInfo) {
   const std::filesystem::path file_path =
       orbit_test::GetTestdataDir() / "line_info_test_binary_compressed";
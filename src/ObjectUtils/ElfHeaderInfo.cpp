@@ -0,0 +1,189 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ObjectUtils/ElfHeaderInfo.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <elf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/File.h"
+
+namespace orbit_object_utils {
+
+namespace {
+
+// Guards against allocating huge buffers for corrupted headers. The segments we read are small.
+constexpr uint64_t kMaxSegmentSize = 1024 * 1024;
+
+ErrorMessageOr<std::vector<char>> ReadBytes(const orbit_base::unique_fd& fd, uint64_t offset,
+                                            uint64_t size) {
+  if (size > kMaxSegmentSize) {
+    return ErrorMessage{absl::StrFormat("Unexpectedly large read of %u bytes", size)};
+  }
+  std::vector<char> buffer(size);
+  OUTCOME_TRY(auto&& read_size, orbit_base::ReadFullyAtOffset(fd, buffer.data(), size, offset));
+  if (read_size < size) {
+    return ErrorMessage{absl::StrFormat("Not enough bytes left in the file: %u < %u", read_size,
+                                        size)};
+  }
+  return buffer;
+}
+
+std::optional<uint64_t> VirtualAddressToFileOffset(const std::vector<Elf64_Phdr>& program_headers,
+                                                   uint64_t address) {
+  for (const Elf64_Phdr& phdr : program_headers) {
+    if (phdr.p_type == PT_LOAD && address >= phdr.p_vaddr &&
+        address - phdr.p_vaddr < phdr.p_filesz) {
+      return address - phdr.p_vaddr + phdr.p_offset;
+    }
+  }
+  return std::nullopt;
+}
+
+ErrorMessageOr<std::string> ReadBuildIdFromNotes(const std::vector<char>& notes,
+                                                 uint64_t alignment) {
+  auto align = [alignment](uint64_t value) {
+    return (value + alignment - 1) / alignment * alignment;
+  };
+  uint64_t offset = 0;
+  while (offset + sizeof(Elf64_Nhdr) <= notes.size()) {
+    Elf64_Nhdr note_header;
+    std::memcpy(&note_header, notes.data() + offset, sizeof(note_header));
+    const uint64_t name_offset = offset + sizeof(note_header);
+    const uint64_t desc_offset = name_offset + align(note_header.n_namesz);
+    const uint64_t next_offset = desc_offset + align(note_header.n_descsz);
+    if (desc_offset + note_header.n_descsz > notes.size()) {
+      return ErrorMessage{"Note extends past the end of the PT_NOTE segment"};
+    }
+
+    constexpr char kGnuName[] = "GNU";
+    if (note_header.n_type == NT_GNU_BUILD_ID && note_header.n_namesz == sizeof(kGnuName) &&
+        std::memcmp(notes.data() + name_offset, kGnuName, sizeof(kGnuName)) == 0) {
+      std::string build_id;
+      for (uint64_t i = 0; i < note_header.n_descsz; ++i) {
+        absl::StrAppend(&build_id,
+                        absl::Hex(static_cast<uint8_t>(notes[desc_offset + i]), absl::kZeroPad2));
+      }
+      return build_id;
+    }
+    offset = next_offset;
+  }
+  return std::string{};
+}
+
+ErrorMessageOr<std::string> ReadSoname(const orbit_base::unique_fd& fd,
+                                       const std::vector<Elf64_Phdr>& program_headers,
+                                       const Elf64_Phdr& dynamic_header) {
+  OUTCOME_TRY(auto&& dynamic_bytes,
+              ReadBytes(fd, dynamic_header.p_offset, dynamic_header.p_filesz));
+  std::optional<uint64_t> soname_offset;
+  std::optional<uint64_t> string_table_address;
+  std::optional<uint64_t> string_table_size;
+  for (uint64_t offset = 0; offset + sizeof(Elf64_Dyn) <= dynamic_bytes.size();
+       offset += sizeof(Elf64_Dyn)) {
+    Elf64_Dyn dyn;
+    std::memcpy(&dyn, dynamic_bytes.data() + offset, sizeof(dyn));
+    if (dyn.d_tag == DT_NULL) break;
+    switch (dyn.d_tag) {
+      case DT_SONAME:
+        soname_offset = dyn.d_un.d_val;
+        break;
+      case DT_STRTAB:
+        string_table_address = dyn.d_un.d_ptr;
+        break;
+      case DT_STRSZ:
+        string_table_size = dyn.d_un.d_val;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (!soname_offset.has_value() || !string_table_address.has_value() ||
+      !string_table_size.has_value()) {
+    return std::string{};
+  }
+  if (soname_offset.value() >= string_table_size.value()) {
+    return ErrorMessage{"Soname offset is out of bounds of the string table"};
+  }
+  std::optional<uint64_t> string_table_offset =
+      VirtualAddressToFileOffset(program_headers, string_table_address.value());
+  if (!string_table_offset.has_value()) {
+    return ErrorMessage{"The dynamic string table is not part of a loadable segment"};
+  }
+
+  // The soname is short, so only read the beginning of what is left of the string table.
+  constexpr uint64_t kMaxSonameSize = 4096;
+  const uint64_t size =
+      std::min(string_table_size.value() - soname_offset.value(), kMaxSonameSize);
+  OUTCOME_TRY(auto&& soname_bytes,
+              ReadBytes(fd, string_table_offset.value() + soname_offset.value(), size));
+  auto terminator = std::find(soname_bytes.begin(), soname_bytes.end(), '\0');
+  if (terminator == soname_bytes.end()) {
+    return ErrorMessage{"Soname is not null-terminated"};
+  }
+  return std::string(soname_bytes.begin(), terminator);
+}
+
+}  // namespace
+
+ErrorMessageOr<ElfHeaderInfo> ReadElfHeaderInfo(const std::filesystem::path& file_path) {
+  OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForReading(file_path));
+  Elf64_Ehdr elf_header;
+  OUTCOME_TRY(auto&& elf_header_size,
+              orbit_base::ReadFullyAtOffset(fd, &elf_header, sizeof(elf_header), 0));
+  if (elf_header_size < SELFMAG || std::memcmp(elf_header.e_ident, ELFMAG, SELFMAG) != 0) {
+    return ErrorMessage{absl::StrFormat("\"%s\" is not an ELF file", file_path.string())};
+  }
+  if (elf_header_size < sizeof(elf_header)) {
+    return ErrorMessage{
+        absl::StrFormat("The ELF header of \"%s\" is truncated", file_path.string())};
+  }
+  if (elf_header.e_ident[EI_CLASS] != ELFCLASS64 || elf_header.e_ident[EI_DATA] != ELFDATA2LSB) {
+    return ErrorMessage{
+        absl::StrFormat("\"%s\" is not a 64-bit little-endian ELF file", file_path.string())};
+  }
+  if (elf_header.e_phnum == PN_XNUM ||
+      (elf_header.e_phnum > 0 && elf_header.e_phentsize != sizeof(Elf64_Phdr))) {
+    return ErrorMessage{
+        absl::StrFormat("Unsupported program headers in \"%s\"", file_path.string())};
+  }
+
+  OUTCOME_TRY(auto&& program_header_bytes,
+              ReadBytes(fd, elf_header.e_phoff, elf_header.e_phnum * sizeof(Elf64_Phdr)));
+  std::vector<Elf64_Phdr> program_headers(elf_header.e_phnum);
+  std::memcpy(program_headers.data(), program_header_bytes.data(), program_header_bytes.size());
+
+  ElfHeaderInfo header_info;
+  bool has_executable_segment = false;
+  for (const Elf64_Phdr& phdr : program_headers) {
+    if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X) != 0 && !has_executable_segment) {
+      header_info.load_bias = phdr.p_vaddr - phdr.p_offset;
+      header_info.executable_segment_offset = phdr.p_offset;
+      has_executable_segment = true;
+    } else if (phdr.p_type == PT_NOTE && header_info.build_id.empty()) {
+      OUTCOME_TRY(auto&& notes, ReadBytes(fd, phdr.p_offset, phdr.p_filesz));
+      // Notes are 4-byte aligned, except in segments that explicitly require 8-byte alignment.
+      OUTCOME_TRY(auto&& build_id, ReadBuildIdFromNotes(notes, phdr.p_align == 8 ? 8 : 4));
+      header_info.build_id = std::move(build_id);
+    } else if (phdr.p_type == PT_DYNAMIC) {
+      OUTCOME_TRY(auto&& soname, ReadSoname(fd, program_headers, phdr));
+      header_info.soname = std::move(soname);
+    }
+  }
+  if (!has_executable_segment) {
+    return ErrorMessage{
+        absl::StrFormat("No executable PT_LOAD segment found in \"%s\"", file_path.string())};
+  }
+  return header_info;
+}
+
+}  // namespace orbit_object_utils
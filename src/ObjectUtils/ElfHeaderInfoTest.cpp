@@ -0,0 +1,64 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <utility>
+
+#include "ObjectUtils/ElfFile.h"
+#include "ObjectUtils/ElfHeaderInfo.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/TestUtils.h"
+#include "Test/Path.h"
+
+using orbit_base::HasError;
+using orbit_base::HasNoError;
+
+namespace orbit_object_utils {
+
+TEST(ElfHeaderInfo, MatchesElfFile) {
+  for (const char* file_name : {"hello_world_elf", "hello_world_elf_no_build_id",
+                                "hello_world_static_elf", "libtest-1.0.so", "no_symbols_elf",
+                                "line_info_test_binary"}) {
+    SCOPED_TRACE(file_name);
+    const std::filesystem::path file_path = orbit_test::GetTestdataDir() / file_name;
+
+    auto elf_file_or_error = CreateElfFile(file_path);
+    ASSERT_THAT(elf_file_or_error, HasNoError());
+    const std::unique_ptr<ElfFile>& elf_file = elf_file_or_error.value();
+
+    auto header_info_or_error = ReadElfHeaderInfo(file_path);
+    ASSERT_THAT(header_info_or_error, HasNoError());
+    const ElfHeaderInfo& header_info = header_info_or_error.value();
+
+    EXPECT_EQ(header_info.build_id, elf_file->GetBuildId());
+    EXPECT_EQ(header_info.soname, elf_file->GetSoname());
+    EXPECT_EQ(header_info.load_bias, elf_file->GetLoadBias());
+    EXPECT_EQ(header_info.executable_segment_offset, elf_file->GetExecutableSegmentOffset());
+  }
+}
+
+TEST(ElfHeaderInfo, Values) {
+  auto header_info_or_error = ReadElfHeaderInfo(orbit_test::GetTestdataDir() / "libtest-1.0.so");
+  ASSERT_THAT(header_info_or_error, HasNoError());
+  EXPECT_EQ(header_info_or_error.value().build_id, "2e70049c5cf42e6c5105825b57104af5882a40a2");
+  EXPECT_EQ(header_info_or_error.value().soname, "libtest.so");
+  EXPECT_EQ(header_info_or_error.value().load_bias, 0x0);
+}
+
+TEST(ElfHeaderInfo, UnsupportedFiles) {
+  EXPECT_THAT(ReadElfHeaderInfo(orbit_test::GetTestdataDir() / "textfile.txt"),
+              HasError("is not an ELF file"));
+  EXPECT_THAT(ReadElfHeaderInfo(orbit_test::GetTestdataDir() / "libtest.dll"),
+              HasError("is not an ELF file"));
+  EXPECT_THAT(
+      ReadElfHeaderInfo(orbit_test::GetTestdataDir() / "hello_world_elf_no_program_headers"),
+      HasError("No executable PT_LOAD segment"));
+  EXPECT_THAT(ReadElfHeaderInfo("/not/a/valid/file/path"), HasError(""));
+}
+
+}  // namespace orbit_object_utils
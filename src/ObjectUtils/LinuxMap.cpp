@@ -4,25 +4,33 @@
 
 #include "ObjectUtils/LinuxMap.h"
 
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/match.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include <algorithm>
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
-#include <system_error>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
 #include "ObjectUtils/ElfFile.h"
+#include "ObjectUtils/ElfHeaderInfo.h"
 #include "ObjectUtils/ObjectFile.h"
 #include "OrbitBase/Align.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/SafeStrerror.h"
 
 namespace orbit_object_utils {
 
@@ -31,23 +39,82 @@ using orbit_object_utils::CreateObjectFile;
 using orbit_object_utils::ElfFile;
 using orbit_object_utils::ObjectFile;
 
-ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path,
-                                        uint64_t start_address, uint64_t end_address) {
-  // This excludes mapped character or block devices.
-  if (absl::StartsWith(module_path.string(), "/dev/")) {
-    return ErrorMessage(absl::StrFormat(
-        "The module \"%s\" is a character or block device (is in /dev/)", module_path));
+namespace {
+
+// Identifies the version of a file the information in a ModuleInfo was read from. A file that is
+// replaced gets a new inode, and a file that is modified in place gets a new modification time.
+struct FileIdentity {
+  std::string path;
+  uint64_t device;
+  uint64_t inode;
+  int64_t modification_time_ns;
+  uint64_t size;
+
+  friend bool operator==(const FileIdentity& lhs, const FileIdentity& rhs) {
+    return std::tie(lhs.path, lhs.device, lhs.inode, lhs.modification_time_ns, lhs.size) ==
+           std::tie(rhs.path, rhs.device, rhs.inode, rhs.modification_time_ns, rhs.size);
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const FileIdentity& identity) {
+    return H::combine(std::move(h), identity.path, identity.device, identity.inode,
+                      identity.modification_time_ns, identity.size);
+  }
+};
+
+// Process-wide cache of the ModuleInfos (without address range) created from files. Most modules
+// are mapped by many processes and don't change while the service runs, but they would otherwise
+// be read again for every module listing, at the start of every capture and for every mmap.
+class ModuleInfoCache {
+ public:
+  [[nodiscard]] std::optional<ModuleInfo> Find(const FileIdentity& identity) const {
+    absl::MutexLock lock(&mutex_);
+    auto it = module_infos_.find(identity);
+    if (it == module_infos_.end()) return std::nullopt;
+    return it->second;
   }
 
-  if (!std::filesystem::exists(module_path)) {
-    return ErrorMessage(absl::StrFormat("The module file \"%s\" does not exist", module_path));
+  void Insert(FileIdentity identity, ModuleInfo module_info) {
+    absl::MutexLock lock(&mutex_);
+    // Entries of files that were replaced are never looked up again. Rather than tracking usage,
+    // simply start over when the cache grows too large.
+    if (module_infos_.size() >= kMaxSize) {
+      module_infos_.clear();
+    }
+    module_infos_.insert_or_assign(std::move(identity), std::move(module_info));
   }
 
-  std::error_code error;
-  uint64_t file_size = std::filesystem::file_size(module_path, error);
-  if (error) {
-    return ErrorMessage(
-        absl::StrFormat("Unable to get size of \"%s\": %s", module_path, error.message()));
+ private:
+  static constexpr size_t kMaxSize = 16 * 1024;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<FileIdentity, ModuleInfo> module_infos_ ABSL_GUARDED_BY(mutex_);
+};
+
+ModuleInfoCache& GetModuleInfoCache() {
+  static auto* module_info_cache = new ModuleInfoCache();
+  return *module_info_cache;
+}
+
+ErrorMessageOr<ModuleInfo> ReadModuleInfoFromFile(const std::filesystem::path& module_path,
+                                                  uint64_t file_size) {
+  ModuleInfo module_info;
+  module_info.set_file_path(module_path);
+  module_info.set_file_size(file_size);
+
+  // Reading the few headers we need directly is much cheaper than creating an ObjectFile. Only fall
+  // back to the latter for files the former doesn't support, e.g., COFF files, or to get the same
+  // error message as for other uses of the file.
+  ErrorMessageOr<ElfHeaderInfo> header_info_or_error = ReadElfHeaderInfo(module_path);
+  if (header_info_or_error.has_value()) {
+    const ElfHeaderInfo& header_info = header_info_or_error.value();
+    module_info.set_name(header_info.soname.empty() ? module_path.filename().string()
+                                                    : header_info.soname);
+    module_info.set_load_bias(header_info.load_bias);
+    module_info.set_executable_segment_offset(header_info.executable_segment_offset);
+    module_info.set_build_id(header_info.build_id);
+    module_info.set_soname(header_info.soname);
+    return module_info;
   }
 
   auto object_file_or_error = CreateObjectFile(module_path);
@@ -56,11 +123,6 @@ ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path
                                         object_file_or_error.error().message()));
   }
 
-  ModuleInfo module_info;
-  module_info.set_file_path(module_path);
-  module_info.set_file_size(file_size);
-  module_info.set_address_start(start_address);
-  module_info.set_address_end(end_address);
   module_info.set_name(object_file_or_error.value()->GetName());
   module_info.set_load_bias(object_file_or_error.value()->GetLoadBias());
   module_info.set_executable_segment_offset(
@@ -78,6 +140,42 @@ ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path
   return module_info;
 }
 
+}  // namespace
+
+ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path,
+                                        uint64_t start_address, uint64_t end_address) {
+  // This excludes mapped character or block devices.
+  if (absl::StartsWith(module_path.string(), "/dev/")) {
+    return ErrorMessage(absl::StrFormat(
+        "The module \"%s\" is a character or block device (is in /dev/)", module_path));
+  }
+
+  struct stat file_stat {};
+  if (stat(module_path.c_str(), &file_stat) != 0) {
+    if (errno == ENOENT || errno == ENOTDIR) {
+      return ErrorMessage(absl::StrFormat("The module file \"%s\" does not exist", module_path));
+    }
+    return ErrorMessage(absl::StrFormat("Unable to get size of \"%s\": %s", module_path,
+                                        SafeStrerror(errno)));
+  }
+
+  FileIdentity file_identity{
+      module_path.string(), file_stat.st_dev, file_stat.st_ino,
+      static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1'000'000'000 + file_stat.st_mtim.tv_nsec,
+      static_cast<uint64_t>(file_stat.st_size)};
+  ModuleInfoCache& module_info_cache = GetModuleInfoCache();
+  std::optional<ModuleInfo> module_info = module_info_cache.Find(file_identity);
+  if (!module_info.has_value()) {
+    OUTCOME_TRY(auto&& new_module_info, ReadModuleInfoFromFile(module_path, file_identity.size));
+    module_info_cache.Insert(std::move(file_identity), new_module_info);
+    module_info = std::move(new_module_info);
+  }
+
+  module_info->set_address_start(start_address);
+  module_info->set_address_end(end_address);
+  return std::move(module_info.value());
+}
+
 ErrorMessageOr<std::vector<ModuleInfo>> ReadModules(int32_t pid) {
   std::filesystem::path proc_maps_path{absl::StrFormat("/proc/%d/maps", pid)};
   OUTCOME_TRY(auto&& proc_maps_data, orbit_base::ReadFileToString(proc_maps_path));
@@ -15,7 +15,10 @@
 #include <vector>
 
 #include "ObjectUtils/LinuxMap.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/ReadFileToString.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/TemporaryFile.h"
 #include "OrbitBase/TestUtils.h"
 #include "Test/Path.h"
 #include "module.pb.h"
@@ -121,6 +124,43 @@ TEST(LinuxMap, CreateModuleFileDoesNotExist) {
   EXPECT_EQ(result.error().message(), "The module file \"/not/a/valid/file/path\" does not exist");
 }
 
+TEST(LinuxMap, CreateModuleAfterFileChanged) {
+  auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+  ASSERT_THAT(temporary_file_or_error, HasNoError());
+  orbit_base::TemporaryFile& temporary_file = temporary_file_or_error.value();
+
+  auto write_testdata_file_to_temporary_file = [&temporary_file](std::string_view file_name) {
+    auto content_or_error =
+        orbit_base::ReadFileToString(orbit_test::GetTestdataDir() / std::string{file_name});
+    ASSERT_THAT(content_or_error, HasNoError());
+    ASSERT_THAT(orbit_base::WriteFullyAtOffset(temporary_file.fd(), content_or_error.value().data(),
+                                               content_or_error.value().size(), 0),
+                HasNoError());
+  };
+
+  write_testdata_file_to_temporary_file("libtest-1.0.so");
+  auto result = CreateModule(temporary_file.file_path(), 0, 0x1000);
+  ASSERT_THAT(result, HasNoError());
+  EXPECT_EQ(result.value().build_id(), "2e70049c5cf42e6c5105825b57104af5882a40a2");
+  EXPECT_EQ(result.value().name(), "libtest.so");
+
+  // The module is created from the same file again...
+  result = CreateModule(temporary_file.file_path(), 0x2000, 0x3000);
+  ASSERT_THAT(result, HasNoError());
+  EXPECT_EQ(result.value().build_id(), "2e70049c5cf42e6c5105825b57104af5882a40a2");
+  EXPECT_EQ(result.value().address_start(), 0x2000);
+  EXPECT_EQ(result.value().address_end(), 0x3000);
+
+  // ...and from the modified file, which is larger, so that the change is detected even if the
+  // modification time doesn't change.
+  write_testdata_file_to_temporary_file("hello_world_elf");
+  result = CreateModule(temporary_file.file_path(), 0, 0x1000);
+  ASSERT_THAT(result, HasNoError());
+  EXPECT_EQ(result.value().build_id(), "d12d54bc5b72ccce54a408bdeda65e2530740ac8");
+  EXPECT_EQ(result.value().soname(), "");
+  EXPECT_EQ(result.value().file_size(), 16616);
+}
+
 TEST(LinuxMap, ReadModules) {
   const auto result = ReadModules(getpid());
   EXPECT_THAT(result, HasNoError());
@@ -0,0 +1,38 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OBJECT_UTILS_ELF_HEADER_INFO_H_
+#define OBJECT_UTILS_ELF_HEADER_INFO_H_
+
+#include <stdint.h>
+
+#if defined(__linux)
+
+#include <filesystem>
+#include <string>
+
+#include "OrbitBase/Result.h"
+
+namespace orbit_object_utils {
+
+// The information about an ELF file that is needed to create a ModuleInfo.
+struct ElfHeaderInfo {
+  std::string build_id;
+  std::string soname;
+  uint64_t load_bias = 0;
+  uint64_t executable_segment_offset = 0;
+};
+
+// Reads ElfHeaderInfo only from the ELF header, the program headers and the PT_NOTE and PT_DYNAMIC
+// segments, with a handful of small reads. Unlike CreateElfFile, this neither maps the file nor
+// parses the section headers, which makes it suitable for reading the modules of a process.
+// The values are the ones ElfFile reports. Only 64-bit little-endian files are supported; for other
+// files, and files whose headers are inconsistent, an error is returned.
+[[nodiscard]] ErrorMessageOr<ElfHeaderInfo> ReadElfHeaderInfo(
+    const std::filesystem::path& file_path);
+
+}  // namespace orbit_object_utils
+
+#endif  // defined(__linux)
+#endif  // OBJECT_UTILS_ELF_HEADER_INFO_H_
@@ -16,6 +16,7 @@
 #include <absl/time/time.h>
 #include <imgui.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cinttypes>
 #include <cstddef>
@@ -38,7 +39,6 @@
 #include "ClientData/ModuleManager.h"
 #include "ClientData/PostProcessedSamplingData.h"
 #include "ClientData/ProcessData.h"
-#include "ClientData/TimerChain.h"
 #include "ClientData/UserDefinedCaptureData.h"
 #include "ClientModel/CaptureDeserializer.h"
 #include "ClientModel/CaptureSerializer.h"
@@ -104,8 +104,6 @@ using orbit_client_data::PostProcessedSamplingData;
 using orbit_client_data::ProcessData;
 using orbit_client_data::SampledFunction;
 using orbit_client_data::ThreadID;
-using orbit_client_data::TimerBlock;
-using orbit_client_data::TimerChain;
 using orbit_client_data::TracepointInfoSet;
 using orbit_client_data::UserDefinedCaptureData;
 
@@ -143,6 +141,8 @@ namespace {
 
 constexpr const char* kLibOrbitVulkanLayerSoFileName = "libOrbitVulkanLayer.so";
 
+constexpr absl::Duration kLiveSamplingReportRefreshInterval = absl::Seconds(1);
+
 orbit_data_views::PresetLoadState GetPresetLoadStateForProcess(const PresetFile& preset,
                                                                const ProcessData* process) {
   if (process == nullptr) {
@@ -293,6 +293,12 @@ void OrbitApp::OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture
         // this task is completely executed.
         capture_data_ = std::make_unique<CaptureData>(
             module_manager_.get(), capture_started, file_path, std::move(frame_track_function_ids));
+        live_sampling_data_aggregator_.Clear();
+        last_live_sampling_report_time_ = absl::Now();
+        {
+          absl::MutexLock lock(&live_sampling_report_mutex_);
+          live_sampling_reports_enabled_ = true;
+        }
         capture_window_->CreateTimeGraph(capture_data_.get());
         TrackManager* track_manager = GetMutableTimeGraph()->GetTrackManager();
         track_manager->SetIsDataFromSavedCapture(is_loading_capture_);
@@ -337,6 +343,7 @@ void OrbitApp::OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture
 }
 
 Future<void> OrbitApp::OnCaptureComplete() {
+  DisableLiveSamplingReports();
   for (ThreadTrack* thread_track : GetMutableTimeGraph()->GetTrackManager()->GetThreadTracks()) {
     thread_track->OnCaptureComplete();
   }
@@ -344,8 +351,9 @@ Future<void> OrbitApp::OnCaptureComplete() {
 
   GetMutableCaptureData().FilterBrokenCallstacks();
   PostProcessedSamplingData post_processed_sampling_data =
-      orbit_client_model::CreatePostProcessedSamplingData(GetCaptureData().GetCallstackData(),
-                                                          GetCaptureData());
+      orbit_client_model::CreatePostProcessedSamplingData(
+          GetCaptureData().GetCallstackData(), GetCaptureData(), /*generate_summary=*/true,
+          core_count_sized_thread_pool_.get());
 
   LOG("The capture contains %u intervals with incomplete data",
       GetCaptureData().incomplete_data_intervals().size());
@@ -371,6 +379,7 @@ Future<void> OrbitApp::OnCaptureComplete() {
 }
 
 Future<void> OrbitApp::OnCaptureCancelled() {
+  DisableLiveSamplingReports();
   return main_thread_executor_->Schedule([this]() mutable {
     ORBIT_SCOPE("OnCaptureCancelled");
     CHECK(capture_failed_callback_);
@@ -381,6 +390,7 @@ Future<void> OrbitApp::OnCaptureCancelled() {
 }
 
 Future<void> OrbitApp::OnCaptureFailed(ErrorMessage error_message) {
+  DisableLiveSamplingReports();
   return main_thread_executor_->Schedule(
       [this, error_message = std::move(error_message)]() mutable {
         ORBIT_SCOPE("OnCaptureFailed");
@@ -428,15 +438,66 @@ void OrbitApp::OnUniqueCallstack(uint64_t callstack_id, CallstackInfo callstack)
 }
 
 void OrbitApp::OnCallstackEvent(CallstackEvent callstack_event) {
+  live_sampling_data_aggregator_.AddCallstackEvent(callstack_event);
   GetMutableCaptureData().AddCallstackEvent(std::move(callstack_event));
 }
 
+void OrbitApp::RefreshLiveSamplingReportIfNeeded() {
+  CHECK(std::this_thread::get_id() == main_thread_id_);
+  // When loading a capture, the final report will be computed shortly anyway.
+  if (!IsCapturing() || is_loading_capture_ || !HasCaptureData()) return;
+  if (!live_sampling_report_future_.IsFinished()) return;
+  if (absl::Now() - last_live_sampling_report_time_ < kLiveSamplingReportRefreshInterval) return;
+  last_live_sampling_report_time_ = absl::Now();
+
+  // Like the selection reports, this reads the CaptureData while the capture thread keeps adding
+  // callstacks, address infos and thread names to it, which CaptureData guards internally. Only the
+  // post-processing at the end of the capture has to wait.
+  live_sampling_report_future_ = thread_pool_->Schedule([this, capture_data = &GetCaptureData()] {
+    ORBIT_SCOPE("RefreshLiveSamplingReport");
+    absl::MutexLock lock(&live_sampling_report_mutex_);
+    if (!live_sampling_reports_enabled_) return;
+
+    PostProcessedSamplingData post_processed_sampling_data =
+        live_sampling_data_aggregator_.CreatePostProcessedSamplingData(
+            capture_data->GetCallstackData(), *capture_data, /*generate_summary=*/true,
+            core_count_sized_thread_pool_.get());
+    std::unique_ptr<CallTreeView> top_down_view =
+        CallTreeView::CreateTopDownViewFromPostProcessedSamplingData(post_processed_sampling_data,
+                                                                     *capture_data);
+    std::unique_ptr<CallTreeView> bottom_up_view =
+        CallTreeView::CreateBottomUpViewFromPostProcessedSamplingData(post_processed_sampling_data,
+                                                                      *capture_data);
+    absl::flat_hash_map<uint64_t, std::shared_ptr<CallstackInfo>> unique_callstacks =
+        capture_data->GetCallstackData().GetUniqueCallstacksCopy();
+
+    // Scheduled while holding the lock, so that this runs before the task showing the final report,
+    // which OnCaptureComplete only schedules after acquiring the lock.
+    main_thread_executor_->Schedule(
+        [this, post_processed_sampling_data = std::move(post_processed_sampling_data),
+         unique_callstacks = std::move(unique_callstacks), top_down_view = std::move(top_down_view),
+         bottom_up_view = std::move(bottom_up_view)]() mutable {
+          if (!HasCaptureData()) return;
+          SetSamplingReport(std::move(post_processed_sampling_data), std::move(unique_callstacks));
+          CHECK(top_down_view_callback_);
+          top_down_view_callback_(std::move(top_down_view));
+          CHECK(bottom_up_view_callback_);
+          bottom_up_view_callback_(std::move(bottom_up_view));
+        });
+  });
+}
+
+void OrbitApp::DisableLiveSamplingReports() {
+  absl::MutexLock lock(&live_sampling_report_mutex_);
+  live_sampling_reports_enabled_ = false;
+}
+
 void OrbitApp::OnThreadName(int32_t thread_id, std::string thread_name) {
   GetMutableCaptureData().AddOrAssignThreadName(thread_id, std::move(thread_name));
 }
 
 void OrbitApp::OnThreadStateSlice(orbit_client_protos::ThreadStateSliceInfo thread_state_slice) {
-  GetMutableCaptureData().AddThreadStateSlice(std::move(thread_state_slice));
+  GetMutableCaptureData().AddThreadStateSlice(thread_state_slice);
 }
 
 void OrbitApp::OnAddressInfo(LinuxAddressInfo address_info) {
@@ -918,6 +979,8 @@ void OrbitApp::ShowSourceCode(const orbit_client_protos::FunctionInfo& function)
 void OrbitApp::MainTick() {
   ORBIT_SCOPE("OrbitApp::MainTick");
 
+  RefreshLiveSamplingReportIfNeeded();
+
   if (DoZoom && HasCaptureData()) {
     capture_window_->ZoomAll();
     RequestUpdatePrimitives();
@@ -1445,6 +1508,15 @@ void OrbitApp::ClearCapture() {
   if (capture_window_ != nullptr) {
     capture_window_->ClearTimeGraph();
   }
+  // Selection reports and live sampling reports might still be computed from the CaptureData in
+  // the background.
+  ++selection_report_generation_;
+  for (const orbit_base::Future<void>& future : selection_report_futures_) {
+    future.Wait();
+  }
+  selection_report_futures_.clear();
+  DisableLiveSamplingReports();
+  live_sampling_report_future_.Wait();
   capture_data_.reset();
 
   string_manager_.Clear();
@@ -2272,28 +2344,84 @@ uint64_t OrbitApp::GetFunctionIdToHighlight() const {
   return selected_function_id;
 }
 
-void OrbitApp::SelectCallstackEvents(const std::vector<CallstackEvent>& selected_callstack_events,
+void OrbitApp::SelectCallstackEvents(uint64_t min_timestamp, uint64_t max_timestamp,
                                      int32_t thread_id) {
-  const CallstackData& callstack_data = GetCaptureData().GetCallstackData();
-  std::unique_ptr<CallstackData> selection_callstack_data = std::make_unique<CallstackData>();
-  for (const CallstackEvent& event : selected_callstack_events) {
-    selection_callstack_data->AddCallstackFromKnownCallstackData(event, callstack_data);
-  }
-  // TODO: this might live on the data_manager
-  GetMutableCaptureData().set_selection_callstack_data(std::move(selection_callstack_data));
-
-  // Generate selection report.
-  bool generate_summary = thread_id == orbit_base::kAllProcessThreadsTid;
-  PostProcessedSamplingData processed_sampling_data =
-      orbit_client_model::CreatePostProcessedSamplingData(
-          *GetCaptureData().GetSelectionCallstackData(), GetCaptureData(), generate_summary);
-
-  SetSelectionTopDownView(processed_sampling_data, GetCaptureData());
-  SetSelectionBottomUpView(processed_sampling_data, GetCaptureData());
-
-  SetSelectionReport(std::move(processed_sampling_data),
-                     GetCaptureData().GetSelectionCallstackData()->GetUniqueCallstacksCopy(),
-                     generate_summary);
+  CHECK(std::this_thread::get_id() == main_thread_id_);
+  const uint64_t generation = ++selection_report_generation_;
+  auto is_superseded = [this, generation] { return selection_report_generation_ != generation; };
+
+  // Superseded computations can still be running, possibly after this one, as the thread pool runs
+  // tasks concurrently. They all only read the CaptureData, which outlives them: ClearCapture waits
+  // for all of `selection_report_futures_` before destroying the CaptureData.
+  selection_report_futures_.erase(
+      std::remove_if(selection_report_futures_.begin(), selection_report_futures_.end(),
+                     [](const orbit_base::Future<void>& future) { return future.IsFinished(); }),
+      selection_report_futures_.end());
+  orbit_base::Future<void> future = thread_pool_->Schedule([this, is_superseded, min_timestamp,
+                                                            max_timestamp, thread_id,
+                                                            capture_data = &GetCaptureData()] {
+    ORBIT_SCOPE("SelectCallstackEvents");
+    const CallstackData& callstack_data = capture_data->GetCallstackData();
+    auto selection_callstack_data = std::make_unique<CallstackData>();
+    auto add_to_selection = [&selection_callstack_data,
+                             &callstack_data](const CallstackEvent& event) {
+      selection_callstack_data->AddCallstackFromKnownCallstackData(event, callstack_data);
+    };
+    if (thread_id == orbit_base::kAllProcessThreadsTid) {
+      callstack_data.ForEachCallstackEventInTimeRange(min_timestamp, max_timestamp,
+                                                      add_to_selection);
+    } else {
+      callstack_data.ForEachCallstackEventOfTidInTimeRange(thread_id, min_timestamp,
+                                                           max_timestamp, add_to_selection);
+    }
+    if (is_superseded()) return;
+
+    // Generate selection report.
+    const bool generate_summary = thread_id == orbit_base::kAllProcessThreadsTid;
+    PostProcessedSamplingData processed_sampling_data =
+        orbit_client_model::CreatePostProcessedSamplingData(*selection_callstack_data,
+                                                            *capture_data, generate_summary,
+                                                            core_count_sized_thread_pool_.get());
+    if (is_superseded()) return;
+
+    // Each view is shown as soon as it is ready.
+    std::unique_ptr<CallTreeView> top_down_view =
+        CallTreeView::CreateTopDownViewFromPostProcessedSamplingData(processed_sampling_data,
+                                                                     *capture_data);
+    main_thread_executor_->Schedule(
+        [this, is_superseded, top_down_view = std::move(top_down_view)]() mutable {
+          if (is_superseded()) return;
+          CHECK(selection_top_down_view_callback_);
+          selection_top_down_view_callback_(std::move(top_down_view));
+        });
+    if (is_superseded()) return;
+
+    std::unique_ptr<CallTreeView> bottom_up_view =
+        CallTreeView::CreateBottomUpViewFromPostProcessedSamplingData(processed_sampling_data,
+                                                                      *capture_data);
+    main_thread_executor_->Schedule(
+        [this, is_superseded, bottom_up_view = std::move(bottom_up_view)]() mutable {
+          if (is_superseded()) return;
+          CHECK(selection_bottom_up_view_callback_);
+          selection_bottom_up_view_callback_(std::move(bottom_up_view));
+        });
+    if (is_superseded()) return;
+
+    absl::flat_hash_map<uint64_t, std::shared_ptr<CallstackInfo>> unique_callstacks =
+        selection_callstack_data->GetUniqueCallstacksCopy();
+    main_thread_executor_->Schedule(
+        [this, is_superseded, generate_summary, unique_callstacks = std::move(unique_callstacks),
+         selection_callstack_data = std::move(selection_callstack_data),
+         processed_sampling_data = std::move(processed_sampling_data)]() mutable {
+          if (is_superseded()) return;
+          // TODO: this might live on the data_manager
+          GetMutableCaptureData().set_selection_callstack_data(
+              std::move(selection_callstack_data));
+          SetSelectionReport(std::move(processed_sampling_data), std::move(unique_callstacks),
+                             generate_summary);
+        });
+  });
+  selection_report_futures_.push_back(std::move(future));
 }
 
 void OrbitApp::UpdateAfterSymbolLoading() {
@@ -2304,8 +2432,9 @@ void OrbitApp::UpdateAfterSymbolLoading() {
 
   if (sampling_report_ != nullptr) {
     PostProcessedSamplingData post_processed_sampling_data =
-        orbit_client_model::CreatePostProcessedSamplingData(capture_data.GetCallstackData(),
-                                                            capture_data);
+        orbit_client_model::CreatePostProcessedSamplingData(
+            capture_data.GetCallstackData(), capture_data, /*generate_summary=*/true,
+            core_count_sized_thread_pool_.get());
     sampling_report_->UpdateReport(post_processed_sampling_data,
                                    capture_data.GetCallstackData().GetUniqueCallstacksCopy());
     GetMutableCaptureData().set_post_processed_sampling_data(post_processed_sampling_data);
@@ -2318,9 +2447,9 @@ void OrbitApp::UpdateAfterSymbolLoading() {
   }
 
   PostProcessedSamplingData selection_post_processed_sampling_data =
-      orbit_client_model::CreatePostProcessedSamplingData(*capture_data.GetSelectionCallstackData(),
-                                                          capture_data,
-                                                          selection_report_->has_summary());
+      orbit_client_model::CreatePostProcessedSamplingData(
+          *capture_data.GetSelectionCallstackData(), capture_data,
+          selection_report_->has_summary(), core_count_sized_thread_pool_.get());
 
   SetSelectionTopDownView(selection_post_processed_sampling_data, capture_data);
   SetSelectionBottomUpView(selection_post_processed_sampling_data, capture_data);
@@ -2588,19 +2717,10 @@ void OrbitApp::AddFrameTrackTimers(uint64_t instrumented_function_id) {
     return;
   }
 
-  std::vector<const TimerChain*> chains = GetMutableTimeGraph()->GetAllThreadTrackTimerChains();
-
   std::vector<uint64_t> all_start_times;
-
-  for (const TimerChain* chain : chains) {
-    for (const TimerBlock& block : *chain) {
-      for (uint64_t i = 0; i < block.size(); ++i) {
-        const TimerInfo& timer_info = block[i];
-        if (timer_info.function_id() == instrumented_function_id) {
-          all_start_times.push_back(timer_info.start());
-        }
-      }
-    }
+  for (const TimerInfo* timer_info :
+       GetTimeGraph()->GetAllTimersForFunction(instrumented_function_id)) {
+    all_start_times.push_back(timer_info->start());
   }
   std::sort(all_start_times.begin(), all_start_times.end());
 
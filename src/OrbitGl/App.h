@@ -7,6 +7,7 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/types/span.h>
 #include <grpc/impl/codegen/connectivity_state.h>
 #include <grpcpp/channel.h>
@@ -40,6 +41,7 @@
 #include "ClientData/ProcessData.h"
 #include "ClientData/TracepointCustom.h"
 #include "ClientData/UserDefinedCaptureData.h"
+#include "ClientModel/SamplingDataAggregator.h"
 #include "ClientServices/CrashManager.h"
 #include "ClientServices/ProcessManager.h"
 #include "ClientServices/TracepointServiceClient.h"
@@ -436,9 +438,10 @@ class OrbitApp final : public DataViewFactory,
 
   [[nodiscard]] uint64_t GetFunctionIdToHighlight() const;
 
-  void SelectCallstackEvents(
-      const std::vector<orbit_client_protos::CallstackEvent>& selected_callstack_events,
-      int32_t thread_id);
+  // Computes the selection report (and the selection top-down and bottom-up views) of the
+  // callstack events of `thread_id` in [min_timestamp, max_timestamp] in the background. The
+  // results are shown as they become ready, unless a newer selection has been made in the meantime.
+  void SelectCallstackEvents(uint64_t min_timestamp, uint64_t max_timestamp, int32_t thread_id);
 
   void SelectTracepoint(const orbit_grpc_protos::TracepointInfo& info);
   void DeselectTracepoint(const orbit_grpc_protos::TracepointInfo& tracepoint);
@@ -516,6 +519,15 @@ class OrbitApp final : public DataViewFactory,
 
   void RequestUpdatePrimitives();
 
+  // Only call from the main thread, this is driven by MainTick. Computes the sampling report and
+  // the call trees of the samples received so far on `thread_pool_` and then shows them. A refresh
+  // is started at most about once per second, and not while the previous one is still running.
+  void RefreshLiveSamplingReportIfNeeded();
+  // Waits for the computation of a live sampling report that is in progress and prevents new ones
+  // until the next capture starts. Called before the CaptureData is post-processed at the end of
+  // the capture, and before it is destroyed.
+  void DisableLiveSamplingReports();
+
   // Only call from the capture thread
   void CaptureMetricProcessTimer(const orbit_client_protos::TimerInfo& timer);
   // Only call from the capture thread
@@ -524,6 +536,16 @@ class OrbitApp final : public DataViewFactory,
   std::atomic<bool> capture_loading_cancellation_requested_ = false;
   std::atomic<bool> is_loading_capture_{false};
 
+  orbit_client_model::SamplingDataAggregator live_sampling_data_aggregator_;
+  // Only accessed from the main thread.
+  absl::Time last_live_sampling_report_time_ = absl::InfinitePast();
+  // Only accessed from the main thread. ClearCapture waits for it before destroying the
+  // CaptureData.
+  orbit_base::Future<void> live_sampling_report_future_;
+  // Held while a live sampling report is computed.
+  absl::Mutex live_sampling_report_mutex_;
+  bool live_sampling_reports_enabled_ ABSL_GUARDED_BY(live_sampling_report_mutex_) = false;
+
   CaptureStartedCallback capture_started_callback_;
   CaptureStopRequestedCallback capture_stop_requested_callback_;
   CaptureStoppedCallback capture_stopped_callback_;
@@ -560,6 +582,11 @@ class OrbitApp final : public DataViewFactory,
 
   std::shared_ptr<SamplingReport> sampling_report_;
   std::shared_ptr<SamplingReport> selection_report_ = nullptr;
+  // Incremented on every new selection of callstack events and when the capture is cleared. The
+  // computation of a superseded selection report stops early and its results are discarded.
+  std::atomic<uint64_t> selection_report_generation_ = 0;
+  // Only accessed from the main thread.
+  std::vector<orbit_base::Future<void>> selection_report_futures_;
 
   absl::flat_hash_map<std::pair<std::string, std::string>,
                       orbit_base::Future<ErrorMessageOr<std::filesystem::path>>>
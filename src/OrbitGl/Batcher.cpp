@@ -6,10 +6,13 @@
 
 #include <GteVector.h>
 #include <GteVector2.h>
+#include <absl/base/casts.h>
 #include <glad/glad.h>
 #include <math.h>
 #include <stddef.h>
 
+#include <array>
+
 #include "DisplayFormats/DisplayFormats.h"
 #include "Introspection/Introspection.h"
 #include "OrbitBase/Logging.h"
@@ -59,6 +62,7 @@ void Batcher::AddLine(Vec2 from, Vec2 to, float z, const Color& color, const Col
   // tracks are missing. We need a better solution for this issue.
   MoveLineToPixelCenterIfHorizontal(line);
   auto& buffer = primitive_buffers_by_layer_[z];
+  buffer.picking_index.reset();
 
   buffer.line_buffer.lines_.emplace_back(line);
   buffer.line_buffer.colors_.push_back_n(color, 2);
@@ -205,6 +209,7 @@ void Batcher::AddBox(const Box& box, const std::array<Color, 4>& colors, const C
   }
   float layer_z_value = rounded_box.vertices[0][2];
   auto& buffer = primitive_buffers_by_layer_[layer_z_value];
+  buffer.picking_index.reset();
   buffer.box_buffer.boxes_.emplace_back(rounded_box);
   buffer.box_buffer.colors_.push_back(colors);
   buffer.box_buffer.picking_colors_.push_back_n(picking_color, 4);
@@ -259,6 +264,7 @@ void Batcher::AddTriangle(const Triangle& triangle, const std::array<Color, 3>&
   }
   float layer_z_value = rounded_tri.vertices[0][2];
   auto& buffer = primitive_buffers_by_layer_[layer_z_value];
+  buffer.picking_index.reset();
   buffer.triangle_buffer.triangles_.emplace_back(rounded_tri);
   buffer.triangle_buffer.colors_.push_back(colors);
   buffer.triangle_buffer.picking_colors_.push_back_n(picking_color, 3);
@@ -287,6 +293,7 @@ void Batcher::AddCircle(Vec2 position, float radius, float z, Color color) {
 }
 
 const PickingUserData* Batcher::GetUserData(PickingId id) const {
+  if (merged_into_ != nullptr) return merged_into_->GetUserData(id);
   CHECK(id.element_id >= 0);
   CHECK(id.batcher_id == batcher_id_);
 
@@ -365,6 +372,163 @@ void Batcher::ResetElements() {
 void Batcher::StartNewFrame() {
   ResetElements();
   user_data_.clear();
+  merged_into_ = nullptr;
+}
+
+static PickingId PickingIdFromColor(const Color& picking_color) {
+  const std::array<uint8_t, 4> color_values{picking_color[0], picking_color[1], picking_color[2],
+                                            picking_color[3]};
+  return PickingId::FromPixelValue(absl::bit_cast<uint32_t>(color_values));
+}
+
+// Picking colors of lines, boxes and triangles encode the index of the user data in the batcher.
+// Offsets that index by `element_id_offset`. Colors of pickables are left unchanged.
+static Color OffsetPickingColor(const Color& picking_color, uint32_t element_id_offset) {
+  const PickingId id = PickingIdFromColor(picking_color);
+  if (id.type != PickingType::kLine && id.type != PickingType::kBox &&
+      id.type != PickingType::kTriangle) {
+    return picking_color;
+  }
+  return PickingId::ToColor(id.type, id.element_id + element_id_offset, id.batcher_id);
+}
+
+template <typename T, uint32_t BlockSize>
+static void AppendAll(const BlockChain<T, BlockSize>& from, BlockChain<T, BlockSize>* to) {
+  for (const T& element : from) {
+    to->emplace_back(element);
+  }
+}
+
+template <uint32_t BlockSize>
+static void AppendAllPickingColors(const BlockChain<Color, BlockSize>& from,
+                                   uint32_t element_id_offset, BlockChain<Color, BlockSize>* to) {
+  for (const Color& picking_color : from) {
+    to->emplace_back(OffsetPickingColor(picking_color, element_id_offset));
+  }
+}
+
+void Batcher::MergeFrom(Batcher* other) {
+  CHECK(other != nullptr);
+  CHECK(other != this);
+  CHECK(other->batcher_id_ == batcher_id_);
+  CHECK(other->merged_into_ == nullptr);
+
+  const auto element_id_offset = static_cast<uint32_t>(user_data_.size());
+  for (auto& [layer, other_buffer] : other->primitive_buffers_by_layer_) {
+    auto& buffer = primitive_buffers_by_layer_[layer];
+    buffer.picking_index.reset();
+
+    AppendAll(other_buffer.line_buffer.lines_, &buffer.line_buffer.lines_);
+    AppendAll(other_buffer.line_buffer.colors_, &buffer.line_buffer.colors_);
+    AppendAllPickingColors(other_buffer.line_buffer.picking_colors_, element_id_offset,
+                           &buffer.line_buffer.picking_colors_);
+
+    AppendAll(other_buffer.box_buffer.boxes_, &buffer.box_buffer.boxes_);
+    AppendAll(other_buffer.box_buffer.colors_, &buffer.box_buffer.colors_);
+    AppendAllPickingColors(other_buffer.box_buffer.picking_colors_, element_id_offset,
+                           &buffer.box_buffer.picking_colors_);
+
+    AppendAll(other_buffer.triangle_buffer.triangles_, &buffer.triangle_buffer.triangles_);
+    AppendAll(other_buffer.triangle_buffer.colors_, &buffer.triangle_buffer.colors_);
+    AppendAllPickingColors(other_buffer.triangle_buffer.picking_colors_, element_id_offset,
+                           &buffer.triangle_buffer.picking_colors_);
+  }
+
+  for (std::unique_ptr<PickingUserData>& user_data : other->user_data_) {
+    user_data_.push_back(std::move(user_data));
+  }
+  other->user_data_.clear();
+  other->merged_into_ = this;
+}
+
+static orbit_gl::Rect GetBoundingRect(const Vec3* vertices, size_t num_vertices) {
+  Vec2 min(vertices[0][0], vertices[0][1]);
+  Vec2 max = min;
+  for (size_t i = 1; i < num_vertices; ++i) {
+    min = Vec2(std::min(min[0], vertices[i][0]), std::min(min[1], vertices[i][1]));
+    max = Vec2(std::max(max[0], vertices[i][0]), std::max(max[1], vertices[i][1]));
+  }
+  return orbit_gl::Rect(min, max);
+}
+
+template <uint32_t BlockSize>
+static void AppendPickingIds(const BlockChain<Color, BlockSize>& picking_colors,
+                             uint32_t colors_per_primitive, std::vector<PickingId>* picking_ids) {
+  uint32_t color_index = 0;
+  for (const Color& picking_color : picking_colors) {
+    if (color_index++ % colors_per_primitive == 0) {
+      picking_ids->push_back(PickingIdFromColor(picking_color));
+    }
+  }
+}
+
+static std::unique_ptr<PickingIndex> CreatePickingIndex(const PrimitiveBuffers& buffers,
+                                                        Vec2 pixel_size) {
+  auto picking_index = std::make_unique<PickingIndex>();
+  picking_index->pixel_size = pixel_size;
+  std::vector<orbit_gl::Rect> rects;
+
+  for (const Box& box : buffers.box_buffer.boxes_) {
+    rects.push_back(GetBoundingRect(box.vertices, 4));
+  }
+  AppendPickingIds(buffers.box_buffer.picking_colors_, 4, &picking_index->picking_ids);
+
+  // Lines are one pixel wide, coordinates are rounded down to the pixel they cover.
+  for (const Line& line : buffers.line_buffer.lines_) {
+    const Vec3 vertices[2] = {line.start_point, line.end_point};
+    orbit_gl::Rect rect = GetBoundingRect(vertices, 2);
+    rect.max += pixel_size;
+    rects.push_back(rect);
+  }
+  AppendPickingIds(buffers.line_buffer.picking_colors_, 2, &picking_index->picking_ids);
+
+  picking_index->first_triangle_index = rects.size();
+  for (const Triangle& triangle : buffers.triangle_buffer.triangles_) {
+    rects.push_back(GetBoundingRect(triangle.vertices, 3));
+    picking_index->triangles.push_back(triangle);
+  }
+  AppendPickingIds(buffers.triangle_buffer.picking_colors_, 3, &picking_index->picking_ids);
+
+  CHECK(picking_index->picking_ids.size() == rects.size());
+  picking_index->spatial_index = std::make_unique<orbit_gl::SpatialIndex>(rects);
+  return picking_index;
+}
+
+static bool TriangleContains(const Triangle& triangle, Vec2 point) {
+  auto cross = [point](const Vec3& from, const Vec3& to) {
+    return (to[0] - from[0]) * (point[1] - from[1]) - (to[1] - from[1]) * (point[0] - from[0]);
+  };
+  const float d0 = cross(triangle.vertices[0], triangle.vertices[1]);
+  const float d1 = cross(triangle.vertices[1], triangle.vertices[2]);
+  const float d2 = cross(triangle.vertices[2], triangle.vertices[0]);
+  const bool has_negative = d0 < 0 || d1 < 0 || d2 < 0;
+  const bool has_positive = d0 > 0 || d1 > 0 || d2 > 0;
+  return !(has_negative && has_positive);
+}
+
+std::optional<PickingId> Batcher::GetTopmostPickingIdAt(float layer, Vec2 pos,
+                                                       Vec2 pixel_size) const {
+  auto buffers_it = primitive_buffers_by_layer_.find(layer);
+  if (buffers_it == primitive_buffers_by_layer_.end()) return std::nullopt;
+  const PrimitiveBuffers& buffers = buffers_it->second;
+  if (buffers.picking_index == nullptr || buffers.picking_index->pixel_size != pixel_size) {
+    buffers.picking_index = CreatePickingIndex(buffers, pixel_size);
+  }
+  const PickingIndex& picking_index = *buffers.picking_index;
+
+  std::optional<uint32_t> topmost_index;
+  picking_index.spatial_index->ForEachRectContaining(pos, [&](uint32_t index) {
+    if (topmost_index.has_value() && index < topmost_index.value()) return;
+    if (index >= picking_index.first_triangle_index &&
+        !TriangleContains(picking_index.triangles[index - picking_index.first_triangle_index],
+                          pos)) {
+      return;
+    }
+    topmost_index = index;
+  });
+
+  if (!topmost_index.has_value()) return std::nullopt;
+  return picking_index.picking_ids[topmost_index.value()];
 }
 
 std::vector<float> Batcher::GetLayers() const {
@@ -378,6 +542,7 @@ std::vector<float> Batcher::GetLayers() const {
 void Batcher::DrawLayer(float layer, bool picking) const {
   ORBIT_SCOPE_FUNCTION;
   if (!primitive_buffers_by_layer_.count(layer)) return;
+  CHECK(vertex_buffer_garbage_ != nullptr);
   glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
   if (picking) {
     glDisable(GL_BLEND);
@@ -394,6 +559,7 @@ void Batcher::DrawLayer(float layer, bool picking) const {
   DrawLineBuffer(layer, picking);
   DrawTriangleBuffer(layer, picking);
 
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
   glDisableClientState(GL_COLOR_ARRAY);
   glDisableClientState(GL_VERTEX_ARRAY);
   glPopAttrib();
@@ -405,6 +571,76 @@ void Batcher::Draw(bool picking) const {
   }
 }
 
+RetainedBufferRange::Upload RetainedBufferRange::Update(size_t size_in_bytes) {
+  Upload upload;
+  if (size_in_bytes > capacity_in_bytes_) {
+    capacity_in_bytes_ = std::max(size_in_bytes, 2 * capacity_in_bytes_);
+    upload.new_capacity_in_bytes = capacity_in_bytes_;
+    num_bytes_uploaded_ = 0;
+  }
+  if (size_in_bytes > num_bytes_uploaded_) {
+    upload.offset_in_bytes = num_bytes_uploaded_;
+    upload.size_in_bytes = size_in_bytes - num_bytes_uploaded_;
+  }
+  num_bytes_uploaded_ = size_in_bytes;
+  return upload;
+}
+
+void VertexBufferGarbage::DeleteAll() {
+  if (vertex_buffer_ids_.empty()) return;
+  glDeleteBuffers(static_cast<GLsizei>(vertex_buffer_ids_.size()), vertex_buffer_ids_.data());
+  vertex_buffer_ids_.clear();
+}
+
+void RetainedVertexBuffer::Upload(const void* data, size_t size_in_bytes) {
+  if (vertex_buffer_id_ == 0) {
+    glGenBuffers(1, &vertex_buffer_id_);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_id_);
+
+  RetainedBufferRange::Upload upload = range_.Update(size_in_bytes);
+  if (upload.new_capacity_in_bytes.has_value()) {
+    glBufferData(GL_ARRAY_BUFFER, upload.new_capacity_in_bytes.value(), nullptr, GL_DYNAMIC_DRAW);
+  }
+  if (upload.size_in_bytes > 0) {
+    glBufferSubData(GL_ARRAY_BUFFER, upload.offset_in_bytes, upload.size_in_bytes,
+                    static_cast<const uint8_t*>(data) + upload.offset_in_bytes);
+  }
+}
+
+void RetainedVertexBuffer::Release(VertexBufferGarbage* garbage) {
+  if (vertex_buffer_id_ == 0) return;
+  garbage->Add(vertex_buffer_id_);
+  vertex_buffer_id_ = 0;
+  range_ = RetainedBufferRange();
+}
+
+Batcher::~Batcher() {
+  for (auto& [unused_layer, buffer] : primitive_buffers_by_layer_) {
+    buffer.line_buffer.retained_blocks_.Release(vertex_buffer_garbage_);
+    buffer.box_buffer.retained_blocks_.Release(vertex_buffer_garbage_);
+    buffer.triangle_buffer.retained_blocks_.Release(vertex_buffer_garbage_);
+  }
+}
+
+// Brings the GPU copy of a block up to date and draws it. `colors` are either the colors or the
+// picking colors of the primitives, `vertices_per_primitive` of them per primitive.
+template <typename Primitive>
+static void DrawRetainedBlock(GLenum mode, const Primitive* primitives, uint32_t num_primitives,
+                              uint32_t vertices_per_primitive, const Color* colors, bool picking,
+                              RetainedBlock* retained_block) {
+  const uint32_t num_vertices = num_primitives * vertices_per_primitive;
+  retained_block->vertices.Upload(primitives, num_primitives * sizeof(Primitive));
+  glVertexPointer(3, GL_FLOAT, sizeof(Vec3), nullptr);
+
+  RetainedVertexBuffer& color_buffer =
+      picking ? retained_block->picking_colors : retained_block->colors;
+  color_buffer.Upload(colors, num_vertices * sizeof(Color));
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color), nullptr);
+
+  glDrawArrays(mode, 0, num_vertices);
+}
+
 void Batcher::DrawBoxBuffer(float layer, bool picking) const {
   auto& box_buffer = primitive_buffers_by_layer_.at(layer).box_buffer;
   const Block<Box, BoxBuffer::NUM_BOXES_PER_BLOCK>* box_block = box_buffer.boxes_.root();
@@ -412,15 +648,16 @@ void Batcher::DrawBoxBuffer(float layer, bool picking) const {
 
   color_block = !picking ? box_buffer.colors_.root() : box_buffer.picking_colors_.root();
 
+  size_t block_index = 0;
   while (box_block != nullptr) {
     if (auto num_elems = box_block->size()) {
-      glVertexPointer(3, GL_FLOAT, sizeof(Vec3), box_block->data());
-      glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color), color_block->data());
-      glDrawArrays(GL_QUADS, 0, num_elems * 4);
+      DrawRetainedBlock(GL_QUADS, box_block->data(), num_elems, 4, color_block->data(), picking,
+                        box_buffer.retained_blocks_.GetBlock(block_index));
     }
 
     box_block = box_block->next();
     color_block = color_block->next();
+    ++block_index;
   }
 }
 
@@ -430,15 +667,16 @@ void Batcher::DrawLineBuffer(float layer, bool picking) const {
   const Block<Color, LineBuffer::NUM_LINES_PER_BLOCK * 2>* color_block;
 
   color_block = !picking ? line_buffer.colors_.root() : line_buffer.picking_colors_.root();
+  size_t block_index = 0;
   while (line_block != nullptr) {
     if (auto num_elems = line_block->size()) {
-      glVertexPointer(3, GL_FLOAT, sizeof(Vec3), line_block->data());
-      glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color), color_block->data());
-      glDrawArrays(GL_LINES, 0, num_elems * 2);
+      DrawRetainedBlock(GL_LINES, line_block->data(), num_elems, 2, color_block->data(), picking,
+                        line_buffer.retained_blocks_.GetBlock(block_index));
     }
 
     line_block = line_block->next();
     color_block = color_block->next();
+    ++block_index;
   }
 }
 
@@ -450,14 +688,15 @@ void Batcher::DrawTriangleBuffer(float layer, bool picking) const {
 
   color_block = !picking ? triangle_buffer.colors_.root() : triangle_buffer.picking_colors_.root();
 
+  size_t block_index = 0;
   while (triangle_block != nullptr) {
     if (int num_elems = triangle_block->size()) {
-      glVertexPointer(3, GL_FLOAT, sizeof(Vec3), triangle_block->data());
-      glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color), color_block->data());
-      glDrawArrays(GL_TRIANGLES, 0, num_elems * 3);
+      DrawRetainedBlock(GL_TRIANGLES, triangle_block->data(), num_elems, 3, color_block->data(),
+                        picking, triangle_buffer.retained_blocks_.GetBlock(block_index));
     }
 
     triangle_block = triangle_block->next();
     color_block = color_block->next();
+    ++block_index;
   }
 }
@@ -12,6 +12,7 @@
 #include <array>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -21,6 +22,7 @@
 #include "CoreMath.h"
 #include "Geometry.h"
 #include "PickingManager.h"
+#include "SpatialIndex.h"
 #include "capture_data.pb.h"
 
 using TooltipCallback = std::function<std::string(PickingId)>;
@@ -35,17 +37,114 @@ struct PickingUserData {
       : timer_info_(timer_info), generate_tooltip_(std::move(generate_tooltip)) {}
 };
 
+// Keeps track of which part of an array that only grows until it is reset was already transferred
+// to the vertex buffer object mirroring it, and decides what needs to be transferred next. This is
+// the bookkeeping of RetainedVertexBuffer, which does not call OpenGL.
+class RetainedBufferRange {
+ public:
+  struct Upload {
+    // If set, the vertex buffer object needs to be reallocated with this capacity first, which
+    // discards its content.
+    std::optional<size_t> new_capacity_in_bytes;
+    size_t offset_in_bytes = 0;
+    size_t size_in_bytes = 0;
+  };
+
+  // Returns what needs to be transferred for the vertex buffer object to mirror the first
+  // `size_in_bytes` bytes of the array, and records them as transferred.
+  [[nodiscard]] Upload Update(size_t size_in_bytes);
+  // To be called when the mirrored array is reset, as its content is then overwritten.
+  void MarkDirty() { num_bytes_uploaded_ = 0; }
+
+  [[nodiscard]] size_t capacity_in_bytes() const { return capacity_in_bytes_; }
+  [[nodiscard]] size_t num_bytes_uploaded() const { return num_bytes_uploaded_; }
+
+ private:
+  size_t capacity_in_bytes_ = 0;
+  size_t num_bytes_uploaded_ = 0;
+};
+
+// Vertex buffer objects can only be deleted while the OpenGL context they were created in is
+// current, which is usually not the case when a Batcher is destroyed, e.g., the one of the time
+// graph when a capture is cleared. A Batcher that was drawn therefore passes the vertex buffer
+// objects it created to the VertexBufferGarbage of the canvas that drew it, which deletes them the
+// next time it renders. Those still collected when the canvas is destroyed are freed together with
+// its OpenGL context.
+class VertexBufferGarbage {
+ public:
+  void Add(uint32_t vertex_buffer_id) { vertex_buffer_ids_.push_back(vertex_buffer_id); }
+  // Requires the OpenGL context the vertex buffer objects were created in to be current.
+  void DeleteAll();
+
+  [[nodiscard]] size_t size() const { return vertex_buffer_ids_.size(); }
+
+ private:
+  std::vector<uint32_t> vertex_buffer_ids_;
+};
+
+// Vertex buffer object mirroring an array that only grows until it is reset. Only the part of the
+// array appended since the previous upload is transferred to the GPU.
+class RetainedVertexBuffer {
+ public:
+  // Creates the vertex buffer object if needed, binds it to GL_ARRAY_BUFFER and uploads the part of
+  // `data` that was not uploaded yet.
+  void Upload(const void* data, size_t size_in_bytes);
+  void MarkDirty() { range_.MarkDirty(); }
+  // Passes the vertex buffer object, if it was created, to `garbage`.
+  void Release(VertexBufferGarbage* garbage);
+
+ private:
+  uint32_t vertex_buffer_id_ = 0;
+  RetainedBufferRange range_;
+};
+
+// GPU copy of a block of a primitive buffer.
+struct RetainedBlock {
+  void MarkDirty() {
+    vertices.MarkDirty();
+    colors.MarkDirty();
+    picking_colors.MarkDirty();
+  }
+  void Release(VertexBufferGarbage* garbage) {
+    vertices.Release(garbage);
+    colors.Release(garbage);
+    picking_colors.Release(garbage);
+  }
+
+  RetainedVertexBuffer vertices;
+  RetainedVertexBuffer colors;
+  RetainedVertexBuffer picking_colors;
+};
+
+struct RetainedBlocks {
+  void MarkDirty() {
+    for (RetainedBlock& block : blocks) block.MarkDirty();
+  }
+  void Release(VertexBufferGarbage* garbage) {
+    for (RetainedBlock& block : blocks) block.Release(garbage);
+    blocks.clear();
+  }
+  [[nodiscard]] RetainedBlock* GetBlock(size_t block_index) {
+    if (block_index >= blocks.size()) blocks.resize(block_index + 1);
+    return &blocks[block_index];
+  }
+
+  std::vector<RetainedBlock> blocks;
+};
+
 struct LineBuffer {
   void Reset() {
     lines_.Reset();
     colors_.Reset();
     picking_colors_.Reset();
+    retained_blocks_.MarkDirty();
   }
 
   static const int NUM_LINES_PER_BLOCK = 64 * 1024;
   BlockChain<Line, NUM_LINES_PER_BLOCK> lines_;
   BlockChain<Color, 2 * NUM_LINES_PER_BLOCK> colors_;
   BlockChain<Color, 2 * NUM_LINES_PER_BLOCK> picking_colors_;
+  mutable RetainedBlocks retained_blocks_;
 };
 
 struct BoxBuffer {
@@ -53,12 +152,14 @@ struct BoxBuffer {
     boxes_.Reset();
     colors_.Reset();
     picking_colors_.Reset();
+    retained_blocks_.MarkDirty();
   }
 
   static const int NUM_BOXES_PER_BLOCK = 64 * 1024;
   BlockChain<Box, NUM_BOXES_PER_BLOCK> boxes_;
   BlockChain<Color, 4 * NUM_BOXES_PER_BLOCK> colors_;
   BlockChain<Color, 4 * NUM_BOXES_PER_BLOCK> picking_colors_;
+  mutable RetainedBlocks retained_blocks_;
 };
 
 struct TriangleBuffer {
@@ -66,12 +167,27 @@ struct TriangleBuffer {
     triangles_.Reset();
     colors_.Reset();
     picking_colors_.Reset();
+    retained_blocks_.MarkDirty();
   }
 
   static const int NUM_TRIANGLES_PER_BLOCK = 64 * 1024;
   BlockChain<Triangle, NUM_TRIANGLES_PER_BLOCK> triangles_;
   BlockChain<Color, 3 * NUM_TRIANGLES_PER_BLOCK> colors_;
   BlockChain<Color, 3 * NUM_TRIANGLES_PER_BLOCK> picking_colors_;
+  mutable RetainedBlocks retained_blocks_;
+};
+
+// Spatial index over the primitives of one layer of a Batcher, to pick without rendering.
+struct PickingIndex {
+  // The rectangles of the spatial index are the bounding boxes of the boxes, then the lines, then
+  // the triangles, which is the order in which they are drawn.
+  std::unique_ptr<orbit_gl::SpatialIndex> spatial_index;
+  // The size of a pixel in the coordinates of the layer that the index was built for, as lines are
+  // one pixel wide.
+  Vec2 pixel_size;
+  std::vector<PickingId> picking_ids;
+  size_t first_triangle_index = 0;
+  std::vector<Triangle> triangles;
 };
 
 struct PrimitiveBuffers {
@@ -79,11 +195,14 @@ struct PrimitiveBuffers {
     line_buffer.Reset();
     box_buffer.Reset();
     triangle_buffer.Reset();
+    picking_index.reset();
   }
 
   LineBuffer line_buffer;
   BoxBuffer box_buffer;
   TriangleBuffer triangle_buffer;
+  // Built on demand by Batcher::GetTopmostPickingIdAt and reset when primitives are added.
+  mutable std::unique_ptr<PickingIndex> picking_index;
 };
 
 enum class ShadingDirection { kLeftToRight, kRightToLeft, kTopToBottom, kBottomToTop };
@@ -96,6 +215,11 @@ into layers formed by equal z-coordinates. Each layer can then be drawn seperate
 Batcher::DrawLayer(), or all layers can be drawn at once in their correct order using
 Batcher::Draw():
 
+Drawing keeps a copy of the primitives in vertex buffer objects on the GPU. As the buffers only
+grow until they are reset, each draw only uploads the primitives added since the previous draw.
+Drawing a batcher that was not changed, e.g. the time graph while only the overlay changes, does
+not transfer any geometry.
+
 NOTE: The Batcher assumes x/y coordinates are in pixels and will automatically round those
 down to the next integer in all Batcher::AddXXX methods. This fixes the issue of primitives
 "jumping" around when their coordinates are changed slightly.
@@ -114,6 +238,9 @@ class Batcher {
   }
 
   Batcher() = delete;
+  // Passes the vertex buffer objects created by drawing to the VertexBufferGarbage, see
+  // SetVertexBufferGarbage.
+  virtual ~Batcher();
   Batcher(const Batcher&) = delete;
   Batcher(Batcher&&) = delete;
 
@@ -159,14 +286,39 @@ class Batcher {
 
   void AddCircle(Vec2 position, float radius, float z, Color color);
   [[nodiscard]] std::vector<float> GetLayers() const;
+  // Drawing requires a VertexBufferGarbage to be set, see SetVertexBufferGarbage.
   void DrawLayer(float layer, bool picking = false) const;
   virtual void Draw(bool picking = false) const;
 
   void ResetElements();
   void StartNewFrame();
 
+  // Appends all primitives of `other` to the primitives of this batcher and takes ownership of
+  // the user data of `other`, translating picking ids such that they refer to this batcher. This
+  // allows to fill separate batchers in parallel and to merge them into the one used for drawing.
+  // Until its next StartNewFrame, `other` forwards GetUserData to this batcher, so that tooltip
+  // callbacks created with `other` keep working.
+  void MergeFrom(Batcher* other);
+
+  // Returns the picking id of the primitive that is drawn on top at `pos` in `layer`, or nullopt if
+  // there is none. This answers the same question as a picking pass, without rendering: within a
+  // layer, boxes are drawn before lines and lines before triangles, and later primitives are drawn
+  // over earlier ones. `pixel_size` is the size of a pixel in the coordinates of `layer`, which
+  // determines the width of lines. The spatial index used is built on the first call after
+  // primitives were added to the layer or `pixel_size` changed, so that subsequent calls take
+  // O(log n).
+  [[nodiscard]] std::optional<PickingId> GetTopmostPickingIdAt(float layer, Vec2 pos,
+                                                               Vec2 pixel_size) const;
+
+  [[nodiscard]] BatcherId GetBatcherId() const { return batcher_id_; }
   [[nodiscard]] PickingManager* GetPickingManager() const { return picking_manager_; }
   void SetPickingManager(PickingManager* picking_manager) { picking_manager_ = picking_manager; }
+  // Sets where the vertex buffer objects created by drawing go when this batcher is destroyed. This
+  // is the VertexBufferGarbage of the canvas whose OpenGL context this batcher is drawn in, which
+  // needs to outlive this batcher.
+  void SetVertexBufferGarbage(VertexBufferGarbage* vertex_buffer_garbage) {
+    vertex_buffer_garbage_ = vertex_buffer_garbage;
+  }
 
   [[nodiscard]] const PickingUserData* GetUserData(PickingId id) const;
   [[nodiscard]] PickingUserData* GetUserData(PickingId id);
@@ -195,9 +347,11 @@ class Batcher {
 
   BatcherId batcher_id_;
   PickingManager* picking_manager_;
+  VertexBufferGarbage* vertex_buffer_garbage_ = nullptr;
   std::unordered_map<float, PrimitiveBuffers> primitive_buffers_by_layer_;
 
   std::vector<std::unique_ptr<PickingUserData>> user_data_;
+  const Batcher* merged_into_ = nullptr;
 
   std::vector<Vec2> circle_points;
 };
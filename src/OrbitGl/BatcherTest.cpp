@@ -6,6 +6,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -237,4 +238,168 @@ TEST(Batcher, MultipleDrawCalls) {
   EXPECT_DEATH((void)batcher.GetUserData(id), "size");
 }
 
-}  // namespace
\ No newline at end of file
+TEST(Batcher, MergeFrom) {
+  PickingManager pm;
+  MockBatcher batcher(BatcherId::kTimeGraph, &pm);
+  MockBatcher other_batcher(BatcherId::kTimeGraph, &pm);
+
+  std::string line_custom_data = "line custom data";
+  auto line_user_data = std::make_unique<PickingUserData>();
+  line_user_data->custom_data_ = &line_custom_data;
+
+  std::string triangle_custom_data = "triangle custom data";
+  auto triangle_user_data = std::make_unique<PickingUserData>();
+  triangle_user_data->custom_data_ = &triangle_custom_data;
+
+  std::string box_custom_data = "box custom data";
+  auto box_user_data = std::make_unique<PickingUserData>();
+  box_user_data->custom_data_ = &box_custom_data;
+
+  std::shared_ptr<PickableMock> box_pickable = std::make_shared<PickableMock>();
+
+  batcher.AddLine(Vec2(0, 0), Vec2(1, 0), 0, Color(255, 255, 255, 255), std::move(line_user_data));
+  other_batcher.AddTriangle(Triangle(Vec3(0, 0, 0), Vec3(0, 1, 0), Vec3(1, 0, 0)),
+                            Color(0, 255, 0, 255), std::move(triangle_user_data));
+  other_batcher.AddBox(Box(Vec2(0, 0), Vec2(1, 1), 1), Color(255, 0, 0, 255),
+                       std::move(box_user_data));
+  other_batcher.AddBox(Box(Vec2(0, 0), Vec2(1, 1), 1), Color(0, 0, 255, 255), box_pickable);
+
+  batcher.MergeFrom(&other_batcher);
+  ExpectDraw(batcher, 1, 1, 2);
+  EXPECT_EQ(batcher.GetDrawnTriangleColors()[0], Color(0, 255, 0, 255));
+  EXPECT_EQ(batcher.GetDrawnBoxColors()[1], Color(0, 0, 255, 255));
+
+  batcher.ResetMockDrawCounts();
+  batcher.Draw(true);
+  ExpectCustomDataEq(batcher, batcher.GetDrawnLineColors()[0], line_custom_data);
+  ExpectCustomDataEq(batcher, batcher.GetDrawnTriangleColors()[0], triangle_custom_data);
+  ExpectCustomDataEq(batcher, batcher.GetDrawnBoxColors()[0], box_custom_data);
+  ExpectPickableEq(batcher, batcher.GetDrawnBoxColors()[1], pm, box_pickable);
+
+  // Picking ids of the merged batcher can also be resolved through the batcher merged from.
+  ExpectCustomDataEq(other_batcher, batcher.GetDrawnTriangleColors()[0], triangle_custom_data);
+
+  other_batcher.StartNewFrame();
+  ExpectDraw(other_batcher, 0, 0, 0);
+  EXPECT_DEATH(
+      (void)other_batcher.GetUserData(MockRenderPickingColor(batcher.GetDrawnBoxColors()[0])),
+      "size");
+}
+
+TEST(Batcher, GetTopmostPickingIdAt) {
+  MockBatcher batcher(BatcherId::kUi);
+  const Vec2 kPixelSize(1, 1);
+
+  batcher.AddBox(Box(Vec2(0, 0), Vec2(10, 10), 0), Color(255, 0, 0, 255),
+                 std::make_unique<PickingUserData>());
+  batcher.AddLine(Vec2(0, 5), Vec2(10, 5), 0, Color(255, 255, 255, 255),
+                  std::make_unique<PickingUserData>());
+  batcher.AddTriangle(Triangle(Vec3(20, 0, 0), Vec3(30, 0, 0), Vec3(20, 10, 0)),
+                      Color(0, 255, 0, 255), std::make_unique<PickingUserData>());
+
+  std::optional<PickingId> id = batcher.GetTopmostPickingIdAt(0, Vec2(5, 2), kPixelSize);
+  ASSERT_TRUE(id.has_value());
+  EXPECT_EQ(id->type, PickingType::kBox);
+  EXPECT_EQ(id->batcher_id, BatcherId::kUi);
+
+  // Lines are drawn over boxes.
+  id = batcher.GetTopmostPickingIdAt(0, Vec2(5, 6), kPixelSize);
+  ASSERT_TRUE(id.has_value());
+  EXPECT_EQ(id->type, PickingType::kLine);
+
+  id = batcher.GetTopmostPickingIdAt(0, Vec2(21, 1), kPixelSize);
+  ASSERT_TRUE(id.has_value());
+  EXPECT_EQ(id->type, PickingType::kTriangle);
+
+  // Inside the bounding box of the triangle, but not inside the triangle.
+  EXPECT_FALSE(batcher.GetTopmostPickingIdAt(0, Vec2(29, 9), kPixelSize).has_value());
+  EXPECT_FALSE(batcher.GetTopmostPickingIdAt(0, Vec2(15, 5), kPixelSize).has_value());
+  EXPECT_FALSE(batcher.GetTopmostPickingIdAt(1, Vec2(5, 2), kPixelSize).has_value());
+
+  // Primitives added after a query are found as well.
+  batcher.AddBox(Box(Vec2(40, 40), Vec2(10, 10), 0), Color(255, 0, 0, 255),
+                 std::make_unique<PickingUserData>());
+  id = batcher.GetTopmostPickingIdAt(0, Vec2(45, 45), kPixelSize);
+  ASSERT_TRUE(id.has_value());
+  EXPECT_EQ(id->type, PickingType::kBox);
+  EXPECT_EQ(id->element_id, 3);
+}
+
+TEST(Batcher, GetTopmostPickingIdAtLinesArePixelWide) {
+  MockBatcher batcher(BatcherId::kUi);
+  batcher.AddVerticalLine(Vec2(10, 0), 10, 0, Color(255, 255, 255, 255),
+                          std::make_unique<PickingUserData>());
+
+  // When zoomed out, a pixel is wider than a unit of the layer's coordinates.
+  EXPECT_TRUE(batcher.GetTopmostPickingIdAt(0, Vec2(13, 5), Vec2(4, 4)).has_value());
+  EXPECT_FALSE(batcher.GetTopmostPickingIdAt(0, Vec2(15, 5), Vec2(4, 4)).has_value());
+
+  // When zoomed in, a pixel is narrower.
+  EXPECT_TRUE(batcher.GetTopmostPickingIdAt(0, Vec2(10.05f, 5), Vec2(0.1f, 0.1f)).has_value());
+  EXPECT_FALSE(batcher.GetTopmostPickingIdAt(0, Vec2(10.5f, 5), Vec2(0.1f, 0.1f)).has_value());
+}
+
+TEST(RetainedBufferRange, UploadsOnlyTheAppendedBytes) {
+  RetainedBufferRange range;
+
+  RetainedBufferRange::Upload upload = range.Update(100);
+  EXPECT_EQ(upload.new_capacity_in_bytes, 100);
+  EXPECT_EQ(upload.offset_in_bytes, 0);
+  EXPECT_EQ(upload.size_in_bytes, 100);
+
+  upload = range.Update(100);
+  EXPECT_FALSE(upload.new_capacity_in_bytes.has_value());
+  EXPECT_EQ(upload.size_in_bytes, 0);
+
+  // Growing beyond the capacity at least doubles it and uploads everything again, as reallocating
+  // discards the content of the buffer.
+  upload = range.Update(150);
+  EXPECT_EQ(upload.new_capacity_in_bytes, 200);
+  EXPECT_EQ(upload.offset_in_bytes, 0);
+  EXPECT_EQ(upload.size_in_bytes, 150);
+
+  upload = range.Update(180);
+  EXPECT_FALSE(upload.new_capacity_in_bytes.has_value());
+  EXPECT_EQ(upload.offset_in_bytes, 150);
+  EXPECT_EQ(upload.size_in_bytes, 30);
+
+  upload = range.Update(1000);
+  EXPECT_EQ(upload.new_capacity_in_bytes, 1000);
+  EXPECT_EQ(upload.offset_in_bytes, 0);
+  EXPECT_EQ(upload.size_in_bytes, 1000);
+  EXPECT_EQ(range.capacity_in_bytes(), 1000);
+  EXPECT_EQ(range.num_bytes_uploaded(), 1000);
+}
+
+TEST(RetainedBufferRange, MarkDirtyUploadsAgainWithoutReallocating) {
+  RetainedBufferRange range;
+  (void)range.Update(100);
+
+  range.MarkDirty();
+  EXPECT_EQ(range.num_bytes_uploaded(), 0);
+
+  RetainedBufferRange::Upload upload = range.Update(40);
+  EXPECT_FALSE(upload.new_capacity_in_bytes.has_value());
+  EXPECT_EQ(upload.offset_in_bytes, 0);
+  EXPECT_EQ(upload.size_in_bytes, 40);
+  EXPECT_EQ(range.capacity_in_bytes(), 100);
+
+  upload = range.Update(60);
+  EXPECT_EQ(upload.offset_in_bytes, 40);
+  EXPECT_EQ(upload.size_in_bytes, 20);
+}
+
+TEST(Batcher, DestroyingBatcherThatWasNotDrawnReleasesNoVertexBuffers) {
+  VertexBufferGarbage garbage;
+  {
+    Batcher batcher(BatcherId::kUi);
+    batcher.SetVertexBufferGarbage(&garbage);
+    batcher.AddBox(Box(Vec2(0, 0), Vec2(10, 10), 0), Color(255, 255, 255, 255));
+    batcher.AddLine(Vec2(0, 0), Vec2(10, 0), 0, Color(255, 255, 255, 255));
+  }
+  EXPECT_EQ(garbage.size(), 0);
+  // Nothing to delete, so this doesn't need an OpenGL context.
+  garbage.DeleteAll();
+}
+
+}  // namespace
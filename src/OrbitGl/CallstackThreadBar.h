@@ -50,7 +50,7 @@ class CallstackThreadBar : public ThreadBar {
       const orbit_client_protos::CallstackInfo& callstack, int max_line_length = 80,
       int max_lines = 20, int bottom_n_lines = 5) const;
 
-  [[nodiscard]] std::string GetSampleTooltip(const Batcher& batcher, PickingId id) const;
+  [[nodiscard]] std::string GetSampleTooltip(uint64_t callstack_id) const;
 };
 
 }  // namespace orbit_gl
@@ -7,6 +7,9 @@
 #include <absl/strings/str_format.h>
 
 #include "CaptureWindow.h"
+#include "ClientData/LatencyHistogram.h"
+#include "ClientData/TimerChain.h"
+#include "DisplayFormats/DisplayFormats.h"
 #include "Introspection/Introspection.h"
 #include "SchedulingStats.h"
 #include "capture_data.pb.h"
@@ -30,5 +33,22 @@ ErrorMessageOr<void> CaptureStats::Generate(CaptureWindow* capture_window, uint6
   };
   SchedulingStats scheduling_stats(sched_scopes, thread_name_provider, start_ns, end_ns);
   summary_ = scheduling_stats.ToString();
+
+  std::vector<const orbit_client_data::TimerChain*> timer_chains =
+      time_graph->GetAllThreadTrackTimerChains();
+  std::string function_stats;
+  for (const auto& [function_id, function] : capture_data->instrumented_functions()) {
+    orbit_client_data::LatencyHistogram histogram;
+    for (const orbit_client_data::TimerChain* timer_chain : timer_chains) {
+      timer_chain->AddDurationsToHistogram(function_id, start_ns, end_ns, &histogram);
+    }
+    if (histogram.count() == 0) continue;
+    function_stats += absl::StrFormat(
+        "  %s: %u calls, P50 %s, P95 %s, P99 %s\n", function.function_name(), histogram.count(),
+        orbit_display_formats::GetDisplayTime(absl::Nanoseconds(histogram.GetPercentile(50))),
+        orbit_display_formats::GetDisplayTime(absl::Nanoseconds(histogram.GetPercentile(95))),
+        orbit_display_formats::GetDisplayTime(absl::Nanoseconds(histogram.GetPercentile(99))));
+  }
+  if (!function_stats.empty()) summary_ += "\nInstrumented functions:\n" + function_stats;
   return outcome::success();
 }
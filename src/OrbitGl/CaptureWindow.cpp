@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <optional>
 #include <ostream>
 #include <string_view>
 
@@ -184,6 +185,54 @@ void CaptureWindow::HandlePickedElement(PickingMode picking_mode, PickingId pick
   }
 }
 
+std::optional<PickingId> CaptureWindow::PickFromDrawnPrimitives(int x, int y) {
+  Batcher* time_graph_batcher = time_graph_ != nullptr ? &time_graph_->GetBatcher() : nullptr;
+
+  std::vector<float> all_layers = ui_batcher_.GetLayers();
+  if (time_graph_batcher != nullptr) {
+    orbit_base::Append(all_layers, time_graph_batcher->GetLayers());
+  }
+  std::sort(all_layers.begin(), all_layers.end(), std::greater<>());
+  all_layers.erase(std::unique(all_layers.begin(), all_layers.end()), all_layers.end());
+
+  const Vec2 world_pos = viewport_.ScreenToWorldPos(Vec2i(x, y));
+  const Vec2 screen_pos(static_cast<float>(x), static_cast<float>(viewport_.GetScreenHeight() - y));
+  const Vec2 world_pixel_size(
+      viewport_.GetVisibleWorldWidth() / static_cast<float>(viewport_.GetScreenWidth()),
+      viewport_.GetVisibleWorldHeight() / static_cast<float>(viewport_.GetScreenHeight()));
+  const Vec2 screen_pixel_size(1.f, 1.f);
+
+  // Same order as in Draw, from top to bottom: higher layers first, and within a layer the ui
+  // batcher is drawn after the time graph batcher.
+  std::optional<PickingId> picking_id;
+  for (float layer : all_layers) {
+    const bool is_world_layer = layer < GlCanvas::kScreenSpaceCutPoint;
+    const Vec2& pos = is_world_layer ? world_pos : screen_pos;
+    const Vec2& pixel_size = is_world_layer ? world_pixel_size : screen_pixel_size;
+    picking_id = ui_batcher_.GetTopmostPickingIdAt(layer, pos, pixel_size);
+    if (!picking_id.has_value() && time_graph_batcher != nullptr) {
+      picking_id = time_graph_batcher->GetTopmostPickingIdAt(layer, pos, pixel_size);
+    }
+    if (picking_id.has_value()) break;
+  }
+  if (!picking_id.has_value()) return std::nullopt;
+
+  // Some elements, e.g. the sampling events of a thread, only emit pickable primitives while
+  // rendering the picking pass. Only trust elements that provide a tooltip themselves, and fall
+  // back to the picking pass for the elements underneath which such primitives could be.
+  if (picking_id->type == PickingType::kPickable) {
+    std::shared_ptr<Pickable> pickable = GetPickingManager().GetPickableFromId(picking_id.value());
+    if (pickable == nullptr || pickable->HasTooltipPrimitivesOnlyWhenPicking()) {
+      return std::nullopt;
+    }
+    return picking_id;
+  }
+  PickingUserData* user_data =
+      GetBatcherById(picking_id->batcher_id).GetUserData(picking_id.value());
+  if (user_data == nullptr || !user_data->generate_tooltip_) return std::nullopt;
+  return picking_id;
+}
+
 void CaptureWindow::SelectTimer(const TimerInfo* timer_info) {
   CHECK(time_graph_ != nullptr);
   if (timer_info == nullptr) return;
@@ -604,6 +653,7 @@ void CaptureWindow::set_draw_help(bool draw_help) {
 void CaptureWindow::CreateTimeGraph(const CaptureData* capture_data) {
   time_graph_ =
       std::make_unique<TimeGraph>(this, app_, &viewport_, capture_data, &GetPickingManager());
+  time_graph_->GetBatcher().SetVertexBufferGarbage(&vertex_buffer_garbage_);
 }
 
 Batcher& CaptureWindow::GetBatcherById(BatcherId batcher_id) {
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -84,6 +85,7 @@ class CaptureWindow : public GlCanvas {
   [[nodiscard]] virtual const char* GetHelpText() const;
   [[nodiscard]] virtual bool ShouldAutoZoom() const;
   void HandlePickedElement(PickingMode picking_mode, PickingId picking_id, int x, int y) override;
+  [[nodiscard]] std::optional<PickingId> PickFromDrawnPrimitives(int x, int y) override;
 
   std::unique_ptr<TimeGraph> time_graph_ = nullptr;
   bool draw_help_;
@@ -4,7 +4,13 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "CallstackThreadBar.h"
 #include "CaptureWindow.h"
+#include "TimeGraphLayout.h"
 #include "UnitTestSlider.h"
 
 namespace orbit_gl {
@@ -73,4 +79,41 @@ TEST_F(UnitTestCaptureWindow, SlidersRespondToMouseLeave) {
   EXPECT_FALSE(unit_test_vertical_slider->IsMouseOver());
 }
 
+TEST_F(UnitTestCaptureWindow, HoveringNearSampleFallsBackToPickingPass) {
+  Resize(100, 200);
+  const Color kWhite(255, 255, 255, 255);
+  const Vec2 top_left = viewport_.ScreenToWorldPos(Vec2i(0, 0));
+  const Vec2 bottom_right = viewport_.ScreenToWorldPos(Vec2i(100, 200));
+  const float world_height = bottom_right[1] - top_left[1];
+
+  // Outside of the picking pass, a callstack thread bar is drawn with a bare line for each sample.
+  TimeGraphLayout layout;
+  auto callstack_thread_bar = std::make_shared<CallstackThreadBar>(
+      nullptr, nullptr, nullptr, &viewport_, &layout, nullptr, /*thread_id=*/42, kWhite);
+  ui_batcher_.AddBox(Box(top_left, Vec2(bottom_right[0] - top_left[0], world_height),
+                         GlCanvas::kZValueEventBar),
+                     kWhite, callstack_thread_bar);
+  const Vec2 sample_pos = viewport_.ScreenToWorldPos(Vec2i(50, 0));
+  ui_batcher_.AddVerticalLine(sample_pos, world_height, GlCanvas::kZValueEvent, kWhite);
+
+  // An element that provides its tooltip outside of the picking pass as well.
+  const Vec2 timer_pos = viewport_.ScreenToWorldPos(Vec2i(70, 0));
+  const Vec2 timer_end = viewport_.ScreenToWorldPos(Vec2i(90, 0));
+  ui_batcher_.AddBox(Box(timer_pos, Vec2(timer_end[0] - timer_pos[0], world_height),
+                         GlCanvas::kZValueEvent),
+                     kWhite,
+                     std::make_unique<PickingUserData>(
+                         nullptr, [](PickingId /*id*/) { return std::string("timer"); }));
+
+  // The tooltip of the sample only exists in the picking pass, so neither hovering the sample nor
+  // the thread bar next to it can be resolved from the drawn primitives.
+  EXPECT_FALSE(PickFromDrawnPrimitives(50, 100).has_value());
+  EXPECT_FALSE(PickFromDrawnPrimitives(53, 100).has_value());
+
+  std::optional<PickingId> picking_id = PickFromDrawnPrimitives(80, 100);
+  ASSERT_TRUE(picking_id.has_value());
+  EXPECT_EQ(picking_id->type, PickingType::kBox);
+  EXPECT_EQ(picking_id->batcher_id, BatcherId::kUi);
+}
+
 }  // namespace orbit_gl
\ No newline at end of file
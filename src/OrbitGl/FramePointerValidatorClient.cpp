@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <memory>
 #include <string>
 
 #include "App.h"
@@ -45,7 +46,6 @@ void FramePointerValidatorClient::AnalyzeModules(const std::vector<const ModuleD
 
   for (const ModuleData* module : modules) {
     ValidateFramePointersRequest request;
-    ValidateFramePointersResponse response;
     CHECK(module != nullptr);
 
     std::vector<const FunctionInfo*> functions = module->GetFunctions();
@@ -55,21 +55,15 @@ void FramePointerValidatorClient::AnalyzeModules(const std::vector<const ModuleD
       function_info->set_offset(orbit_client_data::function_utils::Offset(*function, *module));
       function_info->set_size(function->size());
     }
-    grpc::ClientContext context;
-    std::chrono::time_point deadline = std::chrono::system_clock::now() + std::chrono::minutes(1);
-    context.set_deadline(deadline);
-
-    // careful this is the synchronous call (maybe async is better)
-    grpc::Status status =
-        frame_pointer_validator_service_->ValidateFramePointers(&context, request, &response);
 
-    if (!status.ok()) {
+    ErrorMessageOr<size_t> fpo_functions_or_error = CountFpoFunctions(request);
+    if (fpo_functions_or_error.has_error()) {
       return app_->SendErrorToUi(
           "Frame Pointer Validation",
           absl::StrFormat("Grpc call for frame-pointer validation failed for module %s: %s",
-                          module->name(), status.error_message()));
+                          module->name(), fpo_functions_or_error.error().message()));
     }
-    size_t fpo_functions = response.functions_without_frame_pointer_size();
+    size_t fpo_functions = fpo_functions_or_error.value();
     size_t no_fpo_functions = functions.size() - fpo_functions;
     dialogue_messages.push_back(
         absl::StrFormat("Module %s: %d functions support frame pointers, %d functions don't.",
@@ -79,3 +73,34 @@ void FramePointerValidatorClient::AnalyzeModules(const std::vector<const ModuleD
   std::string text = absl::StrJoin(dialogue_messages, "\n");
   app_->SendInfoToUi("Frame Pointer Validation", text);
 }
+
+ErrorMessageOr<size_t> FramePointerValidatorClient::CountFpoFunctions(
+    const ValidateFramePointersRequest& request) {
+  constexpr std::chrono::minutes kTimeout{1};
+  {
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + kTimeout);
+    std::unique_ptr<grpc::ClientReader<ValidateFramePointersResponse>> reader =
+        frame_pointer_validator_service_->ValidateFramePointersIncrementally(&context, request);
+    size_t fpo_functions = 0;
+    ValidateFramePointersResponse response;
+    while (reader->Read(&response)) {
+      fpo_functions += response.functions_without_frame_pointer_size();
+    }
+    grpc::Status status = reader->Finish();
+    if (status.ok()) return fpo_functions;
+    if (status.error_code() != grpc::StatusCode::UNIMPLEMENTED) {
+      return ErrorMessage{status.error_message()};
+    }
+  }
+
+  // The service predates ValidateFramePointersIncrementally.
+  grpc::ClientContext context;
+  context.set_deadline(std::chrono::system_clock::now() + kTimeout);
+  ValidateFramePointersResponse response;
+  // careful this is the synchronous call (maybe async is better)
+  grpc::Status status =
+      frame_pointer_validator_service_->ValidateFramePointers(&context, request, &response);
+  if (!status.ok()) return ErrorMessage{status.error_message()};
+  return response.functions_without_frame_pointer_size();
+}
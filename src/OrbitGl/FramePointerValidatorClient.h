@@ -5,10 +5,13 @@
 #ifndef ORBIT_GL_FRAME_POINTER_VALIDATOR_CLIENT_H_
 #define ORBIT_GL_FRAME_POINTER_VALIDATOR_CLIENT_H_
 
+#include <stddef.h>
+
 #include <memory>
 #include <vector>
 
 #include "ClientData/ModuleData.h"
+#include "OrbitBase/Result.h"
 #include "grpcpp/grpcpp.h"
 #include "services.grpc.pb.h"
 
@@ -35,6 +38,10 @@ class FramePointerValidatorClient {
   void AnalyzeModules(const std::vector<const orbit_client_data::ModuleData*>& modules);
 
  private:
+  // Returns the number of functions without frame pointer among the functions in `request`.
+  [[nodiscard]] ErrorMessageOr<size_t> CountFpoFunctions(
+      const orbit_grpc_protos::ValidateFramePointersRequest& request);
+
   OrbitApp* app_;
   std::unique_ptr<orbit_grpc_protos::FramePointerValidatorService::Stub>
       frame_pointer_validator_service_;
@@ -65,6 +65,7 @@ GlCanvas::GlCanvas()
   // Note that `GlCanvas` is the bridge to OpenGl content, and `GlCanvas`'s parent needs special
   // handling for accessibility. Thus, we use `nullptr` here.
   text_renderer_.SetViewport(&viewport_);
+  ui_batcher_.SetVertexBufferGarbage(&vertex_buffer_garbage_);
 
   is_selecting_ = false;
   double_clicking_ = false;
@@ -274,6 +275,8 @@ void GlCanvas::Render(int width, int height) {
 
   redraw_requested_ = false;
   ui_batcher_.StartNewFrame();
+  // The OpenGL context is current while rendering.
+  vertex_buffer_garbage_.DeleteAll();
 
   PrepareGlState();
   PrepareWorldSpaceViewport();
@@ -314,8 +317,17 @@ void GlCanvas::PreRender() {
     ResetHoverTimer();
   }
 
-  if (is_mouse_over_ && can_hover_ && hover_timer_.ElapsedMillis() > hover_delay_ms_) {
-    SetPickingMode(PickingMode::kHover);
+  if (is_mouse_over_ && can_hover_ && hover_timer_.ElapsedMillis() > hover_delay_ms_ &&
+      imgui_context_ == nullptr) {
+    const int x = mouse_move_pos_screen_[0];
+    const int y = mouse_move_pos_screen_[1];
+    std::optional<PickingId> picking_id = PickFromDrawnPrimitives(x, y);
+    if (picking_id.has_value()) {
+      can_hover_ = false;
+      HandlePickedElement(PickingMode::kHover, picking_id.value(), x, y);
+    } else {
+      SetPickingMode(PickingMode::kHover);
+    }
   }
 }
 
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -161,6 +162,9 @@ class GlCanvas : public orbit_gl::AccessibleInterfaceProvider {
 
   orbit_gl::Viewport viewport_;
 
+  // Collects the vertex buffer objects of destroyed batchers drawn in this canvas. Declared before
+  // the batchers, so that it outlives them.
+  VertexBufferGarbage vertex_buffer_garbage_;
   // Batcher to draw elements in the UI.
   Batcher ui_batcher_;
   std::vector<RenderCallback> render_callbacks_;
@@ -171,6 +175,11 @@ class GlCanvas : public orbit_gl::AccessibleInterfaceProvider {
   void Pick(PickingMode picking_mode, int x, int y);
   virtual void HandlePickedElement(PickingMode /*picking_mode*/, PickingId /*picking_id*/,
                                    int /*x*/, int /*y*/) {}
+  // Allows to resolve hovering from the primitives drawn in the last frame, without rendering a
+  // picking pass. Returns nullopt if a picking pass is required.
+  [[nodiscard]] virtual std::optional<PickingId> PickFromDrawnPrimitives(int /*x*/, int /*y*/) {
+    return std::nullopt;
+  }
 };
 
 #endif  // ORBIT_GL_GL_CANVAS_H_
@@ -54,13 +54,16 @@ const std::vector<orbit_data_views::DataView::Column>& LiveFunctionsDataView::Ge
     std::vector<Column> columns;
     columns.resize(kNumColumns);
     columns[kColumnSelected] = {"Hooked", .0f, SortingOrder::kDescending};
-    columns[kColumnName] = {"Function", .4f, SortingOrder::kAscending};
+    columns[kColumnName] = {"Function", .25f, SortingOrder::kAscending};
     columns[kColumnCount] = {"Count", .0f, SortingOrder::kDescending};
     columns[kColumnTimeTotal] = {"Total", .075f, SortingOrder::kDescending};
     columns[kColumnTimeAvg] = {"Avg", .075f, SortingOrder::kDescending};
     columns[kColumnTimeMin] = {"Min", .075f, SortingOrder::kDescending};
     columns[kColumnTimeMax] = {"Max", .075f, SortingOrder::kDescending};
     columns[kColumnStdDev] = {"Std Dev", .075f, SortingOrder::kDescending};
+    columns[kColumnTimeP50] = {"P50", .05f, SortingOrder::kDescending};
+    columns[kColumnTimeP95] = {"P95", .05f, SortingOrder::kDescending};
+    columns[kColumnTimeP99] = {"P99", .05f, SortingOrder::kDescending};
     columns[kColumnModule] = {"Module", .1f, SortingOrder::kAscending};
     columns[kColumnAddress] = {"Address", .1f, SortingOrder::kAscending};
     return columns;
@@ -97,6 +100,12 @@ std::string LiveFunctionsDataView::GetValue(int row, int column) {
       return orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats.max_ns()));
     case kColumnStdDev:
       return orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats.std_dev_ns()));
+    case kColumnTimeP50:
+      return GetDisplayPercentile(function_id, 50);
+    case kColumnTimeP95:
+      return GetDisplayPercentile(function_id, 95);
+    case kColumnTimeP99:
+      return GetDisplayPercentile(function_id, 99);
     case kColumnModule:
       return function.module_path();
     case kColumnAddress:
@@ -106,6 +115,11 @@ std::string LiveFunctionsDataView::GetValue(int row, int column) {
   }
 }
 
+std::string LiveFunctionsDataView::GetDisplayPercentile(uint64_t function_id, double percentile) {
+  return orbit_display_formats::GetDisplayTime(absl::Nanoseconds(
+      app_->GetCaptureData().GetFunctionDurationPercentile(function_id, percentile)));
+}
+
 std::vector<int> LiveFunctionsDataView::GetVisibleSelectedIndices() {
   std::optional<int> visible_selected_index = GetRowFromFunctionId(selected_function_id_);
   if (!visible_selected_index.has_value()) return {};
@@ -141,6 +155,13 @@ void LiveFunctionsDataView::OnSelect(const std::vector<int>& rows) {
     const FunctionStats& stats_b = app_->GetCaptureData().GetFunctionStatsOrDefault(b);       \
     return orbit_gl::CompareAscendingOrDescending(stats_a.Member, stats_b.Member, ascending); \
   }
+#define ORBIT_PERCENTILE_SORT(Percentile)                                      \
+  [&](uint64_t a, uint64_t b) {                                                \
+    const CaptureData& capture_data = app_->GetCaptureData();                  \
+    return orbit_gl::CompareAscendingOrDescending(                             \
+        capture_data.GetFunctionDurationPercentile(a, Percentile),             \
+        capture_data.GetFunctionDurationPercentile(b, Percentile), ascending); \
+  }
 #define ORBIT_CUSTOM_FUNC_SORT(Func)                                                            \
   [&](uint64_t a, uint64_t b) {                                                                 \
     return orbit_gl::CompareAscendingOrDescending(Func(functions.at(a)), Func(functions.at(b)), \
@@ -182,6 +203,15 @@ void LiveFunctionsDataView::DoSort() {
     case kColumnStdDev:
       sorter = ORBIT_STAT_SORT(std_dev_ns());
       break;
+    case kColumnTimeP50:
+      sorter = ORBIT_PERCENTILE_SORT(50);
+      break;
+    case kColumnTimeP95:
+      sorter = ORBIT_PERCENTILE_SORT(95);
+      break;
+    case kColumnTimeP99:
+      sorter = ORBIT_PERCENTILE_SORT(99);
+      break;
     case kColumnModule:
       sorter = ORBIT_CUSTOM_FUNC_SORT(orbit_client_data::function_utils::GetLoadedModuleName);
       break;
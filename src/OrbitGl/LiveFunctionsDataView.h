@@ -71,6 +71,9 @@ class LiveFunctionsDataView : public orbit_data_views::DataView {
     kColumnTimeMin,
     kColumnTimeMax,
     kColumnStdDev,
+    kColumnTimeP50,
+    kColumnTimeP95,
+    kColumnTimeP99,
     kColumnModule,
     kColumnAddress,
     kNumColumns
@@ -89,6 +92,8 @@ class LiveFunctionsDataView : public orbit_data_views::DataView {
   static const std::string kMenuActionDisableFrameTrack;
 
  private:
+  [[nodiscard]] std::string GetDisplayPercentile(uint64_t function_id, double percentile);
+
   orbit_metrics_uploader::MetricsUploader* metrics_uploader_;
 
   // TODO(b/185090791): This is temporary and will be removed once this data view has been ported
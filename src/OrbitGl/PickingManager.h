@@ -31,6 +31,10 @@ class Pickable {
   virtual void OnRelease() {}
   [[nodiscard]] virtual bool Draggable() { return false; }
   [[nodiscard]] virtual std::string GetTooltip() const { return ""; }
+  // Whether primitives with tooltips are drawn over this element in the picking pass only, e.g.,
+  // the boxes around the sampling events of a thread. Hovering such an element then can't be
+  // resolved from the primitives drawn for rendering.
+  [[nodiscard]] virtual bool HasTooltipPrimitivesOnlyWhenPicking() const { return false; }
 };
 
 enum class PickingType { kInvalid, kLine, kBox, kTriangle, kPickable, kCount };
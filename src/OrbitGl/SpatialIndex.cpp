@@ -0,0 +1,124 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace orbit_gl {
+
+namespace {
+
+[[nodiscard]] Vec2 GetCenter(const Rect& rect) { return (rect.min + rect.max) * 0.5f; }
+
+[[nodiscard]] Rect GetBounds(const Rect& a, const Rect& b) {
+  return Rect(Vec2(std::min(a.min[0], b.min[0]), std::min(a.min[1], b.min[1])),
+              Vec2(std::max(a.max[0], b.max[0]), std::max(a.max[1], b.max[1])));
+}
+
+// Orders the rectangles such that consecutive groups of `node_capacity` rectangles are close to
+// each other: the rectangles are sorted by x into vertical slices, and each slice is sorted by y.
+[[nodiscard]] std::vector<uint32_t> SortTileRecursive(const std::vector<Rect>& rects,
+                                                      size_t node_capacity) {
+  std::vector<uint32_t> order(rects.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  const size_t num_nodes = (rects.size() + node_capacity - 1) / node_capacity;
+  const auto num_slices =
+      static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_nodes))));
+  const size_t slice_size = num_slices * node_capacity;
+
+  std::sort(order.begin(), order.end(), [&rects](uint32_t lhs, uint32_t rhs) {
+    return GetCenter(rects[lhs])[0] < GetCenter(rects[rhs])[0];
+  });
+  for (size_t slice_begin = 0; slice_begin < order.size(); slice_begin += slice_size) {
+    const size_t slice_end = std::min(slice_begin + slice_size, order.size());
+    std::sort(order.begin() + slice_begin, order.begin() + slice_end,
+              [&rects](uint32_t lhs, uint32_t rhs) {
+                return GetCenter(rects[lhs])[1] < GetCenter(rects[rhs])[1];
+              });
+  }
+  return order;
+}
+
+}  // namespace
+
+SpatialIndex::SpatialIndex(const std::vector<Rect>& rects) : rects_(rects) {
+  if (rects_.empty()) return;
+
+  rect_indices_ = SortTileRecursive(rects_, kNodeCapacity);
+  std::vector<Node> leaves;
+  for (size_t begin = 0; begin < rect_indices_.size(); begin += kNodeCapacity) {
+    const size_t end = std::min(begin + kNodeCapacity, rect_indices_.size());
+    Node leaf{rects_[rect_indices_[begin]], static_cast<uint32_t>(begin),
+              static_cast<uint32_t>(end - begin)};
+    for (size_t i = begin + 1; i < end; ++i) {
+      leaf.bounds = GetBounds(leaf.bounds, rects_[rect_indices_[i]]);
+    }
+    leaves.push_back(leaf);
+  }
+  levels_.push_back(std::move(leaves));
+
+  while (levels_.back().size() > 1) {
+    const std::vector<Node>& children = levels_.back();
+    std::vector<Rect> children_bounds;
+    children_bounds.reserve(children.size());
+    for (const Node& child : children) {
+      children_bounds.push_back(child.bounds);
+    }
+
+    // The children of a node need to be contiguous, hence reorder the level below.
+    const std::vector<uint32_t> order = SortTileRecursive(children_bounds, kNodeCapacity);
+    std::vector<Node> reordered_children;
+    reordered_children.reserve(children.size());
+    for (uint32_t index : order) {
+      reordered_children.push_back(children[index]);
+    }
+    levels_.back() = std::move(reordered_children);
+
+    std::vector<Node> parents;
+    const std::vector<Node>& sorted_children = levels_.back();
+    for (size_t begin = 0; begin < sorted_children.size(); begin += kNodeCapacity) {
+      const size_t end = std::min(begin + kNodeCapacity, sorted_children.size());
+      Node parent{sorted_children[begin].bounds, static_cast<uint32_t>(begin),
+                  static_cast<uint32_t>(end - begin)};
+      for (size_t i = begin + 1; i < end; ++i) {
+        parent.bounds = GetBounds(parent.bounds, sorted_children[i].bounds);
+      }
+      parents.push_back(parent);
+    }
+    levels_.push_back(std::move(parents));
+  }
+}
+
+void SpatialIndex::ForEachRectContaining(Vec2 point,
+                                         const std::function<void(uint32_t)>& action) const {
+  if (levels_.empty()) return;
+  for (const Node& root : levels_.back()) {
+    ForEachRectContaining(levels_.size() - 1, root, point, action);
+  }
+}
+
+void SpatialIndex::ForEachRectContaining(size_t level, const Node& node, Vec2 point,
+                                         const std::function<void(uint32_t)>& action) const {
+  if (!node.bounds.Contains(point)) return;
+
+  const uint32_t end = node.first_child + node.num_children;
+  if (level == 0) {
+    for (uint32_t i = node.first_child; i < end; ++i) {
+      const uint32_t rect_index = rect_indices_[i];
+      if (rects_[rect_index].Contains(point)) action(rect_index);
+    }
+    return;
+  }
+
+  const std::vector<Node>& children = levels_[level - 1];
+  for (uint32_t i = node.first_child; i < end; ++i) {
+    ForEachRectContaining(level - 1, children[i], point, action);
+  }
+}
+
+}  // namespace orbit_gl
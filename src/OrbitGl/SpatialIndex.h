@@ -0,0 +1,64 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_GL_SPATIAL_INDEX_H_
+#define ORBIT_GL_SPATIAL_INDEX_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "CoreMath.h"
+
+namespace orbit_gl {
+
+// Axis-aligned rectangle, where `min` and `max` are inclusive.
+struct Rect {
+  Rect() = default;
+  Rect(Vec2 min, Vec2 max) : min(min), max(max) {}
+  [[nodiscard]] bool Contains(Vec2 point) const {
+    return point[0] >= min[0] && point[0] <= max[0] && point[1] >= min[1] && point[1] <= max[1];
+  }
+
+  Vec2 min;
+  Vec2 max;
+};
+
+// SpatialIndex is a static R-tree over a set of rectangles, bulk-loaded with the
+// Sort-Tile-Recursive algorithm. Finding the rectangles that contain a point takes O(log n) plus
+// the number of rectangles that need to be visited because they overlap the point, which is small
+// for primitives drawn in a time graph.
+class SpatialIndex {
+ public:
+  explicit SpatialIndex(const std::vector<Rect>& rects);
+
+  // Calls `action` with the index (into the vector passed to the constructor) of each rectangle
+  // that contains `point`, in no particular order.
+  void ForEachRectContaining(Vec2 point, const std::function<void(uint32_t)>& action) const;
+
+  [[nodiscard]] size_t size() const { return rects_.size(); }
+
+ private:
+  static constexpr size_t kNodeCapacity = 16;
+
+  struct Node {
+    Rect bounds;
+    // Range of children in the level below, or of `rect_indices_` for the leaf level.
+    uint32_t first_child;
+    uint32_t num_children;
+  };
+
+  void ForEachRectContaining(size_t level, const Node& node, Vec2 point,
+                             const std::function<void(uint32_t)>& action) const;
+
+  std::vector<Rect> rects_;
+  std::vector<uint32_t> rect_indices_;
+  // levels_[0] are the leaves, levels_.back() is the root level.
+  std::vector<std::vector<Node>> levels_;
+};
+
+}  // namespace orbit_gl
+
+#endif  // ORBIT_GL_SPATIAL_INDEX_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "CoreMath.h"
+#include "SpatialIndex.h"
+
+namespace orbit_gl {
+
+static std::vector<uint32_t> GetRectsContaining(const SpatialIndex& index, Vec2 point) {
+  std::vector<uint32_t> result;
+  index.ForEachRectContaining(point, [&result](uint32_t rect_index) {
+    result.push_back(rect_index);
+  });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+TEST(SpatialIndex, Empty) {
+  SpatialIndex index({});
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_TRUE(GetRectsContaining(index, Vec2(0, 0)).empty());
+}
+
+TEST(SpatialIndex, OverlappingRects) {
+  SpatialIndex index({Rect(Vec2(0, 0), Vec2(10, 10)), Rect(Vec2(5, 5), Vec2(15, 15)),
+                      Rect(Vec2(20, 0), Vec2(30, 10))});
+  EXPECT_EQ(index.size(), 3);
+  EXPECT_EQ(GetRectsContaining(index, Vec2(1, 1)), std::vector<uint32_t>{0});
+  EXPECT_EQ(GetRectsContaining(index, Vec2(7, 7)), (std::vector<uint32_t>{0, 1}));
+  // Bounds are inclusive.
+  EXPECT_EQ(GetRectsContaining(index, Vec2(30, 10)), std::vector<uint32_t>{2});
+  EXPECT_TRUE(GetRectsContaining(index, Vec2(17, 5)).empty());
+}
+
+TEST(SpatialIndex, MatchesLinearSearch) {
+  // Rows of timer-like boxes, enough for several levels of the tree.
+  std::vector<Rect> rects;
+  for (int row = 0; row < 20; ++row) {
+    for (int column = 0; column < 500; ++column) {
+      const float x = column * 10.f + row;
+      const float y = row * 20.f;
+      rects.emplace_back(Vec2(x, y), Vec2(x + 5.f + column % 7, y + 10.f));
+    }
+  }
+  SpatialIndex index(rects);
+
+  for (float x = -5.f; x < 5100.f; x += 7.3f) {
+    for (float y = -5.f; y < 420.f; y += 6.1f) {
+      std::vector<uint32_t> expected;
+      for (uint32_t i = 0; i < rects.size(); ++i) {
+        if (rects[i].Contains(Vec2(x, y))) expected.push_back(i);
+      }
+      EXPECT_EQ(GetRectsContaining(index, Vec2(x, y)), expected);
+    }
+  }
+}
+
+}  // namespace orbit_gl
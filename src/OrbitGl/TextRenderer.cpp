@@ -56,6 +56,7 @@ TextRenderer::~TextRenderer() {
 }
 
 void TextRenderer::Init() {
+  absl::MutexLock lock(&mutex_);
   if (initialized_) return;
 
   int atlas_size = 2 * 1024;
@@ -128,14 +129,13 @@ ftgl::texture_glyph_t* TextRenderer::MaybeLoadAndGetGlyph(ftgl::texture_font_t*
 
 void TextRenderer::RenderLayer(float layer) {
   ORBIT_SCOPE_FUNCTION;
+  // Lazy init
+  Init();
+
+  absl::MutexLock lock(&mutex_);
   if (vertex_buffers_by_layer_.count(layer) == 0) return;
   auto& buffer = vertex_buffers_by_layer_.at(layer);
 
-  // Lazy init
-  if (!initialized_) {
-    Init();
-  }
-
   glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glEnable(GL_BLEND);
   glDepthMask(GL_FALSE);
@@ -183,6 +183,7 @@ void TextRenderer::RenderLayer(float layer) {
 
 void TextRenderer::RenderDebug(Batcher* batcher) {
   if (!draw_outline_) return;
+  absl::MutexLock lock(&mutex_);
   for (auto& [unused_layer, buffer] : vertex_buffers_by_layer_) {
     DrawOutline(batcher, buffer);
   }
@@ -285,6 +286,7 @@ void TextRenderer::AddText(const char* text, float x, float y, float z, const Co
                            uint32_t font_size, float max_size, bool right_justified,
                            Vec2* out_text_pos, Vec2* out_text_size) {
   if (!font_size) return;
+  absl::MutexLock lock(&mutex_);
   ToScreenSpace(x, y, pen_.x, pen_.y);
 
   if (right_justified) {
@@ -314,10 +316,19 @@ float TextRenderer::AddTextTrailingCharsPrioritized(const char* text, float x, f
                                                     const Color& color,
                                                     size_t trailing_chars_length,
                                                     uint32_t font_size, float max_size) {
-  if (!initialized_) {
-    Init();
-  }
+  Init();
+
+  std::string text_to_add = ComputeTrailingCharsPrioritizedText(text, x, trailing_chars_length,
+                                                                font_size, max_size);
+  AddText(text_to_add.c_str(), x, y, z, color, font_size, max_size);
+  return GetStringWidth(text_to_add.c_str(), font_size);
+}
 
+std::string TextRenderer::ComputeTrailingCharsPrioritizedText(const char* text, float x,
+                                                              size_t trailing_chars_length,
+                                                              uint32_t font_size,
+                                                              float max_size) {
+  absl::MutexLock lock(&mutex_);
   float temp_pen_x = ToScreenSpace(x);
   float max_width = max_size == -1.f ? FLT_MAX : ToScreenSpace(max_size);
   float string_width = 0.f;
@@ -364,8 +375,7 @@ float TextRenderer::AddTextTrailingCharsPrioritized(const char* text, float x, f
                            (fitting_chars_count > (trailing_chars_length + kEllipsisBufferSize));
 
   if (!use_ellipsis_text) {
-    AddText(text, x, y, z, color, font_size, max_size);
-    return GetStringWidth(text, font_size);
+    return text;
   }
 
   auto leading_char_count = fitting_chars_count - (trailing_chars_length + kEllipsisTextLen);
@@ -375,16 +385,16 @@ float TextRenderer::AddTextTrailingCharsPrioritized(const char* text, float x, f
 
   auto time_position = text_length - trailing_chars_length;
   modified_text.append(&text[time_position], trailing_chars_length);
-
-  AddText(modified_text.c_str(), x, y, z, color, font_size, max_size);
-  return GetStringWidth(modified_text.c_str(), font_size);
+  return modified_text;
 }
 
 float TextRenderer::GetStringWidth(const char* text, uint32_t font_size) {
+  absl::MutexLock lock(&mutex_);
   return viewport_->ScreenToWorldWidth(GetStringWidthScreenSpace(text, font_size));
 }
 
 float TextRenderer::GetStringHeight(const char* text, uint32_t font_size) {
+  absl::MutexLock lock(&mutex_);
   return viewport_->ScreenToWorldHeight(GetStringHeightScreenSpace(text, font_size));
 }
 
@@ -428,6 +438,7 @@ int TextRenderer::GetStringHeightScreenSpace(const char* text, uint32_t font_siz
 }
 
 std::vector<float> TextRenderer::GetLayers() const {
+  absl::MutexLock lock(&mutex_);
   std::vector<float> layers;
   for (auto& [layer, unused_buffer] : vertex_buffers_by_layer_) {
     layers.push_back(layer);
@@ -450,6 +461,7 @@ float TextRenderer::ToScreenSpace(float width) {
 }
 
 void TextRenderer::Clear() {
+  absl::MutexLock lock(&mutex_);
   pen_.x = 0.f;
   pen_.y = 0.f;
   for (auto& [unused_layer, buffer] : vertex_buffers_by_layer_) {
@@ -11,10 +11,12 @@
 #include <freetype-gl/texture-font.h>
 #include <freetype-gl/vec234.h>
 #include <glad/glad.h>
+#include <absl/synchronization/mutex.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include <map>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -28,6 +30,9 @@ struct vertex_buffer_t;
 struct texture_font_t;
 }  // namespace ftgl
 
+// Text can be added from multiple threads concurrently, e.g. while the tracks of the time graph
+// update their primitives in parallel. Init and RenderLayer have to be called on the thread that
+// owns the OpenGL context.
 class TextRenderer {
  public:
   explicit TextRenderer();
@@ -59,6 +64,13 @@ class TextRenderer {
                        ftgl::vec2* pen, float max_size = -1.f, float z = -0.01f,
                        ftgl::vec2* out_text_pos = nullptr, ftgl::vec2* out_text_size = nullptr);
 
+  // Returns `text`, or, if it doesn't fit into `max_size`, its beginning followed by an ellipsis
+  // and its last `trailing_chars_length` characters.
+  [[nodiscard]] std::string ComputeTrailingCharsPrioritizedText(const char* text, float x,
+                                                                size_t trailing_chars_length,
+                                                                uint32_t font_size,
+                                                                float max_size);
+
   void ToScreenSpace(float x, float y, float& o_x, float& o_y);
   [[nodiscard]] float ToScreenSpace(float width);
   [[nodiscard]] int GetStringWidthScreenSpace(const char* text, uint32_t font_size);
@@ -70,6 +82,7 @@ class TextRenderer {
   void DrawOutline(Batcher* batcher, ftgl::vertex_buffer_t* buffer);
 
  private:
+  mutable absl::Mutex mutex_;
   ftgl::texture_atlas_t* texture_atlas_;
   // Indicates when a change to the texture atlas occurred so that we have to reupload the
   // texture data. Only freetype-gl's texture_font_load_glyph modifies the texture atlas,
@@ -32,6 +32,10 @@ class ThreadBar : public CaptureViewElement, public std::enable_shared_from_this
 
   [[nodiscard]] virtual bool IsEmpty() const { return false; }
 
+  // Samples and tracepoints are drawn as bare lines and only get boxes with tooltips in the picking
+  // pass.
+  [[nodiscard]] bool HasTooltipPrimitivesOnlyWhenPicking() const override { return true; }
+
   [[nodiscard]] virtual const std::string& GetName() const { return name_; }
 
  protected:
@@ -145,21 +145,13 @@ static std::string GetThreadStateDescription(ThreadStateSliceInfo::ThreadState s
   }
 }
 
-std::string ThreadStateBar::GetThreadStateSliceTooltip(Batcher* batcher, PickingId id) const {
-  PickingUserData* user_data = batcher->GetUserData(id);
-  if (user_data == nullptr || user_data->custom_data_ == nullptr) {
-    return "";
-  }
-
-  const auto* thread_state_slice =
-      static_cast<const ThreadStateSliceInfo*>(user_data->custom_data_);
+static std::string GetThreadStateSliceTooltip(ThreadStateSliceInfo::ThreadState state) {
   return absl::StrFormat(
       "<b>%s</b><br/>"
       "<i>Thread state</i><br/>"
       "<br/>"
       "%s",
-      GetThreadStateName(thread_state_slice->thread_state()),
-      GetThreadStateDescription(thread_state_slice->thread_state()));
+      GetThreadStateName(state), GetThreadStateDescription(state));
 }
 
 void ThreadStateBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
@@ -172,49 +164,45 @@ void ThreadStateBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint6
   const float pixel_width_in_world_coords =
       viewport_->GetVisibleWorldWidth() / static_cast<float>(viewport_->GetScreenWidth());
 
-  uint64_t ignore_until_ns = 0;
-
   CHECK(capture_data_ != nullptr);
+  // Reduce overdraw by not drawing slices whose entire width would only draw over a previous
+  // slice. Similar to TimerTrack::UpdatePrimitives. The returned `ignore_until_ns` lets the store
+  // skip such slices with a binary search instead of visiting each of them.
   capture_data_->ForEachThreadStateSliceIntersectingTimeRange(
-      GetThreadId(), min_tick, max_tick, [&](const ThreadStateSliceInfo& slice) {
-        if (slice.end_timestamp_ns() <= ignore_until_ns) {
-          // Reduce overdraw by not drawing slices whose entire width would only draw over a
-          // previous slice. Similar to TimerTrack::UpdatePrimitives.
-          return;
-        }
-
-        const float x0 = time_graph_->GetWorldFromTick(slice.begin_timestamp_ns());
-        const float x1 = time_graph_->GetWorldFromTick(slice.end_timestamp_ns());
+      GetThreadId(), min_tick, max_tick,
+      [&](uint64_t begin_timestamp_ns, uint64_t end_timestamp_ns,
+          ThreadStateSliceInfo::ThreadState state) -> uint64_t {
+        const float x0 = time_graph_->GetWorldFromTick(begin_timestamp_ns);
+        const float x1 = time_graph_->GetWorldFromTick(end_timestamp_ns);
         const float width = x1 - x0;
 
         const Vec2 pos{x0, pos_[1]};
         const Vec2 size{width, -size_[1]};
 
-        const Color color = GetThreadStateColor(slice.thread_state());
+        const Color color = GetThreadStateColor(state);
 
-        auto user_data = std::make_unique<PickingUserData>(nullptr, [&, batcher](PickingId id) {
-          return GetThreadStateSliceTooltip(batcher, id);
-        });
-        user_data->custom_data_ = &slice;
+        // Capture the state by value, as there is no ThreadStateSliceInfo for `custom_data_` to
+        // point to.
+        auto user_data = std::make_unique<PickingUserData>(
+            nullptr, [state](PickingId /*id*/) { return GetThreadStateSliceTooltip(state); });
 
-        if (slice.end_timestamp_ns() - slice.begin_timestamp_ns() > pixel_delta_ns) {
+        if (end_timestamp_ns - begin_timestamp_ns > pixel_delta_ns) {
           Box box(pos, size, GlCanvas::kZValueEvent + z_offset);
           batcher->AddBox(box, color, std::move(user_data));
-        } else {
-          // Make this slice cover an entire pixel and don't draw subsequent slices that would
-          // coincide with the same pixel.
-          // Use AddBox instead of AddVerticalLine as otherwise the tops of Boxes and lines wouldn't
-          // be properly aligned.
-          Box box(pos, {pixel_width_in_world_coords, size[1]}, GlCanvas::kZValueEvent + z_offset);
-          batcher->AddBox(box, color, std::move(user_data));
-
-          if (pixel_delta_ns != 0) {
-            ignore_until_ns =
-                min_time_graph_ns +
-                (slice.begin_timestamp_ns() - min_time_graph_ns) / pixel_delta_ns * pixel_delta_ns +
-                pixel_delta_ns;
-          }
+          return 0;
         }
+
+        // Make this slice cover an entire pixel and don't draw subsequent slices that would
+        // coincide with the same pixel.
+        // Use AddBox instead of AddVerticalLine as otherwise the tops of Boxes and lines wouldn't
+        // be properly aligned.
+        Box box(pos, {pixel_width_in_world_coords, size[1]}, GlCanvas::kZValueEvent + z_offset);
+        batcher->AddBox(box, color, std::move(user_data));
+
+        if (pixel_delta_ns == 0) return 0;
+        return min_time_graph_ns +
+               (begin_timestamp_ns - min_time_graph_ns) / pixel_delta_ns * pixel_delta_ns +
+               pixel_delta_ns;
       });
 }
 
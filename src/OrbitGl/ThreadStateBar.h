@@ -37,9 +37,6 @@ class ThreadStateBar final : public ThreadBar {
   void OnPick(int x, int y) override;
 
   [[nodiscard]] bool IsEmpty() const override;
-
- private:
-  std::string GetThreadStateSliceTooltip(Batcher* batcher, PickingId id) const;
 };
 
 }  // namespace orbit_gl
@@ -408,7 +408,9 @@ float ThreadTrack::GetYFromDepth(uint32_t depth) const {
          GetDefaultBoxHeight() * static_cast<float>(depth + 1);
 }
 
-void ThreadTrack::OnTimer(const TimerInfo& timer_info) {
+void ThreadTrack::OnTimer(const TimerInfo& timer_info) { AddTimer(timer_info); }
+
+const TimerInfo& ThreadTrack::AddTimer(const TimerInfo& timer_info) {
   UpdateDepth(timer_info.depth() + 1);
 
   if (process_id_ == -1) {
@@ -426,6 +428,7 @@ void ThreadTrack::OnTimer(const TimerInfo& timer_info) {
     absl::MutexLock lock(&scope_tree_mutex_);
     scope_tree_.Insert(&timer_info_chain_ref);
   }
+  return timer_info_chain_ref;
 }
 
 void ThreadTrack::OnCaptureComplete() {
@@ -50,6 +50,8 @@ class ThreadTrack final : public TimerTrack {
   void UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
                         PickingMode picking_mode, float z_offset = 0) override;
   void OnTimer(const orbit_client_protos::TimerInfo& timer_info) override;
+  // Same as OnTimer, and returns the timer as stored in this track, which doesn't move.
+  const orbit_client_protos::TimerInfo& AddTimer(const orbit_client_protos::TimerInfo& timer_info);
   [[nodiscard]] float GetYFromDepth(uint32_t depth) const override;
 
   void OnPick(int x, int y) override;
@@ -306,8 +306,7 @@ void TimeGraph::ProcessTimer(const TimerInfo& timer_info, const InstrumentedFunc
       break;
     }
     case TimerInfo::kNone: {
-      ThreadTrack* track = track_manager_->GetOrCreateThreadTrack(timer_info.thread_id());
-      track->OnTimer(timer_info);
+      ProcessThreadTrackTimer(timer_info);
       break;
     }
     case TimerInfo::kApiEvent: {
@@ -315,8 +314,7 @@ void TimeGraph::ProcessTimer(const TimerInfo& timer_info, const InstrumentedFunc
       break;
     }
     case TimerInfo::kApiScope: {
-      ThreadTrack* track = track_manager_->GetOrCreateThreadTrack(timer_info.thread_id());
-      track->OnTimer(timer_info);
+      ProcessThreadTrackTimer(timer_info);
       break;
     }
     case TimerInfo::kApiScopeAsync: {
@@ -330,13 +328,17 @@ void TimeGraph::ProcessTimer(const TimerInfo& timer_info, const InstrumentedFunc
   RequestUpdate();
 }
 
+void TimeGraph::ProcessThreadTrackTimer(const TimerInfo& timer_info) {
+  ThreadTrack* track = track_manager_->GetOrCreateThreadTrack(timer_info.thread_id());
+  function_timer_index_.Add(track->AddTimer(timer_info));
+}
+
 void TimeGraph::ProcessApiEventTimerLegacy(const TimerInfo& timer_info) {
   orbit_api::Event api_event = ManualInstrumentationManager::ApiEventFromTimerInfo(timer_info);
   switch (api_event.type) {
     case orbit_api::kScopeStart:
     case orbit_api::kScopeStop: {
-      ThreadTrack* track = track_manager_->GetOrCreateThreadTrack(timer_info.thread_id());
-      track->OnTimer(timer_info);
+      ProcessThreadTrackTimer(timer_info);
       break;
     }
     case orbit_api::kScopeStartAsync:
@@ -363,8 +365,7 @@ void TimeGraph::ProcessIntrospectionTimer(const TimerInfo& timer_info) {
 
   switch (event.type) {
     case orbit_api::kScopeStart: {
-      ThreadTrack* track = track_manager_->GetOrCreateThreadTrack(timer_info.thread_id());
-      track->OnTimer(timer_info);
+      ProcessThreadTrackTimer(timer_info);
     } break;
     case orbit_api::kScopeStartAsync:
     case orbit_api::kScopeStopAsync:
@@ -557,49 +558,12 @@ void TimeGraph::SelectAndMakeVisible(const TimerInfo* timer_info) {
 const TimerInfo* TimeGraph::FindPreviousFunctionCall(uint64_t function_address,
                                                      uint64_t current_time,
                                                      std::optional<int32_t> thread_id) const {
-  const orbit_client_protos::TimerInfo* previous_timer = nullptr;
-  uint64_t goal_time = std::numeric_limits<uint64_t>::lowest();
-  std::vector<const TimerChain*> chains = GetAllThreadTrackTimerChains();
-  for (const TimerChain* chain : chains) {
-    for (const auto& block : *chain) {
-      if (!block.Intersects(goal_time, current_time)) continue;
-      for (uint64_t i = 0; i < block.size(); i++) {
-        const orbit_client_protos::TimerInfo& timer_info = block[i];
-        auto timer_end_time = timer_info.end();
-        if ((timer_info.function_id() == function_address) &&
-            (!thread_id || thread_id.value() == timer_info.thread_id()) &&
-            (timer_end_time < current_time) && (goal_time < timer_end_time)) {
-          previous_timer = &timer_info;
-          goal_time = timer_end_time;
-        }
-      }
-    }
-  }
-  return previous_timer;
+  return function_timer_index_.FindPrevious(function_address, current_time, thread_id);
 }
 
 const TimerInfo* TimeGraph::FindNextFunctionCall(uint64_t function_address, uint64_t current_time,
                                                  std::optional<int32_t> thread_id) const {
-  const orbit_client_protos::TimerInfo* next_timer = nullptr;
-  uint64_t goal_time = std::numeric_limits<uint64_t>::max();
-  std::vector<const TimerChain*> chains = GetAllThreadTrackTimerChains();
-  for (const TimerChain* chain : chains) {
-    CHECK(chain != nullptr);
-    for (const auto& block : *chain) {
-      if (!block.Intersects(current_time, goal_time)) continue;
-      for (uint64_t i = 0; i < block.size(); i++) {
-        const orbit_client_protos::TimerInfo& timer_info = block[i];
-        auto timer_end_time = timer_info.end();
-        if ((timer_info.function_id() == function_address) &&
-            (!thread_id || thread_id.value() == timer_info.thread_id()) &&
-            (timer_end_time > current_time) && (goal_time > timer_end_time)) {
-          next_timer = &timer_info;
-          goal_time = timer_end_time;
-        }
-      }
-    }
-  }
-  return next_timer;
+  return function_timer_index_.FindNext(function_address, current_time, thread_id);
 }
 
 void TimeGraph::RequestUpdate() {
@@ -615,6 +579,11 @@ void TimeGraph::UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, ui
 
   batcher_.StartNewFrame();
   text_renderer_static_.Clear();
+  // Tracks add text from the thread pool while updating their primitives, make sure the text
+  // renderer is not lazily initialized there, as that requires the OpenGL context.
+  text_renderer_static_.Init();
+  // Cleared before updating the tracks, which can request another update.
+  update_primitives_requested_ = false;
 
   capture_min_timestamp_ =
       std::min(capture_min_timestamp_, capture_data_->GetCallstackData().min_time());
@@ -629,8 +598,6 @@ void TimeGraph::UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, ui
 
   track_manager_->UpdateTracksForRendering();
   track_manager_->UpdateTrackPrimitives(&batcher_, min_tick, max_tick, picking_mode);
-
-  update_primitives_requested_ = false;
 }
 
 void TimeGraph::SelectCallstacks(float world_start, float world_end, int32_t thread_id) {
@@ -641,25 +608,36 @@ void TimeGraph::SelectCallstacks(float world_start, float world_end, int32_t thr
   uint64_t t0 = GetTickFromWorld(world_start);
   uint64_t t1 = GetTickFromWorld(world_end);
 
-  CHECK(capture_data_);
-  std::vector<CallstackEvent> selected_callstack_events =
-      (thread_id == orbit_base::kAllProcessThreadsTid)
-          ? capture_data_->GetCallstackData().GetCallstackEventsInTimeRange(t0, t1)
-          : capture_data_->GetCallstackData().GetCallstackEventsOfTidInTimeRange(thread_id, t0, t1);
-
-  selected_callstack_events_per_thread_.clear();
-  for (CallstackEvent& event : selected_callstack_events) {
-    selected_callstack_events_per_thread_[event.thread_id()].emplace_back(event);
-    selected_callstack_events_per_thread_[orbit_base::kAllProcessThreadsTid].emplace_back(event);
-  }
-
-  app_->SelectCallstackEvents(selected_callstack_events, thread_id);
+  callstack_selection_ = CallstackSelection{thread_id, t0, t1};
+  app_->SelectCallstackEvents(t0, t1, thread_id);
 
   RequestUpdate();
 }
 
-const std::vector<CallstackEvent>& TimeGraph::GetSelectedCallstackEvents(int32_t tid) {
-  return selected_callstack_events_per_thread_[tid];
+void TimeGraph::ForEachSelectedCallstackEvent(
+    int32_t tid, uint64_t min_tick, uint64_t max_tick,
+    const std::function<void(const CallstackEvent&)>& action) const {
+  if (!callstack_selection_.has_value()) return;
+  const CallstackSelection& selection = callstack_selection_.value();
+
+  int32_t selected_tid = selection.thread_id;
+  if (selected_tid == orbit_base::kAllProcessThreadsTid) {
+    selected_tid = tid;
+  } else if (tid != orbit_base::kAllProcessThreadsTid && tid != selected_tid) {
+    return;
+  }
+
+  min_tick = std::max(min_tick, selection.min_tick);
+  max_tick = std::min(max_tick, selection.max_tick);
+  if (min_tick > max_tick) return;
+
+  CHECK(capture_data_);
+  if (selected_tid == orbit_base::kAllProcessThreadsTid) {
+    capture_data_->GetCallstackData().ForEachCallstackEventInTimeRange(min_tick, max_tick, action);
+  } else {
+    capture_data_->GetCallstackData().ForEachCallstackEventOfTidInTimeRange(selected_tid, min_tick,
+                                                                            max_tick, action);
+  }
 }
 
 void TimeGraph::Draw(Batcher& batcher, TextRenderer& text_renderer,
@@ -1021,21 +999,13 @@ std::pair<const TimerInfo*, const TimerInfo*> TimeGraph::GetMinMaxTimerInfoForFu
     uint64_t function_id) const {
   const orbit_client_protos::TimerInfo* min_timer = nullptr;
   const orbit_client_protos::TimerInfo* max_timer = nullptr;
-  std::vector<const TimerChain*> chains = GetAllThreadTrackTimerChains();
-  for (const TimerChain* chain : chains) {
-    for (const auto& block : *chain) {
-      for (size_t i = 0; i < block.size(); i++) {
-        const orbit_client_protos::TimerInfo& timer_info = block[i];
-        if (timer_info.function_id() != function_id) continue;
-
-        uint64_t elapsed_nanos = timer_info.end() - timer_info.start();
-        if (min_timer == nullptr || elapsed_nanos < (min_timer->end() - min_timer->start())) {
-          min_timer = &timer_info;
-        }
-        if (max_timer == nullptr || elapsed_nanos > (max_timer->end() - max_timer->start())) {
-          max_timer = &timer_info;
-        }
-      }
+  for (const TimerInfo* timer_info : function_timer_index_.GetTimers(function_id)) {
+    uint64_t elapsed_nanos = timer_info->end() - timer_info->start();
+    if (min_timer == nullptr || elapsed_nanos < (min_timer->end() - min_timer->start())) {
+      min_timer = timer_info;
+    }
+    if (max_timer == nullptr || elapsed_nanos > (max_timer->end() - max_timer->start())) {
+      max_timer = timer_info;
     }
   }
   return std::make_pair(min_timer, max_timer);
@@ -8,6 +8,7 @@
 #include <absl/container/flat_hash_map.h>
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -20,6 +21,7 @@
 #include "CallstackThreadBar.h"
 #include "CaptureViewElement.h"
 #include "ClientData/CaptureData.h"
+#include "ClientData/FunctionTimerIndex.h"
 #include "ClientData/TimerChain.h"
 #include "CoreMath.h"
 #include "ManualInstrumentationManager.h"
@@ -57,7 +59,11 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   void UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, uint64_t /*max_tick*/,
                         PickingMode /*picking_mode*/, float /*z_offset*/ = 0) override;
   void SelectCallstacks(float world_start, float world_end, int32_t thread_id);
-  const std::vector<orbit_client_protos::CallstackEvent>& GetSelectedCallstackEvents(int32_t tid);
+  // Calls `action` for the selected callstack events of thread `tid` (of all threads if `tid` is
+  // kAllProcessThreadsTid) with timestamps in [min_tick, max_tick].
+  void ForEachSelectedCallstackEvent(
+      int32_t tid, uint64_t min_tick, uint64_t max_tick,
+      const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const;
 
   void ProcessTimer(const orbit_client_protos::TimerInfo& timer_info,
                     const orbit_grpc_protos::InstrumentedFunction* function);
@@ -148,6 +154,11 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   [[nodiscard]] std::pair<const orbit_client_protos::TimerInfo*,
                           const orbit_client_protos::TimerInfo*>
   GetMinMaxTimerInfoForFunction(uint64_t function_id) const;
+  // Returns the timers of the function in thread tracks, sorted by end time.
+  [[nodiscard]] std::vector<const orbit_client_protos::TimerInfo*> GetAllTimersForFunction(
+      uint64_t function_id) const {
+    return function_timer_index_.GetTimers(function_id);
+  }
 
   // TODO(http://b/194777907): Move GetColor outside TimeGraph
   [[nodiscard]] static Color GetColor(uint32_t id) {
@@ -195,6 +206,7 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
 
   [[deprecated]] void ProcessApiEventTimerLegacy(const orbit_client_protos::TimerInfo& timer_info);
   void ProcessApiScopeTimer(const orbit_client_protos::TimerInfo& timer_info);
+  void ProcessThreadTrackTimer(const orbit_client_protos::TimerInfo& timer_info);
   void ProcessApiScopeAsyncTimer(const orbit_client_protos::TimerInfo& timer_info);
   void ProcessIntrospectionTimer(const orbit_client_protos::TimerInfo& timer_info);
   [[deprecated]] void ProcessValueTrackingTimerLegacy(
@@ -241,9 +253,16 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   Batcher batcher_;
 
   std::unique_ptr<TrackManager> track_manager_;
-
-  absl::flat_hash_map<int32_t, std::vector<orbit_client_protos::CallstackEvent>>
-      selected_callstack_events_per_thread_;
+  // Indexes the timers of all thread tracks by function, for iterating over function calls.
+  orbit_client_data::FunctionTimerIndex function_timer_index_;
+
+  // The callstack events selected by SelectCallstacks are not copied, only the selection is stored.
+  struct CallstackSelection {
+    int32_t thread_id;
+    uint64_t min_tick;
+    uint64_t max_tick;
+  };
+  std::optional<CallstackSelection> callstack_selection_;
 
   ManualInstrumentationManager* manual_instrumentation_manager_;
   std::unique_ptr<ManualInstrumentationManager::AsyncTimerInfoListener> async_timer_info_listener_;
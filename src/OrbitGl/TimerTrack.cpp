@@ -77,6 +77,30 @@ WorldXInfo ToWorldX(double start_us, double end_us, double inv_time_window, floa
   return result;
 }
 
+// Returns the index of the last timer of the largest group of timers in `block` that starts at
+// `index` and for which the group summary shows that none of its timers would be drawn: either
+// because they are all outside of the visible range, or because they all fall into the pixel
+// covered by the last vertical line drawn, [min_ignore, max_ignore]. Returns `index` if there is no
+// such group.
+size_t GetLastIndexOfGroupNotToDraw(const orbit_client_data::TimerBlock& block, size_t index,
+                                    const internal::DrawData& draw_data, uint64_t min_ignore,
+                                    uint64_t max_ignore) {
+  for (size_t level = 0; level < orbit_client_data::TimerBlock::kSummaryGroupSizes.size();
+       ++level) {
+    const size_t group_size = orbit_client_data::TimerBlock::kSummaryGroupSizes[level];
+    if (index % group_size != 0) continue;
+    const orbit_client_data::TimerGroupSummary summary =
+        block.GetGroupSummary(level, index / group_size);
+    if (summary.count == 0) continue;
+    const bool all_outside_visible_range =
+        summary.max_end < draw_data.min_tick || summary.min_start > draw_data.max_tick;
+    const bool all_in_ignored_pixel =
+        summary.min_start >= min_ignore && summary.max_end <= max_ignore;
+    if (all_outside_visible_range || all_in_ignored_pixel) return index + summary.count - 1;
+  }
+  return index;
+}
+
 }  // namespace
 
 std::string TimerTrack::GetDisplayTime(const TimerInfo& timer) const {
@@ -303,6 +327,17 @@ void TimerTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t
 
         prev_timer_info = current_timer_info;
         current_timer_info = next_timer_info;
+
+        // DrawTimer would discard each timer of a group whose summary shows that all of them are
+        // invisible or overdraw, hence skip the group, which saves touching most timers when
+        // zoomed out. Keep track of the last two timers as if the group had been iterated.
+        const size_t last_index_to_skip =
+            GetLastIndexOfGroupNotToDraw(block, k, draw_data, min_ignore, max_ignore);
+        if (last_index_to_skip != k) {
+          k = last_index_to_skip;
+          prev_timer_info = &block[k - 1];
+          current_timer_info = &block[k];
+        }
       }
     }
 
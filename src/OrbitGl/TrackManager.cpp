@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <optional>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -28,6 +29,8 @@
 #include "CoreMath.h"
 #include "GlCanvas.h"
 #include "OrbitBase/Append.h"
+#include "OrbitBase/Future.h"
+#include "OrbitBase/JoinFutures.h"
 #include "OrbitBase/ThreadConstants.h"
 #include "TimeGraph.h"
 #include "TimeGraphLayout.h"
@@ -52,8 +55,14 @@ TrackManager::TrackManager(TimeGraph* time_graph, orbit_gl::Viewport* viewport,
   for (auto& type : Track::kAllTrackTypes) {
     track_type_visibility_[type] = true;
   }
+
+  const size_t number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+  thread_pool_ = orbit_base::ThreadPool::Create(number_of_threads, number_of_threads,
+                                                /*thread_ttl=*/absl::Seconds(1));
 }
 
+TrackManager::~TrackManager() { thread_pool_->ShutdownAndWait(); }
+
 std::vector<Track*> TrackManager::GetAllTracks() const {
   std::vector<Track*> tracks;
   for (const auto& track : all_tracks_) {
@@ -299,24 +308,92 @@ int TrackManager::FindMovingTrackIndex() {
 
 void TrackManager::UpdateTrackPrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
                                          PickingMode picking_mode) {
+  std::vector<float> track_heights = UpdateVisibleTrackPositions();
+  UpdateVisibleTrackPrimitivesInParallel(batcher, min_tick, max_tick, picking_mode);
+
+  // Updating the primitives of a track can change its height, e.g., when it sees a deeper timer for
+  // the first time. The tracks below it then need to be moved down in the next update.
+  for (size_t i = 0; i < visible_tracks_.size(); ++i) {
+    if (visible_tracks_[i]->GetHeight() != track_heights[i]) {
+      track_heights[i] = visible_tracks_[i]->GetHeight();
+      if (time_graph_ != nullptr) time_graph_->RequestUpdate();
+    }
+  }
+
+  float tracks_total_height = layout_->GetSchedulerTrackOffset();
+  for (float track_height : track_heights) {
+    tracks_total_height += track_height + layout_->GetSpaceBetweenTracks();
+  }
+  // TODO: This margin should be treated in a different way (http://b/192070555).
+  tracks_total_height += layout_->GetBottomMargin();
+
+  tracks_total_height_ = tracks_total_height;
+}
+
+std::vector<float> TrackManager::UpdateVisibleTrackPositions() {
   // Make sure track tab fits in the viewport.
   float current_y = -layout_->GetSchedulerTrackOffset();
 
-  // Draw tracks
-  for (auto& track : visible_tracks_) {
-    const float z_offset = track->IsMoving() ? GlCanvas::kZOffsetMovingTrack : 0.f;
+  // Tracks are drawn from 0 (top) to negative y-coordinates.
+  std::vector<float> track_heights;
+  track_heights.reserve(visible_tracks_.size());
+  for (Track* track : visible_tracks_) {
     if (!track->IsMoving()) {
       track->SetPos(track->GetPos()[0], current_y);
     }
-    track->UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
-    current_y -= (track->GetHeight() + layout_->GetSpaceBetweenTracks());
+    const float track_height = track->GetHeight();
+    track_heights.push_back(track_height);
+    current_y -= (track_height + layout_->GetSpaceBetweenTracks());
+  }
+  return track_heights;
+}
+
+void TrackManager::UpdateVisibleTrackPrimitivesInParallel(Batcher* batcher, uint64_t min_tick,
+                                                          uint64_t max_tick,
+                                                          PickingMode picking_mode) {
+  auto update_track_primitives = [min_tick, max_tick, picking_mode](Track* track,
+                                                                    Batcher* track_batcher) {
+    const float z_offset = track->IsMoving() ? GlCanvas::kZOffsetMovingTrack : 0.f;
+    track->UpdatePrimitives(track_batcher, min_tick, max_tick, picking_mode, z_offset);
+  };
+
+  const size_t number_of_chunks = std::min(visible_tracks_.size(), thread_pool_->GetPoolSize());
+  if (number_of_chunks <= 1) {
+    for (Track* track : visible_tracks_) {
+      update_track_primitives(track, batcher);
+    }
+    return;
   }
 
-  // TODO: This margin should be treated in a different way (http://b/192070555).
-  current_y -= layout_->GetBottomMargin();
+  while (track_chunk_batchers_.size() < number_of_chunks) {
+    track_chunk_batchers_.push_back(
+        std::make_unique<Batcher>(batcher->GetBatcherId(), batcher->GetPickingManager()));
+  }
 
-  // Tracks are drawn from 0 (top) to negative y-coordinates.
-  tracks_total_height_ = std::abs(current_y);
+  const size_t tracks_per_chunk =
+      (visible_tracks_.size() + number_of_chunks - 1) / number_of_chunks;
+  std::vector<orbit_base::Future<void>> futures;
+  std::vector<Batcher*> chunk_batchers;
+  for (size_t begin = 0; begin < visible_tracks_.size(); begin += tracks_per_chunk) {
+    const size_t end = std::min(begin + tracks_per_chunk, visible_tracks_.size());
+    Batcher* chunk_batcher = track_chunk_batchers_[chunk_batchers.size()].get();
+    chunk_batcher->StartNewFrame();
+    chunk_batcher->SetPickingManager(batcher->GetPickingManager());
+    chunk_batchers.push_back(chunk_batcher);
+    futures.emplace_back(
+        thread_pool_->Schedule([this, begin, end, chunk_batcher, &update_track_primitives] {
+          for (size_t i = begin; i < end; ++i) {
+            update_track_primitives(visible_tracks_[i], chunk_batcher);
+          }
+        }));
+  }
+  orbit_base::JoinFutures(absl::MakeConstSpan(futures)).Wait();
+
+  // As the chunks are contiguous, this yields the same primitives in the same order as updating
+  // all tracks into `batcher` directly.
+  for (Batcher* chunk_batcher : chunk_batchers) {
+    batcher->MergeFrom(chunk_batcher);
+  }
 }
 
 void TrackManager::UpdateTracksForRendering() {
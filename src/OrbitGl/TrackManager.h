@@ -16,10 +16,12 @@
 #include <vector>
 
 #include "AsyncTrack.h"
+#include "Batcher.h"
 #include "CGroupAndProcessMemoryTrack.h"
 #include "FrameTrack.h"
 #include "GpuTrack.h"
 #include "GraphTrack.h"
+#include "OrbitBase/ThreadPool.h"
 #include "PageFaultsTrack.h"
 #include "PickingManager.h"
 #include "SchedulerTrack.h"
@@ -41,6 +43,7 @@ class TrackManager {
   explicit TrackManager(TimeGraph* time_graph, orbit_gl::Viewport* viewport,
                         TimeGraphLayout* layout, OrbitApp* app,
                         const orbit_client_data::CaptureData* capture_data);
+  ~TrackManager();
 
   [[nodiscard]] std::vector<Track*> GetAllTracks() const;
   [[nodiscard]] std::vector<Track*> GetVisibleTracks() const { return visible_tracks_; }
@@ -90,6 +93,12 @@ class TrackManager {
   void SortTracks();
   [[nodiscard]] std::vector<ThreadTrack*> GetSortedThreadTracks();
   void UpdateVisibleTrackList();
+  // Positions the visible tracks below each other and returns the height of each of them.
+  std::vector<float> UpdateVisibleTrackPositions();
+  // Tracks are split into contiguous chunks whose primitives are updated in parallel into one
+  // batcher per chunk. The batchers are then merged into `batcher` in the order of the tracks.
+  void UpdateVisibleTrackPrimitivesInParallel(Batcher* batcher, uint64_t min_tick,
+                                              uint64_t max_tick, PickingMode picking_mode);
 
   void AddTrack(const std::shared_ptr<Track>& track);
   void AddFrameTrack(const std::shared_ptr<FrameTrack>& frame_track);
@@ -124,6 +133,9 @@ class TrackManager {
   std::string filter_;
   std::vector<Track*> visible_tracks_;
 
+  std::shared_ptr<orbit_base::ThreadPool> thread_pool_;
+  std::vector<std::unique_ptr<Batcher>> track_chunk_batchers_;
+
   float tracks_total_height_ = 0.0f;
   const orbit_client_data::CaptureData* capture_data_ = nullptr;
 
@@ -10,6 +10,8 @@
 #include <absl/synchronization/mutex.h>
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <queue>
 #include <stack>
@@ -17,6 +19,7 @@
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/ThreadUtils.h"
+#include "VulkanLayerIntermediateEvents.h"
 #include "VulkanLayerProducer.h"
 
 namespace orbit_vulkan_layer {
@@ -29,9 +32,9 @@ namespace orbit_vulkan_layer {
  * timestamp commands (`VkCmdWriteTimestamp`). The same is done for debug marker begins and ends.
  * All that data will be gathered together at a queue submission (`VkQueueSubmit`).
  *
- * Upon every `VkQueuePresentKHR` it will check if the last timestamp of a certain submission is
- * already available, and if so, it will assume that all timestamps are available and it will send
- * the results over to the `VulkanLayerProducer`.
+ * Upon every `VkQueuePresentKHR` (and periodically on `VkQueueSubmit`) it will check if the last
+ * timestamp of a certain submission is already available, and if so, it will assume that all
+ * timestamps are available and it will send the results over to the `VulkanLayerProducer`.
  *
  * See also `DispatchTable` (for vulkan dispatch), `TimerQueryPool` (to manage the timestamp slots),
  * and `DeviceManager` (to retrieve device properties).
@@ -39,6 +42,10 @@ namespace orbit_vulkan_layer {
  * Thread-Safety: This class is internally synchronized (using read/write locks), and can be
  * safely accessed from different threads. This is needed, as in Vulkan submits and command buffer
  * modifications can happen from multiple threads.
+ * The state of individual command buffers is sharded by command buffer handle (see
+ * `CommandBufferShard`), such that recording into different command buffers from different threads
+ * does not contend on a single lock. Only the submission and completion paths, as well as capture
+ * start and finish, acquire `mutex_` which guards the per-queue state.
  */
 template <class DispatchTable, class DeviceManager, class TimerQueryPool>
 class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
@@ -175,7 +182,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     for (uint32_t i = 0; i < count; ++i) {
       VkCommandBuffer cb = command_buffers[i];
       associated_cbs_it->second.insert(cb);
-      command_buffer_to_device_[cb] = device;
+      CommandBufferShard& shard = GetCommandBufferShard(cb);
+      absl::WriterMutexLock shard_lock(&shard.mutex);
+      shard.command_buffer_to_device[cb] = device;
     }
   }
 
@@ -188,24 +197,26 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     for (uint32_t i = 0; i < count; ++i) {
       VkCommandBuffer command_buffer = command_buffers[i];
       associated_command_buffers.erase(command_buffer);
+      CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+      absl::WriterMutexLock shard_lock(&shard.mutex);
 
       // vkFreeCommandBuffers (and thus this method) can be also called on command bufers in
       // "recording" or executable state and has similar effect as vkResetCommandBuffer has.
-      // In `OnCaptureFinished`, we reset all the timer slots left in `command_buffer_to_state_`.
+      // In `OnCaptureFinished`, we reset all the timer slots left in `command_buffer_to_state`.
       // If we would not reset them here and clear the state, we would try to reset those command
       // buffers there. However, the mapping to the device (which is needed) would be missing.
-      if (command_buffer_to_state_.contains(command_buffer)) {
+      if (shard.command_buffer_to_state.contains(command_buffer)) {
         // Note: This will "rollback" the slot indices (rather then actually resetting them on the
         // Gpu). This is fine, as we remove the command buffer state right after submission. Thus,
         // There can not be a value in the respective slot.
-        ResetCommandBufferUnsafe(command_buffer);
+        ResetCommandBufferUnsafe(&shard, command_buffer);
 
-        command_buffer_to_state_.erase(command_buffer);
+        shard.command_buffer_to_state.erase(command_buffer);
       }
 
-      CHECK(command_buffer_to_device_.contains(command_buffer));
-      CHECK(command_buffer_to_device_.at(command_buffer) == device);
-      command_buffer_to_device_.erase(command_buffer);
+      CHECK(shard.command_buffer_to_device.contains(command_buffer));
+      CHECK(shard.command_buffer_to_device.at(command_buffer) == device);
+      shard.command_buffer_to_device.erase(command_buffer);
     }
     if (associated_command_buffers.empty()) {
       pool_to_command_buffers_.erase(pool);
@@ -213,7 +224,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void MarkCommandBufferBegin(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+    absl::WriterMutexLock lock(&shard.mutex);
     // Even when we are not capturing we create state for this command buffer to allow the
     // debug marker tracking. In order to compute the correct depth of a debug marker and being able
     // to match an "end" marker with the corresponding "begin" marker, we maintain a stack of all
@@ -223,33 +235,34 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     // submission. We will not write timestamps in this case and thus don't store any information
     // other than the debug markers then.
     {
-      if (command_buffer_to_state_.contains(command_buffer)) {
+      if (shard.command_buffer_to_state.contains(command_buffer)) {
         // We end up in this case, if we have used the command buffer before and want to write new
         // commands to it without resetting the command buffer. Per specification,
         // "vkBeginCommandBuffer" does also reset the command buffer, in addition to putting it
         // into the executable state.
-        ResetCommandBufferUnsafe(command_buffer);
+        ResetCommandBufferUnsafe(&shard, command_buffer);
       }
-      command_buffer_to_state_[command_buffer] = {};
+      shard.command_buffer_to_state[command_buffer] = {};
     }
     if (!is_capturing_) {
       return;
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      command_buffer_to_state_.at(command_buffer).command_buffer_begin_slot_index =
+    if (RecordTimestamp(&shard, command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      shard.command_buffer_to_state.at(command_buffer).command_buffer_begin_slot_index =
           std::make_optional(slot_index);
     }
   }
 
   void MarkCommandBufferEnd(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+    absl::WriterMutexLock lock(&shard.mutex);
     if (!is_capturing_) {
       return;
     }
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard.command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkEndCommandBuffer on a command buffer that is in the initial state "
           "(i.e. either freshly allocated or reset with vkResetCommandBuffer).");
@@ -257,30 +270,32 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
+    if (RecordTimestamp(&shard, command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        &slot_index)) {
       // MarkCommandBufferBegin/End are called from within the same submit, and as the
       // `MarkCommandBufferBegin` will always insert the state, we can assume that it is there.
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& command_buffer_state = command_buffer_to_state_.at(command_buffer);
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& command_buffer_state = shard.command_buffer_to_state.at(command_buffer);
       command_buffer_state.command_buffer_end_slot_index = std::make_optional(slot_index);
     }
   }
 
   void MarkDebugMarkerBegin(VkCommandBuffer command_buffer, const char* text, Color color) {
-    absl::WriterMutexLock lock(&mutex_);
+    CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+    absl::WriterMutexLock lock(&shard.mutex);
     // It is ensured by the Vulkan spec. that `text` must not be nullptr.
     CHECK(text != nullptr);
     bool marker_depth_exceeds_maximum;
     {
-      if (!command_buffer_to_state_.contains(command_buffer)) {
+      if (!shard.command_buffer_to_state.contains(command_buffer)) {
         ERROR_ONCE(
             "Calling vkCmdDebugMarkerBeginEXT/vkCmdBeginDebugUtilsLabelEXT on a command buffer "
             "that is in the initial state (i.e. either freshly allocated or reset with "
             "vkResetCommandBuffer).");
         return;
       }
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
       ++state.local_marker_stack_size;
       marker_depth_exceeds_maximum =
           state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
@@ -296,26 +311,27 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    if (RecordTimestamp(&shard, command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
       state.markers.back().slot_index = std::make_optional(slot_index);
     }
   }
 
   void MarkDebugMarkerEnd(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+    absl::WriterMutexLock lock(&shard.mutex);
     bool marker_depth_exceeds_maximum;
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard.command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkCmdDebugMarkerEndEXT/vkCmdEndDebugUtilsLabelEXT on a command buffer "
           "that is in the initial state (i.e. either freshly allocated or reset with "
           "vkResetCommandBuffer).");
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CHECK(shard.command_buffer_to_state.contains(command_buffer));
+    CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
     marker_depth_exceeds_maximum =
         state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
     Marker marker{.type = MarkerType::kDebugMarkerEnd, .cut_off = marker_depth_exceeds_maximum};
@@ -331,9 +347,10 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    if (RecordTimestamp(&shard, command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        &slot_index)) {
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
       state.markers.back().slot_index = std::make_optional(slot_index);
     }
   }
@@ -375,7 +392,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       for (uint32_t command_buffer_index = 0; command_buffer_index < submit_info.commandBufferCount;
            ++command_buffer_index) {
         VkCommandBuffer command_buffer = submit_info.pCommandBuffers[command_buffer_index];
-        PersistSingleCommandBufferOnSubmit(device, command_buffer, &queue_submission,
+        CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+        absl::WriterMutexLock shard_lock(&shard.mutex);
+        PersistSingleCommandBufferOnSubmit(&shard, device, command_buffer, &queue_submission,
                                            &submitted_submit_info, &query_slots_not_needed_to_read);
       }
     }
@@ -428,12 +447,15 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       for (uint32_t command_buffer_index = 0; command_buffer_index < submit_info.commandBufferCount;
            ++command_buffer_index) {
         VkCommandBuffer command_buffer = submit_info.pCommandBuffers[command_buffer_index];
+        CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+        absl::WriterMutexLock shard_lock(&shard.mutex);
         if (device == VK_NULL_HANDLE) {
-          CHECK(command_buffer_to_device_.contains(command_buffer));
-          device = command_buffer_to_device_.at(command_buffer);
+          CHECK(shard.command_buffer_to_device.contains(command_buffer));
+          device = shard.command_buffer_to_device.at(command_buffer);
         }
-        PersistDebugMarkersOfASingleCommandBufferOnSubmit(
-            command_buffer, &queue_submission_optional, &markers, &marker_slots_not_needed_to_read);
+        PersistDebugMarkersOfASingleCommandBufferOnSubmit(&shard, command_buffer,
+                                                          &queue_submission_optional, &markers,
+                                                          &marker_slots_not_needed_to_read);
       }
     }
 
@@ -455,23 +477,24 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   // This method is responsible for retrieving all the timestamps for the "completed" submissions,
   // for transforming the information of those submissions (in particular about the command buffers
-  // and debug markers) into the `GpuQueueSubmission` proto, and for sending it to the
-  // `VulkanLayerProducer`. We consider a submission to be "completed" when all timestamps that are
-  // associated with this submission are ready.
+  // and debug markers) into a `GpuQueueSubmission`, and for sending it to the
+  // `VulkanLayerProducer`. Note that `GpuQueueSubmission` is a plain struct: the corresponding
+  // proto is only built on the producer's forwarder thread, off the application's threads.
+  // We consider a submission to be "completed" when all timestamps that are associated with this
+  // submission are ready.
   // We maintain a priority queue (for every `VkQueue`) `submissions_queue_` and process submissions
   // with the oldest CPU timestamp, until we encounter the first "incomplete" submission.
   // This way, we ensure that we will send the submission information per queue ordered by the
   // CPU timestamp.
-  // Beside the timestamps of command buffers and the meta information of the submission, the proto
+  // Beside the timestamps of command buffers and the meta information of the submission, it
   // also contains the debug markers, "begin" (even if submitted in a different submission) and
   // "end", that got completed in this submission.
   // See also `WriteMetaInfo`, `WriteCommandBufferTimings` and `WriteDebugMarkers`.
   // This method also resets all the timer slots that have been read.
-  // It is assumed to be called periodically, e.g. on `vkQueuePresentKHR`.
+  // It is assumed to be called periodically, e.g. on `vkQueuePresentKHR` and rate-limited on
+  // `vkQueueSubmit`. Note that querying the timestamps does not wait for the GPU.
   void CompleteSubmits(VkDevice device) {
     absl::WriterMutexLock lock(&mutex_);
-    VkQueryPool query_pool = timer_query_pool_->GetQueryPool(device);
-
     if (queue_to_submission_priority_queue_.empty()) {
       return;
     }
@@ -491,15 +514,14 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
         QueueSubmission completed_submission = submissions.top();
         submissions.pop();
         bool command_buffer_queries_succeeded = QueryCommandBufferTimestamps(
-            &completed_submission, &query_slots_done_reading, device, query_pool, timestamp_period);
+            &completed_submission, &query_slots_done_reading, device, timestamp_period);
 
         // We only need to read the debug marker timestamps, if querying the command buffers
         // succeeded.
         bool marker_queries_succeeded = false;
         if (command_buffer_queries_succeeded) {
-          marker_queries_succeeded =
-              QueryDebugMarkerTimestamps(&completed_submission, &query_slots_done_reading, device,
-                                         query_pool, timestamp_period);
+          marker_queries_succeeded = QueryDebugMarkerTimestamps(
+              &completed_submission, &query_slots_done_reading, device, timestamp_period);
         }
 
         if (command_buffer_queries_succeeded && marker_queries_succeeded) {
@@ -512,18 +534,15 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     for (const auto& completed_submission : submissions_to_send) {
-      orbit_grpc_protos::ProducerCaptureEvent capture_event;
-      orbit_grpc_protos::GpuQueueSubmission* submission_proto =
-          capture_event.mutable_gpu_queue_submission();
-
-      WriteMetaInfo(completed_submission.meta_information, submission_proto->mutable_meta_info());
+      GpuQueueSubmission submission;
+      WriteMetaInfo(completed_submission.meta_information, &submission.meta_info);
       bool has_command_buffer_timestamps =
-          WriteCommandBufferTimings(completed_submission, submission_proto);
-      bool has_debug_marker_timestamps = WriteDebugMarkers(completed_submission, submission_proto);
+          WriteCommandBufferTimings(completed_submission, &submission);
+      bool has_debug_marker_timestamps = WriteDebugMarkers(completed_submission, &submission);
 
       if (vulkan_layer_producer_ != nullptr &&
           (has_command_buffer_timestamps || has_debug_marker_timestamps)) {
-        vulkan_layer_producer_->EnqueueCaptureEvent(std::move(capture_event));
+        vulkan_layer_producer_->EnqueueGpuQueueSubmission(std::move(submission));
       }
     }
 
@@ -533,8 +552,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void ResetCommandBuffer(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
-    ResetCommandBufferUnsafe(command_buffer);
+    CommandBufferShard& shard = GetCommandBufferShard(command_buffer);
+    absl::WriterMutexLock lock(&shard.mutex);
+    ResetCommandBufferUnsafe(&shard, command_buffer);
   }
 
   void ResetCommandPool(VkCommandPool command_pool) {
@@ -554,6 +574,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
     absl::WriterMutexLock lock(&mutex_);
+    AllCommandBufferShardsLock shards_lock(&command_buffer_shards_);
     SetMaxLocalMarkerDepthPerCommandBuffer(
         capture_options.max_local_marker_depth_per_command_buffer());
     is_capturing_ = true;
@@ -563,32 +584,35 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   void OnCaptureFinished() override {
     absl::WriterMutexLock lock(&mutex_);
+    AllCommandBufferShardsLock shards_lock(&command_buffer_shards_);
     std::vector<uint32_t> slots_not_needed_to_read_anymore;
 
     VkDevice device = VK_NULL_HANDLE;
 
-    for (auto& [command_buffer, command_buffer_state] : command_buffer_to_state_) {
-      if (command_buffer_state.pre_submission_cpu_timestamp.has_value()) continue;
-      if (device == VK_NULL_HANDLE) {
-        CHECK(command_buffer_to_device_.contains(command_buffer));
-        device = command_buffer_to_device_.at(command_buffer);
-      }
-      if (command_buffer_state.command_buffer_begin_slot_index.has_value()) {
-        slots_not_needed_to_read_anymore.push_back(
-            command_buffer_state.command_buffer_begin_slot_index.value());
-        command_buffer_state.command_buffer_begin_slot_index.reset();
-      }
+    for (CommandBufferShard& shard : command_buffer_shards_) {
+      for (auto& [command_buffer, command_buffer_state] : shard.command_buffer_to_state) {
+        if (command_buffer_state.pre_submission_cpu_timestamp.has_value()) continue;
+        if (device == VK_NULL_HANDLE) {
+          CHECK(shard.command_buffer_to_device.contains(command_buffer));
+          device = shard.command_buffer_to_device.at(command_buffer);
+        }
+        if (command_buffer_state.command_buffer_begin_slot_index.has_value()) {
+          slots_not_needed_to_read_anymore.push_back(
+              command_buffer_state.command_buffer_begin_slot_index.value());
+          command_buffer_state.command_buffer_begin_slot_index.reset();
+        }
 
-      if (command_buffer_state.command_buffer_end_slot_index.has_value()) {
-        slots_not_needed_to_read_anymore.push_back(
-            command_buffer_state.command_buffer_end_slot_index.value());
-        command_buffer_state.command_buffer_end_slot_index.reset();
-      }
+        if (command_buffer_state.command_buffer_end_slot_index.has_value()) {
+          slots_not_needed_to_read_anymore.push_back(
+              command_buffer_state.command_buffer_end_slot_index.value());
+          command_buffer_state.command_buffer_end_slot_index.reset();
+        }
 
-      for (Marker& marker : command_buffer_state.markers) {
-        if (marker.slot_index.has_value()) {
-          slots_not_needed_to_read_anymore.push_back(marker.slot_index.value());
-          marker.slot_index.reset();
+        for (Marker& marker : command_buffer_state.markers) {
+          if (marker.slot_index.has_value()) {
+            slots_not_needed_to_read_anymore.push_back(marker.slot_index.value());
+            marker.slot_index.reset();
+          }
         }
       }
     }
@@ -640,35 +664,77 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     uint32_t local_marker_stack_size;
   };
 
-  bool RecordTimestamp(VkCommandBuffer command_buffer, VkPipelineStageFlagBits pipeline_stage_flags,
-                       uint32_t* slot_index) {
-    mutex_.AssertReaderHeld();
+  // Holds the state of all command buffers whose handle hashes to this shard. Vulkan requires the
+  // application to externally synchronize the recording into a command buffer, so threads
+  // recording into different command buffers will mostly end up on different shards and thus not
+  // block each other. The shards are aligned to cache lines to avoid false sharing of the mutexes.
+  struct alignas(64) CommandBufferShard {
+    absl::Mutex mutex;
+    absl::flat_hash_map<VkCommandBuffer, VkDevice> command_buffer_to_device;
+    absl::flat_hash_map<VkCommandBuffer, CommandBufferState> command_buffer_to_state;
+  };
+
+  static constexpr size_t kNumCommandBufferShards = 64;
+  using CommandBufferShards = std::array<CommandBufferShard, kNumCommandBufferShards>;
+
+  // Acquires the mutexes of all command buffer shards in index order and releases them in reverse
+  // order. This is needed when a consistent view over all command buffers is required (e.g. in
+  // `OnCaptureFinished`). Note that `mutex_` must always be acquired before any shard mutex.
+  class AllCommandBufferShardsLock {
+   public:
+    explicit AllCommandBufferShardsLock(CommandBufferShards* shards) : shards_(shards) {
+      for (CommandBufferShard& shard : *shards_) {
+        shard.mutex.Lock();
+      }
+    }
+    ~AllCommandBufferShardsLock() {
+      for (auto it = shards_->rbegin(); it != shards_->rend(); ++it) {
+        it->mutex.Unlock();
+      }
+    }
+    AllCommandBufferShardsLock(const AllCommandBufferShardsLock&) = delete;
+    AllCommandBufferShardsLock& operator=(const AllCommandBufferShardsLock&) = delete;
+
+   private:
+    CommandBufferShards* shards_;
+  };
+
+  [[nodiscard]] CommandBufferShard& GetCommandBufferShard(VkCommandBuffer command_buffer) {
+    return command_buffer_shards_[absl::Hash<VkCommandBuffer>{}(command_buffer) %
+                                  kNumCommandBufferShards];
+  }
+
+  bool RecordTimestamp(CommandBufferShard* shard, VkCommandBuffer command_buffer,
+                       VkPipelineStageFlagBits pipeline_stage_flags, uint32_t* slot_index) {
+    shard->mutex.AssertReaderHeld();
     VkDevice device;
     {
-      CHECK(command_buffer_to_device_.contains(command_buffer));
-      device = command_buffer_to_device_.at(command_buffer);
+      CHECK(shard->command_buffer_to_device.contains(command_buffer));
+      device = shard->command_buffer_to_device.at(command_buffer);
     }
 
-    VkQueryPool query_pool = timer_query_pool_->GetQueryPool(device);
-
     if (!timer_query_pool_->NextReadyQuerySlot(device, slot_index)) {
       // TODO(b/192998580): Send an appropriate CaptureEvent to notify the client that the Vulkan
       //  layer was out of query slots in a certain time range.
       return false;
     }
+    auto [query_pool, query_index] =
+        timer_query_pool_->GetQueryPoolAndQueryIndex(device, *slot_index);
     dispatch_table_->CmdWriteTimestamp(command_buffer)(command_buffer, pipeline_stage_flags,
-                                                       query_pool, *slot_index);
+                                                       query_pool, query_index);
 
     return true;
   }
 
-  std::optional<uint64_t> QueryGpuTimestampNs(VkDevice device, VkQueryPool query_pool,
-                                              uint32_t slot_index, float timestamp_period) {
+  std::optional<uint64_t> QueryGpuTimestampNs(VkDevice device, uint32_t slot_index,
+                                              float timestamp_period) {
     static constexpr VkDeviceSize kResultStride = sizeof(uint64_t);
 
+    auto [query_pool, query_index] =
+        timer_query_pool_->GetQueryPoolAndQueryIndex(device, slot_index);
     uint64_t timestamp = 0;
     VkResult result_status = dispatch_table_->GetQueryPoolResults(device)(
-        device, query_pool, slot_index, 1, sizeof(timestamp), &timestamp, kResultStride,
+        device, query_pool, query_index, 1, sizeof(timestamp), &timestamp, kResultStride,
         VK_QUERY_RESULT_64_BIT);
 
     if (result_status != VK_SUCCESS) {
@@ -679,24 +745,23 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   static void WriteMetaInfo(const SubmissionMetaInformation& meta_info,
-                            orbit_grpc_protos::GpuQueueSubmissionMetaInfo* target_proto) {
-    target_proto->set_tid(meta_info.thread_id);
-    target_proto->set_pid(meta_info.process_id);
-    target_proto->set_pre_submission_cpu_timestamp(meta_info.pre_submission_cpu_timestamp);
-    target_proto->set_post_submission_cpu_timestamp(meta_info.post_submission_cpu_timestamp);
+                            GpuQueueSubmissionMetaInfo* target) {
+    target->tid = meta_info.thread_id;
+    target->pid = meta_info.process_id;
+    target->pre_submission_cpu_timestamp = meta_info.pre_submission_cpu_timestamp;
+    target->post_submission_cpu_timestamp = meta_info.post_submission_cpu_timestamp;
   }
 
   [[nodiscard]] bool QuerySingleCommandBufferTimestamps(SubmittedCommandBuffer* command_buffer,
                                                         std::vector<uint32_t>* query_slots_to_reset,
-                                                        VkDevice device, VkQueryPool query_pool,
-                                                        float timestamp_period) {
+                                                        VkDevice device, float timestamp_period) {
     CHECK(command_buffer != nullptr);
 
     if (!command_buffer->end_timestamp.has_value()) {
       CHECK(command_buffer->command_buffer_end_slot_index.has_value());
       uint32_t slot_index = command_buffer->command_buffer_end_slot_index.value();
       std::optional<uint64_t> end_timestamp =
-          QueryGpuTimestampNs(device, query_pool, slot_index, timestamp_period);
+          QueryGpuTimestampNs(device, slot_index, timestamp_period);
       if (end_timestamp.has_value()) {
         command_buffer->end_timestamp = end_timestamp;
         query_slots_to_reset->push_back(slot_index);
@@ -714,7 +779,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     if (!command_buffer->begin_timestamp.has_value()) {
       uint32_t slot_index = command_buffer->command_buffer_begin_slot_index.value();
       std::optional<uint64_t> begin_timestamp =
-          QueryGpuTimestampNs(device, query_pool, slot_index, timestamp_period);
+          QueryGpuTimestampNs(device, slot_index, timestamp_period);
       if (begin_timestamp.has_value()) {
         command_buffer->begin_timestamp = begin_timestamp;
         query_slots_to_reset->push_back(slot_index);
@@ -728,12 +793,11 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   [[nodiscard]] bool QueryCommandBufferTimestamps(QueueSubmission* completed_submission,
                                                   std::vector<uint32_t>* query_slots_to_reset,
-                                                  VkDevice device, VkQueryPool query_pool,
-                                                  float timestamp_period) {
+                                                  VkDevice device, float timestamp_period) {
     for (auto& completed_submit : completed_submission->submit_infos) {
       for (auto& completed_command_buffer : completed_submit.command_buffers) {
         bool queries_succeeded = QuerySingleCommandBufferTimestamps(
-            &completed_command_buffer, query_slots_to_reset, device, query_pool, timestamp_period);
+            &completed_command_buffer, query_slots_to_reset, device, timestamp_period);
         if (!queries_succeeded) return false;
       }
     }
@@ -742,13 +806,12 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   [[nodiscard]] bool QuerySingleDebugMarkerTimestamps(SubmittedMarkerSlice* marker_slice,
                                                       std::vector<uint32_t>* query_slots_to_reset,
-                                                      VkDevice device, VkQueryPool query_pool,
-                                                      float timestamp_period) {
+                                                      VkDevice device, float timestamp_period) {
     CHECK(marker_slice != nullptr);
 
     if (!marker_slice->end_info.timestamp.has_value()) {
       std::optional<uint64_t> end_timestamp = QueryGpuTimestampNs(
-          device, query_pool, marker_slice->end_info.slot_index, timestamp_period);
+          device, marker_slice->end_info.slot_index, timestamp_period);
       if (end_timestamp.has_value()) {
         marker_slice->end_info.timestamp = end_timestamp;
         query_slots_to_reset->push_back(marker_slice->end_info.slot_index);
@@ -763,7 +826,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
     if (!marker_slice->begin_info->timestamp.has_value()) {
       std::optional<uint64_t> begin_timestamp = QueryGpuTimestampNs(
-          device, query_pool, marker_slice->begin_info->slot_index, timestamp_period);
+          device, marker_slice->begin_info->slot_index, timestamp_period);
       if (begin_timestamp.has_value()) {
         marker_slice->begin_info->timestamp = begin_timestamp;
         query_slots_to_reset->push_back(marker_slice->begin_info->slot_index);
@@ -776,39 +839,36 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   [[nodiscard]] bool QueryDebugMarkerTimestamps(QueueSubmission* completed_submission,
                                                 std::vector<uint32_t>* query_slots_to_reset,
-                                                VkDevice device, VkQueryPool query_pool,
-                                                float timestamp_period) {
+                                                VkDevice device, float timestamp_period) {
     for (auto& marker_slice : completed_submission->completed_markers) {
       bool queries_succeeded = QuerySingleDebugMarkerTimestamps(
-          &marker_slice, query_slots_to_reset, device, query_pool, timestamp_period);
+          &marker_slice, query_slots_to_reset, device, timestamp_period);
       if (!queries_succeeded) return false;
     }
     return true;
   }
 
-  [[nodiscard]] bool WriteCommandBufferTimings(
-      const QueueSubmission& completed_submission,
-      orbit_grpc_protos::GpuQueueSubmission* submission_proto) {
+  [[nodiscard]] static bool WriteCommandBufferTimings(const QueueSubmission& completed_submission,
+                                                      GpuQueueSubmission* submission) {
     bool has_at_least_one_timestamp = false;
+    submission->submit_infos.reserve(completed_submission.submit_infos.size());
     for (const auto& completed_submit : completed_submission.submit_infos) {
-      orbit_grpc_protos::GpuSubmitInfo* submit_info_proto = submission_proto->add_submit_infos();
+      GpuSubmitInfo& submit_info = submission->submit_infos.emplace_back();
+      submit_info.command_buffers.reserve(completed_submit.command_buffers.size());
       for (const auto& completed_command_buffer : completed_submit.command_buffers) {
-        orbit_grpc_protos::GpuCommandBuffer* command_buffer_proto =
-            submit_info_proto->add_command_buffers();
+        GpuCommandBuffer& command_buffer = submit_info.command_buffers.emplace_back();
 
         if (completed_command_buffer.command_buffer_begin_slot_index.has_value()) {
           // This function must only be called once queries have actually succeeded. If this command
           // buffer has a slot index for the begin timestamp, we must have a value here.
           CHECK(completed_command_buffer.begin_timestamp.has_value());
-          command_buffer_proto->set_begin_gpu_timestamp_ns(
-              completed_command_buffer.begin_timestamp.value());
+          command_buffer.begin_gpu_timestamp_ns = completed_command_buffer.begin_timestamp.value();
         }
 
         // Similarly here, this function must only be called once timestamp queries have succeeded,
         // and therefore we must have an end timestamp here.
         CHECK(completed_command_buffer.end_timestamp.has_value());
-        command_buffer_proto->set_end_gpu_timestamp_ns(
-            completed_command_buffer.end_timestamp.value());
+        command_buffer.end_gpu_timestamp_ns = completed_command_buffer.end_timestamp.value();
 
         has_at_least_one_timestamp = true;
       }
@@ -817,18 +877,19 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   [[nodiscard]] bool WriteDebugMarkers(const QueueSubmission& completed_submission,
-                                       orbit_grpc_protos::GpuQueueSubmission* submission_proto) {
-    submission_proto->set_num_begin_markers(completed_submission.num_begin_markers);
+                                       GpuQueueSubmission* submission) {
+    submission->num_begin_markers = static_cast<int32_t>(completed_submission.num_begin_markers);
     bool has_at_least_one_timestamp = false;
+    submission->completed_markers.reserve(completed_submission.completed_markers.size());
     for (const auto& marker_state : completed_submission.completed_markers) {
       CHECK(marker_state.end_info.timestamp.has_value());
       uint64_t end_timestamp = marker_state.end_info.timestamp.value();
       has_at_least_one_timestamp = true;
 
-      orbit_grpc_protos::GpuDebugMarker* marker_proto = submission_proto->add_completed_markers();
+      GpuDebugMarker& marker = submission->completed_markers.emplace_back();
       if (vulkan_layer_producer_ != nullptr) {
-        marker_proto->set_text_key(
-            vulkan_layer_producer_->InternStringIfNecessaryAndGetKey(marker_state.label_name));
+        marker.text_key =
+            vulkan_layer_producer_->InternStringIfNecessaryAndGetKey(marker_state.label_name);
       }
 
       auto quantize = [](float value) { return static_cast<uint8_t>(value * 255.f); };
@@ -838,42 +899,37 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       // color.
       if (quantize(marker_state.color.red) != 0 || quantize(marker_state.color.green) != 0 ||
           quantize(marker_state.color.blue) != 0 || quantize(marker_state.color.alpha) != 0) {
-        auto* color = marker_proto->mutable_color();
-        color->set_red(marker_state.color.red);
-        color->set_green(marker_state.color.green);
-        color->set_blue(marker_state.color.blue);
-        color->set_alpha(marker_state.color.alpha);
+        marker.color = GpuDebugMarkerColor{marker_state.color.red, marker_state.color.green,
+                                           marker_state.color.blue, marker_state.color.alpha};
       }
-      marker_proto->set_depth(marker_state.depth);
-      marker_proto->set_end_gpu_timestamp_ns(end_timestamp);
+      marker.depth = static_cast<int32_t>(marker_state.depth);
+      marker.end_gpu_timestamp_ns = end_timestamp;
 
       // If we haven't captured the begin marker, we'll leave the optional begin_marker empty.
       if (!marker_state.begin_info.has_value()) {
         continue;
       }
-      orbit_grpc_protos::GpuDebugMarkerBeginInfo* begin_debug_marker_proto =
-          marker_proto->mutable_begin_marker();
-      WriteMetaInfo(marker_state.begin_info->meta_information,
-                    begin_debug_marker_proto->mutable_meta_info());
+      GpuDebugMarkerBeginInfo& begin_marker = marker.begin_marker.emplace();
+      WriteMetaInfo(marker_state.begin_info->meta_information, &begin_marker.meta_info);
 
       CHECK(marker_state.begin_info->timestamp.has_value());
-      uint64_t begin_timestamp = marker_state.begin_info->timestamp.value();
-      begin_debug_marker_proto->set_gpu_timestamp_ns(begin_timestamp);
+      begin_marker.gpu_timestamp_ns = marker_state.begin_info->timestamp.value();
     }
 
     return has_at_least_one_timestamp;
   }
 
-  // This method does not acquire a lock and MUST NOT be called without holding the `mutex_`.
-  void ResetCommandBufferUnsafe(VkCommandBuffer command_buffer) {
-    mutex_.AssertHeld();
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+  // This method does not acquire a lock and MUST NOT be called without holding the mutex of the
+  // `shard` the command buffer belongs to.
+  void ResetCommandBufferUnsafe(CommandBufferShard* shard, VkCommandBuffer command_buffer) {
+    shard->mutex.AssertHeld();
+    if (!shard->command_buffer_to_state.contains(command_buffer)) {
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
-    CHECK(command_buffer_to_device_.contains(command_buffer));
-    VkDevice device = command_buffer_to_device_.at(command_buffer);
+    CHECK(shard->command_buffer_to_state.contains(command_buffer));
+    CommandBufferState& state = shard->command_buffer_to_state.at(command_buffer);
+    CHECK(shard->command_buffer_to_device.contains(command_buffer));
+    VkDevice device = shard->command_buffer_to_device.at(command_buffer);
     std::vector<uint32_t> query_slots_to_reset{};
     if (state.command_buffer_begin_slot_index.has_value()) {
       query_slots_to_reset.push_back(state.command_buffer_begin_slot_index.value());
@@ -892,26 +948,28 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       timer_query_pool_->RollbackPendingQuerySlots(device, query_slots_to_reset);
     }
 
-    command_buffer_to_state_.erase(command_buffer);
+    shard->command_buffer_to_state.erase(command_buffer);
   }
 
-  void PersistSingleCommandBufferOnSubmit(VkDevice device, VkCommandBuffer command_buffer,
+  void PersistSingleCommandBufferOnSubmit(CommandBufferShard* shard, VkDevice device,
+                                          VkCommandBuffer command_buffer,
                                           QueueSubmission* queue_submission,
                                           SubmitInfo* submitted_submit_info,
                                           std::vector<uint32_t>* query_slots_not_needed_to_read) {
     mutex_.AssertHeld();
+    shard->mutex.AssertHeld();
     CHECK(queue_submission != nullptr);
     CHECK(submitted_submit_info != nullptr);
     CHECK(query_slots_not_needed_to_read != nullptr);
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard->command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkQueueSubmit on a command buffer that is in the initial state (i.e. "
           "either freshly allocated or reset with vkResetCommandBuffer).");
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CHECK(shard->command_buffer_to_state.contains(command_buffer));
+    CommandBufferState& state = shard->command_buffer_to_state.at(command_buffer);
     bool has_been_submitted_before = state.pre_submission_cpu_timestamp.has_value();
 
     // Mark that this command buffer in the current state was already submitted. If the command
@@ -926,7 +984,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
         queue_submission->meta_information.pre_submission_cpu_timestamp;
 
     if (device == VK_NULL_HANDLE) {
-      device = command_buffer_to_device_.at(command_buffer);
+      device = shard->command_buffer_to_device.at(command_buffer);
     }
 
     // If we haven't recorded neither the end nor the begin of a command buffer, we have no
@@ -954,21 +1012,23 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void PersistDebugMarkersOfASingleCommandBufferOnSubmit(
-      VkCommandBuffer command_buffer, std::optional<QueueSubmission>* queue_submission_optional,
-      QueueMarkerState* markers, std::vector<uint32_t>* marker_slots_not_needed_to_read) {
+      CommandBufferShard* shard, VkCommandBuffer command_buffer,
+      std::optional<QueueSubmission>* queue_submission_optional, QueueMarkerState* markers,
+      std::vector<uint32_t>* marker_slots_not_needed_to_read) {
     mutex_.AssertHeld();
+    shard->mutex.AssertHeld();
     CHECK(queue_submission_optional != nullptr);
     CHECK(markers != nullptr);
     CHECK(marker_slots_not_needed_to_read != nullptr);
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard->command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkQueueSubmit on a command buffer that is in the initial state (i.e. "
           "either freshly allocated or reset with vkResetCommandBuffer).");
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    const CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CHECK(shard->command_buffer_to_state.contains(command_buffer));
+    const CommandBufferState& state = shard->command_buffer_to_state.at(command_buffer);
 
     for (const Marker& marker : state.markers) {
       std::optional<SubmittedMarker> submitted_marker = std::nullopt;
@@ -1032,11 +1092,12 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
   }
 
+  // Guards the command pools as well as the per-queue state (markers and pending submissions).
+  // Must be acquired before any of the mutexes in `command_buffer_shards_`.
   absl::Mutex mutex_;
   absl::flat_hash_map<VkCommandPool, absl::flat_hash_set<VkCommandBuffer>> pool_to_command_buffers_;
-  absl::flat_hash_map<VkCommandBuffer, VkDevice> command_buffer_to_device_;
 
-  absl::flat_hash_map<VkCommandBuffer, CommandBufferState> command_buffer_to_state_;
+  CommandBufferShards command_buffer_shards_;
 
   static constexpr auto kPreSubmissionCpuTimestampComparator =
       [](const QueueSubmission& lhs, const QueueSubmission& rhs) -> bool {
@@ -1056,7 +1117,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   // We use std::numeric_limits<uint32_t>::max() to disable filtering of markers and 0 to discard
   // all debug markers.
-  uint32_t max_local_marker_depth_per_command_buffer_ = std::numeric_limits<uint32_t>::max();
+  std::atomic<uint32_t> max_local_marker_depth_per_command_buffer_ =
+      std::numeric_limits<uint32_t>::max();
   VulkanLayerProducer* vulkan_layer_producer_ = nullptr;
 
   // This boolean is precisely true between a call to OnCaptureStart and OnCaptureFinished. In
@@ -1065,7 +1127,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // command buffers and debug markers. A consistent state allows proper cleanup of query slots
   // either in OnCaptureFinished or when completing submits. Note that calling
   // vulkan_layer_producer_->IsCapturing() is not a correct replacement for checking this boolean.
-  bool is_capturing_ = false;
+  // It is only written while holding `mutex_` and the mutexes of all command buffer shards, so
+  // reading it while holding any of those is consistent with the state of the command buffers.
+  std::atomic<bool> is_capturing_ = false;
 };
 
 }  // namespace orbit_vulkan_layer
@@ -7,6 +7,9 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include "OrbitBase/ThreadUtils.h"
 #include "SubmissionTracker.h"
@@ -32,7 +35,8 @@ PFN_vkCmdWriteTimestamp dummy_write_timestamp_function =
 
 class MockTimerQueryPool {
  public:
-  MOCK_METHOD(VkQueryPool, GetQueryPool, (VkDevice), ());
+  MOCK_METHOD((std::pair<VkQueryPool, uint32_t>), GetQueryPoolAndQueryIndex, (VkDevice, uint32_t),
+              ());
   MOCK_METHOD(void, MarkQuerySlotsForReset, (VkDevice, const std::vector<uint32_t>&), ());
   MOCK_METHOD(void, MarkQuerySlotsDoneReading, (VkDevice, const std::vector<uint32_t>&), ());
   MOCK_METHOD(void, RollbackPendingQuerySlots, (VkDevice, const std::vector<uint32_t>&), ());
@@ -50,8 +54,14 @@ class MockVulkanLayerProducer : public VulkanLayerProducer {
  public:
   MOCK_METHOD(bool, IsCapturing, (), (override));
   MOCK_METHOD(uint64_t, InternStringIfNecessaryAndGetKey, (std::string), (override));
+  // Translate the submission right away, so that tests can verify the proto that would be sent.
+  bool EnqueueGpuQueueSubmission(GpuQueueSubmission&& submission) override {
+    orbit_grpc_protos::ProducerCaptureEvent capture_event;
+    WriteGpuQueueSubmissionProto(submission, capture_event.mutable_gpu_queue_submission());
+    return EnqueueCaptureEvent(std::move(capture_event));
+  }
   MOCK_METHOD(bool, EnqueueCaptureEvent, (orbit_grpc_protos::ProducerCaptureEvent && capture_event),
-              (override));
+              ());
 
   MOCK_METHOD(void, BringUp, (const std::shared_ptr<grpc::Channel>& channel), (override));
   MOCK_METHOD(void, TakeDown, (), (override));
@@ -105,7 +115,12 @@ class SubmissionTrackerTest : public ::testing::Test {
     tracker_.SetVulkanLayerProducer(producer_.get());
     auto is_capturing_function = [this]() -> bool { return producer_->is_capturing_; };
     EXPECT_CALL(*producer_, IsCapturing).WillRepeatedly(Invoke(is_capturing_function));
-    EXPECT_CALL(timer_query_pool_, GetQueryPool).WillRepeatedly(Return(query_pool_));
+    auto get_query_pool_and_query_index_function = [this](VkDevice /*device*/,
+                                                          uint32_t slot_index) {
+      return std::make_pair(query_pool_, slot_index);
+    };
+    EXPECT_CALL(timer_query_pool_, GetQueryPoolAndQueryIndex)
+        .WillRepeatedly(Invoke(get_query_pool_and_query_index_function));
     EXPECT_CALL(device_manager_, GetPhysicalDeviceOfLogicalDevice)
         .WillRepeatedly(Return(physical_device_));
     EXPECT_CALL(device_manager_, GetPhysicalDeviceProperties)
@@ -1863,4 +1878,97 @@ TEST_F(SubmissionTrackerTest, WillWriteTimestampEvenWhenCommandBufferIsNotInInit
 
   EXPECT_THAT(actual_slots_to_reset, UnorderedElementsAre(kSlotIndex1, kSlotIndex2));
 }
+
+TEST_F(SubmissionTrackerTest, CanRecordDistinctCommandBuffersFromMultipleThreads) {
+  constexpr uint32_t kNumThreads = 8;
+  constexpr uint32_t kNumCommandBuffersPerThread = 64;
+  constexpr uint32_t kNumCommandBuffers = kNumThreads * kNumCommandBuffersPerThread;
+
+  std::atomic<uint32_t> next_slot_index = 0;
+  auto mock_next_ready_query_slot = [&next_slot_index](VkDevice /*device*/,
+                                                        uint32_t* allocated_slot) {
+    *allocated_slot = next_slot_index++;
+    return true;
+  };
+  // Two timestamps for the command buffer and two for the debug marker.
+  EXPECT_CALL(timer_query_pool_, NextReadyQuerySlot)
+      .Times(4 * kNumCommandBuffers)
+      .WillRepeatedly(Invoke(mock_next_ready_query_slot));
+  // Every slot is ready and simply returns its index as timestamp.
+  PFN_vkGetQueryPoolResults mock_get_query_pool_results_function =
+      +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
+          uint32_t /*query_count*/, size_t /*dataSize*/, void* data, VkDeviceSize /*stride*/,
+          VkQueryResultFlags /*flags*/) -> VkResult {
+    *absl::bit_cast<uint64_t*>(data) = first_query;
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(dispatch_table_, GetQueryPoolResults)
+      .WillRepeatedly(Return(mock_get_query_pool_results_function));
+  std::vector<uint32_t> actual_slots_done_reading;
+  EXPECT_CALL(timer_query_pool_, MarkQuerySlotsDoneReading)
+      .Times(1)
+      .WillOnce(SaveArg<1>(&actual_slots_done_reading));
+  EXPECT_CALL(*producer_, InternStringIfNecessaryAndGetKey).WillRepeatedly(Return(42));
+  orbit_grpc_protos::ProducerCaptureEvent actual_capture_event;
+  auto mock_enqueue_capture_event =
+      [&actual_capture_event](orbit_grpc_protos::ProducerCaptureEvent&& capture_event) {
+        actual_capture_event = std::move(capture_event);
+        return true;
+      };
+  EXPECT_CALL(*producer_, EnqueueCaptureEvent)
+      .Times(1)
+      .WillOnce(Invoke(mock_enqueue_capture_event));
+
+  std::vector<VkCommandBuffer> command_buffers(kNumCommandBuffers);
+  for (uint32_t i = 0; i < kNumCommandBuffers; ++i) {
+    command_buffers[i] = absl::bit_cast<VkCommandBuffer>(static_cast<uintptr_t>(i + 1));
+  }
+  tracker_.TrackCommandBuffers(device_, command_pool_, command_buffers.data(), kNumCommandBuffers);
+
+  producer_->StartCapture();
+  std::vector<std::thread> recording_threads;
+  for (uint32_t thread_index = 0; thread_index < kNumThreads; ++thread_index) {
+    recording_threads.emplace_back([this, thread_index, &command_buffers] {
+      for (uint32_t i = 0; i < kNumCommandBuffersPerThread; ++i) {
+        VkCommandBuffer command_buffer =
+            command_buffers[thread_index * kNumCommandBuffersPerThread + i];
+        tracker_.MarkCommandBufferBegin(command_buffer);
+        tracker_.MarkDebugMarkerBegin(command_buffer, "Text", {1.f, 1.f, 1.f, 1.f});
+        tracker_.MarkDebugMarkerEnd(command_buffer);
+        tracker_.MarkCommandBufferEnd(command_buffer);
+      }
+    });
+  }
+  for (std::thread& thread : recording_threads) {
+    thread.join();
+  }
+
+  VkSubmitInfo submit_info = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                              .pNext = nullptr,
+                              .commandBufferCount = kNumCommandBuffers,
+                              .pCommandBuffers = command_buffers.data()};
+  std::optional<QueueSubmission> queue_submission_optional =
+      tracker_.PersistCommandBuffersOnSubmit(queue_, 1, &submit_info);
+  tracker_.PersistDebugMarkersOnSubmit(queue_, 1, &submit_info, queue_submission_optional);
+  tracker_.CompleteSubmits(device_);
+
+  EXPECT_EQ(actual_slots_done_reading.size(), 4 * kNumCommandBuffers);
+  ASSERT_TRUE(actual_capture_event.has_gpu_queue_submission());
+  const orbit_grpc_protos::GpuQueueSubmission& actual_queue_submission =
+      actual_capture_event.gpu_queue_submission();
+  ASSERT_EQ(actual_queue_submission.submit_infos_size(), 1);
+  ASSERT_EQ(actual_queue_submission.submit_infos(0).command_buffers_size(), kNumCommandBuffers);
+  for (const orbit_grpc_protos::GpuCommandBuffer& command_buffer :
+       actual_queue_submission.submit_infos(0).command_buffers()) {
+    EXPECT_LT(command_buffer.begin_gpu_timestamp_ns(), command_buffer.end_gpu_timestamp_ns());
+  }
+  EXPECT_EQ(actual_queue_submission.num_begin_markers(), kNumCommandBuffers);
+  ASSERT_EQ(actual_queue_submission.completed_markers_size(), kNumCommandBuffers);
+  for (const orbit_grpc_protos::GpuDebugMarker& marker :
+       actual_queue_submission.completed_markers()) {
+    EXPECT_EQ(marker.depth(), 0);
+    ASSERT_TRUE(marker.has_begin_marker());
+    EXPECT_LT(marker.begin_marker().gpu_timestamp_ns(), marker.end_gpu_timestamp_ns());
+  }
+}
 }  // namespace orbit_vulkan_layer
@@ -10,8 +10,10 @@
 #include <absl/synchronization/mutex.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <fstream>
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include "OrbitBase/Logging.h"
@@ -24,6 +26,14 @@ namespace orbit_vulkan_layer {
 // indices.
 // In order to do so, it stores the internal `SlotState` for each index.
 //
+// The slots of a device are backed by one or more `VkQueryPool`s of
+// `num_timer_query_slots_per_pool` queries each. Initially, only one such pool is created. When
+// all slots are occupied, an additional pool is created on demand, until
+// `max_num_query_pools_per_device` is reached. Slot indices are contiguous across the pools, i.e.
+// slot `i` is backed by the query `i % num_timer_query_slots_per_pool` of the pool
+// `i / num_timer_query_slots_per_pool`. Use `GetQueryPoolAndQueryIndex` to resolve a slot index to
+// the Vulkan query.
+//
 // Slots can be requested using `NextReadyQuerySlot, which will block them until being reset again.
 // If the command buffer storing the slot index gets reset before it was even submitted,
 // `RollbackPendingQuerySlots` can be called to mark the slot as being free (ready) again without
@@ -57,80 +67,93 @@ namespace orbit_vulkan_layer {
 template <class DispatchTable>
 class TimerQueryPool {
  public:
-  explicit TimerQueryPool(DispatchTable* dispatch_table, uint32_t num_timer_query_slots)
-      : dispatch_table_(dispatch_table), num_timer_query_slots_(num_timer_query_slots) {}
+  // Utilization counters of the slots of a device, see `GetSlotUtilization`.
+  struct SlotUtilization {
+    // The number of slots of all `VkQueryPool`s created so far.
+    uint32_t num_slots = 0;
+    // The number of slots that are currently not ready for a query to be issued.
+    uint32_t num_occupied_slots = 0;
+    // The maximum of `num_occupied_slots` since the initialization.
+    uint32_t max_num_occupied_slots = 0;
+    // The number of calls to `NextReadyQuerySlot` that failed, as all slots were occupied.
+    uint64_t num_failed_slot_requests = 0;
+  };
+
+  explicit TimerQueryPool(DispatchTable* dispatch_table, uint32_t num_timer_query_slots_per_pool,
+                          uint32_t max_num_query_pools_per_device = 1)
+      : dispatch_table_(dispatch_table),
+        num_timer_query_slots_per_pool_(num_timer_query_slots_per_pool),
+        max_num_query_pools_per_device_(max_num_query_pools_per_device) {
+    CHECK(max_num_query_pools_per_device_ > 0);
+  }
 
   // Creates and resets a vulkan `VkQueryPool`, ready to use for timestamp queries.
   void InitializeTimerQueryPool(VkDevice device) {
-    VkQueryPool query_pool;
-
-    VkQueryPoolCreateInfo create_info = {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
-                                         .pNext = nullptr,
-                                         .flags = 0,
-                                         .queryType = VK_QUERY_TYPE_TIMESTAMP,
-                                         .queryCount = num_timer_query_slots_,
-                                         .pipelineStatistics = 0};
-
-    VkResult result =
-        dispatch_table_->CreateQueryPool(device)(device, &create_info, nullptr, &query_pool);
-    CHECK(result == VK_SUCCESS);
-
-    dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, 0, num_timer_query_slots_);
-
-    {
-      absl::WriterMutexLock lock(&mutex_);
-      CHECK(!device_to_query_pool_.contains(device));
-      device_to_query_pool_[device] = query_pool;
-      std::vector<SlotState> slots{num_timer_query_slots_};
-      std::fill(slots.begin(), slots.end(), SlotState::kReadyForQueryIssue);
-      device_to_query_slots_[device] = slots;
-      std::vector<uint32_t> free_slots(num_timer_query_slots_);
-      // At the beginning all slot indices in [0, num_timer_query_slots) are free.
-      std::iota(free_slots.begin(), free_slots.end(), 0);
-      device_to_free_slots_[device] = free_slots;
-    }
+    absl::WriterMutexLock lock(&mutex_);
+    CHECK(!device_to_state_.contains(device));
+    DeviceState& device_state = device_to_state_[device];
+    AddQueryPool(device, &device_state);
   }
 
-  // Destroys the VkQueryPool for the given device
+  // Destroys the VkQueryPools for the given device
   void DestroyTimerQueryPool(VkDevice device) {
     absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_pool_.contains(device));
-    VkQueryPool query_pool = device_to_query_pool_.at(device);
-    device_to_query_slots_.erase(device);
-    device_to_free_slots_.erase(device);
-
-    dispatch_table_->DestroyQueryPool(device)(device, query_pool, nullptr);
+    CHECK(device_to_state_.contains(device));
+    const DeviceState& device_state = device_to_state_.at(device);
+    LOG("Timer query slots of device %p: %u slots, at most %u occupied, %u failed requests",
+        static_cast<void*>(device), device_state.slot_states.size(),
+        device_state.utilization.max_num_occupied_slots,
+        device_state.utilization.num_failed_slot_requests);
+    for (VkQueryPool query_pool : device_state.query_pools) {
+      dispatch_table_->DestroyQueryPool(device)(device, query_pool, nullptr);
+    }
 
-    device_to_query_pool_.erase(device);
+    device_to_state_.erase(device);
   }
 
-  // Retrieves the query pool for a given device. Note that the pool must be initialized using
+  // Resolves a slot index (as returned by `NextReadyQuerySlot`) to the `VkQueryPool` backing that
+  // slot and the index of the query within that pool. Note that the pool must be initialized using
   // `InitializeTimerQueryPool` before.
-  [[nodiscard]] VkQueryPool GetQueryPool(VkDevice device) {
+  [[nodiscard]] std::pair<VkQueryPool, uint32_t> GetQueryPoolAndQueryIndex(VkDevice device,
+                                                                           uint32_t slot_index) {
     absl::ReaderMutexLock lock(&mutex_);
-    CHECK(device_to_query_pool_.contains(device));
-    return device_to_query_pool_.at(device);
+    CHECK(device_to_state_.contains(device));
+    const DeviceState& device_state = device_to_state_.at(device);
+    uint32_t pool_index = slot_index / num_timer_query_slots_per_pool_;
+    CHECK(pool_index < device_state.query_pools.size());
+    return std::make_pair(device_state.query_pools[pool_index],
+                          slot_index % num_timer_query_slots_per_pool_);
   }
 
-  // Returns a free query slot from the device's pool if one still exists. It returns `false` if all
-  // slots are occupied and true otherwise. If successful, the index will be written to the given
-  // `allocated_index`.
+  // Returns a free query slot from the device's pools if one still exists. If all slots are
+  // occupied, it will try to create an additional `VkQueryPool`. It returns `false` if all slots
+  // are occupied and no further pool can be created and true otherwise. If successful, the index
+  // will be written to the given `allocated_index`.
   //
   // Note that the pool must be initialized using `InitializeTimerQueryPool` before.
   // See also `ResetQuerySlots` to make occupied slots available again.
   [[nodiscard]] bool NextReadyQuerySlot(VkDevice device, uint32_t* allocated_index) {
     absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_free_slots_.contains(device));
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    CHECK(device_to_state_.contains(device));
+    DeviceState& device_state = device_to_state_.at(device);
+    if (device_state.free_slots.empty() &&
+        device_state.query_pools.size() < max_num_query_pools_per_device_) {
+      AddQueryPool(device, &device_state);
+    }
+    std::vector<uint32_t>& free_slots = device_state.free_slots;
     if (free_slots.empty()) {
+      ++device_state.utilization.num_failed_slot_requests;
       return false;
     }
     *allocated_index = free_slots.back();
     free_slots.pop_back();
 
-    CHECK(device_to_query_slots_.at(device)[*allocated_index] == SlotState::kReadyForQueryIssue);
-    device_to_query_slots_.at(device)[*allocated_index] = SlotState::kQueryPendingOnGpu;
+    CHECK(device_state.slot_states[*allocated_index] == SlotState::kReadyForQueryIssue);
+    device_state.slot_states[*allocated_index] = SlotState::kQueryPendingOnGpu;
+    SlotUtilization& utilization = device_state.utilization;
+    ++utilization.num_occupied_slots;
+    utilization.max_num_occupied_slots =
+        std::max(utilization.max_num_occupied_slots, utilization.num_occupied_slots);
     return true;
   }
 
@@ -150,22 +173,18 @@ class TimerQueryPool {
       return;
     }
     absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
-    CHECK(device_to_free_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    CHECK(device_to_state_.contains(device));
+    DeviceState& device_state = device_to_state_.at(device);
+    std::vector<SlotState>& slot_states = device_state.slot_states;
     for (uint32_t slot_index : slot_indices) {
-      CHECK(slot_index < num_timer_query_slots_);
+      CHECK(slot_index < slot_states.size());
       const SlotState& current_state = slot_states[slot_index];
       if (current_state == SlotState::kQueryPendingOnGpu) {
         slot_states[slot_index] = SlotState::kDoneReading;
         continue;
       }
       CHECK(current_state == SlotState::kResetRequested);
-      slot_states[slot_index] = SlotState::kReadyForQueryIssue;
-      free_slots.push_back(slot_index);
-      VkQueryPool query_pool = device_to_query_pool_.at(device);
-      dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, slot_index, 1);
+      ResetSlot(device, &device_state, slot_index);
     }
   }
 
@@ -185,22 +204,18 @@ class TimerQueryPool {
       return;
     }
     absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
-    CHECK(device_to_free_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    CHECK(device_to_state_.contains(device));
+    DeviceState& device_state = device_to_state_.at(device);
+    std::vector<SlotState>& slot_states = device_state.slot_states;
     for (uint32_t slot_index : slot_indices) {
-      CHECK(slot_index < num_timer_query_slots_);
+      CHECK(slot_index < slot_states.size());
       const SlotState& current_state = slot_states[slot_index];
       if (current_state == SlotState::kQueryPendingOnGpu) {
         slot_states[slot_index] = SlotState::kResetRequested;
         continue;
       }
       CHECK(current_state == SlotState::kDoneReading);
-      slot_states[slot_index] = SlotState::kReadyForQueryIssue;
-      free_slots.push_back(slot_index);
-      VkQueryPool query_pool = device_to_query_pool_.at(device);
-      dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, slot_index, 1);
+      ResetSlot(device, &device_state, slot_index);
     }
   }
 
@@ -217,19 +232,30 @@ class TimerQueryPool {
       return;
     }
     absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
-    CHECK(device_to_free_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    CHECK(device_to_state_.contains(device));
+    DeviceState& device_state = device_to_state_.at(device);
+    std::vector<SlotState>& slot_states = device_state.slot_states;
     for (uint32_t slot_index : slot_indices) {
-      CHECK(slot_index < num_timer_query_slots_);
+      CHECK(slot_index < slot_states.size());
       const SlotState& current_state = slot_states[slot_index];
       CHECK(current_state == SlotState::kQueryPendingOnGpu);
       slot_states[slot_index] = SlotState::kReadyForQueryIssue;
-      free_slots.push_back(slot_index);
+      device_state.free_slots.push_back(slot_index);
+      --device_state.utilization.num_occupied_slots;
     }
   }
 
+  // Returns the utilization counters of the slots of the given device. Note that the pool must be
+  // initialized using `InitializeTimerQueryPool` before.
+  [[nodiscard]] SlotUtilization GetSlotUtilization(VkDevice device) {
+    absl::ReaderMutexLock lock(&mutex_);
+    CHECK(device_to_state_.contains(device));
+    const DeviceState& device_state = device_to_state_.at(device);
+    SlotUtilization utilization = device_state.utilization;
+    utilization.num_slots = device_state.slot_states.size();
+    return utilization;
+  }
+
  private:
   enum class SlotState {
     kReadyForQueryIssue = 0,
@@ -238,14 +264,63 @@ class TimerQueryPool {
     kResetRequested = 3
   };
 
+  struct DeviceState {
+    std::vector<VkQueryPool> query_pools;
+    std::vector<SlotState> slot_states;
+    std::vector<uint32_t> free_slots;
+    SlotUtilization utilization;
+  };
+
+  // Creates an additional `VkQueryPool` for the device, resets it and makes its slots available.
+  void AddQueryPool(VkDevice device, DeviceState* device_state) {
+    mutex_.AssertHeld();
+    VkQueryPool query_pool;
+
+    VkQueryPoolCreateInfo create_info = {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                         .pNext = nullptr,
+                                         .flags = 0,
+                                         .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                         .queryCount = num_timer_query_slots_per_pool_,
+                                         .pipelineStatistics = 0};
+
+    VkResult result =
+        dispatch_table_->CreateQueryPool(device)(device, &create_info, nullptr, &query_pool);
+    CHECK(result == VK_SUCCESS);
+
+    dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, 0,
+                                               num_timer_query_slots_per_pool_);
+
+    const uint32_t first_slot_index = device_state->slot_states.size();
+    device_state->query_pools.push_back(query_pool);
+    device_state->slot_states.resize(first_slot_index + num_timer_query_slots_per_pool_,
+                                     SlotState::kReadyForQueryIssue);
+    // All the slot indices of the new pool are free. Add them in reverse order, such that the
+    // lower indices get handed out first.
+    std::vector<uint32_t>& free_slots = device_state->free_slots;
+    const size_t num_previously_free_slots = free_slots.size();
+    free_slots.resize(num_previously_free_slots + num_timer_query_slots_per_pool_);
+    std::iota(free_slots.rbegin(), free_slots.rbegin() + num_timer_query_slots_per_pool_,
+              first_slot_index);
+  }
+
+  void ResetSlot(VkDevice device, DeviceState* device_state, uint32_t slot_index) {
+    mutex_.AssertHeld();
+    device_state->slot_states[slot_index] = SlotState::kReadyForQueryIssue;
+    device_state->free_slots.push_back(slot_index);
+    --device_state->utilization.num_occupied_slots;
+    VkQueryPool query_pool =
+        device_state->query_pools[slot_index / num_timer_query_slots_per_pool_];
+    dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool,
+                                               slot_index % num_timer_query_slots_per_pool_, 1);
+  }
+
   DispatchTable* dispatch_table_;
-  const uint32_t num_timer_query_slots_;
+  const uint32_t num_timer_query_slots_per_pool_;
+  const uint32_t max_num_query_pools_per_device_;
 
   absl::Mutex mutex_;
 
-  absl::flat_hash_map<VkDevice, VkQueryPool> device_to_query_pool_;
-  absl::flat_hash_map<VkDevice, std::vector<SlotState>> device_to_query_slots_;
-  absl::flat_hash_map<VkDevice, std::vector<uint32_t>> device_to_free_slots_;
+  absl::flat_hash_map<VkDevice, DeviceState> device_to_state_;
 };
 }  // namespace orbit_vulkan_layer
 
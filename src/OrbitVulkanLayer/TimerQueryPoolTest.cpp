@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/base/casts.h>
 #include <absl/container/flat_hash_set.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -41,7 +42,7 @@ TEST(TimerQueryPool, ATimerQueryPoolMustGetInitialized) {
 
   uint32_t slot_index = 32;
   std::vector<uint32_t> reset_slots;
-  EXPECT_DEATH({ (void)query_pool.GetQueryPool(device); }, "");
+  EXPECT_DEATH({ (void)query_pool.GetQueryPoolAndQueryIndex(device, 0); }, "");
   EXPECT_DEATH({ (void)query_pool.NextReadyQuerySlot(device, &slot_index); }, "");
   reset_slots.push_back(slot_index);
   EXPECT_DEATH({ (void)query_pool.MarkQuerySlotsDoneReading(device, reset_slots); }, "");
@@ -133,8 +134,9 @@ TEST(TimerQueryPool, QueryPoolCanBeRetrievedAfterInitialization) {
 
   query_pool.InitializeTimerQueryPool(device);
 
-  VkQueryPool vulkan_query_pool = query_pool.GetQueryPool(device);
+  auto [vulkan_query_pool, query_index] = query_pool.GetQueryPoolAndQueryIndex(device, 1);
   EXPECT_EQ(vulkan_query_pool, expected_vulkan_query_pool);
+  EXPECT_EQ(query_index, 1);
 }
 
 TEST(TimerQueryPool, CanRetrieveNumSlotsUniqueSlots) {
@@ -184,6 +186,102 @@ TEST(TimerQueryPool, CannotRetrieveMoreThanNumSlotsSlots) {
   ASSERT_FALSE(found_slot);
 }
 
+TEST(TimerQueryPool, CreatesAdditionalPoolsWhenAllSlotsAreOccupied) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlotsPerPool = 4;
+  static constexpr uint32_t kMaxNumPools = 2;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlotsPerPool, kMaxNumPools);
+  VkDevice device = {};
+
+  PFN_vkCreateQueryPool mock_create_query_pool_function =
+      +[](VkDevice /*device*/, const VkQueryPoolCreateInfo* create_info,
+          const VkAllocationCallbacks* /*allocator*/, VkQueryPool* query_pool_out) -> VkResult {
+    EXPECT_EQ(create_info->queryCount, kNumSlotsPerPool);
+    static uint64_t next_query_pool = 1;
+    *query_pool_out = absl::bit_cast<VkQueryPool>(next_query_pool++);
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .Times(kMaxNumPools)
+      .WillRepeatedly(Return(mock_create_query_pool_function));
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillRepeatedly(Return(dummy_reset_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+
+  absl::flat_hash_set<uint32_t> slots;
+  absl::flat_hash_set<std::pair<VkQueryPool, uint32_t>> queries;
+  for (uint32_t i = 0; i < kNumSlotsPerPool * kMaxNumPools; ++i) {
+    uint32_t slot;
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+    slots.insert(slot);
+    auto [vulkan_query_pool, query_index] = query_pool.GetQueryPoolAndQueryIndex(device, slot);
+    EXPECT_LT(query_index, kNumSlotsPerPool);
+    queries.emplace(vulkan_query_pool, query_index);
+  }
+  EXPECT_EQ(slots.size(), kNumSlotsPerPool * kMaxNumPools);
+  EXPECT_EQ(queries.size(), kNumSlotsPerPool * kMaxNumPools);
+
+  uint32_t slot;
+  EXPECT_FALSE(query_pool.NextReadyQuerySlot(device, &slot));
+}
+
+TEST(TimerQueryPool, DestroyPoolForDeviceWillDestroyAllCreatedQueryPools) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlotsPerPool = 1;
+  static constexpr uint32_t kMaxNumPools = 4;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlotsPerPool, kMaxNumPools);
+  VkDevice device = {};
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .Times(2)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillRepeatedly(Return(dummy_reset_query_pool_function));
+  PFN_vkDestroyQueryPool dummy_destroy_query_pool_function =
+      +[](VkDevice /*device*/, VkQueryPool /*query_pool*/,
+          const VkAllocationCallbacks* /*allocator*/) {};
+  EXPECT_CALL(dispatch_table, DestroyQueryPool)
+      .Times(2)
+      .WillRepeatedly(Return(dummy_destroy_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+  uint32_t slot;
+  EXPECT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+  EXPECT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+  query_pool.DestroyTimerQueryPool(device);
+}
+
+TEST(TimerQueryPool, SlotUtilizationIsTracked) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlots = 2;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlots);
+  VkDevice device = {};
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillRepeatedly(Return(dummy_reset_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+  uint32_t first_slot;
+  uint32_t second_slot;
+  uint32_t third_slot;
+  EXPECT_TRUE(query_pool.NextReadyQuerySlot(device, &first_slot));
+  EXPECT_TRUE(query_pool.NextReadyQuerySlot(device, &second_slot));
+  EXPECT_FALSE(query_pool.NextReadyQuerySlot(device, &third_slot));
+  query_pool.RollbackPendingQuerySlots(device, {first_slot});
+  query_pool.MarkQuerySlotsDoneReading(device, {second_slot});
+
+  TimerQueryPool<MockDispatchTable>::SlotUtilization utilization =
+      query_pool.GetSlotUtilization(device);
+  EXPECT_EQ(utilization.num_slots, kNumSlots);
+  EXPECT_EQ(utilization.num_occupied_slots, 1);
+  EXPECT_EQ(utilization.max_num_occupied_slots, 2);
+  EXPECT_EQ(utilization.num_failed_slot_requests, 1);
+
+  query_pool.MarkQuerySlotsForReset(device, {second_slot});
+  EXPECT_EQ(query_pool.GetSlotUtilization(device).num_occupied_slots, 0);
+}
+
 TEST(TimerQueryPool, RollingBackSlotsMakesSlotsReady) {
   MockDispatchTable dispatch_table;
   static constexpr uint32_t kNumSlots = 1;
@@ -9,7 +9,10 @@
 #include <vulkan/vk_layer.h>
 #include <vulkan/vulkan.h>
 
+#include <atomic>
+
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
 #include "ProducerSideChannel/ProducerSideChannel.h"
 #include "VulkanLayerProducerImpl.h"
 
@@ -49,7 +52,7 @@ class VulkanLayerController {
 
   VulkanLayerController()
       : device_manager_(&dispatch_table_),
-        timer_query_pool_(&dispatch_table_, kNumTimerQuerySlots),
+        timer_query_pool_(&dispatch_table_, kNumTimerQuerySlotsPerPool, kMaxNumTimerQueryPools),
         submission_tracker_(&dispatch_table_, &timer_query_pool_, &device_manager_,
                             std::numeric_limits<uint32_t>::max()) {}
 
@@ -301,12 +304,15 @@ class VulkanLayerController {
       submission_tracker_.PersistDebugMarkersOnSubmit(queue, submit_count, submits,
                                                       queue_submission_optional);
     }
+
+    // Applications that never present (e.g. compute-only or offscreen workloads) would otherwise
+    // never get their timestamps read and their query slots freed.
+    CompleteSubmitsIfDue(queue);
     return result;
   }
 
   [[nodiscard]] VkResult OnQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
-    // TODO(b/185454430): Consider calling  CompleteSubmits periodically on vkQueueSubmit instead of
-    //  on vkQueuePresentKHR.
+    last_complete_submits_timestamp_ns_ = orbit_base::CaptureTimestampNs();
     submission_tracker_.CompleteSubmits(queue_manager_.GetDeviceOfQueue(queue));
     return dispatch_table_.QueuePresentKHR(queue)(queue, present_info);
   }
@@ -701,6 +707,22 @@ class VulkanLayerController {
                                       extension_name, output);
   }
 
+  // Calls `CompleteSubmits`, unless this has already happened within the last
+  // `kMinCompleteSubmitsIntervalNs`. If multiple threads submit concurrently, only one of them will
+  // do the work, the others return immediately.
+  void CompleteSubmitsIfDue(VkQueue queue) {
+    uint64_t now = orbit_base::CaptureTimestampNs();
+    uint64_t last_complete_submits_timestamp_ns = last_complete_submits_timestamp_ns_;
+    if (now < last_complete_submits_timestamp_ns + kMinCompleteSubmitsIntervalNs) {
+      return;
+    }
+    if (!last_complete_submits_timestamp_ns_.compare_exchange_strong(
+            last_complete_submits_timestamp_ns, now)) {
+      return;
+    }
+    submission_tracker_.CompleteSubmits(queue_manager_.GetDeviceOfQueue(queue));
+  }
+
   void AddRequiredInstanceExtensionNameIfMissing(const VkInstanceCreateInfo* create_info,
 
                                                  const char* extension_name,
@@ -723,8 +745,16 @@ class VulkanLayerController {
   QueueManager queue_manager_;
   VulkanWrapper vulkan_wrapper_;
 
-  // The number of timer query slots is chosen arbitrary such that it is large enough.
-  static constexpr uint32_t kNumTimerQuerySlots = 131072;
+  std::atomic<uint64_t> last_complete_submits_timestamp_ns_ = 0;
+
+  // The timer query slots of a device are allocated in pools of `kNumTimerQuerySlotsPerPool` slots.
+  // Additional pools are created on demand, up to `kMaxNumTimerQueryPools`. The numbers are chosen
+  // arbitrary such that they are large enough.
+  static constexpr uint32_t kNumTimerQuerySlotsPerPool = 16384;
+  static constexpr uint32_t kMaxNumTimerQueryPools = 32;
+
+  // The minimum time between two calls to `CompleteSubmits` on `vkQueueSubmit`.
+  static constexpr uint64_t kMinCompleteSubmitsIntervalNs = 5'000'000;
 };
 
 }  // namespace orbit_vulkan_layer
@@ -91,7 +91,8 @@ class MockQueueManager {
 
 class MockTimerQueryPool {
  public:
-  explicit MockTimerQueryPool(MockDispatchTable* /*dispatch_table*/, uint32_t /*num_slots*/) {}
+  explicit MockTimerQueryPool(MockDispatchTable* /*dispatch_table*/, uint32_t /*num_slots*/,
+                              uint32_t /*max_num_pools*/) {}
   MOCK_METHOD(void, InitializeTimerQueryPool, (VkDevice));
   MOCK_METHOD(void, DestroyTimerQueryPool, (VkDevice));
 };
@@ -878,6 +879,11 @@ TEST_F(VulkanLayerControllerTest, ForwardsOnGetQueueSubmitToSubmissionTracker) {
   const MockSubmissionTracker* submission_tracker = controller_.submission_tracker();
   EXPECT_CALL(*submission_tracker, PersistCommandBuffersOnSubmit).Times(1);
   EXPECT_CALL(*submission_tracker, PersistDebugMarkersOnSubmit).Times(1);
+  // This is the first submit, so the timestamps of completed submissions get harvested.
+  EXPECT_CALL(*submission_tracker, CompleteSubmits).Times(1);
+  VkDevice device = {};
+  const MockQueueManager* queue_manager = controller_.queue_manager();
+  EXPECT_CALL(*queue_manager, GetDeviceOfQueue).Times(1).WillOnce(Return(device));
 
   VkQueue queue = {};
   VkCommandBuffer command_buffer = {};
@@ -889,6 +895,38 @@ TEST_F(VulkanLayerControllerTest, ForwardsOnGetQueueSubmitToSubmissionTracker) {
   EXPECT_EQ(result, VK_SUCCESS);
 }
 
+TEST_F(VulkanLayerControllerTest, OnQueueSubmitRightAfterPresentDoesNotCompleteSubmitsAgain) {
+  PFN_vkQueuePresentKHR fake_queue_present =
+      +[](VkQueue /*queue*/, const VkPresentInfoKHR * /*present_info*/) -> VkResult {
+    return VK_SUCCESS;
+  };
+  PFN_vkQueueSubmit fake_queue_submit =
+      +[](VkQueue /*queue*/, uint32_t /*submit_count*/, const VkSubmitInfo* /*submits*/,
+          VkFence /*fence*/) -> VkResult { return VK_SUCCESS; };
+  const MockDispatchTable* dispatch_table = controller_.dispatch_table();
+  EXPECT_CALL(*dispatch_table, QueuePresentKHR).Times(1).WillOnce(Return(fake_queue_present));
+  EXPECT_CALL(*dispatch_table, QueueSubmit).Times(1).WillOnce(Return(fake_queue_submit));
+
+  const MockSubmissionTracker* submission_tracker = controller_.submission_tracker();
+  EXPECT_CALL(*submission_tracker, PersistCommandBuffersOnSubmit).Times(1);
+  EXPECT_CALL(*submission_tracker, PersistDebugMarkersOnSubmit).Times(1);
+  EXPECT_CALL(*submission_tracker, CompleteSubmits).Times(1);
+  VkDevice device = {};
+  const MockQueueManager* queue_manager = controller_.queue_manager();
+  EXPECT_CALL(*queue_manager, GetDeviceOfQueue).Times(1).WillOnce(Return(device));
+
+  VkQueue queue = {};
+  VkPresentInfoKHR present_info{.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+  EXPECT_EQ(controller_.OnQueuePresentKHR(queue, &present_info), VK_SUCCESS);
+
+  VkCommandBuffer command_buffer = {};
+  VkSubmitInfo submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                           .commandBufferCount = 1,
+                           .pCommandBuffers = &command_buffer};
+  VkFence fence = {};
+  EXPECT_EQ(controller_.OnQueueSubmit(queue, 1, &submit_info, fence), VK_SUCCESS);
+}
+
 TEST_F(VulkanLayerControllerTest, ForwardsOnQueuePresentKHRToSubmissionTracker) {
   PFN_vkQueuePresentKHR fake_queue_present =
       +[](VkQueue /*queue*/, const VkPresentInfoKHR * /*present_info*/) -> VkResult {
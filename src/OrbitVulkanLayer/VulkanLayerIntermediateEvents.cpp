@@ -0,0 +1,82 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "VulkanLayerIntermediateEvents.h"
+
+#include <utility>
+
+namespace orbit_vulkan_layer {
+
+namespace {
+
+void WriteMetaInfoProto(const GpuQueueSubmissionMetaInfo& meta_info,
+                        orbit_grpc_protos::GpuQueueSubmissionMetaInfo* meta_info_proto) {
+  meta_info_proto->set_tid(meta_info.tid);
+  meta_info_proto->set_pid(meta_info.pid);
+  meta_info_proto->set_pre_submission_cpu_timestamp(meta_info.pre_submission_cpu_timestamp);
+  meta_info_proto->set_post_submission_cpu_timestamp(meta_info.post_submission_cpu_timestamp);
+}
+
+}  // namespace
+
+void WriteGpuQueueSubmissionProto(const GpuQueueSubmission& submission,
+                                  orbit_grpc_protos::GpuQueueSubmission* submission_proto) {
+  WriteMetaInfoProto(submission.meta_info, submission_proto->mutable_meta_info());
+
+  submission_proto->mutable_submit_infos()->Reserve(submission.submit_infos.size());
+  for (const GpuSubmitInfo& submit_info : submission.submit_infos) {
+    orbit_grpc_protos::GpuSubmitInfo* submit_info_proto = submission_proto->add_submit_infos();
+    submit_info_proto->mutable_command_buffers()->Reserve(submit_info.command_buffers.size());
+    for (const GpuCommandBuffer& command_buffer : submit_info.command_buffers) {
+      orbit_grpc_protos::GpuCommandBuffer* command_buffer_proto =
+          submit_info_proto->add_command_buffers();
+      if (command_buffer.begin_gpu_timestamp_ns.has_value()) {
+        command_buffer_proto->set_begin_gpu_timestamp_ns(
+            command_buffer.begin_gpu_timestamp_ns.value());
+      }
+      command_buffer_proto->set_end_gpu_timestamp_ns(command_buffer.end_gpu_timestamp_ns);
+    }
+  }
+
+  submission_proto->set_num_begin_markers(submission.num_begin_markers);
+  submission_proto->mutable_completed_markers()->Reserve(submission.completed_markers.size());
+  for (const GpuDebugMarker& marker : submission.completed_markers) {
+    orbit_grpc_protos::GpuDebugMarker* marker_proto = submission_proto->add_completed_markers();
+    marker_proto->set_text_key(marker.text_key);
+    if (marker.color.has_value()) {
+      orbit_grpc_protos::Color* color_proto = marker_proto->mutable_color();
+      color_proto->set_red(marker.color->red);
+      color_proto->set_green(marker.color->green);
+      color_proto->set_blue(marker.color->blue);
+      color_proto->set_alpha(marker.color->alpha);
+    }
+    marker_proto->set_depth(marker.depth);
+    marker_proto->set_end_gpu_timestamp_ns(marker.end_gpu_timestamp_ns);
+
+    if (!marker.begin_marker.has_value()) {
+      continue;
+    }
+    orbit_grpc_protos::GpuDebugMarkerBeginInfo* begin_marker_proto =
+        marker_proto->mutable_begin_marker();
+    WriteMetaInfoProto(marker.begin_marker->meta_info, begin_marker_proto->mutable_meta_info());
+    begin_marker_proto->set_gpu_timestamp_ns(marker.begin_marker->gpu_timestamp_ns);
+  }
+}
+
+orbit_grpc_protos::ProducerCaptureEvent* CreateCaptureEvent(
+    VulkanLayerIntermediateEvent&& intermediate_event, google::protobuf::Arena* arena) {
+  auto* capture_event =
+      google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+  if (auto* submission = std::get_if<GpuQueueSubmission>(&intermediate_event)) {
+    WriteGpuQueueSubmissionProto(*submission, capture_event->mutable_gpu_queue_submission());
+  } else if (auto* interned_string = std::get_if<InternedString>(&intermediate_event)) {
+    orbit_grpc_protos::InternedString* interned_string_proto =
+        capture_event->mutable_interned_string();
+    interned_string_proto->set_key(interned_string->key);
+    interned_string_proto->set_intern(std::move(interned_string->intern));
+  }
+  return capture_event;
+}
+
+}  // namespace orbit_vulkan_layer
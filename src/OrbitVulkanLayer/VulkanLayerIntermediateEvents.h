@@ -0,0 +1,89 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_VULKAN_LAYER_VULKAN_LAYER_INTERMEDIATE_EVENTS_H_
+#define ORBIT_VULKAN_LAYER_VULKAN_LAYER_INTERMEDIATE_EVENTS_H_
+
+#include <google/protobuf/arena.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "capture.pb.h"
+
+namespace orbit_vulkan_layer {
+
+// The structs in this file are compact, protobuf-free counterparts of the `ProducerCaptureEvent`s
+// produced by the Vulkan layer. They are filled on the application's threads (e.g. in
+// `vkQueueSubmit` or `vkQueuePresentKHR`), which is where the cost of the layer matters. The
+// translation into the corresponding protos only happens on the forwarder thread of
+// `VulkanLayerProducerImpl`, see `CreateCaptureEvent`.
+
+struct GpuQueueSubmissionMetaInfo {
+  int32_t tid = 0;
+  int32_t pid = 0;
+  uint64_t pre_submission_cpu_timestamp = 0;
+  uint64_t post_submission_cpu_timestamp = 0;
+};
+
+struct GpuCommandBuffer {
+  std::optional<uint64_t> begin_gpu_timestamp_ns;
+  uint64_t end_gpu_timestamp_ns = 0;
+};
+
+struct GpuSubmitInfo {
+  std::vector<GpuCommandBuffer> command_buffers;
+};
+
+struct GpuDebugMarkerBeginInfo {
+  GpuQueueSubmissionMetaInfo meta_info;
+  uint64_t gpu_timestamp_ns = 0;
+};
+
+struct GpuDebugMarkerColor {
+  float red = 0.f;
+  float green = 0.f;
+  float blue = 0.f;
+  float alpha = 0.f;
+};
+
+struct GpuDebugMarker {
+  // Key of the marker's label, as returned by `VulkanLayerProducer::
+  // InternStringIfNecessaryAndGetKey`. The label itself is only sent once per capture.
+  uint64_t text_key = 0;
+  std::optional<GpuDebugMarkerColor> color;
+  int32_t depth = 0;
+  uint64_t end_gpu_timestamp_ns = 0;
+  std::optional<GpuDebugMarkerBeginInfo> begin_marker;
+};
+
+struct GpuQueueSubmission {
+  GpuQueueSubmissionMetaInfo meta_info;
+  std::vector<GpuSubmitInfo> submit_infos;
+  std::vector<GpuDebugMarker> completed_markers;
+  int32_t num_begin_markers = 0;
+};
+
+struct InternedString {
+  uint64_t key = 0;
+  std::string intern;
+};
+
+using VulkanLayerIntermediateEvent = std::variant<GpuQueueSubmission, InternedString>;
+
+// Fills `submission_proto` with the content of `submission`.
+void WriteGpuQueueSubmissionProto(const GpuQueueSubmission& submission,
+                                  orbit_grpc_protos::GpuQueueSubmission* submission_proto);
+
+// Creates the `ProducerCaptureEvent` corresponding to `intermediate_event` in `arena`.
+// `arena` can be nullptr, in which case the caller takes ownership of the returned message.
+[[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent* CreateCaptureEvent(
+    VulkanLayerIntermediateEvent&& intermediate_event, google::protobuf::Arena* arena);
+
+}  // namespace orbit_vulkan_layer
+
+#endif  // ORBIT_VULKAN_LAYER_VULKAN_LAYER_INTERMEDIATE_EVENTS_H_
@@ -7,6 +7,7 @@
 
 #include <grpcpp/grpcpp.h>
 
+#include "VulkanLayerIntermediateEvents.h"
 #include "capture.pb.h"
 
 namespace orbit_vulkan_layer {
@@ -29,11 +30,12 @@ class VulkanLayerProducer {
   // Use this method to query whether Orbit is currently capturing.
   [[nodiscard]] virtual bool IsCapturing() = 0;
 
-  // Use this method to enqueue a CaptureEvent to be sent to OrbitService.
+  // Use this method to enqueue a GpuQueueSubmission to be sent to OrbitService.
   // Returns true if the event was enqueued as the capture is in progress, false otherwise.
   // Callers can use the return value to check if the event was actually enqueued as the capture
-  // is in progress.
-  virtual bool EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent&& capture_event) = 0;
+  // is in progress. The conversion to the corresponding ProducerCaptureEvent is deferred to the
+  // thread that sends the events, so that the calling thread doesn't pay for it.
+  virtual bool EnqueueGpuQueueSubmission(GpuQueueSubmission&& submission) = 0;
 
   // This method enqueues an InternedString to be sent to OrbitService the first time the string
   // passed as argument is seen. In all cases, it returns the key corresponding to the string.
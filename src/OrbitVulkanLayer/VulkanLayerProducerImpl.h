@@ -9,6 +9,7 @@
 #include <google/protobuf/arena.h>
 
 #include "CaptureEventProducer/LockFreeBufferCaptureEventProducer.h"
+#include "VulkanLayerIntermediateEvents.h"
 #include "VulkanLayerProducer.h"
 
 namespace orbit_vulkan_layer {
@@ -26,9 +27,9 @@ class VulkanLayerProducerImpl : public VulkanLayerProducer {
 
   [[nodiscard]] bool IsCapturing() override { return lock_free_producer_.IsCapturing(); }
 
-  bool EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent&& capture_event) override {
+  bool EnqueueGpuQueueSubmission(GpuQueueSubmission&& submission) override {
     return lock_free_producer_.EnqueueIntermediateEventIfCapturing(
-        [&capture_event] { return capture_event; });
+        [&submission] { return VulkanLayerIntermediateEvent{std::move(submission)}; });
   }
 
   [[nodiscard]] uint64_t InternStringIfNecessaryAndGetKey(std::string str) override;
@@ -38,7 +39,7 @@ class VulkanLayerProducerImpl : public VulkanLayerProducer {
  private:
   class LockFreeBufferVulkanLayerProducer
       : public orbit_capture_event_producer::LockFreeBufferCaptureEventProducer<
-            orbit_grpc_protos::ProducerCaptureEvent> {
+            VulkanLayerIntermediateEvent> {
    public:
     explicit LockFreeBufferVulkanLayerProducer(VulkanLayerProducerImpl* outer) : outer_{outer} {}
 
@@ -67,18 +68,9 @@ class VulkanLayerProducerImpl : public VulkanLayerProducer {
     }
 
     orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
-        orbit_grpc_protos::ProducerCaptureEvent&& intermediate_event,
+        VulkanLayerIntermediateEvent&& intermediate_event,
         google::protobuf::Arena* arena) override {
-      auto* capture_event =
-          google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
-      // Note that, as capture_event is in the Arena and intermediate_event is on the heap, this
-      // std::move will actually end up being a copy, as it will use CopyFrom internally.
-      // For the amount of events that this Vulkan layer produces, this is fine performance-wise.
-      // This is also in line with the principle of this method, which in general expects a
-      // transformation from any type that intermediate_event could be to the ProducerCaptureEvent
-      // protobuf.
-      *capture_event = std::move(intermediate_event);
-      return capture_event;
+      return CreateCaptureEvent(std::move(intermediate_event), arena);
     }
 
    private:
@@ -167,10 +167,10 @@ TEST_F(VulkanLayerProducerImplTest, WorksWithNoListener) {
   EXPECT_FALSE(producer_->IsCapturing());
 }
 
-TEST_F(VulkanLayerProducerImplTest, EnqueueCaptureEvent) {
+TEST_F(VulkanLayerProducerImplTest, EnqueueGpuQueueSubmission) {
   EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(0);
   EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(0);
-  EXPECT_FALSE(producer_->EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent()));
+  EXPECT_FALSE(producer_->EnqueueGpuQueueSubmission(GpuQueueSubmission{}));
   std::this_thread::sleep_for(kWaitMessagesSentDuration);
 
   ::testing::Mock::VerifyAndClearExpectations(&*fake_service_);
@@ -192,9 +192,9 @@ TEST_F(VulkanLayerProducerImplTest, EnqueueCaptureEvent) {
       });
   EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(::testing::Between(1, 3));
   EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(0);
-  EXPECT_TRUE(producer_->EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent()));
-  EXPECT_TRUE(producer_->EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent()));
-  EXPECT_TRUE(producer_->EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent()));
+  EXPECT_TRUE(producer_->EnqueueGpuQueueSubmission(GpuQueueSubmission{}));
+  EXPECT_TRUE(producer_->EnqueueGpuQueueSubmission(GpuQueueSubmission{}));
+  EXPECT_TRUE(producer_->EnqueueGpuQueueSubmission(GpuQueueSubmission{}));
   std::this_thread::sleep_for(kWaitMessagesSentDuration);
   EXPECT_EQ(capture_events_received_count, 3);
 
@@ -211,7 +211,7 @@ TEST_F(VulkanLayerProducerImplTest, EnqueueCaptureEvent) {
 
   EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(0);
   EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(0);
-  EXPECT_FALSE(producer_->EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent()));
+  EXPECT_FALSE(producer_->EnqueueGpuQueueSubmission(GpuQueueSubmission{}));
   std::this_thread::sleep_for(kWaitMessagesSentDuration);
 
   ::testing::Mock::VerifyAndClearExpectations(&*fake_service_);
@@ -227,7 +227,86 @@ TEST_F(VulkanLayerProducerImplTest, EnqueueCaptureEvent) {
 
   EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(0);
   EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(0);
-  EXPECT_FALSE(producer_->EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent()));
+  EXPECT_FALSE(producer_->EnqueueGpuQueueSubmission(GpuQueueSubmission{}));
+}
+
+TEST_F(VulkanLayerProducerImplTest, GpuQueueSubmissionIsTranslatedToProto) {
+  EXPECT_CALL(mock_listener_, OnCaptureStart(CaptureOptionsEq(kFakeCaptureOptions))).Times(1);
+  fake_service_->SendStartCaptureCommand(kFakeCaptureOptions);
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+
+  ::testing::Mock::VerifyAndClearExpectations(&mock_listener_);
+
+  GpuQueueSubmission submission;
+  submission.meta_info.tid = 1;
+  submission.meta_info.pid = 2;
+  submission.meta_info.pre_submission_cpu_timestamp = 3;
+  submission.meta_info.post_submission_cpu_timestamp = 4;
+  GpuSubmitInfo& submit_info = submission.submit_infos.emplace_back();
+  submit_info.command_buffers.push_back(GpuCommandBuffer{5, 6});
+  submit_info.command_buffers.push_back(GpuCommandBuffer{std::nullopt, 7});
+  GpuDebugMarker& marker = submission.completed_markers.emplace_back();
+  marker.text_key = 8;
+  marker.color = GpuDebugMarkerColor{0.25f, 0.5f, 0.75f, 1.f};
+  marker.depth = 1;
+  marker.end_gpu_timestamp_ns = 9;
+  marker.begin_marker = GpuDebugMarkerBeginInfo{GpuQueueSubmissionMetaInfo{10, 2, 11, 12}, 13};
+  submission.num_begin_markers = 2;
+
+  std::vector<orbit_grpc_protos::ProducerCaptureEvent> events_received;
+  EXPECT_CALL(*fake_service_, OnCaptureEventsReceived)
+      .Times(1)
+      .WillRepeatedly(
+          [&events_received](const std::vector<orbit_grpc_protos::ProducerCaptureEvent>& events) {
+            events_received.insert(events_received.end(), events.begin(), events.end());
+          });
+  EXPECT_TRUE(producer_->EnqueueGpuQueueSubmission(std::move(submission)));
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+
+  ASSERT_EQ(events_received.size(), 1);
+  ASSERT_EQ(events_received[0].event_case(),
+            orbit_grpc_protos::ProducerCaptureEvent::kGpuQueueSubmission);
+  const orbit_grpc_protos::GpuQueueSubmission& actual = events_received[0].gpu_queue_submission();
+  EXPECT_EQ(actual.meta_info().tid(), 1);
+  EXPECT_EQ(actual.meta_info().pid(), 2);
+  EXPECT_EQ(actual.meta_info().pre_submission_cpu_timestamp(), 3);
+  EXPECT_EQ(actual.meta_info().post_submission_cpu_timestamp(), 4);
+  ASSERT_EQ(actual.submit_infos_size(), 1);
+  ASSERT_EQ(actual.submit_infos(0).command_buffers_size(), 2);
+  EXPECT_EQ(actual.submit_infos(0).command_buffers(0).begin_gpu_timestamp_ns(), 5);
+  EXPECT_EQ(actual.submit_infos(0).command_buffers(0).end_gpu_timestamp_ns(), 6);
+  EXPECT_EQ(actual.submit_infos(0).command_buffers(1).begin_gpu_timestamp_ns(), 0);
+  EXPECT_EQ(actual.submit_infos(0).command_buffers(1).end_gpu_timestamp_ns(), 7);
+  EXPECT_EQ(actual.num_begin_markers(), 2);
+  ASSERT_EQ(actual.completed_markers_size(), 1);
+  const orbit_grpc_protos::GpuDebugMarker& actual_marker = actual.completed_markers(0);
+  EXPECT_EQ(actual_marker.text_key(), 8);
+  ASSERT_TRUE(actual_marker.has_color());
+  EXPECT_EQ(actual_marker.color().red(), 0.25f);
+  EXPECT_EQ(actual_marker.color().green(), 0.5f);
+  EXPECT_EQ(actual_marker.color().blue(), 0.75f);
+  EXPECT_EQ(actual_marker.color().alpha(), 1.f);
+  EXPECT_EQ(actual_marker.depth(), 1);
+  EXPECT_EQ(actual_marker.end_gpu_timestamp_ns(), 9);
+  ASSERT_TRUE(actual_marker.has_begin_marker());
+  EXPECT_EQ(actual_marker.begin_marker().meta_info().tid(), 10);
+  EXPECT_EQ(actual_marker.begin_marker().meta_info().pre_submission_cpu_timestamp(), 11);
+  EXPECT_EQ(actual_marker.begin_marker().meta_info().post_submission_cpu_timestamp(), 12);
+  EXPECT_EQ(actual_marker.begin_marker().gpu_timestamp_ns(), 13);
+
+  ::testing::Mock::VerifyAndClearExpectations(&*fake_service_);
+
+  EXPECT_CALL(mock_listener_, OnCaptureStop).Times(1);
+  EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(0);
+  EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(1);
+  fake_service_->SendStopCaptureCommand();
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+
+  ::testing::Mock::VerifyAndClearExpectations(&mock_listener_);
+  ::testing::Mock::VerifyAndClearExpectations(&*fake_service_);
+
+  EXPECT_CALL(mock_listener_, OnCaptureFinished).Times(1);
+  fake_service_->SendCaptureFinishedCommand();
 }
 
 static void ExpectInternedStrings(
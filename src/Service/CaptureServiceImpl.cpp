@@ -6,13 +6,21 @@
 
 #include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/flags/declare.h>
+#include <absl/flags/flag.h>
+#include <absl/strings/str_format.h>
 #include <absl/synchronization/mutex.h>
 #include <absl/time/time.h>
 #include <pthread.h>
 #include <stdint.h>
 
 #include <algorithm>
+#include <filesystem>
+#include <functional>
 #include <limits>
+#include <optional>
+#include <string>
+#include <system_error>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -20,18 +28,26 @@
 #include "ApiLoader/EnableInTracee.h"
 #include "CaptureEventBuffer.h"
 #include "CaptureEventSender.h"
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "FlightRecorderCaptureEventBuffer.h"
 #include "GrpcProtos/Constants.h"
 #include "Introspection/Introspection.h"
+#include "LocalCapture.h"
 #include "MemoryInfoHandler.h"
 #include "ObjectUtils/ElfFile.h"
 #include "OrbitBase/ExecutablePath.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/ThreadUtils.h"
 #include "OrbitVersion/OrbitVersion.h"
 #include "ProducerEventProcessor.h"
+#include "SenderThreadCaptureEventBuffer.h"
 #include "TracingHandler.h"
 #include "capture.pb.h"
 
+ABSL_DECLARE_FLAG(uint64_t, max_capture_event_buffer_mb);
+
 namespace orbit_service {
 
 using orbit_grpc_protos::CaptureFinished;
@@ -39,81 +55,21 @@ using orbit_grpc_protos::CaptureOptions;
 using orbit_grpc_protos::CaptureRequest;
 using orbit_grpc_protos::CaptureResponse;
 using orbit_grpc_protos::CaptureStarted;
+using orbit_grpc_protos::FlushFlightRecorderRequest;
+using orbit_grpc_protos::FlushFlightRecorderResponse;
 using orbit_grpc_protos::ProducerCaptureEvent;
+using orbit_grpc_protos::StartLocalCaptureRequest;
+using orbit_grpc_protos::StartLocalCaptureResponse;
+using orbit_grpc_protos::StopLocalCaptureRequest;
+using orbit_grpc_protos::StopLocalCaptureResponse;
 
 namespace {
 
 using orbit_grpc_protos::ClientCaptureEvent;
 
-class SenderThreadCaptureEventBuffer final : public CaptureEventBuffer {
- public:
-  explicit SenderThreadCaptureEventBuffer(CaptureEventSender* event_sender)
-      : capture_event_sender_{event_sender} {
-    CHECK(capture_event_sender_ != nullptr);
-    sender_thread_ = std::thread{[this] { SenderThread(); }};
-  }
-
-  void AddEvent(ClientCaptureEvent&& event) override {
-    absl::MutexLock lock{&events_being_buffered_mutex_};
-    if (stop_requested_) {
-      return;
-    }
-    events_being_buffered_.emplace_back(std::move(event));
-  }
-
-  void StopAndWait() {
-    CHECK(sender_thread_.joinable());
-    {
-      // Protect stop_requested_ with event_buffer_mutex_ so that we can use stop_requested_
-      // in Conditions for Await/LockWhen (specifically, in SenderThread).
-      absl::MutexLock lock{&events_being_buffered_mutex_};
-      stop_requested_ = true;
-    }
-    sender_thread_.join();
-  }
-
-  ~SenderThreadCaptureEventBuffer() override { CHECK(!sender_thread_.joinable()); }
-
- private:
-  void SenderThread() {
-    orbit_base::SetCurrentThreadName("SenderThread");
-    constexpr absl::Duration kSendTimeInterval = absl::Milliseconds(20);
-    // This should be lower than kMaxEventsPerResponse in GrpcCaptureEventSender::SendEvents
-    // as a few more events are likely to arrive after the condition becomes true.
-    constexpr uint64_t kSendEventCountInterval = 5000;
-
-    bool stopped = false;
-    while (!stopped) {
-      ORBIT_SCOPE("SenderThread iteration");
-
-      events_being_buffered_mutex_.LockWhenWithTimeout(
-          absl::Condition(
-              +[](SenderThreadCaptureEventBuffer* self) {
-                return self->events_being_buffered_.size() >= kSendEventCountInterval ||
-                       self->stop_requested_;
-              },
-              this),
-          kSendTimeInterval);
-      if (stop_requested_) {
-        stopped = true;
-      }
-      events_being_buffered_.swap(events_to_send_);
-      events_being_buffered_mutex_.Unlock();
-
-      capture_event_sender_->SendEvents(&events_to_send_);
-      // std::vector::clear() "Leaves the capacity() of the vector unchanged", which is desired.
-      events_to_send_.clear();
-    }
-  }
-
-  std::vector<ClientCaptureEvent> events_being_buffered_
-      ABSL_GUARDED_BY(events_being_buffered_mutex_);
-  absl::Mutex events_being_buffered_mutex_;
-  std::vector<ClientCaptureEvent> events_to_send_;
-  CaptureEventSender* capture_event_sender_;
-  std::thread sender_thread_;
-  bool stop_requested_ ABSL_GUARDED_BY(events_being_buffered_mutex_) = false;
-};
+uint64_t GetMaxBufferedBytes() {
+  return absl::GetFlag(FLAGS_max_capture_event_buffer_mb) * 1024 * 1024;
+}
 
 class GrpcCaptureEventSender final : public CaptureEventSender {
  public:
@@ -196,6 +152,30 @@ void FilterOutInstrumentedFunctionsFromCaptureOptions(
       first_to_delete, capture_options.instrumented_functions_size() - first_to_delete);
 }
 
+// Returns a path for a local capture in the temporary directory. The file name contains the current
+// time, and a counter makes it unique if a file with that name already exists, e.g., because
+// another capture was started in the same second.
+ErrorMessageOr<std::filesystem::path> GenerateLocalCaptureFilePath() {
+  std::error_code error;
+  const std::filesystem::path temp_directory = std::filesystem::temp_directory_path(error);
+  if (error) {
+    return ErrorMessage(absl::StrFormat("Unable to get temporary directory: %s", error.message()));
+  }
+
+  const std::string file_name_prefix = absl::StrFormat(
+      "orbit_capture_%s",
+      absl::FormatTime("%Y_%m_%d_%H_%M_%S", absl::Now(), absl::LocalTimeZone()));
+  std::filesystem::path file_path = temp_directory / absl::StrFormat("%s.orbit", file_name_prefix);
+  for (int counter = 1; std::filesystem::exists(file_path, error); ++counter) {
+    file_path = temp_directory / absl::StrFormat("%s_%d.orbit", file_name_prefix, counter);
+  }
+  if (error) {
+    return ErrorMessage(absl::StrFormat("Unable to check whether \"%s\" exists: %s",
+                                        file_path.string(), error.message()));
+  }
+  return file_path;
+}
+
 }  // namespace
 
 // TracingHandler::Stop is blocking, until all perf_event_open events have been processed
@@ -315,25 +295,142 @@ grpc::Status CaptureServiceImpl::Capture(
     grpc::ServerContext* /*context*/,
     grpc::ServerReaderWriter<CaptureResponse, CaptureRequest>* reader_writer) {
   orbit_base::SetCurrentThreadName("CSImpl::Capture");
-  if (is_capturing) {
+  if (is_capturing.exchange(true)) {
     ERROR("Cannot start capture because another capture is already in progress");
     return grpc::Status(grpc::StatusCode::ALREADY_EXISTS,
                         "Cannot start capture because another capture is already in progress.");
   }
-  is_capturing = true;
 
   GrpcCaptureEventSender capture_event_sender{reader_writer};
-  SenderThreadCaptureEventBuffer capture_event_buffer{&capture_event_sender};
-  std::unique_ptr<ProducerEventProcessor> producer_event_processor =
-      ProducerEventProcessor::Create(&capture_event_buffer);
-  TracingHandler tracing_handler{producer_event_processor.get()};
-  MemoryInfoHandler memory_info_handler{producer_event_processor.get()};
+  SenderThreadCaptureEventBuffer capture_event_buffer{
+      &capture_event_sender, GetMaxBufferedBytes()};
 
   CaptureRequest request;
   reader_writer->Read(&request);
   LOG("Read CaptureRequest from Capture's gRPC stream: starting capture");
 
-  const CaptureOptions& capture_options = request.capture_options();
+  RunCapture(request.capture_options(), &capture_event_buffer, [reader_writer] {
+    // The client asks for the capture to be stopped by calling WritesDone.
+    // At that point, this call to Read will return false.
+    // In the meantime, it blocks if no message is received.
+    CaptureRequest request;
+    while (reader_writer->Read(&request)) {
+    }
+    LOG("Client finished writing on Capture's gRPC stream: stopping capture");
+  });
+
+  capture_event_buffer.StopAndWait();
+  LOG("Finished handling gRPC call to Capture: all capture data has been sent");
+  is_capturing = false;
+  return grpc::Status::OK;
+}
+
+grpc::Status CaptureServiceImpl::StartLocalCapture(grpc::ServerContext* /*context*/,
+                                                   const StartLocalCaptureRequest* request,
+                                                   StartLocalCaptureResponse* response) {
+  if (is_capturing.exchange(true)) {
+    ERROR("Cannot start local capture because another capture is already in progress");
+    return grpc::Status(grpc::StatusCode::ALREADY_EXISTS,
+                        "Cannot start capture because another capture is already in progress.");
+  }
+
+  std::filesystem::path file_path = request->file_path();
+  if (file_path.empty()) {
+    ErrorMessageOr<std::filesystem::path> file_path_or_error = GenerateLocalCaptureFilePath();
+    if (file_path_or_error.has_error()) {
+      is_capturing = false;
+      return grpc::Status(grpc::StatusCode::INTERNAL, file_path_or_error.error().message());
+    }
+    file_path = std::move(file_path_or_error.value());
+  }
+
+  auto output_stream_or_error = orbit_capture_file::CaptureFileOutputStream::Create(file_path);
+  if (output_stream_or_error.has_error()) {
+    is_capturing = false;
+    return grpc::Status(grpc::StatusCode::INTERNAL, output_stream_or_error.error().message());
+  }
+  LOG("Starting local capture to \"%s\"", file_path.string());
+
+  absl::MutexLock lock{&local_capture_mutex_};
+  CHECK(local_capture_ == nullptr);
+  local_capture_ = std::make_unique<LocalCapture>(
+      file_path, std::move(output_stream_or_error.value()),
+      GetMaxBufferedBytes());
+  local_capture_->Start([this, capture_options = request->capture_options()](
+                            CaptureEventBuffer* capture_event_buffer,
+                            const std::function<void()>& wait_for_stop_request) {
+    RunCapture(capture_options, capture_event_buffer, wait_for_stop_request);
+  });
+
+  response->set_file_path(file_path.string());
+  return grpc::Status::OK;
+}
+
+grpc::Status CaptureServiceImpl::StopLocalCapture(grpc::ServerContext* /*context*/,
+                                                  const StopLocalCaptureRequest* /*request*/,
+                                                  StopLocalCaptureResponse* response) {
+  std::unique_ptr<LocalCapture> local_capture;
+  {
+    absl::MutexLock lock{&local_capture_mutex_};
+    local_capture = std::move(local_capture_);
+  }
+  if (local_capture == nullptr) {
+    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "No local capture in progress.");
+  }
+
+  ErrorMessageOr<void> stop_result = local_capture->Stop();
+  is_capturing = false;
+  if (stop_result.has_error()) {
+    return grpc::Status(grpc::StatusCode::INTERNAL, stop_result.error().message());
+  }
+  LOG("Finished local capture to \"%s\"", local_capture->file_path().string());
+
+  std::error_code error;
+  const uintmax_t file_size = std::filesystem::file_size(local_capture->file_path(), error);
+  if (error) {
+    return grpc::Status(grpc::StatusCode::INTERNAL,
+                        absl::StrFormat("Unable to get size of \"%s\": %s",
+                                        local_capture->file_path().string(), error.message()));
+  }
+  response->set_file_path(local_capture->file_path().string());
+  response->set_file_size(file_size);
+  return grpc::Status::OK;
+}
+
+grpc::Status CaptureServiceImpl::FlushFlightRecorder(grpc::ServerContext* /*context*/,
+                                                     const FlushFlightRecorderRequest* /*request*/,
+                                                     FlushFlightRecorderResponse* response) {
+  absl::MutexLock lock{&flight_recorder_mutex_};
+  if (flight_recorder_ == nullptr) {
+    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                        "No capture in flight recorder mode in progress.");
+  }
+  const uint64_t flushed_event_count = flight_recorder_->Flush();
+  LOG("Flushed %u events from the flight recorder", flushed_event_count);
+  response->set_flushed_event_count(flushed_event_count);
+  return grpc::Status::OK;
+}
+
+void CaptureServiceImpl::RunCapture(const CaptureOptions& capture_options,
+                                    CaptureEventBuffer* capture_event_buffer,
+                                    const std::function<void()>& wait_for_stop_request) {
+  // In flight recorder mode, the events only reach `capture_event_buffer` when the flight recorder
+  // is flushed.
+  std::optional<FlightRecorderCaptureEventBuffer> flight_recorder;
+  if (capture_options.flight_recorder_options().window_ns() > 0) {
+    LOG("Capturing in flight recorder mode with a window of %u ms",
+        capture_options.flight_recorder_options().window_ns() / 1'000'000);
+    flight_recorder.emplace(capture_event_buffer, capture_options.flight_recorder_options(),
+                            GetMaxBufferedBytes());
+    capture_event_buffer = &flight_recorder.value();
+    absl::MutexLock lock{&flight_recorder_mutex_};
+    flight_recorder_ = &flight_recorder.value();
+  }
+
+  std::unique_ptr<ProducerEventProcessor> producer_event_processor =
+      ProducerEventProcessor::Create(capture_event_buffer);
+  TracingHandler tracing_handler{producer_event_processor.get()};
+  MemoryInfoHandler memory_info_handler{producer_event_processor.get()};
 
   // Enable Orbit API in tracee.
   std::optional<std::string> error_enabling_orbit_api;
@@ -395,17 +492,12 @@ grpc::Status CaptureServiceImpl::Capture(
 
   tracing_handler.Start(linux_tracing_capture_options);
 
-  memory_info_handler.Start(request.capture_options());
+  memory_info_handler.Start(capture_options);
   for (CaptureStartStopListener* listener : capture_start_stop_listeners_) {
-    listener->OnCaptureStartRequested(request.capture_options(), producer_event_processor.get());
+    listener->OnCaptureStartRequested(capture_options, producer_event_processor.get());
   }
 
-  // The client asks for the capture to be stopped by calling WritesDone.
-  // At that point, this call to Read will return false.
-  // In the meantime, it blocks if no message is received.
-  while (reader_writer->Read(&request)) {
-  }
-  LOG("Client finished writing on Capture's gRPC stream: stopping capture");
+  wait_for_stop_request();
 
   // Disable Orbit API in tracee.
   if (capture_options.enable_api()) {
@@ -436,12 +528,36 @@ grpc::Status CaptureServiceImpl::Capture(
   StopInternalProducersAndCaptureStartStopListenersInParallel(
       &tracing_handler, &memory_info_handler, &capture_start_stop_listeners_);
 
-  capture_event_buffer.AddEvent(CreateCaptureFinishedEvent());
+  capture_event_buffer->AddEvent(CreateCaptureFinishedEvent());
 
-  capture_event_buffer.StopAndWait();
-  LOG("Finished handling gRPC call to Capture: all capture data has been sent");
+  if (flight_recorder.has_value()) {
+    absl::MutexLock lock{&flight_recorder_mutex_};
+    flight_recorder_ = nullptr;
+  }
+}
+
+CaptureServiceImpl::CaptureServiceImpl() {
+  // We want to estimate clock resolution once, not at the beginning of every capture.
+  EstimateAndLogClockResolution();
+  instrumentation_manager_ = orbit_user_space_instrumentation::InstrumentationManager::Create();
+}
+
+CaptureServiceImpl::~CaptureServiceImpl() { Shutdown(); }
+
+void CaptureServiceImpl::Shutdown() {
+  std::unique_ptr<LocalCapture> local_capture;
+  {
+    absl::MutexLock lock{&local_capture_mutex_};
+    local_capture = std::move(local_capture_);
+  }
+  if (local_capture == nullptr) return;
+
+  LOG("Stopping local capture to \"%s\" on shutdown", local_capture->file_path().string());
+  ErrorMessageOr<void> stop_result = local_capture->Stop();
+  if (stop_result.has_error()) {
+    ERROR("Stopping local capture: %s", stop_result.error().message());
+  }
   is_capturing = false;
-  return grpc::Status::OK;
 }
 
 void CaptureServiceImpl::AddCaptureStartStopListener(CaptureStartStopListener* listener) {
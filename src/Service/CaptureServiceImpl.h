@@ -5,11 +5,15 @@
 #ifndef ORBIT_SERVICE_CAPTURE_SERVICE_IMPL_H_
 #define ORBIT_SERVICE_CAPTURE_SERVICE_IMPL_H_
 
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
 
 #include <atomic>
+#include <functional>
 #include <memory>
 
+#include "CaptureEventBuffer.h"
 #include "CaptureStartStopListener.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
@@ -20,29 +24,58 @@
 
 namespace orbit_service {
 
+class FlightRecorderCaptureEventBuffer;
+class LocalCapture;
+
 class CaptureServiceImpl final : public orbit_grpc_protos::CaptureService::Service {
  public:
-  CaptureServiceImpl() {
-    // We want to estimate clock resolution once, not at the beginning of every capture.
-    EstimateAndLogClockResolution();
-    instrumentation_manager_ = orbit_user_space_instrumentation::InstrumentationManager::Create();
-  }
+  CaptureServiceImpl();
+  ~CaptureServiceImpl() override;
 
   grpc::Status Capture(
       grpc::ServerContext* context,
       grpc::ServerReaderWriter<orbit_grpc_protos::CaptureResponse,
                                orbit_grpc_protos::CaptureRequest>* reader_writer) override;
 
+  grpc::Status StartLocalCapture(grpc::ServerContext* context,
+                                 const orbit_grpc_protos::StartLocalCaptureRequest* request,
+                                 orbit_grpc_protos::StartLocalCaptureResponse* response) override;
+  grpc::Status StopLocalCapture(grpc::ServerContext* context,
+                                const orbit_grpc_protos::StopLocalCaptureRequest* request,
+                                orbit_grpc_protos::StopLocalCaptureResponse* response) override;
+  grpc::Status FlushFlightRecorder(
+      grpc::ServerContext* context, const orbit_grpc_protos::FlushFlightRecorderRequest* request,
+      orbit_grpc_protos::FlushFlightRecorderResponse* response) override;
+
+  // Stops the local capture in progress, if any. Call this before removing the
+  // CaptureStartStopListeners, so that the capture still receives their events.
+  void Shutdown();
+
   void AddCaptureStartStopListener(CaptureStartStopListener* listener);
   void RemoveCaptureStartStopListener(CaptureStartStopListener* listener);
 
  private:
+  // Runs a capture with the given options, from enabling the producers to adding the
+  // CaptureFinished event to `capture_event_buffer`. Blocks in `wait_for_stop_request` until the
+  // capture is to be stopped.
+  void RunCapture(const orbit_grpc_protos::CaptureOptions& capture_options,
+                  CaptureEventBuffer* capture_event_buffer,
+                  const std::function<void()>& wait_for_stop_request);
+
   std::atomic<bool> is_capturing = false;
   absl::flat_hash_set<CaptureStartStopListener*> capture_start_stop_listeners_;
 
   std::unique_ptr<orbit_user_space_instrumentation::InstrumentationManager>
       instrumentation_manager_;
 
+  absl::Mutex local_capture_mutex_;
+  std::unique_ptr<LocalCapture> local_capture_ ABSL_GUARDED_BY(local_capture_mutex_);
+
+  absl::Mutex flight_recorder_mutex_;
+  // The flight recorder of the capture in progress, if it is in flight recorder mode.
+  FlightRecorderCaptureEventBuffer* flight_recorder_ ABSL_GUARDED_BY(flight_recorder_mutex_) =
+      nullptr;
+
   uint64_t clock_resolution_ns_ = 0;
   void EstimateAndLogClockResolution();
 };
@@ -0,0 +1,140 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureServiceImpl.h"
+#include "OrbitBase/TemporaryFile.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "capture.pb.h"
+#include "services.pb.h"
+
+namespace orbit_service {
+
+namespace {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::StartLocalCaptureRequest;
+using orbit_grpc_protos::StartLocalCaptureResponse;
+using orbit_grpc_protos::StopLocalCaptureRequest;
+using orbit_grpc_protos::StopLocalCaptureResponse;
+
+// The capture is of this test process, with all optional data sources disabled.
+StartLocalCaptureRequest CreateStartLocalCaptureRequest(std::string file_path) {
+  StartLocalCaptureRequest request;
+  request.set_file_path(std::move(file_path));
+  request.mutable_capture_options()->set_pid(orbit_base::GetCurrentProcessId());
+  return request;
+}
+
+class CaptureServiceImplTest : public testing::Test {
+ protected:
+  grpc::Status StartLocalCapture(std::string file_path, std::string* started_file_path = nullptr) {
+    grpc::ServerContext context;
+    StartLocalCaptureRequest request = CreateStartLocalCaptureRequest(std::move(file_path));
+    StartLocalCaptureResponse response;
+    grpc::Status status = capture_service_.StartLocalCapture(&context, &request, &response);
+    if (started_file_path != nullptr) *started_file_path = response.file_path();
+    return status;
+  }
+
+  grpc::Status StopLocalCapture(StopLocalCaptureResponse* response) {
+    grpc::ServerContext context;
+    StopLocalCaptureRequest request;
+    return capture_service_.StopLocalCapture(&context, &request, response);
+  }
+
+  CaptureServiceImpl capture_service_;
+};
+
+}  // namespace
+
+TEST_F(CaptureServiceImplTest, StartAndStopLocalCaptureWritesCaptureFile) {
+  auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+  ASSERT_TRUE(temporary_file_or_error.has_value()) << temporary_file_or_error.error().message();
+  orbit_base::TemporaryFile temporary_file = std::move(temporary_file_or_error.value());
+  temporary_file.CloseAndRemove();
+  const std::filesystem::path& file_path = temporary_file.file_path();
+
+  std::string started_file_path;
+  grpc::Status status = StartLocalCapture(file_path.string(), &started_file_path);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  EXPECT_EQ(started_file_path, file_path.string());
+
+  StopLocalCaptureResponse response;
+  status = StopLocalCapture(&response);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  EXPECT_EQ(response.file_path(), file_path.string());
+  std::error_code error;
+  EXPECT_EQ(response.file_size(), std::filesystem::file_size(file_path, error));
+
+  auto capture_file_or_error = orbit_capture_file::CaptureFile::OpenForReadWrite(file_path);
+  ASSERT_TRUE(capture_file_or_error.has_value()) << capture_file_or_error.error().message();
+  auto capture_section = capture_file_or_error.value()->CreateCaptureSectionInputStream();
+  ClientCaptureEvent event;
+  ASSERT_FALSE(capture_section->ReadMessage(&event).has_error());
+  EXPECT_EQ(event.event_case(), ClientCaptureEvent::kCaptureStarted);
+  // The capture must end with CaptureFinished, after which we can't read any further.
+  while (event.event_case() != ClientCaptureEvent::kCaptureFinished) {
+    ErrorMessageOr<void> read_result = capture_section->ReadMessage(&event);
+    ASSERT_FALSE(read_result.has_error()) << read_result.error().message();
+  }
+  EXPECT_EQ(event.capture_finished().status(), orbit_grpc_protos::CaptureFinished::kSuccessful);
+
+  std::filesystem::remove(file_path, error);
+}
+
+TEST_F(CaptureServiceImplTest, StartLocalCaptureFailsWhileCaptureIsInProgress) {
+  std::string file_path;
+  grpc::Status status = StartLocalCapture("", &file_path);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+
+  EXPECT_EQ(StartLocalCapture("").error_code(), grpc::StatusCode::ALREADY_EXISTS);
+
+  StopLocalCaptureResponse response;
+  status = StopLocalCapture(&response);
+  EXPECT_TRUE(status.ok()) << status.error_message();
+  std::error_code error;
+  std::filesystem::remove(file_path, error);
+}
+
+TEST_F(CaptureServiceImplTest, StopLocalCaptureFailsWhenNoCaptureIsInProgress) {
+  StopLocalCaptureResponse response;
+  EXPECT_EQ(StopLocalCapture(&response).error_code(), grpc::StatusCode::FAILED_PRECONDITION);
+}
+
+TEST_F(CaptureServiceImplTest, DefaultLocalCaptureFilePathsAreUnique) {
+  // Captures started within the same second get the same time in their file names.
+  std::string first_file_path;
+  grpc::Status status = StartLocalCapture("", &first_file_path);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  StopLocalCaptureResponse response;
+  status = StopLocalCapture(&response);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+
+  std::string second_file_path;
+  status = StartLocalCapture("", &second_file_path);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  status = StopLocalCapture(&response);
+  ASSERT_TRUE(status.ok()) << status.error_message();
+
+  EXPECT_NE(first_file_path, second_file_path);
+  std::error_code error;
+  EXPECT_TRUE(std::filesystem::exists(first_file_path, error));
+  EXPECT_TRUE(std::filesystem::exists(second_file_path, error));
+  std::filesystem::remove(first_file_path, error);
+  std::filesystem::remove(second_file_path, error);
+}
+
+}  // namespace orbit_service
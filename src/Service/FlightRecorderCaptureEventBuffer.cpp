@@ -0,0 +1,146 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "FlightRecorderCaptureEventBuffer.h"
+
+#include <absl/strings/str_format.h>
+
+#include <string>
+#include <utility>
+
+#include "Introspection/Introspection.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+
+namespace orbit_service {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace {
+
+// These events are passed on right away instead of being recorded in the ring.
+bool IsPassedOnRightAway(const ClientCaptureEvent& event) {
+  switch (event.event_case()) {
+    case ClientCaptureEvent::kAddressInfo:
+    case ClientCaptureEvent::kCaptureStarted:
+    case ClientCaptureEvent::kClockResolutionEvent:
+    case ClientCaptureEvent::kErrorEnablingOrbitApiEvent:
+    case ClientCaptureEvent::kErrorEnablingUserSpaceInstrumentationEvent:
+    case ClientCaptureEvent::kErrorsWithPerfEventOpenEvent:
+    case ClientCaptureEvent::kInternedCallstack:
+    case ClientCaptureEvent::kInternedString:
+    case ClientCaptureEvent::kInternedTracepointInfo:
+    case ClientCaptureEvent::kModulesSnapshot:
+    case ClientCaptureEvent::kModuleUpdateEvent:
+    case ClientCaptureEvent::kThreadName:
+    case ClientCaptureEvent::kThreadNamesSnapshot:
+    case ClientCaptureEvent::kWarningEvent:
+      return true;
+    default:
+      return false;
+  }
+}
+
+ClientCaptureEvent CreateWarningEvent(std::string message) {
+  ClientCaptureEvent event;
+  orbit_grpc_protos::WarningEvent* warning_event = event.mutable_warning_event();
+  warning_event->set_timestamp_ns(orbit_base::CaptureTimestampNs());
+  warning_event->set_message(std::move(message));
+  return event;
+}
+
+}  // namespace
+
+FlightRecorderCaptureEventBuffer::FlightRecorderCaptureEventBuffer(
+    CaptureEventBuffer* output_buffer, orbit_grpc_protos::FlightRecorderOptions options,
+    uint64_t max_buffered_bytes)
+    : output_buffer_{output_buffer},
+      options_{std::move(options)},
+      max_buffered_bytes_{max_buffered_bytes} {
+  CHECK(output_buffer_ != nullptr);
+}
+
+void FlightRecorderCaptureEventBuffer::AddEvent(ClientCaptureEvent&& event) {
+  if (IsPassedOnRightAway(event)) {
+    output_buffer_->AddEvent(std::move(event));
+    return;
+  }
+
+  if (event.event_case() == ClientCaptureEvent::kCaptureFinished) {
+    absl::MutexLock lock{&mutex_};
+    FlushLocked();
+    output_buffer_->AddEvent(std::move(event));
+    return;
+  }
+
+  const bool is_trigger = IsTrigger(event);
+  const uint64_t now_ns = orbit_base::CaptureTimestampNs();
+  const uint64_t event_bytes = event.ByteSizeLong();
+  absl::MutexLock lock{&mutex_};
+  ring_.push_back(RecordedEvent{now_ns, event_bytes, std::move(event)});
+  ring_bytes_ += event_bytes;
+  DropEventsOutsideOfWindow(now_ns);
+
+  if (is_trigger) {
+    LOG("Flight recorder triggered by function with id %u",
+        options_.function_duration_trigger().function_id());
+    FlushLocked();
+  }
+}
+
+uint64_t FlightRecorderCaptureEventBuffer::Flush() {
+  absl::MutexLock lock{&mutex_};
+  return FlushLocked();
+}
+
+bool FlightRecorderCaptureEventBuffer::IsTrigger(const ClientCaptureEvent& event) const {
+  if (!options_.has_function_duration_trigger() ||
+      event.event_case() != ClientCaptureEvent::kFunctionCall) {
+    return false;
+  }
+  const orbit_grpc_protos::FlightRecorderOptions::FunctionDurationTrigger& trigger =
+      options_.function_duration_trigger();
+  return event.function_call().function_id() == trigger.function_id() &&
+         event.function_call().duration_ns() >= trigger.min_duration_ns();
+}
+
+void FlightRecorderCaptureEventBuffer::DropEventsOutsideOfWindow(uint64_t now_ns) {
+  while (!ring_.empty()) {
+    const RecordedEvent& oldest = ring_.front();
+    // Written as a difference, as adding a large window, e.g. the maximum value as "unbounded", to
+    // the timestamp would overflow.
+    const bool is_outside_of_window = now_ns > oldest.added_timestamp_ns &&
+                                      now_ns - oldest.added_timestamp_ns > options_.window_ns();
+    // The most recent event is kept even if it exceeds the memory limit by itself.
+    const bool exceeds_memory_limit = ring_bytes_ > max_buffered_bytes_ && ring_.size() > 1;
+    if (!is_outside_of_window && !exceeds_memory_limit) break;
+    if (!is_outside_of_window) ++events_dropped_in_window_count_;
+    ring_bytes_ -= oldest.bytes;
+    ring_.pop_front();
+  }
+}
+
+uint64_t FlightRecorderCaptureEventBuffer::FlushLocked() {
+  ORBIT_SCOPE_FUNCTION;
+  DropEventsOutsideOfWindow(orbit_base::CaptureTimestampNs());
+  if (events_dropped_in_window_count_ > 0) {
+    output_buffer_->AddEvent(CreateWarningEvent(absl::StrFormat(
+        "The flight recorder reached its limit of %u MB and had to drop %u of the events in its "
+        "window of %u ms. Only the most recent events were kept.",
+        max_buffered_bytes_ / 1024 / 1024, events_dropped_in_window_count_,
+        options_.window_ns() / 1'000'000)));
+    events_dropped_in_window_count_ = 0;
+  }
+
+  const uint64_t flushed_event_count = ring_.size();
+  ORBIT_UINT64("Flight recorder events flushed", flushed_event_count);
+  for (RecordedEvent& recorded_event : ring_) {
+    output_buffer_->AddEvent(std::move(recorded_event.event));
+  }
+  ring_.clear();
+  ring_bytes_ = 0;
+  return flushed_event_count;
+}
+
+}  // namespace orbit_service
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_SERVICE_FLIGHT_RECORDER_CAPTURE_EVENT_BUFFER_H_
+#define ORBIT_SERVICE_FLIGHT_RECORDER_CAPTURE_EVENT_BUFFER_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <deque>
+
+#include "CaptureEventBuffer.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+// Holds back the events added to it in a ring of the most recent ones, and only passes the content
+// of the ring on to `output_buffer` when flushed: when Flush is called, when the FunctionCall of
+// the trigger in `options` is added, or when CaptureFinished is added.
+//
+// The ring keeps the events added in the last `options.window_ns()`, and at most
+// `max_buffered_bytes` of them (as measured by their serialized size), so that memory stays
+// constant however long the capture runs. Events that later events refer to or that describe the
+// whole capture (interned strings and callstacks, modules, thread names, ...) are not held back but
+// passed on right away, so that they always precede the events that need them.
+class FlightRecorderCaptureEventBuffer final : public CaptureEventBuffer {
+ public:
+  FlightRecorderCaptureEventBuffer(CaptureEventBuffer* output_buffer,
+                                   orbit_grpc_protos::FlightRecorderOptions options,
+                                   uint64_t max_buffered_bytes);
+
+  void AddEvent(orbit_grpc_protos::ClientCaptureEvent&& event) override;
+
+  // Passes on the events in the ring, from the oldest to the most recent, and empties the ring.
+  // Returns the number of events passed on.
+  uint64_t Flush();
+
+ private:
+  struct RecordedEvent {
+    uint64_t added_timestamp_ns;
+    uint64_t bytes;
+    orbit_grpc_protos::ClientCaptureEvent event;
+  };
+
+  [[nodiscard]] bool IsTrigger(const orbit_grpc_protos::ClientCaptureEvent& event) const;
+  void DropEventsOutsideOfWindow(uint64_t now_ns) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  uint64_t FlushLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  CaptureEventBuffer* output_buffer_;
+  const orbit_grpc_protos::FlightRecorderOptions options_;
+  const uint64_t max_buffered_bytes_;
+
+  absl::Mutex mutex_;
+  std::deque<RecordedEvent> ring_ ABSL_GUARDED_BY(mutex_);
+  uint64_t ring_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Events dropped since the last flush only because of `max_buffered_bytes_`, i.e., while they
+  // were still in the window.
+  uint64_t events_dropped_in_window_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace orbit_service
+
+#endif  // ORBIT_SERVICE_FLIGHT_RECORDER_CAPTURE_EVENT_BUFFER_H_
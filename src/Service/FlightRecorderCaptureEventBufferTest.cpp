@@ -0,0 +1,180 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+#include "CaptureEventBuffer.h"
+#include "FlightRecorderCaptureEventBuffer.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+namespace {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::FlightRecorderOptions;
+
+class FakeCaptureEventBuffer : public CaptureEventBuffer {
+ public:
+  void AddEvent(ClientCaptureEvent&& event) override { events_.emplace_back(std::move(event)); }
+
+  [[nodiscard]] const std::vector<ClientCaptureEvent>& events() const { return events_; }
+
+ private:
+  std::vector<ClientCaptureEvent> events_;
+};
+
+constexpr uint64_t kTriggerFunctionId = 42;
+constexpr uint64_t kTriggerMinDurationNs = 16'000'000;
+
+FlightRecorderOptions CreateOptions(uint64_t window_ns) {
+  FlightRecorderOptions options;
+  options.set_window_ns(window_ns);
+  options.mutable_function_duration_trigger()->set_function_id(kTriggerFunctionId);
+  options.mutable_function_duration_trigger()->set_min_duration_ns(kTriggerMinDurationNs);
+  return options;
+}
+
+ClientCaptureEvent CreateSchedulingSlice(int32_t tid) {
+  ClientCaptureEvent event;
+  event.mutable_scheduling_slice()->set_tid(tid);
+  return event;
+}
+
+ClientCaptureEvent CreateFunctionCall(uint64_t function_id, uint64_t duration_ns) {
+  ClientCaptureEvent event;
+  event.mutable_function_call()->set_function_id(function_id);
+  event.mutable_function_call()->set_duration_ns(duration_ns);
+  return event;
+}
+
+ClientCaptureEvent CreateInternedString(uint64_t key) {
+  ClientCaptureEvent event;
+  event.mutable_interned_string()->set_key(key);
+  event.mutable_interned_string()->set_intern("interned string");
+  return event;
+}
+
+std::vector<int32_t> GetSchedulingSliceTids(const std::vector<ClientCaptureEvent>& events) {
+  std::vector<int32_t> tids;
+  for (const ClientCaptureEvent& event : events) {
+    if (event.event_case() == ClientCaptureEvent::kSchedulingSlice) {
+      tids.push_back(event.scheduling_slice().tid());
+    }
+  }
+  return tids;
+}
+
+constexpr uint64_t kLongWindowNs = std::numeric_limits<uint64_t>::max() / 2;
+constexpr uint64_t kNoMemoryLimit = std::numeric_limits<uint64_t>::max();
+
+}  // namespace
+
+TEST(FlightRecorderCaptureEventBuffer, HoldsBackEventsUntilFlush) {
+  FakeCaptureEventBuffer output;
+  FlightRecorderCaptureEventBuffer flight_recorder{&output, CreateOptions(kLongWindowNs),
+                                                   kNoMemoryLimit};
+  flight_recorder.AddEvent(CreateSchedulingSlice(1));
+  flight_recorder.AddEvent(CreateSchedulingSlice(2));
+  flight_recorder.AddEvent(CreateSchedulingSlice(3));
+  EXPECT_TRUE(output.events().empty());
+
+  EXPECT_EQ(flight_recorder.Flush(), 3);
+  EXPECT_THAT(GetSchedulingSliceTids(output.events()), testing::ElementsAre(1, 2, 3));
+
+  EXPECT_EQ(flight_recorder.Flush(), 0);
+  EXPECT_EQ(output.events().size(), 3);
+}
+
+TEST(FlightRecorderCaptureEventBuffer, PassesOnInternedEventsRightAway) {
+  FakeCaptureEventBuffer output;
+  FlightRecorderCaptureEventBuffer flight_recorder{&output, CreateOptions(kLongWindowNs),
+                                                   kNoMemoryLimit};
+  flight_recorder.AddEvent(CreateSchedulingSlice(1));
+  flight_recorder.AddEvent(CreateInternedString(1));
+
+  ASSERT_EQ(output.events().size(), 1);
+  EXPECT_EQ(output.events()[0].event_case(), ClientCaptureEvent::kInternedString);
+}
+
+TEST(FlightRecorderCaptureEventBuffer, DropsEventsOutsideOfWindow) {
+  FakeCaptureEventBuffer output;
+  FlightRecorderCaptureEventBuffer flight_recorder{&output, CreateOptions(absl::ToInt64Nanoseconds(
+                                                                absl::Milliseconds(1))),
+                                                   kNoMemoryLimit};
+  flight_recorder.AddEvent(CreateSchedulingSlice(1));
+  absl::SleepFor(absl::Milliseconds(10));
+  flight_recorder.AddEvent(CreateSchedulingSlice(2));
+  flight_recorder.AddEvent(CreateSchedulingSlice(3));
+
+  // The last events might also have left the window by the time of the flush.
+  flight_recorder.Flush();
+  EXPECT_THAT(GetSchedulingSliceTids(output.events()), testing::Not(testing::Contains(1)));
+}
+
+TEST(FlightRecorderCaptureEventBuffer, KeepsAllEventsWithMaximumWindow) {
+  FakeCaptureEventBuffer output;
+  FlightRecorderCaptureEventBuffer flight_recorder{
+      &output, CreateOptions(std::numeric_limits<uint64_t>::max()), kNoMemoryLimit};
+  flight_recorder.AddEvent(CreateSchedulingSlice(1));
+  absl::SleepFor(absl::Milliseconds(1));
+  flight_recorder.AddEvent(CreateSchedulingSlice(2));
+
+  EXPECT_EQ(flight_recorder.Flush(), 2);
+  EXPECT_THAT(GetSchedulingSliceTids(output.events()), testing::ElementsAre(1, 2));
+}
+
+TEST(FlightRecorderCaptureEventBuffer, DropsOldestEventsBeyondMemoryLimit) {
+  FakeCaptureEventBuffer output;
+  const uint64_t max_buffered_bytes = 2 * CreateSchedulingSlice(1).ByteSizeLong();
+  FlightRecorderCaptureEventBuffer flight_recorder{&output, CreateOptions(kLongWindowNs),
+                                                   max_buffered_bytes};
+  for (int32_t tid = 1; tid <= 5; ++tid) {
+    flight_recorder.AddEvent(CreateSchedulingSlice(tid));
+  }
+
+  EXPECT_EQ(flight_recorder.Flush(), 2);
+  ASSERT_EQ(output.events().size(), 3);
+  EXPECT_EQ(output.events()[0].event_case(), ClientCaptureEvent::kWarningEvent);
+  EXPECT_THAT(output.events()[0].warning_event().message(), testing::HasSubstr("drop 3"));
+  EXPECT_THAT(GetSchedulingSliceTids(output.events()), testing::ElementsAre(4, 5));
+}
+
+TEST(FlightRecorderCaptureEventBuffer, FlushesWhenTriggerFunctionTakesLong) {
+  FakeCaptureEventBuffer output;
+  FlightRecorderCaptureEventBuffer flight_recorder{&output, CreateOptions(kLongWindowNs),
+                                                   kNoMemoryLimit};
+  flight_recorder.AddEvent(CreateSchedulingSlice(1));
+  flight_recorder.AddEvent(CreateFunctionCall(kTriggerFunctionId, kTriggerMinDurationNs - 1));
+  flight_recorder.AddEvent(CreateFunctionCall(kTriggerFunctionId + 1, kTriggerMinDurationNs));
+  EXPECT_TRUE(output.events().empty());
+
+  flight_recorder.AddEvent(CreateFunctionCall(kTriggerFunctionId, kTriggerMinDurationNs));
+  ASSERT_EQ(output.events().size(), 4);
+  EXPECT_EQ(output.events()[3].function_call().function_id(), kTriggerFunctionId);
+  EXPECT_EQ(output.events()[3].function_call().duration_ns(), kTriggerMinDurationNs);
+}
+
+TEST(FlightRecorderCaptureEventBuffer, FlushesWhenCaptureFinishes) {
+  FakeCaptureEventBuffer output;
+  FlightRecorderCaptureEventBuffer flight_recorder{&output, CreateOptions(kLongWindowNs),
+                                                   kNoMemoryLimit};
+  flight_recorder.AddEvent(CreateSchedulingSlice(1));
+  ClientCaptureEvent capture_finished;
+  capture_finished.mutable_capture_finished();
+  flight_recorder.AddEvent(std::move(capture_finished));
+
+  ASSERT_EQ(output.events().size(), 2);
+  EXPECT_EQ(output.events()[0].event_case(), ClientCaptureEvent::kSchedulingSlice);
+  EXPECT_EQ(output.events()[1].event_case(), ClientCaptureEvent::kCaptureFinished);
+}
+
+}  // namespace orbit_service
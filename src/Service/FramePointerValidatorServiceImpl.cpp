@@ -8,6 +8,8 @@
 
 #include <memory>
 #include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "FramePointerValidator/FramePointerValidator.h"
@@ -21,26 +23,34 @@ using orbit_grpc_protos::CodeBlock;
 using orbit_grpc_protos::ValidateFramePointersRequest;
 using orbit_grpc_protos::ValidateFramePointersResponse;
 
-grpc::Status FramePointerValidatorServiceImpl::ValidateFramePointers(
-    grpc::ServerContext*, const ValidateFramePointersRequest* request,
-    ValidateFramePointersResponse* response) {
-  // Even though this information should be available on the client,
-  // we want not rely on this here, and for this particular use case we are
-  // fine with doing some extra work, and read it from the elf file.
-  auto elf_file_result = orbit_object_utils::CreateElfFile(request->module_path());
+namespace {
 
+// Even though this information should be available on the client,
+// we want not rely on this here, and for this particular use case we are
+// fine with doing some extra work, and read it from the elf file.
+ErrorMessageOr<bool> IsModule64Bit(const std::string& module_path) {
+  auto elf_file_result = orbit_object_utils::CreateElfFile(module_path);
   if (elf_file_result.has_error()) {
-    return grpc::Status(grpc::StatusCode::INTERNAL,
-                        absl::StrFormat("Unable to load module \"%s\": %s", request->module_path(),
-                                        elf_file_result.error().message()));
+    return ErrorMessage{absl::StrFormat("Unable to load module \"%s\": %s", module_path,
+                                        elf_file_result.error().message())};
   }
+  return elf_file_result.value()->Is64Bit();
+}
 
-  bool is_64_bit = elf_file_result.value()->Is64Bit();
+}  // namespace
+
+grpc::Status FramePointerValidatorServiceImpl::ValidateFramePointers(
+    grpc::ServerContext*, const ValidateFramePointersRequest* request,
+    ValidateFramePointersResponse* response) {
+  ErrorMessageOr<bool> is_64_bit = IsModule64Bit(request->module_path());
+  if (is_64_bit.has_error()) {
+    return grpc::Status(grpc::StatusCode::INTERNAL, is_64_bit.error().message());
+  }
 
   std::vector<CodeBlock> function_infos(request->functions().begin(), request->functions().end());
 
-  std::optional<std::vector<CodeBlock>> functions =
-      FramePointerValidator::GetFpoFunctions(function_infos, request->module_path(), is_64_bit);
+  std::optional<std::vector<CodeBlock>> functions = FramePointerValidator::GetFpoFunctions(
+      function_infos, request->module_path(), is_64_bit.value());
 
   if (!functions.has_value()) {
     return grpc::Status(
@@ -57,4 +67,36 @@ grpc::Status FramePointerValidatorServiceImpl::ValidateFramePointers(
   return grpc::Status::OK;
 }
 
+grpc::Status FramePointerValidatorServiceImpl::ValidateFramePointersIncrementally(
+    grpc::ServerContext* context, const ValidateFramePointersRequest* request,
+    grpc::ServerWriter<ValidateFramePointersResponse>* writer) {
+  ErrorMessageOr<bool> is_64_bit = IsModule64Bit(request->module_path());
+  if (is_64_bit.has_error()) {
+    return grpc::Status(grpc::StatusCode::INTERNAL, is_64_bit.error().message());
+  }
+
+  std::vector<CodeBlock> function_infos(request->functions().begin(), request->functions().end());
+
+  // Once writing fails, the client is gone and the remaining results are dropped.
+  bool client_is_gone = false;
+  ErrorMessageOr<void> result = FramePointerValidator::GetFpoFunctions(
+      function_infos, request->module_path(), is_64_bit.value(),
+      [writer, &client_is_gone](std::vector<CodeBlock> functions) {
+        if (client_is_gone) return;
+        ValidateFramePointersResponse response;
+        for (CodeBlock& function : functions) {
+          *response.add_functions_without_frame_pointer() = std::move(function);
+        }
+        client_is_gone = !writer->Write(response);
+      });
+
+  if (result.has_error()) {
+    return grpc::Status(grpc::StatusCode::INTERNAL,
+                        absl::StrFormat("Unable to verify functions of module %s: %s",
+                                        request->module_path(), result.error().message()));
+  }
+  if (context->IsCancelled()) return grpc::Status::CANCELLED;
+  return grpc::Status::OK;
+}
+
 }  // namespace orbit_service
@@ -22,6 +22,10 @@ class FramePointerValidatorServiceImpl final
   [[nodiscard]] grpc::Status ValidateFramePointers(
       grpc::ServerContext* context, const orbit_grpc_protos::ValidateFramePointersRequest* request,
       orbit_grpc_protos::ValidateFramePointersResponse* response) override;
+
+  [[nodiscard]] grpc::Status ValidateFramePointersIncrementally(
+      grpc::ServerContext* context, const orbit_grpc_protos::ValidateFramePointersRequest* request,
+      grpc::ServerWriter<orbit_grpc_protos::ValidateFramePointersResponse>* writer) override;
 };
 
 }  // namespace orbit_service
@@ -0,0 +1,69 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "LocalCapture.h"
+
+#include <utility>
+
+#include "Introspection/Introspection.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_service {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+
+CaptureFileEventSender::CaptureFileEventSender(
+    std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream)
+    : output_stream_{std::move(output_stream)} {
+  CHECK(output_stream_ != nullptr);
+}
+
+void CaptureFileEventSender::SendEvents(std::vector<ClientCaptureEvent>* events) {
+  ORBIT_SCOPE_FUNCTION;
+  CHECK(events != nullptr);
+  // After an error, the output stream has removed the file and can't be written to anymore.
+  if (write_error_.has_value()) return;
+
+  for (const ClientCaptureEvent& event : *events) {
+    ErrorMessageOr<void> result = output_stream_->WriteCaptureEvent(event);
+    if (result.has_error()) {
+      ERROR("Writing capture file: %s", result.error().message());
+      write_error_ = result.error();
+      return;
+    }
+  }
+}
+
+ErrorMessageOr<void> CaptureFileEventSender::Close() {
+  if (write_error_.has_value()) return write_error_.value();
+  return output_stream_->Close();
+}
+
+LocalCapture::LocalCapture(
+    std::filesystem::path file_path,
+    std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream,
+    uint64_t max_buffered_bytes)
+    : file_path_{std::move(file_path)},
+      capture_file_event_sender_{std::move(output_stream)},
+      capture_event_buffer_{&capture_file_event_sender_, max_buffered_bytes} {}
+
+LocalCapture::~LocalCapture() { CHECK(!capture_thread_.joinable()); }
+
+void LocalCapture::Start(RunCaptureFunction run_capture) {
+  capture_thread_ = std::thread{[this, run_capture = std::move(run_capture)] {
+    orbit_base::SetCurrentThreadName("CSImpl::Local");
+    run_capture(&capture_event_buffer_, [this] { stop_requested_.WaitForNotification(); });
+    capture_event_buffer_.StopAndWait();
+  }};
+}
+
+ErrorMessageOr<void> LocalCapture::Stop() {
+  stop_requested_.Notify();
+  capture_thread_.join();
+  return capture_file_event_sender_.Close();
+}
+
+}  // namespace orbit_service
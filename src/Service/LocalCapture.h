@@ -0,0 +1,74 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_SERVICE_LOCAL_CAPTURE_H_
+#define ORBIT_SERVICE_LOCAL_CAPTURE_H_
+
+#include <absl/synchronization/notification.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "CaptureEventBuffer.h"
+#include "CaptureEventSender.h"
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "OrbitBase/Result.h"
+#include "SenderThreadCaptureEventBuffer.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+// Writes the events to a capture file instead of sending them to the client.
+class CaptureFileEventSender final : public CaptureEventSender {
+ public:
+  explicit CaptureFileEventSender(
+      std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream);
+
+  void SendEvents(std::vector<orbit_grpc_protos::ClientCaptureEvent>* events) override;
+
+  // Closes the file, or returns the first error that happened while writing to it.
+  [[nodiscard]] ErrorMessageOr<void> Close();
+
+ private:
+  std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream_;
+  std::optional<ErrorMessage> write_error_;
+};
+
+// A capture started with StartLocalCapture. The capture runs on its own thread until Stop is
+// called, and the sender thread of `capture_event_buffer` writes the events to the file.
+class LocalCapture {
+ public:
+  // Runs the capture, adding its events to the given buffer, until the function passed as second
+  // argument returns.
+  using RunCaptureFunction =
+      std::function<void(CaptureEventBuffer*, const std::function<void()>&)>;
+
+  LocalCapture(std::filesystem::path file_path,
+               std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream,
+               uint64_t max_buffered_bytes);
+  ~LocalCapture();
+
+  void Start(RunCaptureFunction run_capture);
+
+  // Stops the capture, waits for all events to be written, and closes the file.
+  [[nodiscard]] ErrorMessageOr<void> Stop();
+
+  [[nodiscard]] const std::filesystem::path& file_path() const { return file_path_; }
+
+ private:
+  std::filesystem::path file_path_;
+  CaptureFileEventSender capture_file_event_sender_;
+  SenderThreadCaptureEventBuffer capture_event_buffer_;
+  absl::Notification stop_requested_;
+  std::thread capture_thread_;
+};
+
+}  // namespace orbit_service
+
+#endif  // ORBIT_SERVICE_LOCAL_CAPTURE_H_
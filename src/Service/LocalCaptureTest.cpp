@@ -0,0 +1,108 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "CaptureEventBuffer.h"
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "LocalCapture.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/TemporaryFile.h"
+#include "OrbitBase/TestUtils.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+namespace {
+
+using orbit_base::HasError;
+using orbit_base::HasNoError;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+constexpr uint64_t kMaxBufferedBytes = 1024 * 1024;
+constexpr uint64_t kEventCount = 1000;
+
+class FailingCaptureFileOutputStream : public orbit_capture_file::CaptureFileOutputStream {
+ public:
+  [[nodiscard]] ErrorMessageOr<void> WriteCaptureEvent(
+      const ClientCaptureEvent& /*event*/) override {
+    return ErrorMessage{"No space left on device"};
+  }
+  ErrorMessageOr<void> Close() noexcept override { return outcome::success(); }
+  [[nodiscard]] bool IsOpen() noexcept override { return true; }
+};
+
+ClientCaptureEvent CreateInternedStringEvent(uint64_t key) {
+  ClientCaptureEvent event;
+  event.mutable_interned_string()->set_key(key);
+  event.mutable_interned_string()->set_intern("interned string");
+  return event;
+}
+
+ClientCaptureEvent CreateCaptureFinishedEvent() {
+  ClientCaptureEvent event;
+  event.mutable_capture_finished()->set_status(orbit_grpc_protos::CaptureFinished::kSuccessful);
+  return event;
+}
+
+// Adds events until the stop is requested, and then the CaptureFinished event, like
+// CaptureServiceImpl::RunCapture.
+void FakeRunCapture(CaptureEventBuffer* capture_event_buffer,
+                    const std::function<void()>& wait_for_stop_request) {
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    capture_event_buffer->AddEvent(CreateInternedStringEvent(key));
+  }
+  wait_for_stop_request();
+  capture_event_buffer->AddEvent(CreateCaptureFinishedEvent());
+}
+
+}  // namespace
+
+TEST(LocalCapture, WritesCaptureFileEndingInCaptureFinished) {
+  auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+  ASSERT_TRUE(temporary_file_or_error.has_value()) << temporary_file_or_error.error().message();
+  orbit_base::TemporaryFile temporary_file = std::move(temporary_file_or_error.value());
+  temporary_file.CloseAndRemove();
+  const std::filesystem::path& file_path = temporary_file.file_path();
+
+  auto output_stream_or_error = orbit_capture_file::CaptureFileOutputStream::Create(file_path);
+  ASSERT_TRUE(output_stream_or_error.has_value()) << output_stream_or_error.error().message();
+  LocalCapture local_capture{file_path, std::move(output_stream_or_error.value()),
+                             kMaxBufferedBytes};
+  EXPECT_EQ(local_capture.file_path(), file_path);
+  local_capture.Start(&FakeRunCapture);
+  ASSERT_THAT(local_capture.Stop(), HasNoError());
+
+  auto capture_file_or_error = orbit_capture_file::CaptureFile::OpenForReadWrite(file_path);
+  ASSERT_TRUE(capture_file_or_error.has_value()) << capture_file_or_error.error().message();
+  auto capture_section = capture_file_or_error.value()->CreateCaptureSectionInputStream();
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    ClientCaptureEvent event;
+    ASSERT_THAT(capture_section->ReadMessage(&event), HasNoError());
+    ASSERT_EQ(event.event_case(), ClientCaptureEvent::kInternedString);
+    EXPECT_EQ(event.interned_string().key(), key);
+  }
+  ClientCaptureEvent event;
+  ASSERT_THAT(capture_section->ReadMessage(&event), HasNoError());
+  EXPECT_EQ(event.event_case(), ClientCaptureEvent::kCaptureFinished);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(LocalCapture, StopReturnsWriteError) {
+  LocalCapture local_capture{"capture.orbit", std::make_unique<FailingCaptureFileOutputStream>(),
+                             kMaxBufferedBytes};
+  local_capture.Start(&FakeRunCapture);
+  EXPECT_THAT(local_capture.Stop(), HasError("No space left on device"));
+}
+
+}  // namespace orbit_service
@@ -70,7 +70,11 @@ bool OrbitGrpcServerImpl::Init(std::string_view server_address) {
   return server_ != nullptr;
 }
 
-void OrbitGrpcServerImpl::Shutdown() { server_->Shutdown(); }
+void OrbitGrpcServerImpl::Shutdown() {
+  capture_service_.Shutdown();
+  process_service_.Shutdown();
+  server_->Shutdown();
+}
 
 void OrbitGrpcServerImpl::Wait() { server_->Wait(); }
 
@@ -24,7 +24,8 @@ class OrbitGrpcServer {
   OrbitGrpcServer() = default;
   virtual ~OrbitGrpcServer() = default;
 
-  // Proxy calls to grpc::Server::Wait() and grpc::Server::Shutdown
+  // Proxy calls to grpc::Server::Wait() and grpc::Server::Shutdown. Shutdown also stops a local
+  // capture in progress, so call it before removing the CaptureStartStopListeners.
   virtual void Shutdown() = 0;
   virtual void Wait() = 0;
 
@@ -183,10 +183,12 @@ void OrbitService::Run(std::atomic<bool>* exit_requested) {
     std::this_thread::sleep_for(std::chrono::seconds{1});
   }
 
+  // This stops a local capture in progress while the producers can still send their last events.
+  grpc_server->Shutdown();
+
   producer_side_server->ShutdownAndWait();
   grpc_server->RemoveCaptureStartStopListener(producer_side_server.get());
 
-  grpc_server->Shutdown();
   grpc_server->Wait();
 }
 
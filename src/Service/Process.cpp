@@ -8,13 +8,17 @@
 #include <absl/strings/str_format.h>
 
 #include <algorithm>
+#include <array>
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "ObjectUtils/ElfFile.h"
+#include "ObjectUtils/ElfHeaderInfo.h"
 #include "OrbitBase/ExecutablePath.h"
+#include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
 #include "OrbitBase/Result.h"
@@ -44,7 +48,40 @@ void Process::UpdateCpuUsage(utils::Jiffies process_cpu_time, utils::TotalCpuTim
   previous_total_cpu_time_ = total_cpu_time.jiffies;
 }
 
+std::optional<utils::Jiffies> Process::ReadCumulativeCpuTime(bool keep_stat_file_open) {
+  if (!stat_fd_.valid()) {
+    const std::filesystem::path stat_file_path =
+        std::filesystem::path{"/proc"} / std::to_string(pid()) / "stat";
+    ErrorMessageOr<orbit_base::unique_fd> stat_fd_or_error =
+        orbit_base::OpenFileForReading(stat_file_path);
+    if (stat_fd_or_error.has_error()) {
+      return std::nullopt;
+    }
+    stat_fd_ = std::move(stat_fd_or_error.value());
+  }
+
+  // The content of the file is generated on every read from offset 0, and is well below 1 KB.
+  std::array<char, 4096> buffer;
+  ErrorMessageOr<size_t> size_or_error =
+      orbit_base::ReadFullyAtOffset(stat_fd_, buffer.data(), buffer.size(), 0);
+  std::optional<utils::Jiffies> cpu_time;
+  if (size_or_error.has_value()) {
+    cpu_time = utils::ParseCumulativeCpuTimeFromProcessStat(
+        std::string_view{buffer.data(), size_or_error.value()});
+  }
+
+  if (!keep_stat_file_open || !cpu_time.has_value()) {
+    stat_fd_.release();
+  }
+  return cpu_time;
+}
+
 ErrorMessageOr<Process> Process::FromPid(pid_t pid) {
+  return FromPid(pid, utils::GetCumulativeTotalCpuTime());
+}
+
+ErrorMessageOr<Process> Process::FromPid(pid_t pid,
+                                         const std::optional<utils::TotalCpuTime>& total_cpu_time) {
   const auto path = std::filesystem::path{"/proc"} / std::to_string(pid);
 
   if (!std::filesystem::is_directory(path)) {
@@ -69,8 +106,7 @@ ErrorMessageOr<Process> Process::FromPid(pid_t pid) {
   process.set_pid(pid);
   process.set_name(name);
 
-  const auto total_cpu_time = utils::GetCumulativeTotalCpuTime();
-  const auto cpu_time = utils::GetCumulativeCpuTimeFromProcess(process.pid());
+  const auto cpu_time = process.ReadCumulativeCpuTime(/*keep_stat_file_open=*/false);
   if (cpu_time && total_cpu_time) {
     process.UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
   } else {
@@ -94,6 +130,16 @@ ErrorMessageOr<Process> Process::FromPid(pid_t pid) {
   if (!file_path_result.has_error()) {
     process.set_full_path(file_path_result.value());
 
+    // Reading only the headers is much cheaper than loading the whole file, but only supports
+    // 64-bit files.
+    ErrorMessageOr<orbit_object_utils::ElfHeaderInfo> header_info =
+        orbit_object_utils::ReadElfHeaderInfo(file_path_result.value());
+    if (header_info.has_value()) {
+      process.set_is_64_bit(true);
+      process.set_build_id(header_info.value().build_id);
+      return process;
+    }
+
     const auto& elf_file = orbit_object_utils::CreateElfFile(file_path_result.value());
     if (!elf_file.has_error()) {
       process.set_is_64_bit(elf_file.value()->Is64Bit());
@@ -7,6 +7,9 @@
 
 #include <sys/types.h>
 
+#include <optional>
+
+#include "OrbitBase/File.h"
 #include "OrbitBase/Result.h"
 #include "ServiceUtils.h"
 #include "process.pb.h"
@@ -19,11 +22,23 @@ class Process : public orbit_grpc_protos::ProcessInfo {
 
   void UpdateCpuUsage(utils::Jiffies process_cpu_time, utils::TotalCpuTime total_cpu_time);
 
+  // Reads the cumulative CPU time of the process from `/proc/<pid>/stat`. If
+  // `keep_stat_file_open` is true, the file stays open and is read again by the next call, which
+  // saves opening it. Reading the open file fails once the process has exited, even if its pid has
+  // been reused by another process since.
+  [[nodiscard]] std::optional<utils::Jiffies> ReadCumulativeCpuTime(bool keep_stat_file_open);
+  [[nodiscard]] bool HasOpenStatFile() const { return stat_fd_.valid(); }
+
   // Creates a `Process` by reading details from the `/proc` filesystem.
   // This might fail due to a non existing pid or due to permission problems.
   static ErrorMessageOr<Process> FromPid(pid_t pid);
+  // Same as above, but computes the CPU usage from the given total CPU time, so that callers
+  // creating many processes only need to read it once.
+  static ErrorMessageOr<Process> FromPid(pid_t pid,
+                                         const std::optional<utils::TotalCpuTime>& total_cpu_time);
 
  private:
+  orbit_base::unique_fd stat_fd_;
   utils::Jiffies previous_process_cpu_time_ = {};
   utils::Jiffies previous_total_cpu_time_ = {};
 };
@@ -5,70 +5,106 @@
 #include "ProcessList.h"
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/strings/numbers.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <google/protobuf/util/message_differencer.h>
 #include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
-#include <filesystem>
-#include <string>
+#include <array>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/SafeStrerror.h"
 #include "ServiceUtils.h"
 
 namespace orbit_service {
 
-ErrorMessageOr<void> ProcessList::Refresh() {
-  absl::flat_hash_map<pid_t, Process> updated_processes{};
-
-  // TODO(b/161423785): This for loop should be refactored. For example, when
-  //  parts are in a separate function, OUTCOME_TRY could be used to simplify
-  //  error handling.
-  std::error_code error;
-  auto directory_iterator = std::filesystem::directory_iterator("/proc", error);
-  if (error) {
-    return ErrorMessage(absl::StrFormat("Unable to iterate /proc directory: %s", error.message()));
+ErrorMessageOr<std::vector<pid_t>> ProcessList::ReadPids() {
+  if (!proc_directory_fd_.valid()) {
+    int fd = TEMP_FAILURE_RETRY(open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd == -1) {
+      return ErrorMessage(
+          absl::StrFormat("Unable to open /proc directory: %s", SafeStrerror(errno)));
+    }
+    proc_directory_fd_ = orbit_base::unique_fd{fd};
+  } else if (lseek(proc_directory_fd_.get(), 0, SEEK_SET) == -1) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to rewind /proc directory: %s", SafeStrerror(errno)));
   }
 
-  for (auto it = begin(directory_iterator); it != end(directory_iterator); it.increment(error)) {
-    if (error) {
+  // Unlike iterating the directory with std::filesystem, this reads many entries per system call
+  // and uses the type of the entries returned with them instead of calling stat on each of them.
+  std::vector<pid_t> pids;
+  // struct dirent64 has the layout of the records returned by getdents64.
+  alignas(struct dirent64) std::array<char, 32 * 1024> buffer;
+  while (true) {
+    const long size =
+        syscall(SYS_getdents64, proc_directory_fd_.get(), buffer.data(), buffer.size());
+    if (size == -1) {
+      const int error = errno;
+      proc_directory_fd_.release();
       return ErrorMessage(
-          absl::StrFormat("Unable to iterate /proc directory: %s", error.message()));
+          absl::StrFormat("Unable to iterate /proc directory: %s", SafeStrerror(error)));
     }
+    if (size == 0) break;
 
-    bool is_directory = it->is_directory(error);
-    if (error) {
-      ERROR("Unable to stat \"%s\" directory entry: %s", it->path(), error.message());
-      continue;
-    }
+    for (long offset = 0; offset < size;) {
+      const auto* entry = reinterpret_cast<const struct dirent64*>(buffer.data() + offset);
+      offset += entry->d_reclen;
+      if (entry->d_type != DT_DIR) continue;
 
-    if (!is_directory) continue;
+      int32_t pid;
+      if (!absl::SimpleAtoi(entry->d_name, &pid)) continue;
+      pids.push_back(pid);
+    }
+  }
+  return pids;
+}
 
-    const std::filesystem::path& path = it->path();
-    std::string folder_name = path.filename().string();
+ErrorMessageOr<void> ProcessList::Refresh() {
+  OUTCOME_TRY(auto&& pids, ReadPids());
 
-    int32_t pid;
-    if (!absl::SimpleAtoi(folder_name, &pid)) continue;
+  // /proc/stat is the same for all processes, so only read it once per refresh.
+  const std::optional<utils::TotalCpuTime> total_cpu_time = utils::GetCumulativeTotalCpuTime();
 
+  absl::flat_hash_map<pid_t, Process> updated_processes{};
+  size_t open_stat_file_count = 0;
+  for (pid_t pid : pids) {
     const auto iter = processes_.find(pid);
 
     if (iter != processes_.end()) {
       auto process = processes_.extract(iter);
 
-      const auto total_cpu_time = utils::GetCumulativeTotalCpuTime();
-      const auto cpu_time = utils::GetCumulativeCpuTimeFromProcess(process.key());
-      if (cpu_time && total_cpu_time) {
-        process.mapped().UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
-      } else {
-        // We don't fail in this case. This could be a permission problem which might occur when not
-        // running as root.
-        ERROR("Could not update the CPU usage of process %d", process.key());
+      const bool had_open_stat_file = process.mapped().HasOpenStatFile();
+      const auto cpu_time = process.mapped().ReadCumulativeCpuTime(
+          /*keep_stat_file_open=*/open_stat_file_count < kMaxOpenStatFiles);
+      if (process.mapped().HasOpenStatFile()) ++open_stat_file_count;
+
+      // If reading the stat file we kept open fails, the process has exited and the pid has been
+      // reused by a new process, which is created from scratch below.
+      if (cpu_time.has_value() || !had_open_stat_file) {
+        if (cpu_time && total_cpu_time) {
+          process.mapped().UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
+        } else {
+          // We don't fail in this case. This could be a permission problem which might occur when
+          // not running as root.
+          ERROR("Could not update the CPU usage of process %d", process.key());
+        }
+
+        updated_processes.insert(std::move(process));
+        continue;
       }
-
-      updated_processes.insert(std::move(process));
-      continue;
     }
 
-    auto process_or_error = Process::FromPid(pid);
+    auto process_or_error = Process::FromPid(pid, total_cpu_time);
 
     if (process_or_error.has_error()) {
       // We don't fail in this case. This could be a permission problem which is restricted to a
@@ -91,4 +127,32 @@ ErrorMessageOr<void> ProcessList::Refresh() {
   return outcome::success();
 }
 
+orbit_grpc_protos::ProcessListUpdate ComputeProcessListUpdate(
+    const std::vector<orbit_grpc_protos::ProcessInfo>& processes,
+    absl::flat_hash_map<int32_t, orbit_grpc_protos::ProcessInfo>* previous_processes) {
+  CHECK(previous_processes != nullptr);
+  orbit_grpc_protos::ProcessListUpdate update;
+  absl::flat_hash_set<int32_t> pids;
+  pids.reserve(processes.size());
+  for (const orbit_grpc_protos::ProcessInfo& process : processes) {
+    pids.insert(process.pid());
+    auto [it, inserted] = previous_processes->try_emplace(process.pid(), process);
+    if (!inserted) {
+      if (google::protobuf::util::MessageDifferencer::Equals(it->second, process)) continue;
+      it->second = process;
+    }
+    *update.add_updated_processes() = process;
+  }
+
+  for (auto it = previous_processes->begin(); it != previous_processes->end();) {
+    if (pids.contains(it->first)) {
+      ++it;
+      continue;
+    }
+    update.add_removed_pids(it->first);
+    previous_processes->erase(it++);
+  }
+  return update;
+}
+
 }  // namespace orbit_service
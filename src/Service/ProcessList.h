@@ -5,6 +5,8 @@
 #ifndef ORBIT_SERVICE_PROCESS_LIST_
 #define ORBIT_SERVICE_PROCESS_LIST_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #include <algorithm>
@@ -13,15 +15,19 @@
 #include <utility>
 #include <vector>
 
+#include "OrbitBase/File.h"
 #include "OrbitBase/Result.h"
 #include "Process.h"
 #include "absl/container/flat_hash_map.h"
 #include "process.pb.h"
+#include "services.pb.h"
 
 namespace orbit_service {
 
 class ProcessList {
  public:
+  // Re-reads the list of processes from `/proc`, together with their CPU usage since the previous
+  // refresh. Only processes that are new since the previous refresh are read completely.
   [[nodiscard]] ErrorMessageOr<void> Refresh();
   [[nodiscard]] std::vector<orbit_grpc_protos::ProcessInfo> GetProcesses() const {
     std::vector<orbit_grpc_protos::ProcessInfo> processes;
@@ -43,9 +49,24 @@ class ProcessList {
   }
 
  private:
+  // Processes keep `/proc/<pid>/stat` open between refreshes, but stay well below the usual limit
+  // of open file descriptors.
+  static constexpr size_t kMaxOpenStatFiles = 512;
+
+  [[nodiscard]] ErrorMessageOr<std::vector<pid_t>> ReadPids();
+
+  // `/proc` is kept open and read again from the start on every refresh.
+  orbit_base::unique_fd proc_directory_fd_;
   absl::flat_hash_map<pid_t, Process> processes_;
 };
 
+// Returns the processes of `processes` that are new or changed compared to `previous_processes`,
+// and the pids of `previous_processes` that are not part of `processes` anymore. Afterwards,
+// `previous_processes` contains `processes`.
+[[nodiscard]] orbit_grpc_protos::ProcessListUpdate ComputeProcessListUpdate(
+    const std::vector<orbit_grpc_protos::ProcessInfo>& processes,
+    absl::flat_hash_map<int32_t, orbit_grpc_protos::ProcessInfo>* previous_processes);
+
 }  // namespace orbit_service
 
 #endif  // ORBIT_SERVICE_PROCESS_LIST_
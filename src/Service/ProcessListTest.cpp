@@ -3,15 +3,22 @@
 // found in the LICENSE file.
 //
 
+#include <absl/container/flat_hash_map.h>
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "OrbitBase/Result.h"
 #include "ProcessList.h"
 #include "ServiceUtils.h"
+#include "process.pb.h"
+#include "services.pb.h"
 
 namespace orbit_service {
 
@@ -39,4 +46,61 @@ TEST(ProcessList, ProcessList) {
   EXPECT_TRUE(process2.has_value());
 }
 
+namespace {
+
+orbit_grpc_protos::ProcessInfo CreateProcessInfo(int32_t pid, const std::string& name,
+                                                 double cpu_usage) {
+  orbit_grpc_protos::ProcessInfo process_info;
+  process_info.set_pid(pid);
+  process_info.set_name(name);
+  process_info.set_cpu_usage(cpu_usage);
+  return process_info;
+}
+
+std::vector<int32_t> GetPids(const orbit_grpc_protos::ProcessListUpdate& update) {
+  std::vector<int32_t> pids;
+  for (const auto& process_info : update.updated_processes()) {
+    pids.push_back(process_info.pid());
+  }
+  return pids;
+}
+
+}  // namespace
+
+TEST(ProcessList, ComputeProcessListUpdate) {
+  absl::flat_hash_map<int32_t, orbit_grpc_protos::ProcessInfo> previous_processes;
+
+  orbit_grpc_protos::ProcessListUpdate update = ComputeProcessListUpdate(
+      {CreateProcessInfo(1, "init", 0.0), CreateProcessInfo(42, "game", 50.0),
+       CreateProcessInfo(43, "shell", 1.0)},
+      &previous_processes);
+  EXPECT_THAT(GetPids(update), testing::UnorderedElementsAre(1, 42, 43));
+  EXPECT_THAT(update.removed_pids(), testing::IsEmpty());
+  EXPECT_EQ(previous_processes.size(), 3);
+
+  update = ComputeProcessListUpdate(
+      {CreateProcessInfo(1, "init", 0.0), CreateProcessInfo(42, "game", 60.0),
+       CreateProcessInfo(43, "shell", 1.0)},
+      &previous_processes);
+  EXPECT_THAT(GetPids(update), testing::ElementsAre(42));
+  EXPECT_EQ(update.updated_processes(0).cpu_usage(), 60.0);
+  EXPECT_THAT(update.removed_pids(), testing::IsEmpty());
+
+  update = ComputeProcessListUpdate(
+      {CreateProcessInfo(1, "init", 0.0), CreateProcessInfo(42, "game", 60.0),
+       CreateProcessInfo(43, "shell", 1.0)},
+      &previous_processes);
+  EXPECT_THAT(GetPids(update), testing::IsEmpty());
+  EXPECT_THAT(update.removed_pids(), testing::IsEmpty());
+
+  update = ComputeProcessListUpdate(
+      {CreateProcessInfo(1, "init", 0.0), CreateProcessInfo(44, "editor", 2.0)},
+      &previous_processes);
+  EXPECT_THAT(GetPids(update), testing::ElementsAre(44));
+  EXPECT_THAT(update.removed_pids(), testing::UnorderedElementsAre(42, 43));
+  EXPECT_EQ(previous_processes.size(), 2);
+  EXPECT_TRUE(previous_processes.contains(1));
+  EXPECT_TRUE(previous_processes.contains(44));
+}
+
 }  // namespace orbit_service
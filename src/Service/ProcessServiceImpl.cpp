@@ -4,6 +4,7 @@
 
 #include "ProcessServiceImpl.h"
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_format.h>
 #include <stdint.h>
 
@@ -32,9 +33,11 @@ using orbit_grpc_protos::GetModuleListRequest;
 using orbit_grpc_protos::GetModuleListResponse;
 using orbit_grpc_protos::GetProcessListRequest;
 using orbit_grpc_protos::GetProcessListResponse;
+using orbit_grpc_protos::GetProcessListUpdatesRequest;
 using orbit_grpc_protos::GetProcessMemoryRequest;
 using orbit_grpc_protos::GetProcessMemoryResponse;
 using orbit_grpc_protos::ProcessInfo;
+using orbit_grpc_protos::ProcessListUpdate;
 
 Status ProcessServiceImpl::GetProcessList(ServerContext*, const GetProcessListRequest*,
                                           GetProcessListResponse* response) {
@@ -59,6 +62,49 @@ Status ProcessServiceImpl::GetProcessList(ServerContext*, const GetProcessListRe
   return Status::OK;
 }
 
+Status ProcessServiceImpl::GetProcessListUpdates(ServerContext* context,
+                                                 const GetProcessListUpdatesRequest* request,
+                                                 grpc::ServerWriter<ProcessListUpdate>* writer) {
+  const absl::Duration refresh_interval = std::max(
+      absl::Milliseconds(request->refresh_interval_ms()), kMinProcessListRefreshInterval);
+  // The processes the client knows about, as of the last update sent.
+  absl::flat_hash_map<int32_t, ProcessInfo> client_processes;
+  bool is_first_update = true;
+
+  while (!context->IsCancelled()) {
+    std::vector<ProcessInfo> processes;
+    {
+      absl::MutexLock lock(&mutex_);
+      const auto refresh_result = process_list_.Refresh();
+      if (refresh_result.has_error()) {
+        return Status(StatusCode::INTERNAL, refresh_result.error().message());
+      }
+      processes = process_list_.GetProcesses();
+    }
+
+    ProcessListUpdate update = ComputeProcessListUpdate(processes, &client_processes);
+    if (is_first_update || update.updated_processes_size() > 0 || update.removed_pids_size() > 0) {
+      if (!writer->Write(update)) {
+        // The client is gone.
+        return Status::OK;
+      }
+      is_first_update = false;
+    }
+
+    absl::MutexLock lock(&shutdown_mutex_);
+    if (shutdown_mutex_.AwaitWithTimeout(absl::Condition(&shutdown_requested_), refresh_interval)) {
+      return Status::OK;
+    }
+  }
+
+  return Status::CANCELLED;
+}
+
+void ProcessServiceImpl::Shutdown() {
+  absl::MutexLock lock(&shutdown_mutex_);
+  shutdown_requested_ = true;
+}
+
 Status ProcessServiceImpl::GetModuleList(ServerContext* /*context*/,
                                          const GetModuleListRequest* request,
                                          GetModuleListResponse* response) {
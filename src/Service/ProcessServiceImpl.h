@@ -5,7 +5,9 @@
 #ifndef ORBIT_SERVICE_PROCESS_SERVICE_IMPL_H_
 #define ORBIT_SERVICE_PROCESS_SERVICE_IMPL_H_
 
+#include <absl/base/thread_annotations.h>
 #include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 #include <grpcpp/grpcpp.h>
 #include <stddef.h>
 
@@ -24,6 +26,10 @@ class ProcessServiceImpl final : public orbit_grpc_protos::ProcessService::Servi
       grpc::ServerContext* context, const orbit_grpc_protos::GetProcessListRequest* request,
       orbit_grpc_protos::GetProcessListResponse* response) override;
 
+  [[nodiscard]] grpc::Status GetProcessListUpdates(
+      grpc::ServerContext* context, const orbit_grpc_protos::GetProcessListUpdatesRequest* request,
+      grpc::ServerWriter<orbit_grpc_protos::ProcessListUpdate>* writer) override;
+
   [[nodiscard]] grpc::Status GetModuleList(
       grpc::ServerContext* context, const orbit_grpc_protos::GetModuleListRequest* request,
       orbit_grpc_protos::GetModuleListResponse* response) override;
@@ -36,10 +42,19 @@ class ProcessServiceImpl final : public orbit_grpc_protos::ProcessService::Servi
       grpc::ServerContext* context, const orbit_grpc_protos::GetDebugInfoFileRequest* request,
       orbit_grpc_protos::GetDebugInfoFileResponse* response) override;
 
+  // Ends all calls to GetProcessListUpdates, which otherwise only end when the client cancels them.
+  // Needs to be called before shutting down the server, which waits for all calls to end.
+  void Shutdown();
+
  private:
   absl::Mutex mutex_;
   ProcessList process_list_;
 
+  absl::Mutex shutdown_mutex_;
+  bool shutdown_requested_ ABSL_GUARDED_BY(shutdown_mutex_) = false;
+
+  static constexpr absl::Duration kMinProcessListRefreshInterval = absl::Milliseconds(100);
+
   static constexpr size_t kMaxGetProcessMemoryResponseSize = 8 * 1024 * 1024;
 };
 
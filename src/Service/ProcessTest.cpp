@@ -25,4 +25,25 @@ TEST(Process, FromPid) {
   EXPECT_EQ(process.name(), std::string_view{"ServiceTests"}.substr(0, kTaskCommLength - 1));
 }
 
+TEST(Process, ReadCumulativeCpuTimeKeepsStatFileOpen) {
+  auto potential_process = Process::FromPid(getpid());
+  ASSERT_TRUE(potential_process.has_value()) << potential_process.error().message();
+  auto& process = potential_process.value();
+  EXPECT_FALSE(process.HasOpenStatFile());
+
+  const auto cpu_time1 = process.ReadCumulativeCpuTime(/*keep_stat_file_open=*/true);
+  ASSERT_TRUE(cpu_time1.has_value());
+  EXPECT_TRUE(process.HasOpenStatFile());
+
+  const auto cpu_time2 = process.ReadCumulativeCpuTime(/*keep_stat_file_open=*/true);
+  ASSERT_TRUE(cpu_time2.has_value());
+  EXPECT_GE(cpu_time2->value, cpu_time1->value);
+  EXPECT_TRUE(process.HasOpenStatFile());
+
+  const auto cpu_time3 = process.ReadCumulativeCpuTime(/*keep_stat_file_open=*/false);
+  ASSERT_TRUE(cpu_time3.has_value());
+  EXPECT_GE(cpu_time3->value, cpu_time2->value);
+  EXPECT_FALSE(process.HasOpenStatFile());
+}
+
 }  // namespace orbit_service
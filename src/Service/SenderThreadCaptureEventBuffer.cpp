@@ -0,0 +1,218 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SenderThreadCaptureEventBuffer.h"
+
+#include <absl/strings/str_format.h>
+#include <absl/time/time.h>
+
+#include <string>
+#include <utility>
+
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureFile/ProtoSectionInputStream.h"
+#include "Introspection/Introspection.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_service {
+
+using orbit_capture_file::CaptureFile;
+using orbit_capture_file::CaptureFileOutputStream;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace {
+
+constexpr absl::Duration kSendTimeInterval = absl::Milliseconds(20);
+// This should be lower than kMaxEventsPerResponse in GrpcCaptureEventSender::SendEvents
+// as a few more events are likely to arrive after the condition becomes true.
+constexpr uint64_t kSendEventCountInterval = 5000;
+
+ClientCaptureEvent CreateWarningEvent(std::string message) {
+  ClientCaptureEvent event;
+  orbit_grpc_protos::WarningEvent* warning_event = event.mutable_warning_event();
+  warning_event->set_timestamp_ns(orbit_base::CaptureTimestampNs());
+  warning_event->set_message(std::move(message));
+  return event;
+}
+
+}  // namespace
+
+SenderThreadCaptureEventBuffer::SenderThreadCaptureEventBuffer(CaptureEventSender* event_sender,
+                                                               uint64_t max_buffered_bytes)
+    : capture_event_sender_{event_sender}, max_buffered_bytes_{max_buffered_bytes} {
+  CHECK(capture_event_sender_ != nullptr);
+  sender_thread_ = std::thread{[this] { SenderThread(); }};
+}
+
+SenderThreadCaptureEventBuffer::~SenderThreadCaptureEventBuffer() {
+  CHECK(!sender_thread_.joinable());
+}
+
+void SenderThreadCaptureEventBuffer::AddEvent(ClientCaptureEvent&& event) {
+  // ByteSizeLong also caches the size for when the event is serialized to be sent.
+  const uint64_t event_bytes = event.ByteSizeLong();
+  absl::MutexLock lock{&events_being_buffered_mutex_};
+  if (stop_requested_) {
+    return;
+  }
+  if (!spill_file_.has_value() && dropped_event_count_ == 0 &&
+      bytes_being_buffered_ + event_bytes <= max_buffered_bytes_) {
+    bytes_being_buffered_ += event_bytes;
+    events_being_buffered_.emplace_back(std::move(event));
+    return;
+  }
+  SpillEvent(event);
+}
+
+void SenderThreadCaptureEventBuffer::StopAndWait() {
+  CHECK(sender_thread_.joinable());
+  {
+    // Protect stop_requested_ with event_buffer_mutex_ so that we can use stop_requested_
+    // in Conditions for Await/LockWhen (specifically, in SenderThread).
+    absl::MutexLock lock{&events_being_buffered_mutex_};
+    stop_requested_ = true;
+  }
+  sender_thread_.join();
+}
+
+void SenderThreadCaptureEventBuffer::SpillEvent(const ClientCaptureEvent& event) {
+  if (!spill_file_.has_value()) {
+    // Don't retry until the sender thread has caught up, so that a failure is only reported once.
+    if (dropped_event_count_ > 0) {
+      ++dropped_event_count_;
+      return;
+    }
+
+    ErrorMessageOr<orbit_base::TemporaryFile> temporary_file = orbit_base::TemporaryFile::Create();
+    if (temporary_file.has_error()) {
+      ERROR("Unable to create file for capture events exceeding the buffer: %s",
+            temporary_file.error().message());
+      ++dropped_event_count_;
+      return;
+    }
+    // CaptureFileOutputStream creates the file itself, so only the unique name of the temporary
+    // file is used. The TemporaryFile still takes care of removing the file in the end.
+    temporary_file.value().CloseAndRemove();
+    auto output_stream = CaptureFileOutputStream::Create(temporary_file.value().file_path());
+    if (output_stream.has_error()) {
+      ERROR("Unable to create file for capture events exceeding the buffer: %s",
+            output_stream.error().message());
+      ++dropped_event_count_;
+      return;
+    }
+    spill_file_.emplace(
+        SpillFile{std::move(temporary_file.value()), std::move(output_stream.value())});
+    LOG("Capture events exceed the buffer of %u bytes, writing them to \"%s\"", max_buffered_bytes_,
+        spill_file_->temporary_file.file_path().string());
+
+    SpillEvent(CreateWarningEvent(absl::StrFormat(
+        "OrbitService could not send capture events as fast as they were produced and buffered "
+        "more than %u MB of them. Further events are temporarily written to disk.",
+        max_buffered_bytes_ / 1024 / 1024)));
+    if (!spill_file_.has_value()) {
+      // Writing the warning failed.
+      ++dropped_event_count_;
+      return;
+    }
+  }
+
+  ErrorMessageOr<void> write_result = spill_file_->output_stream->WriteCaptureEvent(event);
+  if (write_result.has_error()) {
+    // The output stream has already closed and removed the file.
+    ERROR("Writing capture event to file: %s", write_result.error().message());
+    dropped_event_count_ += spill_file_->event_count + 1;
+    spill_file_.reset();
+    return;
+  }
+  ++spill_file_->event_count;
+}
+
+void SenderThreadCaptureEventBuffer::SendSpilledEvents(SpillFile spill_file) {
+  ORBIT_SCOPE_FUNCTION;
+  ORBIT_UINT64("Spilled capture events sent", spill_file.event_count);
+  const std::filesystem::path& file_path = spill_file.temporary_file.file_path();
+
+  uint64_t sent_event_count = 0;
+  auto read_and_send_events = [&]() -> ErrorMessageOr<void> {
+    OUTCOME_TRY(spill_file.output_stream->Close());
+    OUTCOME_TRY(auto&& capture_file, CaptureFile::OpenForReadWrite(file_path));
+    std::unique_ptr<orbit_capture_file::ProtoSectionInputStream> input_stream =
+        capture_file->CreateCaptureSectionInputStream();
+    while (sent_event_count < spill_file.event_count) {
+      ClientCaptureEvent event;
+      OUTCOME_TRY(input_stream->ReadMessage(&event));
+      events_to_send_.emplace_back(std::move(event));
+      if (events_to_send_.size() == kSendEventCountInterval ||
+          sent_event_count + events_to_send_.size() == spill_file.event_count) {
+        sent_event_count += events_to_send_.size();
+        capture_event_sender_->SendEvents(&events_to_send_);
+        events_to_send_.clear();
+      }
+    }
+    return outcome::success();
+  };
+
+  ErrorMessageOr<void> result = read_and_send_events();
+  events_to_send_.clear();
+  if (result.has_error()) {
+    ERROR("Reading capture events from \"%s\": %s", file_path.string(), result.error().message());
+    events_to_send_.emplace_back(CreateWarningEvent(absl::StrFormat(
+        "%u capture events that OrbitService had written to disk could not be sent: %s",
+        spill_file.event_count - sent_event_count, result.error().message())));
+    capture_event_sender_->SendEvents(&events_to_send_);
+    events_to_send_.clear();
+  }
+}
+
+void SenderThreadCaptureEventBuffer::SenderThread() {
+  orbit_base::SetCurrentThreadName("SenderThread");
+
+  bool stopped = false;
+  while (!stopped) {
+    ORBIT_SCOPE("SenderThread iteration");
+
+    events_being_buffered_mutex_.LockWhenWithTimeout(
+        absl::Condition(
+            +[](SenderThreadCaptureEventBuffer* self) {
+              return self->events_being_buffered_.size() >= kSendEventCountInterval ||
+                     self->spill_file_.has_value() || self->stop_requested_;
+            },
+            this),
+        kSendTimeInterval);
+    if (stop_requested_) {
+      stopped = true;
+    }
+    events_being_buffered_.swap(events_to_send_);
+    ORBIT_UINT64("Capture event bytes buffered", bytes_being_buffered_);
+    bytes_being_buffered_ = 0;
+    // The events in the file were added after the ones in memory, hence they are sent afterwards.
+    std::optional<SpillFile> spill_file = std::move(spill_file_);
+    spill_file_.reset();
+    const uint64_t dropped_event_count = dropped_event_count_;
+    dropped_event_count_ = 0;
+    events_being_buffered_mutex_.Unlock();
+
+    capture_event_sender_->SendEvents(&events_to_send_);
+    // std::vector::clear() "Leaves the capacity() of the vector unchanged", which is desired.
+    events_to_send_.clear();
+
+    if (spill_file.has_value()) {
+      SendSpilledEvents(std::move(spill_file.value()));
+    }
+
+    if (dropped_event_count > 0) {
+      events_to_send_.emplace_back(CreateWarningEvent(absl::StrFormat(
+          "OrbitService could not send capture events as fast as they were produced and had to "
+          "drop %u of them.",
+          dropped_event_count)));
+      capture_event_sender_->SendEvents(&events_to_send_);
+      events_to_send_.clear();
+    }
+  }
+}
+
+}  // namespace orbit_service
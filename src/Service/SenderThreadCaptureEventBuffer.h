@@ -0,0 +1,72 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_SERVICE_SENDER_THREAD_CAPTURE_EVENT_BUFFER_H_
+#define ORBIT_SERVICE_SENDER_THREAD_CAPTURE_EVENT_BUFFER_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "CaptureEventBuffer.h"
+#include "CaptureEventSender.h"
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "OrbitBase/TemporaryFile.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+// Buffers the events added from any thread and periodically sends them with `event_sender` from a
+// separate thread.
+//
+// If the events can't be sent as fast as they are added (e.g., because the network or the client
+// stall), the events waiting to be sent are capped at `max_buffered_bytes` (as measured by their
+// serialized size). Further events are written to a temporary file, in the format used by
+// CaptureFileOutputStream, and sent from there, after the events in memory, once the sender thread
+// catches up. A WarningEvent is sent when this happens.
+class SenderThreadCaptureEventBuffer final : public CaptureEventBuffer {
+ public:
+  SenderThreadCaptureEventBuffer(CaptureEventSender* event_sender, uint64_t max_buffered_bytes);
+  ~SenderThreadCaptureEventBuffer() override;
+
+  void AddEvent(orbit_grpc_protos::ClientCaptureEvent&& event) override;
+
+  void StopAndWait();
+
+ private:
+  struct SpillFile {
+    orbit_base::TemporaryFile temporary_file;
+    std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream;
+    uint64_t event_count = 0;
+  };
+
+  void SenderThread();
+  void SpillEvent(const orbit_grpc_protos::ClientCaptureEvent& event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(events_being_buffered_mutex_);
+  void SendSpilledEvents(SpillFile spill_file);
+
+  std::vector<orbit_grpc_protos::ClientCaptureEvent> events_being_buffered_
+      ABSL_GUARDED_BY(events_being_buffered_mutex_);
+  uint64_t bytes_being_buffered_ ABSL_GUARDED_BY(events_being_buffered_mutex_) = 0;
+  // Once this is set, all events are written to the file until the sender thread takes it, so that
+  // the events are sent in the order in which they were added.
+  std::optional<SpillFile> spill_file_ ABSL_GUARDED_BY(events_being_buffered_mutex_);
+  // Events that could neither be kept in memory nor be written to a file.
+  uint64_t dropped_event_count_ ABSL_GUARDED_BY(events_being_buffered_mutex_) = 0;
+  absl::Mutex events_being_buffered_mutex_;
+  std::vector<orbit_grpc_protos::ClientCaptureEvent> events_to_send_;
+  CaptureEventSender* capture_event_sender_;
+  const uint64_t max_buffered_bytes_;
+  std::thread sender_thread_;
+  bool stop_requested_ ABSL_GUARDED_BY(events_being_buffered_mutex_) = false;
+};
+
+}  // namespace orbit_service
+
+#endif  // ORBIT_SERVICE_SENDER_THREAD_CAPTURE_EVENT_BUFFER_H_
@@ -0,0 +1,128 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+#include "CaptureEventSender.h"
+#include "SenderThreadCaptureEventBuffer.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+namespace {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+
+class FakeCaptureEventSender : public CaptureEventSender {
+ public:
+  void SendEvents(std::vector<ClientCaptureEvent>* events) override {
+    // Simulates a client or network that stalls at the beginning of the capture.
+    sending_allowed_.WaitForNotification();
+    absl::MutexLock lock{&mutex_};
+    sent_events_.insert(sent_events_.end(), events->begin(), events->end());
+  }
+
+  void AllowSending() { sending_allowed_.Notify(); }
+
+  [[nodiscard]] std::vector<ClientCaptureEvent> GetSentEvents() {
+    absl::MutexLock lock{&mutex_};
+    return sent_events_;
+  }
+
+ private:
+  absl::Notification sending_allowed_;
+  absl::Mutex mutex_;
+  std::vector<ClientCaptureEvent> sent_events_ ABSL_GUARDED_BY(mutex_);
+};
+
+ClientCaptureEvent CreateInternedStringEvent(uint64_t key) {
+  ClientCaptureEvent event;
+  event.mutable_interned_string()->set_key(key);
+  event.mutable_interned_string()->set_intern("interned string");
+  return event;
+}
+
+constexpr uint64_t kEventCount = 12'345;
+
+void AddEvents(SenderThreadCaptureEventBuffer* buffer) {
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    buffer->AddEvent(CreateInternedStringEvent(key));
+  }
+}
+
+// Returns the keys of the InternedString events among `events`, and counts the WarningEvents.
+std::vector<uint64_t> GetInternedStringKeys(const std::vector<ClientCaptureEvent>& events,
+                                            int* warning_event_count) {
+  std::vector<uint64_t> keys;
+  *warning_event_count = 0;
+  for (const ClientCaptureEvent& event : events) {
+    if (event.event_case() == ClientCaptureEvent::kWarningEvent) {
+      ++*warning_event_count;
+      EXPECT_THAT(event.warning_event().message(), testing::HasSubstr("written to disk"));
+      continue;
+    }
+    EXPECT_EQ(event.event_case(), ClientCaptureEvent::kInternedString);
+    keys.push_back(event.interned_string().key());
+  }
+  return keys;
+}
+
+std::vector<uint64_t> GetExpectedKeys() {
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+}  // namespace
+
+TEST(SenderThreadCaptureEventBuffer, SendsEventsInOrder) {
+  FakeCaptureEventSender sender;
+  sender.AllowSending();
+  SenderThreadCaptureEventBuffer buffer{&sender, std::numeric_limits<uint64_t>::max()};
+  AddEvents(&buffer);
+  buffer.StopAndWait();
+
+  int warning_event_count = 0;
+  EXPECT_EQ(GetInternedStringKeys(sender.GetSentEvents(), &warning_event_count),
+            GetExpectedKeys());
+  EXPECT_EQ(warning_event_count, 0);
+}
+
+TEST(SenderThreadCaptureEventBuffer, SendsEventsExceedingTheBufferFromFileInOrder) {
+  FakeCaptureEventSender sender;
+  constexpr uint64_t kMaxBufferedBytes = 1000;
+  SenderThreadCaptureEventBuffer buffer{&sender, kMaxBufferedBytes};
+  // The sender thread is stuck sending, so most events don't fit into the buffer.
+  AddEvents(&buffer);
+  sender.AllowSending();
+  buffer.StopAndWait();
+
+  int warning_event_count = 0;
+  EXPECT_EQ(GetInternedStringKeys(sender.GetSentEvents(), &warning_event_count),
+            GetExpectedKeys());
+  // Depending on timing, the sender thread might already have taken the file before getting stuck,
+  // in which case a second file is started.
+  EXPECT_GE(warning_event_count, 1);
+}
+
+TEST(SenderThreadCaptureEventBuffer, DropsEventsAfterStop) {
+  FakeCaptureEventSender sender;
+  sender.AllowSending();
+  SenderThreadCaptureEventBuffer buffer{&sender, std::numeric_limits<uint64_t>::max()};
+  buffer.StopAndWait();
+  buffer.AddEvent(CreateInternedStringEvent(0));
+
+  EXPECT_TRUE(sender.GetSentEvents().empty());
+}
+
+}  // namespace orbit_service
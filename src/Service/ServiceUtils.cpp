@@ -110,16 +110,6 @@ ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints()
 std::optional<Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid) noexcept {
   const auto stat = std::filesystem::path{"/proc"} / std::to_string(pid) / "stat";
 
-  // /proc/[pid]/stat looks like so (example - all in one line):
-  // 1395261 (sleep) S 5273 1160 1160 0 -1 1077936128 101 0 0 0 0 0 0 0 20 0 1 0 42187401 5431296
-  // 131 18446744073709551615 94702955896832 94702955911385 140735167078224 0 0 0 0 0 0 0 0 0 17 10
-  // 0 0 0 0 0 94702955928880 94702955930112 94702967197696 140735167083224 140735167083235
-  // 140735167083235 140735167086569 0
-  //
-  // This code reads field 13 (user time) and 14 (kernel time) to determine the process's cpu usage.
-  // Older kernels might have less fields than in the example. Over time fields had been added to
-  // the end, but field indexes stayed stable.
-
   std::error_code error;
   bool file_exists = std::filesystem::exists(stat, error);
   // Even if we couldn't stat we could still be able to read, continue in case of an error.
@@ -133,22 +123,32 @@ std::optional<Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid) noexcept {
     return std::nullopt;
   }
 
-  std::vector<std::string> lines =
-      absl::StrSplit(file_content_or_error.value(), absl::MaxSplits('\n', 1));
-  if (lines.empty()) {
-    ERROR("\"%s\" file is empty", stat.string());
+  return ParseCumulativeCpuTimeFromProcessStat(file_content_or_error.value());
+}
+
+std::optional<Jiffies> ParseCumulativeCpuTimeFromProcessStat(
+    std::string_view stat_content) noexcept {
+  // /proc/[pid]/stat looks like so (example - all in one line):
+  // 1395261 (sleep) S 5273 1160 1160 0 -1 1077936128 101 0 0 0 0 0 0 0 20 0 1 0 42187401 5431296
+  // 131 18446744073709551615 94702955896832 94702955911385 140735167078224 0 0 0 0 0 0 0 0 0 17 10
+  // 0 0 0 0 0 94702955928880 94702955930112 94702967197696 140735167083224 140735167083235
+  // 140735167083235 140735167086569 0
+  //
+  // This code reads field 13 (user time) and 14 (kernel time) to determine the process's cpu usage.
+  // Older kernels might have less fields than in the example. Over time fields had been added to
+  // the end, but field indexes stayed stable.
+
+  std::string_view first_line = stat_content.substr(0, stat_content.find('\n'));
+  if (first_line.empty()) {
     return std::nullopt;
   }
 
-  const std::string& first_line = lines.at(0);
-
   // Remove fields up to comm (process name) as this, enclosed in parentheses, could contain spaces.
   size_t last_closed_paren_index = first_line.find_last_of(')');
   if (last_closed_paren_index == std::string::npos) {
     return std::nullopt;
   }
-  std::string_view first_line_excl_pid_comm =
-      std::string_view{first_line}.substr(last_closed_paren_index + 1);
+  std::string_view first_line_excl_pid_comm = first_line.substr(last_closed_paren_index + 1);
 
   std::vector<std::string_view> fields_excl_pid_comm =
       absl::StrSplit(first_line_excl_pid_comm, ' ', absl::SkipWhitespace{});
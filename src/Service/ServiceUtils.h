@@ -14,6 +14,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -41,6 +42,9 @@ struct TotalCpuTime {
 
 std::optional<TotalCpuTime> GetCumulativeTotalCpuTime() noexcept;
 std::optional<Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid) noexcept;
+// Parses the content of `/proc/[pid]/stat`.
+std::optional<Jiffies> ParseCumulativeCpuTimeFromProcessStat(
+    std::string_view stat_content) noexcept;
 
 ErrorMessageOr<std::filesystem::path> FindSymbolsFilePath(
     const std::filesystem::path& module_path,
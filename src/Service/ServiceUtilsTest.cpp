@@ -59,6 +59,25 @@ TEST(ServiceUtils, GetCumulativeCpuTimeFromProcess) {
   ASSERT_TRUE(jiffies2->value <= total_cpu_time->jiffies.value);
 }
 
+TEST(ServiceUtils, ParseCumulativeCpuTimeFromProcessStat) {
+  std::optional<Jiffies> jiffies = ParseCumulativeCpuTimeFromProcessStat(
+      "1395261 (sleep) S 5273 1160 1160 0 -1 1077936128 101 0 0 0 12 34 0 0 20 0 1 0 42187401 "
+      "5431296 131 18446744073709551615 94702955896832 94702955911385 140735167078224 0 0 0 0 0 0 "
+      "0 0 0 17 10 0 0 0 0 0 94702955928880 94702955930112 94702967197696 140735167083224 "
+      "140735167083235 140735167083235 140735167086569 0\n");
+  ASSERT_TRUE(jiffies.has_value());
+  EXPECT_EQ(jiffies->value, 46);
+
+  // The process name can contain spaces and parentheses.
+  jiffies = ParseCumulativeCpuTimeFromProcessStat(
+      "42 (a (b) c) R 1 42 42 0 -1 4194560 1 0 0 0 100 200 0 0 20 0 1 0 1 1 1");
+  ASSERT_TRUE(jiffies.has_value());
+  EXPECT_EQ(jiffies->value, 300);
+
+  EXPECT_FALSE(ParseCumulativeCpuTimeFromProcessStat("").has_value());
+  EXPECT_FALSE(ParseCumulativeCpuTimeFromProcessStat("42 (sleep) S 1 2 3").has_value());
+}
+
 TEST(ServiceUtils, FindSymbolsFilePath) {
   const Path test_path = orbit_test::GetTestdataDir();
 
@@ -0,0 +1,9 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/flags/flag.h>
+#include <stdint.h>
+
+ABSL_FLAG(uint64_t, max_capture_event_buffer_mb, 512,
+          "Maximum size in MB of the capture events waiting to be sent to the client");
@@ -21,6 +21,10 @@ ABSL_FLAG(uint64_t, grpc_port, 44765, "gRPC server port");
 
 ABSL_FLAG(bool, devmode, false, "Enable developer mode");
 
+ABSL_FLAG(uint64_t, max_capture_event_buffer_mb, 512,
+          "Maximum size in MB of the capture events waiting to be sent to the client. Further "
+          "events are written to a temporary file until the client catches up");
+
 namespace {
 std::atomic<bool> exit_requested;
 
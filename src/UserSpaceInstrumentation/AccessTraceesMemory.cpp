@@ -10,9 +10,12 @@
 #include <absl/strings/str_split.h>
 #include <sys/ptrace.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
+#include <iterator>
 #include <string>
+#include <utility>
 
 #include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
@@ -26,16 +29,25 @@ using orbit_base::ReadFileToString;
 [[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> ReadTraceesMemory(pid_t pid,
                                                                      uint64_t start_address,
                                                                      uint64_t length) {
-  CHECK(length != 0);
+  OUTCOME_TRY(auto&& reader, TraceesMemoryReader::Create(pid));
+  return reader.Read(start_address, length);
+}
 
+ErrorMessageOr<TraceesMemoryReader> TraceesMemoryReader::Create(pid_t pid) {
   OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForReading(absl::StrFormat("/proc/%d/mem", pid)));
+  return TraceesMemoryReader(pid, std::move(fd));
+}
+
+ErrorMessageOr<std::vector<uint8_t>> TraceesMemoryReader::Read(uint64_t start_address,
+                                                               uint64_t length) const {
+  CHECK(length != 0);
 
   std::vector<uint8_t> bytes(length);
-  OUTCOME_TRY(auto&& result, ReadFullyAtOffset(fd, bytes.data(), length, start_address));
+  OUTCOME_TRY(auto&& result, ReadFullyAtOffset(fd_, bytes.data(), length, start_address));
 
   if (result < length) {
     return ErrorMessage(absl::StrFormat(
-        "Failed to read %u bytes from memory file of process %d. Only got %d bytes.", length, pid,
+        "Failed to read %u bytes from memory file of process %d. Only got %d bytes.", length, pid_,
         result));
   }
 
@@ -53,6 +65,59 @@ using orbit_base::ReadFileToString;
   return outcome::success();
 }
 
+void TraceesMemoryWriteBatch::AddWrite(uint64_t start_address, std::vector<uint8_t> bytes) {
+  CHECK(!bytes.empty());
+  writes_.push_back({start_address, std::move(bytes)});
+}
+
+ErrorMessageOr<void> TraceesMemoryWriteBatch::Apply() {
+  if (writes_.empty()) return outcome::success();
+
+  std::vector<Write> writes = std::move(writes_);
+  writes_.clear();
+
+  // Compute the union of all the written ranges, joining ranges that overlap or touch.
+  std::vector<AddressRange> ranges;
+  ranges.reserve(writes.size());
+  for (const Write& write : writes) {
+    ranges.emplace_back(write.start_address, write.start_address + write.bytes.size());
+  }
+  std::sort(ranges.begin(), ranges.end(),
+            [](const AddressRange& lhs, const AddressRange& rhs) { return lhs.start < rhs.start; });
+  std::vector<AddressRange> coalesced_ranges;
+  for (const AddressRange& range : ranges) {
+    if (!coalesced_ranges.empty() && range.start <= coalesced_ranges.back().end) {
+      coalesced_ranges.back().end = std::max(coalesced_ranges.back().end, range.end);
+    } else {
+      coalesced_ranges.push_back(range);
+    }
+  }
+
+  // Copy the writes into the buffers of the coalesced ranges in the order they were added, so
+  // that later writes overwrite earlier ones.
+  std::vector<std::vector<uint8_t>> buffers(coalesced_ranges.size());
+  for (size_t i = 0; i < coalesced_ranges.size(); ++i) {
+    buffers[i].resize(coalesced_ranges[i].end - coalesced_ranges[i].start);
+  }
+  for (const Write& write : writes) {
+    auto it = std::upper_bound(
+        coalesced_ranges.begin(), coalesced_ranges.end(), write.start_address,
+        [](uint64_t address, const AddressRange& range) { return address < range.start; });
+    CHECK(it != coalesced_ranges.begin());
+    const size_t index = std::distance(coalesced_ranges.begin(), it) - 1;
+    memcpy(buffers[index].data() + (write.start_address - coalesced_ranges[index].start),
+           write.bytes.data(), write.bytes.size());
+  }
+
+  OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForWriting(absl::StrFormat("/proc/%d/mem", pid_)));
+  for (size_t i = 0; i < coalesced_ranges.size(); ++i) {
+    OUTCOME_TRY(
+        WriteFullyAtOffset(fd, buffers[i].data(), buffers[i].size(), coalesced_ranges[i].start));
+  }
+
+  return outcome::success();
+}
+
 [[nodiscard]] ErrorMessageOr<AddressRange> GetFirstExecutableMemoryRegion(
     pid_t pid, uint64_t exclude_address) {
   OUTCOME_TRY(auto&& maps, ReadFileToString(absl::StrFormat("/proc/%d/maps", pid)));
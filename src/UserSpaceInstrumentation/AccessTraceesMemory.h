@@ -8,9 +8,11 @@
 #include <sys/types.h>
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "AddressRange.h"
+#include "OrbitBase/File.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_user_space_instrumentation {
@@ -21,11 +23,59 @@ namespace orbit_user_space_instrumentation {
                                                                      uint64_t start_address,
                                                                      uint64_t length);
 
+// Reads from the memory of process `pid` like `ReadTraceesMemory`, but only opens `/proc/<pid>/mem`
+// once for all the reads. Use this when reading many locations at once, e.g. the prologues of the
+// functions to instrument. As for `ReadTraceesMemory`, we assume to be attached to the tracee `pid`
+// while reading.
+class TraceesMemoryReader {
+ public:
+  [[nodiscard]] static ErrorMessageOr<TraceesMemoryReader> Create(pid_t pid);
+
+  [[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> Read(uint64_t start_address,
+                                                           uint64_t length) const;
+
+ private:
+  TraceesMemoryReader(pid_t pid, orbit_base::unique_fd fd) : pid_(pid), fd_(std::move(fd)) {}
+
+  pid_t pid_;
+  orbit_base::unique_fd fd_;
+};
+
 // Write `bytes` into memory of process `pid` starting from `start_address`.
 // Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
 [[nodiscard]] ErrorMessageOr<void> WriteTraceesMemory(pid_t pid, uint64_t start_address,
                                                       const std::vector<uint8_t>& bytes);
 
+// Collects writes into the memory of process `pid` and applies them all at once. Writes that
+// overlap or touch each other are coalesced into a single write and `/proc/<pid>/mem` is only
+// opened once per `Apply`. This keeps the time the tracee is stopped short when patching many
+// locations, e.g. when instrumenting thousands of functions. Note that we can't use
+// `process_vm_writev` for this as it respects the page protections and we need to write into
+// read-only code.
+// Where writes overlap, the write added last wins. As for `WriteTraceesMemory`, we assume to be
+// attached to the tracee `pid` when calling `Apply`.
+class TraceesMemoryWriteBatch {
+ public:
+  explicit TraceesMemoryWriteBatch(pid_t pid) : pid_(pid) {}
+
+  void AddWrite(uint64_t start_address, std::vector<uint8_t> bytes);
+
+  [[nodiscard]] bool IsEmpty() const { return writes_.empty(); }
+
+  // Applies and removes all the writes added so far. On error, some of the writes might have been
+  // applied already.
+  [[nodiscard]] ErrorMessageOr<void> Apply();
+
+ private:
+  struct Write {
+    uint64_t start_address;
+    std::vector<uint8_t> bytes;
+  };
+
+  pid_t pid_;
+  std::vector<Write> writes_;
+};
+
 // Returns the address range of the first executable memory region. In every case I encountered this
 // was the second line in the `maps` file corresponding to the code of the process we look at.
 // However we don't really care. So keeping it general and just searching for an executable region
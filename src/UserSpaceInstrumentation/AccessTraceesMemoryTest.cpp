@@ -204,4 +204,97 @@ TEST(AccessTraceesMemoryTest, ReadWriteRestore) {
   waitpid(pid, NULL, 0);
 }
 
+TEST(AccessTraceesMemoryTest, WriteBatchCoalescesWrites) {
+  pid_t pid = fork();
+  CHECK(pid != -1);
+  if (pid == 0) {
+    // Child just runs an endless loop.
+    while (true) {
+    }
+  }
+
+  // Stop the child process using our tooling.
+  CHECK(!AttachAndStopProcess(pid).has_error());
+
+  auto memory_region_or_error = GetFirstExecutableMemoryRegion(pid);
+  CHECK(memory_region_or_error.has_value());
+  const uint64_t address = memory_region_or_error.value().start;
+
+  constexpr uint64_t kMemorySize = 64;
+  auto backup = ReadTraceesMemory(pid, address, kMemorySize);
+  ASSERT_TRUE(backup.has_value());
+
+  TraceesMemoryWriteBatch write_batch(pid);
+  EXPECT_TRUE(write_batch.IsEmpty());
+  // Two touching writes, a gap of four untouched bytes, and overlapping writes where the write
+  // added last needs to win.
+  write_batch.AddWrite(address + 8, std::vector<uint8_t>(8, 0x02));
+  write_batch.AddWrite(address, std::vector<uint8_t>(8, 0x01));
+  write_batch.AddWrite(address + 20, std::vector<uint8_t>(8, 0x03));
+  write_batch.AddWrite(address + 24, std::vector<uint8_t>(8, 0x04));
+  write_batch.AddWrite(address + 18, std::vector<uint8_t>(4, 0x05));
+  EXPECT_FALSE(write_batch.IsEmpty());
+  ASSERT_FALSE(write_batch.Apply().has_error());
+  EXPECT_TRUE(write_batch.IsEmpty());
+
+  std::vector<uint8_t> expected = backup.value();
+  std::fill(expected.begin(), expected.begin() + 8, 0x01);
+  std::fill(expected.begin() + 8, expected.begin() + 16, 0x02);
+  std::fill(expected.begin() + 20, expected.begin() + 24, 0x03);
+  std::fill(expected.begin() + 24, expected.begin() + 32, 0x04);
+  std::fill(expected.begin() + 18, expected.begin() + 22, 0x05);
+  auto read_back_or_error = ReadTraceesMemory(pid, address, kMemorySize);
+  ASSERT_TRUE(read_back_or_error.has_value());
+  EXPECT_EQ(expected, read_back_or_error.value());
+
+  // Writing to a bad address fails.
+  write_batch.AddWrite(0, std::vector<uint8_t>(8, 0x00));
+  EXPECT_THAT(write_batch.Apply(), HasError("Input/output error"));
+
+  // Restore, detach and end child.
+  CHECK(WriteTraceesMemory(pid, address, backup.value()).has_value());
+  CHECK(!DetachAndContinueProcess(pid).has_error());
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+}
+
+TEST(AccessTraceesMemoryTest, ReaderReadsLikeReadTraceesMemory) {
+  pid_t pid = fork();
+  CHECK(pid != -1);
+  if (pid == 0) {
+    // Child just runs an endless loop.
+    while (true) {
+    }
+  }
+
+  // Stop the child process using our tooling.
+  CHECK(!AttachAndStopProcess(pid).has_error());
+
+  auto memory_region_or_error = GetFirstExecutableMemoryRegion(pid);
+  CHECK(memory_region_or_error.has_value());
+  const uint64_t address = memory_region_or_error.value().start;
+
+  auto reader_or_error = TraceesMemoryReader::Create(pid);
+  ASSERT_TRUE(reader_or_error.has_value());
+  const TraceesMemoryReader& reader = reader_or_error.value();
+  for (uint64_t offset : {0, 16, 100}) {
+    auto expected = ReadTraceesMemory(pid, address + offset, 20);
+    ASSERT_TRUE(expected.has_value());
+    auto result = reader.Read(address + offset, 20);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(expected.value(), result.value());
+  }
+
+  // Read from bad address.
+  EXPECT_THAT(reader.Read(0, 20), HasError("Input/output error"));
+
+  // Process does not exist.
+  EXPECT_THAT(TraceesMemoryReader::Create(-1), HasError("Unable to open file"));
+
+  // Detach and end child.
+  CHECK(!DetachAndContinueProcess(pid).has_error());
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+}
+
 }  // namespace orbit_user_space_instrumentation
\ No newline at end of file
@@ -92,10 +92,16 @@ class InstrumentedProcess {
   // allocated memory in `trampolines_for_modules_` below.
   [[nodiscard]] ErrorMessageOr<uint64_t> GetTrampolineMemory(AddressRange address_range);
   // Releases the address previously obtained by `GetTrampolineMemory` such that it can be reused.
-  // Note that this must only be called once for each call to `GetTrampolineMemory`.
+  // Note that this must only be called once for each call to `GetTrampolineMemory`, in the reverse
+  // order of the calls for the same module. Chunks that become unused are freed.
   [[nodiscard]] ErrorMessageOr<void> ReleaseMostRecentlyAllocatedTrampolineMemory(
       AddressRange address_range);
 
+  // Overwrites the beginning of each function in `function_addresses` with the original code we
+  // backed up when creating its trampoline. Functions without a trampoline are skipped.
+  [[nodiscard]] ErrorMessageOr<void> RestoreOriginalPrologues(
+      const absl::flat_hash_set<uint64_t>& function_addresses);
+
   [[nodiscard]] ErrorMessageOr<void> EnsureTrampolinesWritable();
   [[nodiscard]] ErrorMessageOr<void> EnsureTrampolinesExecutable();
 
@@ -229,6 +235,18 @@ ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentedProcess::InstrumentFun
 
   OUTCOME_TRY(EnsureTrampolinesWritable());
 
+  OUTCOME_TRY(auto&& memory_reader, TraceesMemoryReader::Create(pid_));
+
+  // All the trampolines and patches of function prologues are collected here and written into the
+  // tracee in one go after the loop below. Hence the loop must not return early: the trampolines
+  // already added to `trampoline_map_` would never be written, nor removed again.
+  TraceesMemoryWriteBatch write_batch(pid_);
+  // The function address and the module of each trampoline created in this pass, in the order of
+  // allocation, and the instructions relocated into them. They are only committed to
+  // `relocation_map_` once the trampolines were written, and rolled back otherwise.
+  std::vector<std::pair<uint64_t, AddressRange>> new_trampolines;
+  absl::flat_hash_map<uint64_t, uint64_t> new_relocations;
+  absl::flat_hash_set<uint64_t> addresses_of_patched_functions;
   absl::flat_hash_set<uint64_t> instrumented_function_ids;
   for (const auto& function : capture_options.instrumented_functions()) {
     const uint64_t function_id = function.function_id();
@@ -241,8 +259,13 @@ ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentedProcess::InstrumentFun
     }
     // Get all modules with the right path (usually one, but might be more) and get a function
     // address to instrument for each of them.
-    OUTCOME_TRY(auto&& modules, ModulesFromModulePath(function.file_path()));
-    for (const auto& module : modules) {
+    auto modules_or_error = ModulesFromModulePath(function.file_path());
+    if (modules_or_error.has_error()) {
+      ERROR("Can't instrument function \"%s\": %s", function.function_name(),
+            modules_or_error.error().message());
+      continue;
+    }
+    for (const auto& module : modules_or_error.value()) {
       const uint64_t function_address = orbit_object_utils::SymbolOffsetToAbsoluteAddress(
           function.file_offset(), module.address_start(), module.executable_segment_offset());
       if (!trampoline_map_.contains(function_address)) {
@@ -256,20 +279,35 @@ ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentedProcess::InstrumentFun
         const uint64_t trampoline_address = trampoline_address_or_error.value();
         TrampolineData trampoline_data;
         trampoline_data.trampoline_address = trampoline_address;
-        OUTCOME_TRY(auto&& function_data, ReadTraceesMemory(pid_, function_address, backup_size));
+        auto function_data_or_error = memory_reader.Read(function_address, backup_size);
+        if (function_data_or_error.has_error()) {
+          ERROR("Failed to read function prologue: %s", function_data_or_error.error().message());
+          auto release_result = ReleaseMostRecentlyAllocatedTrampolineMemory(module_address_range);
+          if (release_result.has_error()) {
+            ERROR("Failed to release trampoline memory: %s", release_result.error().message());
+          }
+          continue;
+        }
+        const std::vector<uint8_t>& function_data = function_data_or_error.value();
         trampoline_data.function_data = function_data;
+        absl::flat_hash_map<uint64_t, uint64_t> relocations;
         auto address_after_prologue_or_error =
-            CreateTrampoline(pid_, function_address, function_data, trampoline_address,
+            CreateTrampoline(write_batch, function_address, function_data, trampoline_address,
                              entry_payload_function_address_, return_trampoline_address_,
-                             capstone_handle, relocation_map_);
+                             capstone_handle, relocations);
         if (address_after_prologue_or_error.has_error()) {
           ERROR("Failed to create trampoline: %s",
                 address_after_prologue_or_error.error().message());
-          OUTCOME_TRY(ReleaseMostRecentlyAllocatedTrampolineMemory(module_address_range));
+          auto release_result = ReleaseMostRecentlyAllocatedTrampolineMemory(module_address_range);
+          if (release_result.has_error()) {
+            ERROR("Failed to release trampoline memory: %s", release_result.error().message());
+          }
           continue;
         }
         trampoline_data.address_after_prologue = address_after_prologue_or_error.value();
         trampoline_map_.emplace(function_address, trampoline_data);
+        new_trampolines.emplace_back(function_address, module_address_range);
+        new_relocations.insert(relocations.begin(), relocations.end());
       }
       auto it = trampoline_map_.find(function_address);
       if (it == trampoline_map_.end()) {
@@ -277,19 +315,43 @@ ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentedProcess::InstrumentFun
       }
       const TrampolineData& trampoline_data = it->second;
 
-      auto result = InstrumentFunction(pid_, function_address, function_id,
+      auto result = InstrumentFunction(write_batch, function_address, function_id,
                                        trampoline_data.address_after_prologue,
                                        trampoline_data.trampoline_address);
       if (result.has_error()) {
         ERROR("Unable to instrument \"%s\": %s", function.function_name(),
               result.error().message());
       } else {
-        addresses_of_instrumented_functions_.insert(function_address);
+        addresses_of_patched_functions.insert(function_address);
         instrumented_function_ids.insert(function_id);
       }
     }
   }
 
+  auto write_result = write_batch.Apply();
+  if (write_result.has_error()) {
+    // Part of the batch might have been written. Put back the original code of the functions we
+    // tried to instrument and forget about the new trampolines, which might not have been written.
+    // Their relocations were never committed, and their memory is released for reuse.
+    auto restore_result = RestoreOriginalPrologues(addresses_of_patched_functions);
+    FAIL_IF(restore_result.has_error(), "%s", restore_result.error().message());
+    for (auto it = new_trampolines.rbegin(); it != new_trampolines.rend(); ++it) {
+      const auto& [function_address, module_address_range] = *it;
+      trampoline_map_.erase(function_address);
+      auto release_result = ReleaseMostRecentlyAllocatedTrampolineMemory(module_address_range);
+      if (release_result.has_error()) {
+        ERROR("Failed to release trampoline memory: %s", release_result.error().message());
+      }
+    }
+    return ErrorMessage(absl::StrFormat("Failed to write instrumentation into process %d: %s",
+                                        pid_, write_result.error().message()));
+  }
+  addresses_of_instrumented_functions_.insert(addresses_of_patched_functions.begin(),
+                                              addresses_of_patched_functions.end());
+  for (const auto& [original_address, relocated_address] : new_relocations) {
+    relocation_map_.insert_or_assign(original_address, relocated_address);
+  }
+
   MoveInstructionPointersOutOfOverwrittenCode(pid_, relocation_map_);
 
   OUTCOME_TRY(EnsureTrampolinesExecutable());
@@ -304,7 +366,15 @@ ErrorMessageOr<void> InstrumentedProcess::UninstrumentFunctions() {
                                                  ERROR("Detaching from %i", pid);
                                                }
                                              }};
-  for (uint64_t function_address : addresses_of_instrumented_functions_) {
+  auto write_result_or_error = RestoreOriginalPrologues(addresses_of_instrumented_functions_);
+  FAIL_IF(write_result_or_error.has_error(), "%s", write_result_or_error.error().message());
+  return outcome::success();
+}
+
+ErrorMessageOr<void> InstrumentedProcess::RestoreOriginalPrologues(
+    const absl::flat_hash_set<uint64_t>& function_addresses) {
+  TraceesMemoryWriteBatch write_batch(pid_);
+  for (uint64_t function_address : function_addresses) {
     auto it = trampoline_map_.find(function_address);
     // Skip if this function was not instrumented.
     if (it == trampoline_map_.end()) continue;
@@ -312,10 +382,9 @@ ErrorMessageOr<void> InstrumentedProcess::UninstrumentFunctions() {
     std::vector<uint8_t> code(trampoline_data.function_data.begin(),
                               trampoline_data.function_data.begin() +
                                   (trampoline_data.address_after_prologue - function_address));
-    auto write_result_or_error = WriteTraceesMemory(pid_, function_address, code);
-    FAIL_IF(write_result_or_error.has_error(), "%s", write_result_or_error.error().message());
+    write_batch.AddWrite(function_address, std::move(code));
   }
-  return outcome::success();
+  return write_batch.Apply();
 }
 
 ErrorMessageOr<uint64_t> InstrumentedProcess::GetTrampolineMemory(AddressRange address_range) {
@@ -340,10 +409,22 @@ ErrorMessageOr<uint64_t> InstrumentedProcess::GetTrampolineMemory(AddressRange a
 
 ErrorMessageOr<void> InstrumentedProcess::ReleaseMostRecentlyAllocatedTrampolineMemory(
     AddressRange address_range) {
-  if (!trampolines_for_modules_.contains(address_range)) {
+  auto it = trampolines_for_modules_.find(address_range);
+  if (it == trampolines_for_modules_.end()) {
     return ErrorMessage("Tried to release trampoline memory for a non existent address range");
   }
-  trampolines_for_modules_.find(address_range)->second.back().first_available--;
+  TrampolineMemoryChunks& trampoline_memory_chunks = it->second;
+  // The last chunk can only be unused if its trampolines were all released before, in which case
+  // the most recent allocation is in the chunk before.
+  while (!trampoline_memory_chunks.empty() &&
+         trampoline_memory_chunks.back().first_available == 0) {
+    OUTCOME_TRY(trampoline_memory_chunks.back().memory->Free());
+    trampoline_memory_chunks.pop_back();
+  }
+  if (trampoline_memory_chunks.empty()) {
+    return ErrorMessage("Tried to release trampoline memory that was not allocated");
+  }
+  trampoline_memory_chunks.back().first_available--;
   return outcome::success();
 }
 
@@ -7,19 +7,24 @@
 #include <stdio.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
-#include <stack>
+#include <utility>
+#include <vector>
 
 #include "CaptureEventProducer/LockFreeBufferCaptureEventProducer.h"
-#include "OrbitBase/Profiling.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "ProducerSideChannel/ProducerSideChannel.h"
+#include "TimestampCounterClock.h"
 
 namespace {
 
-using orbit_base::CaptureTimestampNs;
+using orbit_user_space_instrumentation::TimestampCounterClock;
 
 struct OpenFunctionCall {
+  OpenFunctionCall() = default;
   OpenFunctionCall(uint64_t return_address, uint64_t function_id, uint64_t timestamp_on_entry_ns)
       : return_address(return_address),
         function_id(function_id),
@@ -33,13 +38,56 @@ struct OpenFunctionCall {
 // here for awareness and to avoid packing issues in the struct.
 static_assert(sizeof(OpenFunctionCall) == 24, "OpenFunctionCall should be 24 bytes.");
 
-std::stack<OpenFunctionCall>& GetOpenFunctionCallStack() {
-  thread_local std::stack<OpenFunctionCall> open_function_calls;
+// Stack of the instrumented functions a thread is currently in. The first `kFixedCapacity` calls
+// are stored in a preallocated array, so that entering and leaving a function never allocates in
+// the common case. Only deeper stacks (e.g. from deep recursion) spill into `overflow_`; we can't
+// drop calls since we need the return address in `ExitPayload`.
+class OpenFunctionCallStack {
+ public:
+  void Push(uint64_t return_address, uint64_t function_id, uint64_t timestamp_on_entry_ns) {
+    if (size_ < kFixedCapacity) {
+      fixed_[size_] = OpenFunctionCall(return_address, function_id, timestamp_on_entry_ns);
+    } else {
+      overflow_.emplace_back(return_address, function_id, timestamp_on_entry_ns);
+    }
+    ++size_;
+  }
+
+  [[nodiscard]] OpenFunctionCall Pop() {
+    --size_;
+    if (size_ < kFixedCapacity) {
+      return fixed_[size_];
+    }
+    OpenFunctionCall open_function_call = overflow_.back();
+    overflow_.pop_back();
+    return open_function_call;
+  }
+
+ private:
+  static constexpr size_t kFixedCapacity = 256;
+  std::array<OpenFunctionCall, kFixedCapacity> fixed_;
+  size_t size_ = 0;
+  std::vector<OpenFunctionCall> overflow_;
+};
+
+OpenFunctionCallStack& GetOpenFunctionCallStack() {
+  thread_local OpenFunctionCallStack open_function_calls;
   return open_function_calls;
 }
 
+// Timestamps taken in the payloads are based on the timestamp counter, see
+// `TimestampCounterClock`. The initial calibration happens in `StartNewCapture`.
+TimestampCounterClock& GetClock() {
+  static TimestampCounterClock clock;
+  return clock;
+}
+
 uint64_t start_current_capture_timestamp = 0;
 
+// Mirrors the capture state of the producer below. Checked in every `ExitPayload`, which only
+// needs a relaxed load as events at the boundaries of a capture are filtered by timestamp anyway.
+std::atomic<bool> is_capturing = false;
+
 struct FunctionCallEvent {
   FunctionCallEvent() = default;
   FunctionCallEvent(int32_t pid, int32_t tid, uint64_t function_id, uint64_t duration_ns,
@@ -72,6 +120,21 @@ class LockFreeUserSpaceInstrumentationEventProducer
   ~LockFreeUserSpaceInstrumentationEventProducer() { ShutdownAndWait(); }
 
  protected:
+  void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
+    LockFreeBufferCaptureEventProducer::OnCaptureStart(std::move(capture_options));
+    is_capturing.store(true, std::memory_order_relaxed);
+  }
+
+  void OnCaptureStop() override {
+    is_capturing.store(false, std::memory_order_relaxed);
+    LockFreeBufferCaptureEventProducer::OnCaptureStop();
+  }
+
+  void OnCaptureFinished() override {
+    is_capturing.store(false, std::memory_order_relaxed);
+    LockFreeBufferCaptureEventProducer::OnCaptureFinished();
+  }
+
   [[nodiscard]] virtual orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
       FunctionCallEvent&& raw_event, google::protobuf::Arena* arena) override {
     auto* capture_event =
@@ -86,32 +149,43 @@ class LockFreeUserSpaceInstrumentationEventProducer
   }
 };
 
+LockFreeUserSpaceInstrumentationEventProducer& GetProducer() {
+  static LockFreeUserSpaceInstrumentationEventProducer producer;
+  return producer;
+}
+
 }  // namespace
 
-void StartNewCapture() { start_current_capture_timestamp = CaptureTimestampNs(); }
+void StartNewCapture() {
+  // This also takes care of the initial calibration of the clock, which happens on first use. We
+  // are called before any function gets instrumented, so this doesn't delay any payload.
+  GetClock().Recalibrate();
+  start_current_capture_timestamp = GetClock().Now();
+}
 
 void EntryPayload(uint64_t return_address, uint64_t function_id) {
-  const uint64_t timestamp_on_entry_ns = CaptureTimestampNs();
-  auto& open_function_call_stack = GetOpenFunctionCallStack();
-  open_function_call_stack.emplace(return_address, function_id, timestamp_on_entry_ns);
+  const uint64_t timestamp_on_entry_ns = GetClock().Now();
+  GetOpenFunctionCallStack().Push(return_address, function_id, timestamp_on_entry_ns);
 }
 
 uint64_t ExitPayload() {
-  const uint64_t timestamp_on_exit_ns = CaptureTimestampNs();
-  auto& open_function_call_stack = GetOpenFunctionCallStack();
-  OpenFunctionCall current_return_address = open_function_call_stack.top();
-  open_function_call_stack.pop();
+  const uint64_t timestamp_on_exit_ns = GetClock().Now();
+  OpenFunctionCall current_return_address = GetOpenFunctionCallStack().Pop();
 
-  static LockFreeUserSpaceInstrumentationEventProducer producer;
+  // The producer is created on first use; it connects to OrbitService and updates `is_capturing`.
+  LockFreeUserSpaceInstrumentationEventProducer& producer = GetProducer();
   // Skip emitting an event if we are not capturing or the event belongs to a previous capture.
-  if (producer.IsCapturing() &&
+  if (is_capturing.load(std::memory_order_relaxed) &&
       start_current_capture_timestamp < current_return_address.timestamp_on_entry_ns) {
     static pid_t pid = orbit_base::GetCurrentProcessId();
     thread_local pid_t tid = orbit_base::GetCurrentThreadId();
-    const uint64_t duration_ns =
-        timestamp_on_exit_ns - current_return_address.timestamp_on_entry_ns;
+    // A recalibration by another thread can make the timestamp on exit a few nanoseconds earlier
+    // than the one on entry. Clamp it, so that the duration doesn't wrap around.
+    const uint64_t end_timestamp_ns =
+        std::max(timestamp_on_exit_ns, current_return_address.timestamp_on_entry_ns);
+    const uint64_t duration_ns = end_timestamp_ns - current_return_address.timestamp_on_entry_ns;
     producer.EnqueueIntermediateEvent(FunctionCallEvent(
-        pid, tid, current_return_address.function_id, duration_ns, timestamp_on_exit_ns));
+        pid, tid, current_return_address.function_id, duration_ns, end_timestamp_ns));
   }
 
   return current_return_address.return_address;
@@ -0,0 +1,239 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef USER_SPACE_INSTRUMENTATION_TIMESTAMP_COUNTER_CLOCK_H_
+#define USER_SPACE_INSTRUMENTATION_TIMESTAMP_COUNTER_CLOCK_H_
+
+#include <cpuid.h>
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#include "OrbitBase/Profiling.h"
+
+namespace orbit_user_space_instrumentation {
+
+// Provides timestamps in the time domain of `orbit_base::CaptureTimestampNs` (CLOCK_MONOTONIC)
+// computed from the CPU's timestamp counter. Reading the counter with `rdtsc` is considerably
+// cheaper than `clock_gettime`, which matters in the payloads executed on every call of an
+// instrumented function.
+//
+// Ticks are converted to nanoseconds linearly around an anchor, a (ticks, ns) pair. Every
+// `recalibration_interval_ns` the caller of `Now` that notices the anchor is outdated measures
+// CLOCK_MONOTONIC again. To keep timestamps continuous, the new anchor is placed on the previous
+// line and the slope is chosen such that the remaining difference to CLOCK_MONOTONIC is corrected
+// over the next interval. Anchor and slope are published through a seqlock, so `Now` never blocks.
+// The clock only ever jumps forward: if it got ahead of CLOCK_MONOTONIC, it runs slower until
+// CLOCK_MONOTONIC caught up.
+//
+// If the CPU does not have an invariant timestamp counter, `Now` falls back to
+// `CaptureTimestampNs`.
+class TimestampCounterClock {
+ public:
+  static constexpr uint64_t kDefaultRecalibrationIntervalNs = 100'000'000;
+
+  using ReferenceClock = uint64_t (*)();
+
+  // Performs the initial calibration, which busy-waits for `kInitialCalibrationDurationNs`.
+  // `reference_clock` only needs to be replaced in tests.
+  explicit TimestampCounterClock(
+      uint64_t recalibration_interval_ns = kDefaultRecalibrationIntervalNs,
+      ReferenceClock reference_clock = &orbit_base::CaptureTimestampNs)
+      : is_supported_(HasInvariantTimestampCounter()),
+        recalibration_interval_ns_(recalibration_interval_ns),
+        reference_clock_(reference_clock) {
+    if (!is_supported_) return;
+
+    const Measurement first = Measure();
+    Measurement second = first;
+    while (second.ns - first.ns < kInitialCalibrationDurationNs || second.ticks <= first.ticks) {
+      second = Measure();
+    }
+    const uint64_t slope = ComputeSlope(first, second);
+    recalibration_interval_ticks_ =
+        (static_cast<unsigned __int128>(recalibration_interval_ns) << kSlopeShift) / slope;
+    last_rate_measurement_ = second;
+    measured_slope_ = slope;
+    Publish(second.ticks, second.ns, slope);
+  }
+
+  [[nodiscard]] bool IsUsingTimestampCounter() const { return is_supported_; }
+
+  [[nodiscard]] uint64_t Now() {
+    if (!is_supported_) return reference_clock_();
+
+    uint64_t anchor_ticks;
+    uint64_t anchor_ns;
+    uint64_t slope;
+    ReadAnchor(&anchor_ticks, &anchor_ns, &slope);
+    // Read the counter only after the anchor: converting ticks from before an anchor with that
+    // anchor's slope could yield an earlier timestamp than the previous anchor did, i.e., a thread
+    // could observe the clock going backwards. `rdtscp` waits for the loads above to complete.
+    uint32_t unused_processor_id;
+    const uint64_t ticks = __rdtscp(&unused_processor_id);
+    const auto delta_ticks = static_cast<int64_t>(ticks - anchor_ticks);
+    if (delta_ticks >= static_cast<int64_t>(recalibration_interval_ticks_)) {
+      Recalibrate();
+    }
+    return ConvertToNs(ticks, anchor_ticks, anchor_ns, slope);
+  }
+
+  // Forces a new anchor to be measured now, e.g. at the start of a capture.
+  void Recalibrate() {
+    if (!is_supported_) return;
+    // Only one thread at a time recalibrates; the others keep using the current anchor.
+    if (is_recalibrating_.exchange(true, std::memory_order_acquire)) return;
+
+    const Measurement measurement = Measure();
+    if (measurement.ticks > last_rate_measurement_.ticks) {
+      RecalibrateWithMeasurement(measurement);
+    }
+
+    is_recalibrating_.store(false, std::memory_order_release);
+  }
+
+ private:
+  static constexpr uint64_t kInitialCalibrationDurationNs = 1'000'000;
+  static constexpr int64_t kMaxErrorToCorrectGraduallyNs = 100'000;
+  // The slope (nanoseconds per tick) is stored as fixed-point number with this many fractional
+  // bits.
+  static constexpr int kSlopeShift = 32;
+
+  struct Measurement {
+    uint64_t ticks;
+    uint64_t ns;
+  };
+
+  [[nodiscard]] static bool HasInvariantTimestampCounter() {
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    constexpr uint32_t kInvariantTscBit = 1u << 8;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & kInvariantTscBit) != 0;
+  }
+
+  // Takes the timestamp counter right before and after reading the clock and uses the mean. As the
+  // thread could get preempted in between, this is repeated a few times and the measurement with
+  // the shortest span is used.
+  [[nodiscard]] Measurement Measure() const {
+    constexpr int kNumAttempts = 5;
+    Measurement best{};
+    uint64_t best_span = std::numeric_limits<uint64_t>::max();
+    for (int attempt = 0; attempt < kNumAttempts; ++attempt) {
+      const uint64_t ticks_before = __rdtsc();
+      const uint64_t ns = reference_clock_();
+      const uint64_t ticks_after = __rdtsc();
+      const uint64_t span = ticks_after - ticks_before;
+      if (span < best_span) {
+        best_span = span;
+        best = {ticks_before + span / 2, ns};
+      }
+    }
+    return best;
+  }
+
+  [[nodiscard]] static uint64_t ComputeSlope(const Measurement& from, const Measurement& to) {
+    const unsigned __int128 delta_ns = to.ns - from.ns;
+    return static_cast<uint64_t>((delta_ns << kSlopeShift) / (to.ticks - from.ticks));
+  }
+
+  [[nodiscard]] static uint64_t ConvertToNs(uint64_t ticks, uint64_t anchor_ticks,
+                                            uint64_t anchor_ns, uint64_t slope) {
+    const auto delta_ticks = static_cast<int64_t>(ticks - anchor_ticks);
+    const __int128 delta_ns = (static_cast<__int128>(delta_ticks) * slope) >> kSlopeShift;
+    return anchor_ns + static_cast<int64_t>(delta_ns);
+  }
+
+  // Must only be called while holding `is_recalibrating_`.
+  void RecalibrateWithMeasurement(const Measurement& measurement) {
+    uint64_t anchor_ticks;
+    uint64_t anchor_ns;
+    uint64_t slope;
+    ReadAnchor(&anchor_ticks, &anchor_ns, &slope);
+    const uint64_t predicted_ns = ConvertToNs(measurement.ticks, anchor_ticks, anchor_ns, slope);
+
+    const auto error_ns = static_cast<int64_t>(measurement.ns - predicted_ns);
+    if (std::abs(error_ns) > kMaxErrorToCorrectGraduallyNs) {
+      // E.g. after a long time without any call to `Now`, or if the reference clock was slewed.
+      // Don't estimate the rate of the counter across such a discontinuity.
+      last_rate_measurement_ = measurement;
+      if (error_ns > 0) {
+        // Rather jump forward than lag behind.
+        Publish(measurement.ticks, measurement.ns, measured_slope_);
+      } else {
+        // Never jump backwards, as later timestamps would then be smaller than ones already handed
+        // out, e.g. the timestamp on entry of a function. Instead, run at the slowest rate allowed
+        // below until the reference clock caught up.
+        Publish(measurement.ticks, predicted_ns, measured_slope_ / 2);
+      }
+      return;
+    }
+
+    // Only re-estimate the rate of the counter over a long enough window, so that the jitter of
+    // the measurements doesn't matter. This is not the case when forcing a recalibration shortly
+    // after the previous one.
+    if (measurement.ns >= last_rate_measurement_.ns &&
+        measurement.ns - last_rate_measurement_.ns >= recalibration_interval_ns_ / 2) {
+      measured_slope_ = ComputeSlope(last_rate_measurement_, measurement);
+      last_rate_measurement_ = measurement;
+    }
+
+    const __int128 correction =
+        (static_cast<__int128>(error_ns) * (static_cast<__int128>(1) << kSlopeShift)) /
+        static_cast<__int128>(recalibration_interval_ticks_);
+    __int128 new_slope = static_cast<__int128>(measured_slope_) + correction;
+    // Never let the clock run slower than half or faster than twice the measured rate.
+    new_slope = std::max<__int128>(new_slope, measured_slope_ / 2);
+    new_slope = std::min<__int128>(new_slope, static_cast<__int128>(measured_slope_) * 2);
+    Publish(measurement.ticks, predicted_ns, static_cast<uint64_t>(new_slope));
+  }
+
+  void ReadAnchor(uint64_t* anchor_ticks, uint64_t* anchor_ns, uint64_t* slope) const {
+    uint32_t sequence_before;
+    uint32_t sequence_after;
+    do {
+      sequence_before = sequence_.load(std::memory_order_acquire);
+      *anchor_ticks = anchor_ticks_.load(std::memory_order_relaxed);
+      *anchor_ns = anchor_ns_.load(std::memory_order_relaxed);
+      *slope = slope_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      sequence_after = sequence_.load(std::memory_order_relaxed);
+    } while ((sequence_before & 1) != 0 || sequence_before != sequence_after);
+  }
+
+  // Must only be called from the constructor or while holding `is_recalibrating_`.
+  void Publish(uint64_t anchor_ticks, uint64_t anchor_ns, uint64_t slope) {
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    anchor_ticks_.store(anchor_ticks, std::memory_order_relaxed);
+    anchor_ns_.store(anchor_ns, std::memory_order_relaxed);
+    slope_.store(slope, std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  const bool is_supported_;
+  const uint64_t recalibration_interval_ns_;
+  const ReferenceClock reference_clock_;
+  uint64_t recalibration_interval_ticks_ = 0;
+
+  std::atomic<uint32_t> sequence_ = 0;
+  std::atomic<uint64_t> anchor_ticks_ = 0;
+  std::atomic<uint64_t> anchor_ns_ = 0;
+  std::atomic<uint64_t> slope_ = 0;
+
+  std::atomic<bool> is_recalibrating_ = false;
+  // Only accessed from the constructor or while holding `is_recalibrating_`.
+  Measurement last_rate_measurement_{};
+  uint64_t measured_slope_ = 0;
+};
+
+}  // namespace orbit_user_space_instrumentation
+
+#endif  // USER_SPACE_INSTRUMENTATION_TIMESTAMP_COUNTER_CLOCK_H_
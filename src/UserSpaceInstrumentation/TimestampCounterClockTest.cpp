@@ -0,0 +1,119 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "OrbitBase/Profiling.h"
+#include "TimestampCounterClock.h"
+
+namespace orbit_user_space_instrumentation {
+
+namespace {
+
+// Generous to not be flaky on loaded machines; a broken conversion is off by orders of magnitude.
+constexpr uint64_t kToleranceNs = 1'000'000;
+
+[[nodiscard]] bool IsBetween(uint64_t value, uint64_t low, uint64_t high) {
+  return low <= value && value <= high;
+}
+
+// The reference clock of `LaggingReferenceClock` lags CaptureTimestampNs by this much.
+std::atomic<uint64_t> reference_clock_lag_ns = 0;
+
+uint64_t LaggingReferenceClock() {
+  return orbit_base::CaptureTimestampNs() - reference_clock_lag_ns.load();
+}
+
+}  // namespace
+
+TEST(TimestampCounterClockTest, NowIsCloseToCaptureTimestamp) {
+  TimestampCounterClock clock;
+  for (int i = 0; i < 100; ++i) {
+    const uint64_t before = orbit_base::CaptureTimestampNs();
+    const uint64_t now = clock.Now();
+    const uint64_t after = orbit_base::CaptureTimestampNs();
+    EXPECT_TRUE(IsBetween(now, before - kToleranceNs, after + kToleranceNs));
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+TEST(TimestampCounterClockTest, StaysCloseToCaptureTimestampAcrossRecalibrations) {
+  constexpr uint64_t kRecalibrationIntervalNs = 1'000'000;
+  TimestampCounterClock clock{kRecalibrationIntervalNs};
+  const uint64_t end = orbit_base::CaptureTimestampNs() + 50 * kRecalibrationIntervalNs;
+  uint64_t previous = clock.Now();
+  while (orbit_base::CaptureTimestampNs() < end) {
+    const uint64_t before = orbit_base::CaptureTimestampNs();
+    const uint64_t now = clock.Now();
+    const uint64_t after = orbit_base::CaptureTimestampNs();
+    EXPECT_TRUE(IsBetween(now, before - kToleranceNs, after + kToleranceNs));
+    EXPECT_GE(now, previous);
+    previous = now;
+  }
+}
+
+TEST(TimestampCounterClockTest, ForcedRecalibrationKeepsClockMonotonic) {
+  TimestampCounterClock clock;
+  uint64_t previous = clock.Now();
+  for (int i = 0; i < 1000; ++i) {
+    clock.Recalibrate();
+    const uint64_t now = clock.Now();
+    EXPECT_GE(now, previous);
+    previous = now;
+  }
+}
+
+TEST(TimestampCounterClockTest, NeverGoesBackwardsWhenReferenceClockFallsBehindPrediction) {
+  constexpr uint64_t kRecalibrationIntervalNs = 1'000'000;
+  constexpr uint64_t kLagNs = 10'000'000;
+  reference_clock_lag_ns = 0;
+  TimestampCounterClock clock{kRecalibrationIntervalNs, &LaggingReferenceClock};
+  if (!clock.IsUsingTimestampCounter()) GTEST_SKIP() << "No invariant timestamp counter";
+
+  uint64_t previous = clock.Now();
+  reference_clock_lag_ns = kLagNs;
+  clock.Recalibrate();
+  const uint64_t after_recalibration = clock.Now();
+  EXPECT_GE(after_recalibration, previous);
+  previous = after_recalibration;
+
+  // The clock runs slower until the reference clock caught up, which takes about two intervals per
+  // interval of lag.
+  const uint64_t end = orbit_base::CaptureTimestampNs() + 5 * kLagNs;
+  while (orbit_base::CaptureTimestampNs() < end) {
+    const uint64_t now = clock.Now();
+    EXPECT_GE(now, previous);
+    previous = now;
+  }
+
+  const uint64_t before = LaggingReferenceClock();
+  const uint64_t now = clock.Now();
+  const uint64_t after = LaggingReferenceClock();
+  EXPECT_TRUE(IsBetween(now, before - kToleranceNs, after + kToleranceNs));
+}
+
+TEST(TimestampCounterClockTest, IsMonotonicOnEachOfMultipleThreads) {
+  TimestampCounterClock clock{1'000'000};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&clock] {
+      uint64_t previous = clock.Now();
+      for (int j = 0; j < 100'000; ++j) {
+        const uint64_t now = clock.Now();
+        EXPECT_GE(now, previous);
+        previous = now;
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace orbit_user_space_instrumentation
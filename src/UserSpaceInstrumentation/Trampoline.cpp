@@ -776,6 +776,22 @@ ErrorMessageOr<uint64_t> CreateTrampoline(pid_t pid, uint64_t function_address,
                                           uint64_t entry_payload_function_address,
                                           uint64_t return_trampoline_address, csh capstone_handle,
                                           absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+  TraceesMemoryWriteBatch write_batch(pid);
+  OUTCOME_TRY(auto&& address_after_prologue,
+              CreateTrampoline(write_batch, function_address, function, trampoline_address,
+                               entry_payload_function_address, return_trampoline_address,
+                               capstone_handle, relocation_map));
+  OUTCOME_TRY(write_batch.Apply());
+  return address_after_prologue;
+}
+
+ErrorMessageOr<uint64_t> CreateTrampoline(TraceesMemoryWriteBatch& write_batch,
+                                          uint64_t function_address,
+                                          const std::vector<uint8_t>& function,
+                                          uint64_t trampoline_address,
+                                          uint64_t entry_payload_function_address,
+                                          uint64_t return_trampoline_address, csh capstone_handle,
+                                          absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
   MachineCode trampoline;
   // Add code to backup register state, execute the payload and restore the register state.
   AppendBackupCode(trampoline);
@@ -792,11 +808,7 @@ ErrorMessageOr<uint64_t> CreateTrampoline(pid_t pid, uint64_t function_address,
   OUTCOME_TRY(AppendJumpBackCode(address_after_prologue, trampoline_address, trampoline));
 
   // Copy trampoline into tracee.
-  auto write_result_or_error =
-      WriteTraceesMemory(pid, trampoline_address, trampoline.GetResultAsVector());
-  if (write_result_or_error.has_error()) {
-    return write_result_or_error.error();
-  }
+  write_batch.AddWrite(trampoline_address, trampoline.GetResultAsVector());
 
   return address_after_prologue;
 }
@@ -829,6 +841,16 @@ ErrorMessageOr<void> CreateReturnTrampoline(pid_t pid, uint64_t exit_payload_fun
 ErrorMessageOr<void> InstrumentFunction(pid_t pid, uint64_t function_address, uint64_t function_id,
                                         uint64_t address_after_prologue,
                                         uint64_t trampoline_address) {
+  TraceesMemoryWriteBatch write_batch(pid);
+  OUTCOME_TRY(InstrumentFunction(write_batch, function_address, function_id, address_after_prologue,
+                                 trampoline_address));
+  return write_batch.Apply();
+}
+
+ErrorMessageOr<void> InstrumentFunction(TraceesMemoryWriteBatch& write_batch,
+                                        uint64_t function_address, uint64_t function_id,
+                                        uint64_t address_after_prologue,
+                                        uint64_t trampoline_address) {
   MachineCode jump;
   jump.AppendBytes({0xe9});
   ErrorMessageOr<int32_t> offset_or_error =
@@ -847,13 +869,13 @@ ErrorMessageOr<void> InstrumentFunction(pid_t pid, uint64_t function_address, ui
   while (jump.GetResultAsVector().size() < address_after_prologue - function_address) {
     jump.AppendBytes({0x90});
   }
-  OUTCOME_TRY(WriteTraceesMemory(pid, function_address, jump.GetResultAsVector()));
+  write_batch.AddWrite(function_address, jump.GetResultAsVector());
 
   // Patch the trampoline to hand over the current function_id to the entry payload.
   MachineCode function_id_as_bytes;
   function_id_as_bytes.AppendImmediate64(function_id);
-  OUTCOME_TRY(WriteTraceesMemory(pid, trampoline_address + kOffsetOfFunctionIdInCallToEntryPayload,
-                                 function_id_as_bytes.GetResultAsVector()));
+  write_batch.AddWrite(trampoline_address + kOffsetOfFunctionIdInCallToEntryPayload,
+                       function_id_as_bytes.GetResultAsVector());
 
   return outcome::success();
 }
@@ -14,6 +14,7 @@
 #include <optional>
 #include <vector>
 
+#include "AccessTraceesMemory.h"
 #include "AddressRange.h"
 #include "AllocateInTracee.h"
 #include "OrbitBase/Result.h"
@@ -134,6 +135,14 @@ struct RelocatedInstruction {
     uint64_t return_trampoline_address, csh capstone_handle,
     absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
 
+// Same as above but instead of writing the trampoline into the tracee right away, the write is
+// added to `write_batch`. Use this when creating many trampolines at once.
+[[nodiscard]] ErrorMessageOr<uint64_t> CreateTrampoline(
+    TraceesMemoryWriteBatch& write_batch, uint64_t function_address,
+    const std::vector<uint8_t>& function, uint64_t trampoline_address,
+    uint64_t entry_payload_function_address, uint64_t return_trampoline_address,
+    csh capstone_handle, absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
+
 // As above with `GetMaxTrampolineSize` this is a compile time constant, but we prefer to compute it
 // here since this captures every change to the code constructing the return trampoline.
 [[nodiscard]] uint64_t GetReturnTrampolineSize();
@@ -159,6 +168,13 @@ struct RelocatedInstruction {
                                                       uint64_t address_of_instruction_after_jump,
                                                       uint64_t trampoline_address);
 
+// Same as above but the patches of the function and the trampoline are added to `write_batch`.
+[[nodiscard]] ErrorMessageOr<void> InstrumentFunction(TraceesMemoryWriteBatch& write_batch,
+                                                      uint64_t function_address,
+                                                      uint64_t function_id,
+                                                      uint64_t address_of_instruction_after_jump,
+                                                      uint64_t trampoline_address);
+
 // Move every instruction pointer that was in the middle of an overwritten function prologue to
 // the corresponding place in the trampoline.
 void MoveInstructionPointersOutOfOverwrittenCode(